@@ -0,0 +1,42 @@
+#include "AdcFilter.h"
+
+AdcFilter::AdcFilter() : decimation(1), alpha(1.0f) {
+    begin(1, 1.0f);
+}
+
+void AdcFilter::begin(uint16_t dec, float a) {
+    decimation = dec ? dec : 1;
+    alpha = a;
+    for (int i = 0; i < ADC_FILTER_CHANNELS; i++) {
+        acc[i] = 0;
+        count[i] = 0;
+        ema[i] = 0.0f;
+        primed[i] = false;
+        outputs[i] = 0;
+    }
+}
+
+size_t AdcFilter::processBlock(const uint16_t* raw, const uint8_t* chan, size_t n) {
+    size_t produced = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t ch = chan[i];
+        if (ch >= ADC_FILTER_CHANNELS) continue;
+
+        acc[ch] += raw[i];
+        if (++count[ch] < decimation) continue;
+
+        // Boxcar output, then smooth at the decimated rate
+        float mean = (float)acc[ch] / count[ch];
+        acc[ch] = 0;
+        count[ch] = 0;
+        if (primed[ch]) {
+            ema[ch] += alpha * (mean - ema[ch]);
+        } else {
+            ema[ch] = mean;
+            primed[ch] = true;
+        }
+        outputs[ch]++;
+        produced++;
+    }
+    return produced;
+}
@@ -0,0 +1,36 @@
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ADC_FILTER_CHANNELS 4
+
+// Block decimator for the comparator ADCs: a boxcar (first-order CIC)
+// over `decimation` raw conversions per channel, followed by an EMA on the
+// decimated stream. Plain C++ so it can be exercised off-target.
+class AdcFilter {
+public:
+    AdcFilter();
+    void begin(uint16_t decimation, float alpha);
+    void setAlpha(float a) { alpha = a; }
+
+    // Feeds one block of interleaved conversions; chan[i] is the output
+    // channel of raw[i]. Returns the number of decimated outputs produced.
+    size_t processBlock(const uint16_t* raw, const uint8_t* chan, size_t n);
+
+    bool ready(uint8_t ch) const { return primed[ch]; }
+    float value(uint8_t ch) const { return ema[ch]; }
+    uint32_t outputCount(uint8_t ch) const { return outputs[ch]; }
+
+private:
+    uint16_t decimation;
+    float alpha;
+    uint32_t acc[ADC_FILTER_CHANNELS];
+    uint16_t count[ADC_FILTER_CHANNELS];
+    float ema[ADC_FILTER_CHANNELS];
+    bool primed[ADC_FILTER_CHANNELS];
+    uint32_t outputs[ADC_FILTER_CHANNELS];
+};
+
+#endif
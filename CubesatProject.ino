@@ -4,6 +4,9 @@
 #include "TelemetryService.h"
 #include "WebService.h"
 #include "MqttService.h"
+#include "SampleBus.h"
+#include "Metrics.h"
+#include "SystemClock.h"
 
 // Global Services
 SensorService sensorService;
@@ -14,42 +17,54 @@ MqttService mqttService;
 // System Mode State
 OperationMode currentSystemMode = MODE_SENSOR; // Default to sensor mode
 
-// Shared Queue
-QueueHandle_t dataQueue;
+// Sample fan-out (SensorService -> Telemetry, MQTT, Web)
+SampleBus sampleBus;
+
+// Runtime instrumentation (/metrics, cubesat/health)
+Metrics metrics;
+
+// Monotonic µs clock disciplined by NTP/GPS/RTC; stamps every sample
+SystemClock systemClock;
 
 void setup() {
-    Serial.begin(115200);
-    delay(1000);
+    Serial.begin(115200); // No wait for a monitor: sampling and HTTP start right away
     Serial.println("ESP32-S3 OOP Cubesat");
+    metrics.attach(&sensorService, &telemetryService, &mqttService, &sampleBus);
+    metrics.setTask(MTASK_LOOP, xTaskGetCurrentTaskHandle());
+    systemClock.begin();
 
-    // Initialize Shared Queue
-    dataQueue = xQueueCreate(10, sizeof(MeasurementData));
-    if (dataQueue == NULL) {
-        Serial.println("Error creating data queue!");
-    }
-    
-    // Inject Queue into SensorService
-    sensorService.setDataQueue(&dataQueue);
+    // Inject Bus into SensorService
+    sensorService.setSampleBus(&sampleBus);
 
     // Initialize Services
     
-    // 1. Sensors (I2C, GPS)
+    // 1. Sensors (I2C, GPS); sampling starts in step 5
     sensorService.begin();
     
     // 2. MQTT Service
-    mqttService.begin(&sensorService);
+    mqttService.setPowerTrigger(sensorService.getPowerTrigger());
+    mqttService.begin(&sampleBus);
+
+    // 3. Telemetry (SD Card) - Depends on Bus
+    telemetryService.setPowerTrigger(sensorService.getPowerTrigger());
+    telemetryService.begin(&sampleBus);
 
-    // 3. Telemetry (SD Card) - Depends on Queue
-    telemetryService.begin(&dataQueue);
+    // 4. Web Service - Depends on Sensors, MQTT and Bus. Serves at once;
+    // WiFi STA and NTP come up in the background from loop()
+    webService.begin(&sensorService, &mqttService, &sampleBus);
 
-    // 4. Web Service - Depends on Sensors and MQTT
-    webService.begin(&sensorService, &mqttService);
+    // 5. Sampling, once every consumer is on the bus so none misses the
+    // first records
+    sensorService.start();
+    metrics.markBoot(BOOT_SETUP_DONE);
 }
 
 void loop() {
     // Web Server is not purely async in this simple implementation, 
     // it needs a handleClient loop.
+    uint32_t start = Metrics::cycles();
     webService.update();
     mqttService.update();
+    metrics.stop(MT_LOOP, start);
     vTaskDelay(pdMS_TO_TICKS(10));
 }
@@ -0,0 +1,16 @@
+#include "DataModel.h"
+
+void formatTimestamp(const MeasurementData& d, char* out, size_t outSize) {
+    if (d.epoch == 0) {
+        snprintf(out, outSize, "ms_%lu", (unsigned long)d.uptimeMs);
+        return;
+    }
+    static const char* const days[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    time_t t = (time_t)d.epoch;
+    struct tm tmv;
+    gmtime_r(&t, &tmv); // RTC holds local wall-clock time, so no zone conversion
+    snprintf(out, outSize, "%s %04d-%02d-%02d %02d:%02d:%02d",
+             days[tmv.tm_wday],
+             tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday,
+             tmv.tm_hour, tmv.tm_min, tmv.tm_sec);
+}
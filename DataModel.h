@@ -10,10 +10,13 @@
 #define ENABLE_MQTT    1
 #define ENABLE_WIFI_ENTERPRISE 0 // Set to 1 to use WPA2 Enterprise (eduroam)
 #define ENABLE_MQTT_TLS 0 // Set to 1 to bypass port 1883 blocking using port 8883 (TLS)
+#define ENABLE_MQTT_JSON 1 // JSON on MQTT_TOPIC next to the binary frame on MQTT_TOPIC_BIN; 0 = binary only
 
 #define ENABLE_INA226  1 // Set to 1 if hardware acts up
 #define ENABLE_RTC     1 // Set to 1 if hardware acts up
 #define ENABLE_GPS     1 // Set to 1 if hardware acts up
+#define ENABLE_ADC_DMA 1 // Continuous DMA ADC; set to 0 to fall back to analogRead() polling
+#define ENABLE_POWER_CAPTURE 1 // Pre/post-trigger bursts of the INA226 stream on rail anomalies (PowerTrigger.h)
 
 // WI-FI CONFIGURATION (Standard WPA2 Personal)
 #define WIFI_SSID "TT :)"
@@ -34,21 +37,40 @@
 #endif
 
 #define MQTT_TOPIC "cubesat/telemetry"
+#define MQTT_TOPIC_BIN "cubesat/telemetry/bin" // TelemetryFrame, see TelemetryFrame.h
+#define MQTT_TOPIC_CAPTURE "cubesat/capture"  // Power-rail burst captures, see PowerTrigger.h
 
+// Hot sample record — ordered widest-first so there is no interior padding
 struct MeasurementData {
-    char timestamp[32];
-    char snrData[128];
+    double lat, lng;
+    int64_t monoUs;    // SystemClock::monoUs() when the sample was taken (ordering key)
+    uint32_t epoch;    // Local wall-clock seconds since 1970 from SystemClock (0 = never synced)
+    uint32_t uptimeMs; // monoUs / 1000, same base as millis()
     float vin, iin, pin;
+    float vinMin, vinMax; // Extremes of every power reading since the previous record
+    float iinMin, iinMax;
     float vout, iout, pout;
     float efficiency;
-    double lat, lng;
-    int satellites;
-    int adcValues[4];
     float battSoC; // Battery State of Charge (%)
     float adcSoC;  // Redundant SoC from comparator (%)
     float logicLevels[4]; // Inverted logic (0.0=Inactive, 1.0=Active)
+    int16_t adcValues[4]; // 12-bit ADC counts
+    uint8_t satellites;
+    uint8_t fresh;        // SAMPLE_FRESH_* sources updated since the previous record
+    uint8_t timeSource;   // ClockSource steering `epoch` when the sample was taken
+    uint8_t powerReads;   // Power readings folded into vin/iin Min/Max (0 = none: they equal vin/iin)
 };
 
+// MeasurementData::fresh bits
+#define SAMPLE_FRESH_POWER 0x01
+#define SAMPLE_FRESH_ADC   0x02
+#define SAMPLE_FRESH_GPS   0x04
+#define SAMPLE_FRESH_RTC   0x08
+
+// Formats the sample time for output edges (Serial, SD, JSON):
+// "Sunday 2026-03-07 22:30:01", or "ms_<uptime>" when no wall-clock time is known
+void formatTimestamp(const MeasurementData& d, char* out, size_t outSize);
+
 // System Modes
 enum OperationMode {
     MODE_SENSOR,    // Only read sensors, send data
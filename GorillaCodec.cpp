@@ -0,0 +1,264 @@
+#include "GorillaCodec.h"
+#include <string.h>
+
+const GorillaType GORILLA_SAMPLE_TYPES[GS_COUNT] = {
+    GORILLA_COUNTER, GORILLA_COUNTER,
+    GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT,
+    GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT, GORILLA_FLOAT,
+    GORILLA_INT, GORILLA_INT,
+    GORILLA_INT, GORILLA_INT, GORILLA_INT, GORILLA_INT,
+    GORILLA_INT, GORILLA_INT, GORILLA_INT
+};
+
+const char* const GORILLA_SAMPLE_NAMES[GS_COUNT] = {
+    "uptime_ms", "epoch",
+    "vin", "iin", "pin", "vout", "iout", "pout", "eff",
+    "batt_soc", "adc_soc", "logic0", "logic1", "logic2", "logic3",
+    "lat_e7", "lng_e7",
+    "adc0", "adc1", "adc2", "adc3",
+    "satellites", "fresh", "mode"
+};
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline uint8_t clz32(uint32_t v) {
+    return v ? (uint8_t)__builtin_clz(v) : 32;
+}
+
+static inline uint8_t ctz32(uint32_t v) {
+    return v ? (uint8_t)__builtin_ctz(v) : 32;
+}
+
+// ---- Encoder ----
+
+GorillaEncoder::GorillaEncoder()
+    : buf(nullptr), capBits(0), bitPos(0), overflow(false), channels(0), samples(0) {}
+
+bool GorillaEncoder::begin(uint8_t* b, size_t capacity, const GorillaType* t, uint8_t ch) {
+    if (!b || ch == 0 || ch > GORILLA_MAX_CHANNELS || capacity < GORILLA_HEADER(ch)) return false;
+    buf = b;
+    capBits = (capacity > 0xFFFF ? 0xFFFF : capacity) * 8; // Length field is 16 bits
+    channels = ch;
+    samples = 0;
+    overflow = false;
+    memcpy(types, t, ch);
+    memset(state, 0, sizeof(state));
+    buf[0] = GORILLA_MAGIC;
+    buf[1] = GORILLA_VERSION;
+    buf[2] = ch;
+    memcpy(buf + 7, t, ch);
+    bitPos = GORILLA_HEADER(ch) * 8;
+    return true;
+}
+
+void GorillaEncoder::putBits(uint64_t v, uint8_t n) {
+    if (bitPos + n > capBits) {
+        overflow = true;
+        return;
+    }
+    while (n > 0) {
+        size_t byte = bitPos >> 3;
+        uint8_t used = bitPos & 7;
+        uint8_t room = 8 - used;
+        uint8_t take = n < room ? n : room;
+        uint8_t mask = (uint8_t)(((1u << take) - 1) << (room - take));
+        uint8_t bits = (uint8_t)((v >> (n - take)) << (room - take)) & mask;
+        // Masked write: bits left over from a rolled-back append are overwritten
+        buf[byte] = (buf[byte] & ~mask) | bits;
+        bitPos += take;
+        n -= take;
+    }
+}
+
+void GorillaEncoder::putSigned(int32_t v) {
+    uint32_t z = zigzag(v);
+    if (z == 0)              putBits(0x0, 1);
+    else if (z < (1u << 7))  putBits((0x2ull << 7) | z, 9);
+    else if (z < (1u << 9))  putBits((0x6ull << 9) | z, 12);
+    else if (z < (1u << 12)) putBits((0xEull << 12) | z, 16);
+    else                     putBits((0xFull << 32) | z, 36);
+}
+
+void GorillaEncoder::putFloat(GorillaChannelState& s, uint32_t v) {
+    uint32_t x = v ^ s.prev;
+    s.prev = v;
+    if (x == 0) {
+        putBits(0, 1);
+        return;
+    }
+    uint8_t lead = clz32(x);
+    uint8_t trail = ctz32(x);
+    if (lead > 31) lead = 31; // 5-bit field
+    if (s.leading + s.trailing < 32 && lead >= s.leading && trail >= s.trailing) {
+        // Fits the previous window: '10' + meaningful bits
+        uint8_t sig = 32 - s.leading - s.trailing;
+        putBits(0x2, 2);
+        putBits(x >> s.trailing, sig);
+    } else {
+        // New window: '11' + 5-bit leading + 5-bit (length - 1) + bits
+        uint8_t sig = 32 - lead - trail;
+        putBits(0x3, 2);
+        putBits(lead, 5);
+        putBits(sig - 1, 5);
+        putBits(x >> trail, sig);
+        s.leading = lead;
+        s.trailing = trail;
+    }
+}
+
+bool GorillaEncoder::append(const GorillaValue* values) {
+    if (!buf || samples == 0xFFFF) return false;
+
+    // Roll back to here if the sample does not fit
+    size_t savedPos = bitPos;
+    GorillaChannelState saved[GORILLA_MAX_CHANNELS];
+    memcpy(saved, state, sizeof(GorillaChannelState) * channels);
+
+    for (uint8_t c = 0; c < channels; c++) {
+        GorillaChannelState& s = state[c];
+        uint32_t v = values[c].u;
+        if (samples == 0) {
+            putBits(v, 32);
+            s.prev = v;
+            s.prevDelta = 0;
+            s.leading = 32; // No window yet
+            s.trailing = 0;
+            continue;
+        }
+        if (types[c] == GORILLA_FLOAT) {
+            putFloat(s, v);
+        } else {
+            uint32_t delta = v - s.prev; // Wrapping arithmetic covers the full int32 range
+            if (types[c] == GORILLA_COUNTER) {
+                putSigned((int32_t)(delta - s.prevDelta));
+                s.prevDelta = delta;
+            } else {
+                putSigned((int32_t)delta);
+            }
+            s.prev = v;
+        }
+    }
+
+    if (overflow) {
+        bitPos = savedPos;
+        memcpy(state, saved, sizeof(GorillaChannelState) * channels);
+        overflow = false;
+        return false;
+    }
+    samples++;
+    return true;
+}
+
+size_t GorillaEncoder::finish() {
+    if (!buf) return 0;
+    size_t len = bytes();
+    buf[3] = samples & 0xFF;
+    buf[4] = samples >> 8;
+    buf[5] = len & 0xFF;
+    buf[6] = len >> 8;
+    return len;
+}
+
+// ---- Decoder ----
+
+GorillaDecoder::GorillaDecoder()
+    : data(nullptr), endBits(0), bitPos(0), error(false), blockLen(0), channels(0), samples(0), decoded(0) {}
+
+bool GorillaDecoder::begin(const uint8_t* d, size_t len) {
+    if (!d || len < 7 || d[0] != GORILLA_MAGIC || d[1] != GORILLA_VERSION) return false;
+    uint8_t ch = d[2];
+    size_t blen = d[5] | (d[6] << 8);
+    if (ch == 0 || ch > GORILLA_MAX_CHANNELS || blen < GORILLA_HEADER(ch) || blen > len) return false;
+    for (uint8_t c = 0; c < ch; c++) {
+        if (d[7 + c] > GORILLA_COUNTER) return false;
+    }
+    data = d;
+    channels = ch;
+    samples = d[3] | (d[4] << 8);
+    blockLen = blen;
+    endBits = blen * 8;
+    bitPos = GORILLA_HEADER(ch) * 8;
+    decoded = 0;
+    error = false;
+    memcpy(types, d + 7, ch);
+    memset(state, 0, sizeof(state));
+    return true;
+}
+
+uint64_t GorillaDecoder::getBits(uint8_t n) {
+    if (bitPos + n > endBits) {
+        error = true;
+        return 0;
+    }
+    uint64_t v = 0;
+    while (n > 0) {
+        uint8_t used = bitPos & 7;
+        uint8_t room = 8 - used;
+        uint8_t take = n < room ? n : room;
+        uint8_t bits = (data[bitPos >> 3] >> (room - take)) & ((1u << take) - 1);
+        v = (v << take) | bits;
+        bitPos += take;
+        n -= take;
+    }
+    return v;
+}
+
+int32_t GorillaDecoder::getSigned() {
+    if (getBits(1) == 0) return 0;
+    if (getBits(1) == 0) return unzigzag((uint32_t)getBits(7));
+    if (getBits(1) == 0) return unzigzag((uint32_t)getBits(9));
+    if (getBits(1) == 0) return unzigzag((uint32_t)getBits(12));
+    return unzigzag((uint32_t)getBits(32));
+}
+
+uint32_t GorillaDecoder::getFloat(GorillaChannelState& s) {
+    if (getBits(1) == 0) return s.prev;
+    uint32_t x;
+    if (getBits(1) == 0) {
+        uint8_t sig = 32 - s.leading - s.trailing;
+        x = (uint32_t)getBits(sig) << s.trailing;
+    } else {
+        s.leading = (uint8_t)getBits(5);
+        uint8_t sig = (uint8_t)getBits(5) + 1;
+        if (s.leading + sig > 32) {
+            error = true;
+            return 0;
+        }
+        s.trailing = 32 - s.leading - sig;
+        x = (uint32_t)getBits(sig) << s.trailing;
+    }
+    s.prev ^= x;
+    return s.prev;
+}
+
+bool GorillaDecoder::next(GorillaValue* values) {
+    if (!data || error || decoded >= samples) return false;
+    for (uint8_t c = 0; c < channels; c++) {
+        GorillaChannelState& s = state[c];
+        if (decoded == 0) {
+            s.prev = (uint32_t)getBits(32);
+            s.prevDelta = 0;
+            s.leading = 32;
+            s.trailing = 0;
+        } else if (types[c] == GORILLA_FLOAT) {
+            getFloat(s);
+        } else {
+            uint32_t delta = (uint32_t)getSigned();
+            if (types[c] == GORILLA_COUNTER) {
+                delta += s.prevDelta;
+                s.prevDelta = delta;
+            }
+            s.prev += delta;
+        }
+        values[c].u = s.prev;
+    }
+    if (error) return false;
+    decoded++;
+    return true;
+}
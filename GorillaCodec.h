@@ -0,0 +1,121 @@
+#ifndef GORILLA_CODEC_H
+#define GORILLA_CODEC_H
+
+// Block-based time-series compression after Facebook's Gorilla (VLDB 2015).
+// Plain C++ with no Arduino dependencies, shared with tools/ground/.
+//
+// A block holds up to 65535 samples of a fixed set of 32-bit channels:
+//   GORILLA_FLOAT    XOR with the previous value (leading/trailing zero window)
+//   GORILLA_INT      zigzag delta
+//   GORILLA_COUNTER  zigzag delta-of-delta (timestamps, epoch, counters)
+// INT/COUNTER share one bucket code: '0' = 0, '10'+7 bits, '110'+9,
+// '1110'+12, '1111'+32. The first sample of a block is stored raw, so
+// every block decodes on its own.
+//
+// Block layout: magic 'G', version, channel count, sample count (u16 LE),
+// byte length (u16 LE), channel types, then the MSB-first bit stream.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GORILLA_MAGIC        0x47
+#define GORILLA_VERSION      1
+#define GORILLA_MAX_CHANNELS 24
+#define GORILLA_HEADER(ch)   ((size_t)7 + (ch))
+
+enum GorillaType : uint8_t {
+    GORILLA_FLOAT,
+    GORILLA_INT,
+    GORILLA_COUNTER
+};
+
+union GorillaValue {
+    float f;
+    int32_t i;
+    uint32_t u;
+};
+
+struct GorillaChannelState {
+    uint32_t prev;
+    uint32_t prevDelta;
+    uint8_t leading;  // XOR window of the previous float
+    uint8_t trailing;
+};
+
+class GorillaEncoder {
+public:
+    GorillaEncoder();
+
+    // `buf` must stay valid until finish(); returns false on bad arguments
+    bool begin(uint8_t* buf, size_t capacity, const GorillaType* types, uint8_t channels);
+
+    // Appends one sample (one value per channel). Returns false, leaving the
+    // block unchanged, if it does not fit; finish the block and start another.
+    bool append(const GorillaValue* values);
+
+    size_t finish(); // Patches the header; returns the block length in bytes
+    uint16_t count() const { return samples; }
+    size_t bytes() const { return (bitPos + 7) / 8; }
+
+private:
+    void putBits(uint64_t v, uint8_t n);
+    void putSigned(int32_t v);
+    void putFloat(GorillaChannelState& s, uint32_t v);
+
+    uint8_t* buf;
+    size_t capBits;
+    size_t bitPos;
+    bool overflow;
+    uint8_t channels;
+    uint16_t samples;
+    GorillaType types[GORILLA_MAX_CHANNELS];
+    GorillaChannelState state[GORILLA_MAX_CHANNELS];
+};
+
+class GorillaDecoder {
+public:
+    GorillaDecoder();
+
+    // Validates the header; `len` may exceed the block (blocks can be
+    // concatenated), blockBytes() tells where the next one starts
+    bool begin(const uint8_t* data, size_t len);
+    bool next(GorillaValue* values); // false after the last sample or on a truncated stream
+
+    uint8_t channelCount() const { return channels; }
+    GorillaType channelType(uint8_t ch) const { return types[ch]; }
+    uint16_t count() const { return samples; }
+    size_t blockBytes() const { return blockLen; }
+
+private:
+    uint64_t getBits(uint8_t n);
+    int32_t getSigned();
+    uint32_t getFloat(GorillaChannelState& s);
+
+    const uint8_t* data;
+    size_t endBits;
+    size_t bitPos;
+    bool error;
+    size_t blockLen;
+    uint8_t channels;
+    uint16_t samples;
+    uint16_t decoded;
+    GorillaType types[GORILLA_MAX_CHANNELS];
+    GorillaChannelState state[GORILLA_MAX_CHANNELS];
+};
+
+// Channel schema for one telemetry sample, shared by the SD log
+// (/datalog.gor) and the ground tools
+enum GorillaSampleChannel {
+    GS_UPTIME, GS_EPOCH,
+    GS_VIN, GS_IIN, GS_PIN, GS_VOUT, GS_IOUT, GS_POUT, GS_EFF,
+    GS_BATT_SOC, GS_ADC_SOC, GS_LOGIC0, GS_LOGIC1, GS_LOGIC2, GS_LOGIC3,
+    GS_LAT, GS_LNG, // int32, 1e-7 deg
+    GS_ADC0, GS_ADC1, GS_ADC2, GS_ADC3,
+    GS_SATS, GS_FRESH, GS_MODE,
+    GS_COUNT
+};
+
+extern const GorillaType GORILLA_SAMPLE_TYPES[GS_COUNT];
+extern const char* const GORILLA_SAMPLE_NAMES[GS_COUNT];
+
+#endif
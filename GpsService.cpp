@@ -0,0 +1,174 @@
+#include "GpsService.h"
+#include "Metrics.h"
+#include "SystemClock.h"
+
+// A multi-GNSS receiver sends one GSV series per constellation, each
+// counting only its own satellites
+static const char* const GSV_SENTENCES[GPS_GSV_TALKERS] = {"GPGSV", "GLGSV", "GAGSV", "GBGSV", "GNGSV"};
+
+GpsService::GpsService()
+    : serial(1), taskHandle(NULL), fixSeq(0),
+      nmeaLen(0), rateSentences(0), rateStartMs(0) {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    for (int i = 0; i < GPS_GSV_TALKERS; i++) {
+        satsInView[i].begin(gps, GSV_SENTENCES[i], 3);
+        inViewBy[i] = 0;
+    }
+    memset(&fix, 0, sizeof(fix));
+    memset(&stats, 0, sizeof(stats));
+    nmeaSentence[0] = '\0';
+}
+
+void GpsService::begin() {
+    serial.setRxBufferSize(GPS_RX_BUFFER_SIZE); // Must precede begin()
+    serial.begin(GPS_BAUD, SERIAL_8N1, GPS_RX_PIN, GPS_TX_PIN);
+    serial.setRxFIFOFull(GPS_RX_FIFO_FULL);
+
+    rateStartMs = millis();
+    xTaskCreatePinnedToCore(GpsService::task, "GpsTask", 3072, this, 3, &taskHandle, 0);
+    metrics.setTask(MTASK_GPS, taskHandle);
+
+    // Both callbacks run in the UART driver's event task
+    serial.onReceive([this]() {
+        if (taskHandle) xTaskNotifyGive(taskHandle);
+    });
+    serial.onReceiveError([this](hardwareSerial_error_t err) {
+        onUartError(err);
+    });
+}
+
+void GpsService::task(void* param) {
+    GpsService* self = (GpsService*)param;
+    for (;;) {
+        // Woken per RX event; the timeout only bounds the sentence-rate update
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        uint32_t start = Metrics::cycles();
+        self->drain();
+        metrics.stop(MT_GPS_RX, start);
+    }
+}
+
+void GpsService::drain() {
+    uint32_t n = 0;
+    while (serial.available()) {
+        ingest((char)serial.read());
+        n++;
+    }
+
+    portENTER_CRITICAL(&lock);
+    stats.bytes += n;
+    stats.checksumFailures = gps.failedChecksum();
+    unsigned long now = millis();
+    if (now - rateStartMs >= 1000) {
+        stats.sentenceRate = rateSentences * 1000.0f / (now - rateStartMs);
+        rateSentences = 0;
+        rateStartMs = now;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void GpsService::ingest(char c) {
+    gps.encode(c);
+
+    // Assemble the raw sentence to recognize RMC below
+    if (c == '$') nmeaLen = 0;
+    if (c != '\r' && c != '\n') {
+        if (nmeaLen < GPS_NMEA_MAX) nmeaSentence[nmeaLen++] = c;
+        return;
+    }
+    if (nmeaLen == 0) return;
+    nmeaSentence[nmeaLen] = '\0';
+
+    // RMC carries the fix time; its arrival disciplines SystemClock.
+    // Stamped when the line is drained from the UART ring, so it jitters
+    // by up to one RX FIFO batch (~70 ms at 9600 baud)
+    if (nmeaLen >= 6 && !strncmp(nmeaSentence + 3, "RMC", 3) && gps.time.isUpdated() &&
+        gps.location.isValid() && gps.date.isValid() && gps.date.year() >= 2024) {
+        int64_t mono = SystemClock::monoUs();
+        uint32_t utc = SystemClock::epochFromCivil(gps.date.year(), gps.date.month(), gps.date.day(),
+                                                   gps.time.hour(), gps.time.minute(), gps.time.second());
+        int64_t ref = ((int64_t)utc + CLOCK_TZ_OFFSET_S) * 1000000 + gps.time.centisecond() * 10000 + CLOCK_GPS_LATENCY_US;
+        systemClock.discipline(CLOCK_SRC_GPS, ref, mono);
+    }
+
+    // Satellite counts come from GGA/GSV whether or not there is a fix, so
+    // they are published on their own; lat/lng/fixMs only move with a
+    // location update
+    bool located = gps.location.isUpdated();
+    bool counted = gps.satellites.isUpdated();
+    for (int i = 0; i < GPS_GSV_TALKERS; i++) {
+        if (satsInView[i].isUpdated()) {
+            inViewBy[i] = (uint8_t)atoi(satsInView[i].value());
+            counted = true;
+        }
+    }
+    double lat = 0.0, lng = 0.0;
+    bool valid = false;
+    if (located) {
+        lat = gps.location.lat();
+        lng = gps.location.lng();
+        valid = gps.location.isValid();
+    }
+    uint8_t used = 0, inView = 0;
+    if (located || counted) {
+        used = gps.satellites.isValid() ? gps.satellites.value() : 0;
+        unsigned sum = 0;
+        for (int i = 0; i < GPS_GSV_TALKERS; i++) sum += inViewBy[i];
+        inView = sum > UINT8_MAX ? UINT8_MAX : (uint8_t)sum;
+    }
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&lock);
+    stats.sentences++;
+    rateSentences++;
+    if (located) {
+        fix.lat = lat;
+        fix.lng = lng;
+        fix.fixMs = now ? now : 1;
+        fix.valid = valid;
+    }
+    if (located || counted) {
+        fix.satellites = used;
+        fix.satsInView = inView;
+        fixSeq++;
+    }
+    portEXIT_CRITICAL(&lock);
+    nmeaLen = 0;
+}
+
+void GpsService::onUartError(hardwareSerial_error_t err) {
+    portENTER_CRITICAL(&lock);
+    if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR) {
+        stats.overruns++;
+    } else if (err != UART_NO_ERROR) {
+        stats.uartErrors++;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+bool GpsService::getFix(GpsFix& out, uint32_t& seq) {
+    bool updated = false;
+    portENTER_CRITICAL(&lock);
+    if (fixSeq != seq) {
+        out = fix;
+        seq = fixSeq;
+        updated = true;
+    }
+    portEXIT_CRITICAL(&lock);
+    return updated;
+}
+
+bool GpsService::getLatestFix(GpsFix& out) {
+    portENTER_CRITICAL(&lock);
+    out = fix;
+    bool any = fixSeq != 0;
+    portEXIT_CRITICAL(&lock);
+    return any;
+}
+
+GpsStats GpsService::getStats() {
+    portENTER_CRITICAL(&lock);
+    GpsStats s = stats;
+    portEXIT_CRITICAL(&lock);
+    return s;
+}
@@ -0,0 +1,71 @@
+#ifndef GPS_SERVICE_H
+#define GPS_SERVICE_H
+
+#include "DataModel.h"
+#include <TinyGPS++.h>
+
+// GPS Pins
+#define GPS_RX_PIN 21 // GPS TX -> ESP RX
+#define GPS_TX_PIN 47 // GPS RX -> ESP TX
+
+#define GPS_BAUD           9600
+#define GPS_RX_BUFFER_SIZE 2048 // UART driver ring, ~2 s of NMEA at 9600 baud
+#define GPS_RX_FIFO_FULL   64   // Bytes in HW FIFO before the UART event fires
+#define GPS_NMEA_MAX       82   // Longest legal NMEA sentence incl. CR/LF
+#define GPS_GSV_TALKERS    5    // GP, GL, GA, GB, GN: one GSV series per constellation
+
+// Latest receiver state. Republished on every position update and on
+// every satellite count (GGA/GSV), so counts are known before the first fix.
+struct GpsFix {
+    double lat, lng;
+    uint32_t fixMs;     // millis() when the position last updated (0 = never)
+    uint8_t satellites; // Used in fix
+    uint8_t satsInView; // From GSV, summed over every constellation
+    bool valid;
+};
+
+struct GpsStats {
+    uint32_t bytes;
+    uint32_t sentences;        // Complete NMEA lines
+    uint32_t checksumFailures; // Reported by TinyGPS++
+    uint32_t overruns;         // UART FIFO / ring buffer overflows
+    uint32_t uartErrors;       // Framing, parity, break
+    float sentenceRate;        // Sentences/s over the last second
+};
+
+// Dedicated ingestion task: woken by UART RX events, it drains the driver
+// ring buffer into TinyGPS++ continuously instead of once per sample.
+class GpsService {
+public:
+    GpsService();
+    void begin();
+    bool getFix(GpsFix& out, uint32_t& seq); // true if a fix newer than `seq` exists
+    bool getLatestFix(GpsFix& out);          // false before anything was received
+    GpsStats getStats();
+
+private:
+    static void task(void* param);
+    void drain();
+    void ingest(char c);
+    void onUartError(hardwareSerial_error_t err);
+
+    HardwareSerial serial;
+    TinyGPSPlus gps;
+    TinyGPSCustom satsInView[GPS_GSV_TALKERS]; // GSV field 3: satellites in view, per talker
+    uint8_t inViewBy[GPS_GSV_TALKERS];         // Last count from each talker
+    TaskHandle_t taskHandle;
+    portMUX_TYPE lock;        // Guards fix, fixSeq and stats
+
+    GpsFix fix;
+    uint32_t fixSeq;
+    GpsStats stats;
+
+    // NMEA sentence assembly
+    char nmeaSentence[GPS_NMEA_MAX + 1];
+    size_t nmeaLen;
+
+    uint32_t rateSentences;
+    unsigned long rateStartMs;
+};
+
+#endif
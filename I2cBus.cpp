@@ -0,0 +1,221 @@
+#include "I2cBus.h"
+#include <string.h>
+
+void I2cTxn::readReg(uint8_t d, uint8_t p, uint8_t reg, uint8_t n) {
+    memset(this, 0, sizeof(*this));
+    dev = d;
+    prio = p;
+    tx[0] = reg;
+    txLen = 1;
+    rxLen = n > I2C_TXN_MAX ? I2C_TXN_MAX : n;
+}
+
+void I2cTxn::write(uint8_t d, uint8_t p, const uint8_t* data, uint8_t len) {
+    memset(this, 0, sizeof(*this));
+    dev = d;
+    prio = p;
+    txLen = len > I2C_TXN_MAX ? I2C_TXN_MAX : len;
+    memcpy(tx, data, txLen);
+}
+
+void I2cTxn::invoke(uint8_t d, uint8_t p, bool (*fn)(void*), void* fnArg) {
+    memset(this, 0, sizeof(*this));
+    dev = d;
+    prio = p;
+    call = fn;
+    arg = fnArg;
+}
+
+I2cBus::I2cBus() : port(nullptr), deviceCount(0), clockHz(0), timeoutMs(0), stuckUntilUs(0) {
+    memset(devices, 0, sizeof(devices));
+    memset(deviceStats, 0, sizeof(deviceStats));
+    memset(head, 0, sizeof(head));
+    memset(tail, 0, sizeof(tail));
+    memset(&stats, 0, sizeof(stats));
+}
+
+void I2cBus::begin(I2cPort* p) {
+    port = p;
+}
+
+int I2cBus::addDevice(uint8_t addr, const char* name, uint32_t hz, uint16_t ms) {
+    if (deviceCount >= I2C_MAX_DEVICES) return -1;
+    I2cDevice& d = devices[deviceCount];
+    d.addr = addr;
+    d.name = name;
+    d.clockHz = hz;
+    d.timeoutMs = ms;
+    return deviceCount++;
+}
+
+bool I2cBus::submit(I2cTxn* t, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (t[i].dev >= deviceCount || t[i].prio >= I2C_PRIO_COUNT) return false;
+    }
+    int64_t now = port->nowUs();
+    port->lock();
+    for (size_t i = 0; i < n; i++) {
+        I2cTxn* x = &t[i];
+        x->result = I2C_PENDING;
+        x->attempts = 0;
+        x->queuedUs = now;
+        x->next = nullptr;
+        if (tail[x->prio]) tail[x->prio]->next = x;
+        else head[x->prio] = x;
+        tail[x->prio] = x;
+    }
+    stats.queued += n;
+    if (stats.queued > stats.queueMax) stats.queueMax = stats.queued;
+    port->unlock();
+    return true;
+}
+
+I2cTxn* I2cBus::dequeue() {
+    I2cTxn* t = nullptr;
+    port->lock();
+    for (int p = 0; p < I2C_PRIO_COUNT && !t; p++) {
+        t = head[p];
+        if (!t) continue;
+        head[p] = t->next;
+        if (!head[p]) tail[p] = nullptr;
+        stats.queued--;
+    }
+    port->unlock();
+    return t;
+}
+
+void I2cBus::select(const I2cDevice& d) {
+    if (d.clockHz != clockHz) {
+        port->setClock(d.clockHz);
+        if (clockHz) stats.clockSwitches++;
+        clockHz = d.clockHz;
+    }
+    if (d.timeoutMs != timeoutMs) {
+        port->setTimeout(d.timeoutMs);
+        timeoutMs = d.timeoutMs;
+    }
+}
+
+int I2cBus::attempt(I2cTxn* t, const I2cDevice& d) {
+    if (t->call) return t->call(t->arg) ? I2C_OK : I2C_ERR_BUS;
+    return port->transfer(d.addr, t->tx, t->txLen, t->rx, t->rxLen);
+}
+
+bool I2cBus::process() {
+    I2cTxn* t = dequeue();
+    if (!t) return false;
+
+    const I2cDevice& d = devices[t->dev];
+    I2cDeviceStats& s = deviceStats[t->dev];
+    select(d);
+
+    int64_t start = port->nowUs();
+    uint32_t nacks = 0, timeouts = 0;
+    int r = I2C_ERR_BUS;
+    bool usable = true;
+    if (stuckUntilUs) {
+        // Probe once the backoff has expired; until then don't touch the bus
+        usable = start >= stuckUntilUs && recover();
+    }
+    while (usable) {
+        r = attempt(t, d);
+        t->attempts++;
+        if (r == I2C_OK) break;
+        if (r == I2C_ERR_NACK_ADDR || r == I2C_ERR_NACK_DATA) nacks++;
+        if (r == I2C_ERR_TIMEOUT) timeouts++;
+        // A hung bus fails every later transaction too, so clear it even
+        // when this one is out of attempts
+        if (r == I2C_ERR_TIMEOUT || r == I2C_ERR_BUS) usable = recover();
+        if (t->attempts > I2C_RETRIES) break;
+    }
+    if (usable) {
+        stuckUntilUs = 0;
+    } else if (!stuckUntilUs || start >= stuckUntilUs) {
+        stuckUntilUs = port->nowUs() + I2C_STUCK_BACKOFF_US;
+    }
+
+    int64_t end = port->nowUs();
+    uint32_t latencyUs = (uint32_t)(end - t->queuedUs);
+    uint32_t busUs = (uint32_t)(end - start);
+    port->lock();
+    s.txns++;
+    if (r != I2C_OK) s.errors++;
+    s.nacks += nacks;
+    s.timeouts += timeouts;
+    if (t->attempts) s.retries += t->attempts - 1;
+    else stats.shed++;
+    s.latencySumUs += latencyUs;
+    s.busSumUs += busUs;
+    if (latencyUs > s.latencyMaxUs) s.latencyMaxUs = latencyUs;
+    if (busUs > s.busMaxUs) s.busMaxUs = busUs;
+    port->unlock();
+
+    t->result = (uint8_t)r;
+    if (t->done) t->done(t); // May release `t` to its owner
+    return true;
+}
+
+bool I2cBus::recover() {
+    if (port->scl() && port->sda()) {
+        // Lines idle: the fault is in the controller
+        port->release();
+        port->attach();
+        port->lock();
+        stats.resets++;
+        port->unlock();
+        return true;
+    }
+
+    port->release();
+    // A slave may still be stretching the clock; nothing can be done
+    // about SCL held low except waiting for it
+    int64_t t0 = port->nowUs();
+    while (!port->scl()) {
+        if (port->nowUs() - t0 > I2C_STRETCH_MAX_US) {
+            port->attach();
+            port->lock();
+            stats.sclStuck++;
+            port->unlock();
+            return false;
+        }
+        port->delayUs(100);
+    }
+
+    // A slave interrupted mid-read holds SDA low until it has shifted out
+    // the rest of its byte; clock it out, then STOP resets its state machine
+    uint32_t pulses = 0;
+    while (!port->sda() && pulses < I2C_RECOVERY_PULSES) {
+        port->pulse();
+        pulses++;
+    }
+    bool ok = port->sda();
+    if (ok) port->stop();
+    port->attach();
+
+    port->lock();
+    if (!ok) stats.recoveryFailures++;
+    else if (pulses) stats.recoveries++;
+    else stats.resets++;
+    stats.recoveryPulses += pulses;
+    port->unlock();
+    return ok;
+}
+
+I2cDeviceStats I2cBus::getDeviceStats(int i) {
+    port->lock();
+    I2cDeviceStats s = deviceStats[i];
+    port->unlock();
+    return s;
+}
+
+I2cBusStats I2cBus::getStats() {
+    port->lock();
+    I2cBusStats s = stats;
+    port->unlock();
+    return s;
+}
+
+const char* I2cBus::resultName(uint8_t r) {
+    static const char* const names[] = {"ok", "pending", "nack_addr", "nack_data", "timeout", "bus"};
+    return r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
@@ -0,0 +1,170 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+// Transaction queue, per-device clock, stuck-bus recovery and per-device
+// stats for one shared I2C bus.
+// Plain C++ with the hardware behind I2cPort: the firmware runs it on
+// I2cTask over Wire (I2cService), the ground tools over a simulated bus
+// with injected faults (tools/ground/i2c_sim).
+//
+// Drivers submit I2cTxn records into one of I2C_PRIO_COUNT FIFOs; the
+// owner calls process() to run the oldest transaction of the highest
+// non-empty priority. Before each transfer the bus switches to the
+// device's clock and timeout. A failed transfer is retried up to
+// I2C_RETRIES times; timeouts and bus errors first go through recover():
+//   - both lines high: controller reset only
+//   - SCL low (clock stretch): wait up to I2C_STRETCH_MAX_US for release
+//   - SDA low (slave stuck mid-byte): up to 9 SCL pulses, then STOP
+// If the bus cannot be freed, transactions fail immediately for
+// I2C_STUCK_BACKOFF_US instead of each waiting out its timeout.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define I2C_MAX_DEVICES     8
+#define I2C_TXN_MAX         8     // Inline tx/rx bytes per transaction
+#define I2C_RETRIES         1     // Extra attempts after a failed transfer
+#define I2C_STRETCH_MAX_US  25000 // SCL low longer than this = stuck (SMBus tLOW:SEXT)
+#define I2C_RECOVERY_PULSES 9     // Enough to clock out any byte plus its ACK
+#define I2C_STUCK_BACKOFF_US 1000000 // Fail fast this long after a failed recovery
+
+enum I2cPriority {
+    I2C_PRIO_HIGH,   // Sample-rate reads (power monitors)
+    I2C_PRIO_NORMAL,
+    I2C_PRIO_LOW,    // Housekeeping (RTC)
+    I2C_PRIO_COUNT
+};
+
+enum I2cResult {
+    I2C_OK,
+    I2C_PENDING,        // Queued or running
+    I2C_ERR_NACK_ADDR,  // No device answered
+    I2C_ERR_NACK_DATA,
+    I2C_ERR_TIMEOUT,    // Includes clock stretching past the device timeout
+    I2C_ERR_BUS         // Arbitration lost, controller fault, failed call, bus stuck
+};
+
+// Hardware access. Line levels are read while the controller is attached;
+// release()/pulse()/stop() drive the lines as open-drain GPIO.
+class I2cPort {
+public:
+    virtual ~I2cPort() {}
+    // Write `tx`, then read `rxLen` bytes after a repeated start (none if 0)
+    virtual int transfer(uint8_t addr, const uint8_t* tx, uint8_t txLen, uint8_t* rx, uint8_t rxLen) = 0;
+    virtual void setClock(uint32_t hz) = 0;
+    virtual void setTimeout(uint16_t ms) = 0;
+
+    virtual bool scl() = 0; // true = high
+    virtual bool sda() = 0;
+    virtual void release() = 0; // Detach the controller, both lines released
+    virtual void pulse() = 0;   // One SCL clock at <= 100 kHz
+    virtual void stop() = 0;    // STOP condition
+    virtual void attach() = 0;  // Re-initialize the controller
+
+    virtual int64_t nowUs() = 0;
+    virtual void delayUs(uint32_t us) = 0;
+
+    // Guards the queue and stats between submitting tasks and the owner
+    virtual void lock() {}
+    virtual void unlock() {}
+};
+
+struct I2cTxn {
+    uint8_t dev;   // From I2cBus::addDevice
+    uint8_t prio;  // I2cPriority
+    uint8_t txLen;
+    uint8_t rxLen;
+    uint8_t tx[I2C_TXN_MAX];
+    uint8_t rx[I2C_TXN_MAX];
+    // Set instead of tx/rx to run a library driver while the bus is owned
+    // at the device's clock; returns false on failure
+    bool (*call)(void* arg);
+    // Runs on the owner after completion; keep it short
+    void (*done)(I2cTxn* t);
+    void* arg;                 // For call
+    void* user;                // For done
+    volatile uint8_t result;   // I2cResult, I2C_PENDING until done
+    uint8_t attempts;
+    int64_t queuedUs;
+    I2cTxn* next;              // Queue link
+
+    // Register read: write `reg`, read `rxLen` bytes
+    void readReg(uint8_t d, uint8_t p, uint8_t reg, uint8_t rxLen);
+    // Plain write of `len` bytes
+    void write(uint8_t d, uint8_t p, const uint8_t* data, uint8_t len);
+    void invoke(uint8_t d, uint8_t p, bool (*fn)(void*), void* fnArg);
+};
+
+struct I2cDevice {
+    uint8_t addr;
+    const char* name;   // Metrics label
+    uint32_t clockHz;   // Fastest the device supports
+    uint16_t timeoutMs; // Per transfer
+};
+
+struct I2cDeviceStats {
+    uint32_t txns;         // Completed, failed or not
+    uint32_t errors;       // Transactions that failed after all attempts
+    uint32_t nacks;        // Per attempt
+    uint32_t timeouts;     // Per attempt
+    uint32_t retries;
+    uint32_t latencyMaxUs; // Submit → done, includes queueing
+    uint32_t busMaxUs;     // First attempt → done
+    uint64_t latencySumUs; // May tear when read from another core; fine for monitoring
+    uint64_t busSumUs;
+};
+
+struct I2cBusStats {
+    uint32_t resets;           // Controller re-initialized with idle lines
+    uint32_t recoveries;       // SDA released by clocking
+    uint32_t recoveryFailures; // SDA still low after I2C_RECOVERY_PULSES
+    uint32_t recoveryPulses;
+    uint32_t sclStuck;         // SCL held low past I2C_STRETCH_MAX_US
+    uint32_t shed;             // Transactions failed fast while the bus was stuck
+    uint32_t clockSwitches;
+    uint32_t queued;           // Transactions waiting right now
+    uint32_t queueMax;
+};
+
+class I2cBus {
+public:
+    I2cBus();
+    void begin(I2cPort* port);
+    int addDevice(uint8_t addr, const char* name, uint32_t clockHz, uint16_t timeoutMs); // Id, or -1 when full
+
+    // Queues `n` consecutive transactions in one step, so a batch of the
+    // same priority runs back to back. Any task. False (nothing queued)
+    // on an unknown device.
+    bool submit(I2cTxn* t, size_t n = 1);
+
+    // Owner side: runs one transaction; false when every queue is empty
+    bool process();
+
+    int getDeviceCount() const { return deviceCount; }
+    const I2cDevice& getDevice(int i) const { return devices[i]; }
+    I2cDeviceStats getDeviceStats(int i);
+    I2cBusStats getStats();
+
+    static const char* resultName(uint8_t r);
+
+private:
+    I2cTxn* dequeue();
+    int attempt(I2cTxn* t, const I2cDevice& d);
+    void select(const I2cDevice& d);
+    bool recover();
+
+    I2cPort* port;
+    I2cDevice devices[I2C_MAX_DEVICES];
+    I2cDeviceStats deviceStats[I2C_MAX_DEVICES];
+    int deviceCount;
+
+    I2cTxn* head[I2C_PRIO_COUNT];
+    I2cTxn* tail[I2C_PRIO_COUNT];
+
+    uint32_t clockHz;   // Currently programmed, 0 = none yet
+    uint16_t timeoutMs;
+    int64_t stuckUntilUs; // Fail fast until then, 0 = bus usable
+    I2cBusStats stats;
+};
+
+#endif
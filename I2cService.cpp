@@ -0,0 +1,131 @@
+#include "I2cService.h"
+#include "Metrics.h"
+#include "esp_timer.h"
+
+WirePort::WirePort(TwoWire& w) : wire(w), sdaPin(-1), sclPin(-1), clockHz(100000), timeoutMs(50) {
+    mux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+int WirePort::transfer(uint8_t addr, const uint8_t* tx, uint8_t txLen, uint8_t* rx, uint8_t rxLen) {
+    int64_t start = nowUs();
+    wire.beginTransmission(addr);
+    wire.write(tx, txLen);
+    // Without a STOP the write is held back and sent with the read as one
+    // repeated-start transaction
+    uint8_t err = wire.endTransmission(rxLen == 0);
+    switch (err) {
+        case 0: break;
+        case 2: return I2C_ERR_NACK_ADDR;
+        case 3: return I2C_ERR_NACK_DATA;
+        case 5: return I2C_ERR_TIMEOUT;
+        default: return I2C_ERR_BUS;
+    }
+    if (rxLen == 0) return I2C_OK;
+
+    if (wire.requestFrom(addr, rxLen) != rxLen) {
+        // Wire reports no cause for a failed read; a NACK ends within a
+        // few bytes, a timeout only after timeoutMs
+        return nowUs() - start >= (int64_t)timeoutMs * 1000 ? I2C_ERR_TIMEOUT : I2C_ERR_NACK_ADDR;
+    }
+    for (uint8_t i = 0; i < rxLen; i++) rx[i] = wire.read();
+    return I2C_OK;
+}
+
+void WirePort::setClock(uint32_t hz) {
+    clockHz = hz;
+    wire.setClock(hz);
+}
+
+void WirePort::setTimeout(uint16_t ms) {
+    timeoutMs = ms;
+    wire.setTimeOut(ms);
+}
+
+void WirePort::release() {
+    wire.end();
+    digitalWrite(sdaPin, HIGH);
+    digitalWrite(sclPin, HIGH);
+    pinMode(sdaPin, OUTPUT_OPEN_DRAIN);
+    pinMode(sclPin, OUTPUT_OPEN_DRAIN);
+}
+
+// 5 µs half periods: 100 kHz, which every device on the bus accepts
+void WirePort::pulse() {
+    digitalWrite(sclPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sclPin, HIGH);
+    delayMicroseconds(5);
+}
+
+void WirePort::stop() {
+    digitalWrite(sclPin, LOW);
+    digitalWrite(sdaPin, LOW);
+    delayMicroseconds(5);
+    digitalWrite(sclPin, HIGH);
+    delayMicroseconds(5);
+    digitalWrite(sdaPin, HIGH); // SDA rising while SCL is high
+    delayMicroseconds(5);
+}
+
+void WirePort::attach() {
+    wire.begin(sdaPin, sclPin, clockHz);
+    wire.setTimeOut(timeoutMs);
+}
+
+int64_t WirePort::nowUs() {
+    return esp_timer_get_time();
+}
+
+I2cService::I2cService(TwoWire& wire) : port(wire), taskHandle(NULL) {
+}
+
+void I2cService::begin(int sda, int scl) {
+    port.setPins(sda, scl);
+    port.attach();
+    bus.begin(&port);
+    xTaskCreatePinnedToCore(I2cService::task, "I2cTask", I2C_TASK_STACK, this, I2C_TASK_PRIO, &taskHandle, 0);
+    metrics.setTask(MTASK_I2C, taskHandle);
+}
+
+void I2cService::task(void* param) {
+    I2cService* self = (I2cService*)param;
+    for (;;) {
+        while (self->bus.process()) {
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+bool I2cService::submit(I2cTxn* t, size_t n) {
+    if (!bus.submit(t, n)) return false;
+    xTaskNotifyGive(taskHandle);
+    return true;
+}
+
+void I2cService::wake(I2cTxn* t) {
+    xSemaphoreGive((SemaphoreHandle_t)t->user);
+}
+
+bool I2cService::run(I2cTxn* t, size_t n) {
+    if (n == 0) return true;
+    // The batch is one FIFO run, so the last entry finishes last
+    StaticSemaphore_t semBuf;
+    SemaphoreHandle_t sem = xSemaphoreCreateBinaryStatic(&semBuf);
+    t[n - 1].done = I2cService::wake;
+    t[n - 1].user = sem;
+    bool queued = submit(t, n);
+    if (queued) xSemaphoreTake(sem, portMAX_DELAY); // Each attempt is bounded by the device timeout
+    vSemaphoreDelete(sem);
+    if (!queued) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (t[i].result != I2C_OK) return false;
+    }
+    return true;
+}
+
+bool I2cService::call(int dev, uint8_t prio, bool (*fn)(void*), void* arg) {
+    if (dev < 0) return false;
+    I2cTxn t;
+    t.invoke((uint8_t)dev, prio, fn, arg);
+    return run(&t);
+}
@@ -0,0 +1,73 @@
+#ifndef I2C_SERVICE_H
+#define I2C_SERVICE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "I2cBus.h"
+
+// I2cTask owns the controller and runs every transaction on the shared
+// bus (see I2cBus.h); drivers never call Wire directly. It sits above its
+// clients so a queued batch starts as soon as SensorTask blocks on it.
+#define I2C_TASK_PRIO  4
+#define I2C_TASK_STACK 3072
+
+// I2cPort over the Arduino Wire driver, with bit-banged recovery on the
+// same pins
+class WirePort : public I2cPort {
+public:
+    WirePort(TwoWire& wire);
+    void setPins(int sda, int scl) { sdaPin = sda; sclPin = scl; }
+
+    int transfer(uint8_t addr, const uint8_t* tx, uint8_t txLen, uint8_t* rx, uint8_t rxLen) override;
+    void setClock(uint32_t hz) override;
+    void setTimeout(uint16_t ms) override;
+    bool scl() override { return digitalRead(sclPin) == HIGH; }
+    bool sda() override { return digitalRead(sdaPin) == HIGH; }
+    void release() override;
+    void pulse() override;
+    void stop() override;
+    void attach() override;
+    int64_t nowUs() override;
+    void delayUs(uint32_t us) override { delayMicroseconds(us); }
+    void lock() override { portENTER_CRITICAL(&mux); }
+    void unlock() override { portEXIT_CRITICAL(&mux); }
+
+private:
+    TwoWire& wire;
+    int sdaPin;
+    int sclPin;
+    uint32_t clockHz;
+    uint16_t timeoutMs;
+    portMUX_TYPE mux;
+};
+
+class I2cService {
+public:
+    I2cService(TwoWire& wire = Wire);
+    void begin(int sda, int scl);
+    int addDevice(uint8_t addr, const char* name, uint32_t clockHz, uint16_t timeoutMs) {
+        return bus.addDevice(addr, name, clockHz, timeoutMs);
+    }
+
+    // Asynchronous: `done` runs on I2cTask
+    bool submit(I2cTxn* t, size_t n = 1);
+    // Queues a batch of one priority and blocks until all of it ran; one
+    // wake-up for the whole batch. Overwrites the last entry's done/user.
+    // True if every transaction succeeded. Not from a done callback.
+    bool run(I2cTxn* t, size_t n = 1);
+    // Runs `fn` (a library driver using Wire) on I2cTask at the device's
+    // clock and blocks until it returns
+    bool call(int dev, uint8_t prio, bool (*fn)(void*), void* arg);
+
+    I2cBus& getBus() { return bus; } // Device table and stats
+
+private:
+    static void task(void* param);
+    static void wake(I2cTxn* t);
+
+    WirePort port;
+    I2cBus bus;
+    TaskHandle_t taskHandle;
+};
+
+#endif
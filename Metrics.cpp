@@ -0,0 +1,389 @@
+#include "Metrics.h"
+#include "SensorService.h"
+#include "TelemetryService.h"
+#include "MqttService.h"
+#include "SampleBus.h"
+#include "SystemClock.h"
+#include <stdarg.h>
+
+static const char* const TIMER_NAMES[MT_COUNT] = {
+    "sensor_run", "telemetry_sample", "gps_rx", "loop", "sample_age", "uplink_age", "sensor_lateness", "power_read"
+};
+
+static const char* const BOOT_NAMES[BOOT_COUNT] = {
+    "setup_done", "first_sample", "http_ready", "first_http", "wifi_up", "ntp_sync"
+};
+
+static const char* const TASK_NAMES[MTASK_COUNT] = {
+    "SensorTask", "TelemetryTask", "GpsTask", "MqttConnect", "loopTask", "I2cTask", "SerialTask"
+};
+
+Metrics::Metrics() : cpuMHz(0), sensors(nullptr), telemetry(nullptr), mqtt(nullptr), bus(nullptr) {
+    memset(hist, 0, sizeof(hist));
+    memset(tasks, 0, sizeof(tasks));
+    memset(bootUs, 0, sizeof(bootUs));
+}
+
+void Metrics::attach(SensorService* s, TelemetryService* t, MqttService* m, SampleBus* b) {
+    sensors = s;
+    telemetry = t;
+    mqtt = m;
+    bus = b;
+}
+
+void Metrics::setTask(MetricTask t, TaskHandle_t h) {
+    tasks[t] = h;
+}
+
+// CCOUNT is per core; every timed section runs on a pinned task, so start
+// and stop read the same counter. Wraps after ~17 s at 240 MHz.
+void Metrics::stop(MetricTimer t, uint32_t start) {
+    if (cpuMHz == 0) cpuMHz = ESP.getCpuFreqMHz();
+    observeUs(t, (cycles() - start) / cpuMHz);
+}
+
+void Metrics::markBoot(BootMilestone m) {
+    if (!bootUs[m]) bootUs[m] = SystemClock::monoUs();
+}
+
+// Bucket i counts values in (2^(i-1), 2^i] µs; the last one is +Inf
+void Metrics::observeUs(MetricTimer t, uint32_t us) {
+    int i = (us <= 1) ? 0 : 32 - __builtin_clz(us - 1);
+    if (i > METRICS_HIST_BUCKETS - 1) i = METRICS_HIST_BUCKETS - 1;
+    DurationHistogram& h = hist[t];
+    h.buckets[i]++;
+    h.count++;
+    h.sumUs += us;
+    if (us > h.maxUs) h.maxUs = us;
+}
+
+// Buffers lines into ~1 KB chunks for the sink
+class MetricsWriter {
+public:
+    explicit MetricsWriter(const MetricsSink& s) : sink(s), len(0) {}
+    ~MetricsWriter() { flush(); }
+
+    // Formats straight into the buffer; if the text does not fit in what is
+    // left, flushes and formats again into the empty buffer. Nothing is cut:
+    // a line longer than the whole buffer goes to the sink from the heap.
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vformat(fmt, ap);
+        va_end(ap);
+        if (n <= 0) return;
+        flush();
+        va_start(ap, fmt);
+        n = vformat(fmt, ap);
+        va_end(ap);
+        if (n <= 0) return;
+        char* big = (char*)malloc(n + 1);
+        if (big) {
+            va_start(ap, fmt);
+            vsnprintf(big, n + 1, fmt, ap);
+            va_end(ap);
+            sink(big, n);
+            free(big);
+        }
+    }
+    void flush() {
+        if (len) sink(buf, len);
+        len = 0;
+    }
+
+private:
+    // Appends when the whole text fits (vsnprintf needs room for the NUL).
+    // Returns 0 once appended, otherwise the length that did not fit.
+    int vformat(const char* fmt, va_list ap) {
+        size_t room = sizeof(buf) - len;
+        int n = vsnprintf(buf + len, room, fmt, ap);
+        if (n < 0) return 0;
+        if ((size_t)n >= room) return n;
+        len += n;
+        return 0;
+    }
+
+    const MetricsSink& sink;
+    char buf[1024];
+    size_t len;
+};
+
+static void gauge(MetricsWriter& w, const char* name, const char* help, uint32_t v) {
+    w.printf("# HELP %s %s\n", name, help);
+    w.printf("# TYPE %s gauge\n", name);
+    w.printf("%s %lu\n", name, (unsigned long)v);
+}
+
+static void counter(MetricsWriter& w, const char* name, const char* help, uint32_t v) {
+    w.printf("# HELP %s %s\n", name, help);
+    w.printf("# TYPE %s counter\n", name);
+    w.printf("%s %lu\n", name, (unsigned long)v);
+}
+
+template <typename F>
+static void i2cSeries(MetricsWriter& w, I2cBus& i2c, const char* name, const char* type, const char* help, F value) {
+    w.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    for (int i = 0; i < i2c.getDeviceCount(); i++) {
+        w.printf("%s{device=\"%s\"} %.10g\n", name, i2c.getDevice(i).name, (double)value(i2c.getDeviceStats(i)));
+    }
+}
+
+// Per-device series, then bus-wide recovery counters
+static void writeI2c(MetricsWriter& w, I2cBus& i2c) {
+    i2cSeries(w, i2c, "cubesat_i2c_transactions_total", "counter", "I2C transactions completed",
+              [](const I2cDeviceStats& s) { return s.txns; });
+    i2cSeries(w, i2c, "cubesat_i2c_failed_total", "counter", "I2C transactions failed after all attempts",
+              [](const I2cDeviceStats& s) { return s.errors; });
+    i2cSeries(w, i2c, "cubesat_i2c_nacks_total", "counter", "I2C attempts NACKed",
+              [](const I2cDeviceStats& s) { return s.nacks; });
+    i2cSeries(w, i2c, "cubesat_i2c_timeouts_total", "counter", "I2C attempts timed out (incl. clock stretching)",
+              [](const I2cDeviceStats& s) { return s.timeouts; });
+    i2cSeries(w, i2c, "cubesat_i2c_retries_total", "counter", "I2C attempts repeated after a failure",
+              [](const I2cDeviceStats& s) { return s.retries; });
+    i2cSeries(w, i2c, "cubesat_i2c_latency_seconds_sum", "counter", "I2C submit-to-done time, queueing included",
+              [](const I2cDeviceStats& s) { return s.latencySumUs * 1e-6; });
+    i2cSeries(w, i2c, "cubesat_i2c_latency_max_seconds", "gauge", "Longest I2C submit-to-done time",
+              [](const I2cDeviceStats& s) { return s.latencyMaxUs * 1e-6; });
+    i2cSeries(w, i2c, "cubesat_i2c_bus_seconds_sum", "counter", "I2C time on the bus, retries and recovery included",
+              [](const I2cDeviceStats& s) { return s.busSumUs * 1e-6; });
+    i2cSeries(w, i2c, "cubesat_i2c_bus_max_seconds", "gauge", "Longest I2C time on the bus",
+              [](const I2cDeviceStats& s) { return s.busMaxUs * 1e-6; });
+
+    I2cBusStats b = i2c.getStats();
+    counter(w, "cubesat_i2c_resets_total", "I2C controller resets with idle lines", b.resets);
+    counter(w, "cubesat_i2c_recoveries_total", "Stuck SDA released by clocking", b.recoveries);
+    counter(w, "cubesat_i2c_recovery_failures_total", "SDA still low after 9 clock pulses", b.recoveryFailures);
+    counter(w, "cubesat_i2c_scl_stuck_total", "SCL held low past the stretch limit", b.sclStuck);
+    counter(w, "cubesat_i2c_shed_total", "I2C transactions failed fast while the bus was stuck", b.shed);
+    counter(w, "cubesat_i2c_clock_switches_total", "I2C clock changes between devices", b.clockSwitches);
+    gauge(w, "cubesat_i2c_queue_max", "Most I2C transactions queued at once", b.queueMax);
+}
+
+void Metrics::writePrometheus(const MetricsSink& sink) {
+    MetricsWriter w(sink);
+
+    w.printf("# HELP cubesat_duration_seconds Timed sections per task\n"
+             "# TYPE cubesat_duration_seconds histogram\n");
+    for (int t = 0; t < MT_COUNT; t++) {
+        const DurationHistogram& h = hist[t];
+        uint32_t cumulative = 0;
+        for (int i = 0; i < METRICS_HIST_BUCKETS - 1; i++) {
+            cumulative += h.buckets[i];
+            w.printf("cubesat_duration_seconds_bucket{timer=\"%s\",le=\"%g\"} %lu\n",
+                     TIMER_NAMES[t], (double)(1UL << i) * 1e-6, (unsigned long)cumulative);
+        }
+        w.printf("cubesat_duration_seconds_bucket{timer=\"%s\",le=\"+Inf\"} %lu\n",
+                 TIMER_NAMES[t], (unsigned long)h.count);
+        w.printf("cubesat_duration_seconds_sum{timer=\"%s\"} %.6f\n", TIMER_NAMES[t], h.sumUs * 1e-6);
+        w.printf("cubesat_duration_seconds_count{timer=\"%s\"} %lu\n", TIMER_NAMES[t], (unsigned long)h.count);
+    }
+    w.printf("# HELP cubesat_duration_max_seconds Longest observed section\n"
+             "# TYPE cubesat_duration_max_seconds gauge\n");
+    for (int t = 0; t < MT_COUNT; t++) {
+        w.printf("cubesat_duration_max_seconds{timer=\"%s\"} %.6f\n", TIMER_NAMES[t], hist[t].maxUs * 1e-6);
+    }
+
+    w.printf("# HELP cubesat_task_stack_free_bytes Stack high-water mark (never used)\n"
+             "# TYPE cubesat_task_stack_free_bytes gauge\n");
+    for (int t = 0; t < MTASK_COUNT; t++) {
+        if (!tasks[t]) continue;
+        w.printf("cubesat_task_stack_free_bytes{task=\"%s\"} %lu\n",
+                 TASK_NAMES[t], (unsigned long)uxTaskGetStackHighWaterMark(tasks[t]));
+    }
+
+    gauge(w, "cubesat_uptime_seconds", "Time since boot", millis() / 1000);
+    w.printf("# HELP cubesat_boot_milestone_seconds Time from boot to each milestone (absent until reached)\n"
+             "# TYPE cubesat_boot_milestone_seconds gauge\n");
+    for (int m = 0; m < BOOT_COUNT; m++) {
+        if (!bootUs[m]) continue;
+        w.printf("cubesat_boot_milestone_seconds{milestone=\"%s\"} %.6f\n", BOOT_NAMES[m], bootUs[m] * 1e-6);
+    }
+    gauge(w, "cubesat_heap_free_bytes", "Free internal heap", ESP.getFreeHeap());
+    gauge(w, "cubesat_heap_min_free_bytes", "Lowest free heap since boot", ESP.getMinFreeHeap());
+    gauge(w, "cubesat_heap_largest_free_block_bytes", "Largest allocatable block (fragmentation)", ESP.getMaxAllocHeap());
+    gauge(w, "cubesat_psram_free_bytes", "Free PSRAM", ESP.getFreePsram());
+
+    ClockStats c = systemClock.getStats();
+    w.printf("# HELP cubesat_clock_source Source steering the wall clock\n# TYPE cubesat_clock_source gauge\n"
+             "cubesat_clock_source{source=\"%s\"} %d\n", SystemClock::sourceName(c.source), (int)c.source);
+    w.printf("# HELP cubesat_clock_drift_ppm Estimated crystal error (+ = fast)\n# TYPE cubesat_clock_drift_ppm gauge\n"
+             "cubesat_clock_drift_ppm %.3f\n", c.driftPpm);
+    w.printf("# HELP cubesat_clock_last_error_seconds Reference minus prediction at the last sync\n"
+             "# TYPE cubesat_clock_last_error_seconds gauge\ncubesat_clock_last_error_seconds %.6f\n", c.lastErrorUs * 1e-6);
+    w.printf("# HELP cubesat_clock_rtc_error_seconds RTC minus system clock at the last RTC read\n"
+             "# TYPE cubesat_clock_rtc_error_seconds gauge\ncubesat_clock_rtc_error_seconds %.6f\n", c.rtcErrorUs * 1e-6);
+    gauge(w, "cubesat_clock_sync_age_seconds", "Time since the last accepted sync", c.syncAgeS);
+    w.printf("# HELP cubesat_clock_syncs_total Accepted syncs per source\n# TYPE cubesat_clock_syncs_total counter\n");
+    for (int i = CLOCK_SRC_RTC; i < CLOCK_SRC_COUNT; i++) {
+        w.printf("cubesat_clock_syncs_total{source=\"%s\"} %lu\n", SystemClock::sourceName((ClockSource)i), (unsigned long)c.syncs[i]);
+    }
+    counter(w, "cubesat_clock_steps_total", "Syncs that stepped the wall clock", c.steps);
+
+    if (bus) {
+        counter(w, "cubesat_bus_published_total", "Samples published on the sample bus", bus->getPublished());
+        gauge(w, "cubesat_bus_capacity", "Sample bus ring slots", SAMPLE_BUS_SLOTS);
+        int n = bus->getSubscriberCount();
+        w.printf("# HELP cubesat_bus_lag Samples published but not yet read\n# TYPE cubesat_bus_lag gauge\n");
+        for (int i = 0; i < n; i++) {
+            SampleBusStats b = bus->getStats(i);
+            w.printf("cubesat_bus_lag{subscriber=\"%s\"} %lu\n", b.name, (unsigned long)b.lag);
+        }
+        w.printf("# HELP cubesat_bus_max_lag Peak lag since boot\n# TYPE cubesat_bus_max_lag gauge\n");
+        for (int i = 0; i < n; i++) {
+            SampleBusStats b = bus->getStats(i);
+            w.printf("cubesat_bus_max_lag{subscriber=\"%s\"} %lu\n", b.name, (unsigned long)b.maxLag);
+        }
+        w.printf("# HELP cubesat_bus_overruns_total Samples overwritten before the subscriber read them\n"
+                 "# TYPE cubesat_bus_overruns_total counter\n");
+        for (int i = 0; i < n; i++) {
+            SampleBusStats b = bus->getStats(i);
+            w.printf("cubesat_bus_overruns_total{subscriber=\"%s\"} %lu\n", b.name, (unsigned long)b.overruns);
+        }
+    }
+
+    if (sensors) {
+        GpsStats g = sensors->getGpsStats();
+        counter(w, "cubesat_gps_sentences_total", "NMEA sentences parsed", g.sentences);
+        counter(w, "cubesat_gps_checksum_failures_total", "NMEA checksum failures", g.checksumFailures);
+        counter(w, "cubesat_gps_uart_overruns_total", "GPS UART FIFO/buffer overruns", g.overruns);
+        counter(w, "cubesat_gps_uart_errors_total", "GPS UART framing/parity/break errors", g.uartErrors);
+        w.printf("# HELP cubesat_gps_sentence_rate NMEA sentences/s over the last second\n"
+                 "# TYPE cubesat_gps_sentence_rate gauge\ncubesat_gps_sentence_rate %.2f\n", g.sentenceRate);
+        GpsFix fix;
+        if (sensors->getGpsFix(fix)) {
+            gauge(w, "cubesat_gps_satellites_used", "Satellites used in the fix (GGA)", fix.satellites);
+            gauge(w, "cubesat_gps_satellites_in_view", "Satellites in view, all constellations (GSV)", fix.satsInView);
+            if (fix.fixMs) {
+                w.printf("# HELP cubesat_gps_fix_age_seconds Time since the position last updated\n"
+                         "# TYPE cubesat_gps_fix_age_seconds gauge\ncubesat_gps_fix_age_seconds %.3f\n",
+                         (millis() - fix.fixMs) * 1e-3);
+            }
+        }
+        counter(w, "cubesat_i2c_errors_total", "Failed INA226 transactions", sensors->getI2cErrors());
+        counter(w, "cubesat_power_alert_timeouts_total", "INA226 readings forced without a conversion-ready ALERT",
+                sensors->getPowerAlertTimeouts());
+        counter(w, "cubesat_adc_dma_overflows_total", "ADC DMA pool overruns", sensors->getAdcOverflows());
+        PowerTriggerStats pt = sensors->getPowerTrigger()->getStats();
+        counter(w, "cubesat_power_triggers_total", "Power-rail triggers that started a capture", pt.triggers);
+        counter(w, "cubesat_power_captures_total", "Power-rail captures frozen for MQTT/SD", pt.captures);
+        counter(w, "cubesat_power_triggers_suppressed_total", "Trigger hits during a capture, holdoff or held capture", pt.suppressed);
+        writeI2c(w, sensors->getI2cBus());
+        w.printf("# HELP cubesat_sensor_overruns_total Sampling periods skipped because a source ran late\n"
+                 "# TYPE cubesat_sensor_overruns_total counter\n");
+        for (int c = 0; c < SensorService::CH_COUNT; c++) {
+            SensorService::Channel ch = (SensorService::Channel)c;
+            w.printf("cubesat_sensor_overruns_total{channel=\"%s\"} %lu\n",
+                     SensorService::channelName(ch), (unsigned long)sensors->getOverruns(ch));
+        }
+    }
+
+    if (telemetry) {
+        SdLoggerStats sd = telemetry->getSdStats();
+        counter(w, "cubesat_sd_rows_dropped_total", "CSV rows refused because the log file is not open", sd.rowsDropped);
+        counter(w, "cubesat_sd_write_errors_total", "SD write errors", sd.writeErrors);
+        counter(w, "cubesat_sd_bytes_written_total", "Bytes handed to the SD card", sd.bytesWritten);
+        counter(w, "cubesat_sd_flushes_total", "Write-behind buffer flushes to the SD card", sd.flushCount);
+        w.printf("# HELP cubesat_sd_flush_last_seconds Latency of the most recent SD flush\n"
+                 "# TYPE cubesat_sd_flush_last_seconds gauge\ncubesat_sd_flush_last_seconds %.6f\n",
+                 sd.lastFlushUs * 1e-6);
+        w.printf("# HELP cubesat_sd_flush_max_seconds Longest SD flush\n"
+                 "# TYPE cubesat_sd_flush_max_seconds gauge\ncubesat_sd_flush_max_seconds %.6f\n",
+                 sd.maxFlushUs * 1e-6);
+        SerialSinkStats ss = telemetry->getSerialStats();
+        counter(w, "cubesat_serial_frames_total", "Sample frames written to Serial", ss.frames);
+        counter(w, "cubesat_serial_bytes_total", "Bytes written to Serial by SerialTask", ss.bytes);
+        counter(w, "cubesat_serial_dropped_total", "Sample frames dropped because the serial ring was full", ss.dropped);
+        counter(w, "cubesat_serial_dropped_bytes_total", "Bytes in dropped serial frames", ss.droppedBytes);
+        gauge(w, "cubesat_serial_queued_max_bytes", "Peak serial ring usage", ss.queuedMax);
+        w.printf("# HELP cubesat_serial_write_max_seconds Longest single UART write by SerialTask\n"
+                 "# TYPE cubesat_serial_write_max_seconds gauge\ncubesat_serial_write_max_seconds %.6f\n",
+                 ss.writeMaxUs * 1e-6);
+    }
+
+    if (mqtt) {
+        MqttLinkStats l = mqtt->getLinkStats();
+        BacklogStats b = mqtt->getBacklogStats();
+        counter(w, "cubesat_mqtt_connect_attempts_total", "Broker connect attempts", l.attempts);
+        counter(w, "cubesat_mqtt_connect_failures_total", "Failed broker connects", l.failures);
+        w.printf("# HELP cubesat_mqtt_connected_seconds_total Time the broker link has been up\n"
+                 "# TYPE cubesat_mqtt_connected_seconds_total counter\ncubesat_mqtt_connected_seconds_total %.3f\n",
+                 l.connectedMs * 1e-3);
+        w.printf("# HELP cubesat_mqtt_disconnected_seconds_total Time the broker link has been down or connecting\n"
+                 "# TYPE cubesat_mqtt_disconnected_seconds_total counter\ncubesat_mqtt_disconnected_seconds_total %.3f\n",
+                 l.disconnectedMs * 1e-3);
+        w.printf("# HELP cubesat_mqtt_connect_last_seconds Duration of the most recent connect attempt\n"
+                 "# TYPE cubesat_mqtt_connect_last_seconds gauge\ncubesat_mqtt_connect_last_seconds %.3f\n",
+                 l.lastAttemptMs * 1e-3);
+        w.printf("# HELP cubesat_mqtt_backoff_seconds Current reconnect backoff window\n"
+                 "# TYPE cubesat_mqtt_backoff_seconds gauge\ncubesat_mqtt_backoff_seconds %.3f\n",
+                 l.backoffMs * 1e-3);
+        gauge(w, "cubesat_mqtt_backlog_entries", "Samples waiting for the broker (RAM + SD)", b.entries + b.spilled);
+        counter(w, "cubesat_mqtt_backlog_dropped_total", "Backlogged samples lost to the drop policy", b.dropped);
+        MqttBatchStats m = mqtt->getBatchStats();
+        counter(w, "cubesat_mqtt_messages_total", "Telemetry batches published", m.messages);
+        counter(w, "cubesat_mqtt_samples_total", "Samples in published batches", m.samples);
+        counter(w, "cubesat_mqtt_bytes_total", "Telemetry batch payload bytes", m.bytes);
+        counter(w, "cubesat_mqtt_batch_failures_total", "Batch publishes that failed", m.failures);
+        gauge(w, "cubesat_mqtt_batch_limit", "Current samples-per-batch limit", m.limit);
+    }
+}
+
+// Compact summary for cubesat/health; max durations only, the full
+// histograms are on /metrics
+size_t Metrics::encodeHealthJson(char* buf, size_t size) {
+    int n = snprintf(buf, size,
+        "{\"uptime\":%lu,\"heap\":%lu,\"heap_min\":%lu,\"heap_block\":%lu,\"psram\":%lu",
+        (unsigned long)(millis() / 1000), (unsigned long)ESP.getFreeHeap(), (unsigned long)ESP.getMinFreeHeap(),
+        (unsigned long)ESP.getMaxAllocHeap(), (unsigned long)ESP.getFreePsram());
+
+    n += snprintf(buf + n, n < (int)size ? size - n : 0, ",\"max_us\":{");
+    for (int t = 0; t < MT_COUNT; t++) {
+        n += snprintf(buf + n, n < (int)size ? size - n : 0, "%s\"%s\":%lu",
+                      t ? "," : "", TIMER_NAMES[t], (unsigned long)hist[t].maxUs);
+    }
+    n += snprintf(buf + n, n < (int)size ? size - n : 0, "},\"stack_free\":{");
+    bool first = true;
+    for (int t = 0; t < MTASK_COUNT; t++) {
+        if (!tasks[t]) continue;
+        n += snprintf(buf + n, n < (int)size ? size - n : 0, "%s\"%s\":%lu",
+                      first ? "" : ",", TASK_NAMES[t], (unsigned long)uxTaskGetStackHighWaterMark(tasks[t]));
+        first = false;
+    }
+    n += snprintf(buf + n, n < (int)size ? size - n : 0, "}");
+
+    ClockStats c = systemClock.getStats();
+    n += snprintf(buf + n, n < (int)size ? size - n : 0, ",\"clock\":\"%s\",\"drift_ppm\":%.2f",
+                  SystemClock::sourceName(c.source), c.driftPpm);
+
+    if (bus) {
+        uint32_t maxLag = 0, overruns = 0;
+        for (int i = 0; i < bus->getSubscriberCount(); i++) {
+            SampleBusStats b = bus->getStats(i);
+            if (b.maxLag > maxLag) maxLag = b.maxLag;
+            overruns += b.overruns;
+        }
+        n += snprintf(buf + n, n < (int)size ? size - n : 0, ",\"bus_max_lag\":%lu,\"bus_overruns\":%lu",
+                      (unsigned long)maxLag, (unsigned long)overruns);
+    }
+    if (sensors) {
+        GpsStats g = sensors->getGpsStats();
+        uint32_t sensorOverruns = 0;
+        for (int c = 0; c < SensorService::CH_COUNT; c++) {
+            sensorOverruns += sensors->getOverruns((SensorService::Channel)c);
+        }
+        n += snprintf(buf + n, n < (int)size ? size - n : 0,
+                      ",\"i2c_err\":%lu,\"gps_csum\":%lu,\"uart_ovr\":%lu,\"uart_err\":%lu,\"sensor_ovr\":%lu",
+                      (unsigned long)sensors->getI2cErrors(), (unsigned long)g.checksumFailures,
+                      (unsigned long)g.overruns, (unsigned long)g.uartErrors, (unsigned long)sensorOverruns);
+    }
+    if (mqtt) {
+        MqttLinkStats l = mqtt->getLinkStats();
+        n += snprintf(buf + n, n < (int)size ? size - n : 0,
+                      ",\"mqtt_attempts\":%lu,\"mqtt_failures\":%lu,\"mqtt_up_s\":%lu,\"mqtt_down_s\":%lu,"
+                      "\"mqtt_backoff_ms\":%lu",
+                      (unsigned long)l.attempts, (unsigned long)l.failures, (unsigned long)(l.connectedMs / 1000),
+                      (unsigned long)(l.disconnectedMs / 1000), (unsigned long)l.backoffMs);
+    }
+    n += snprintf(buf + n, n < (int)size ? size - n : 0, "}");
+    return (n > 0 && (size_t)n < size) ? n : 0; // 0 on overflow
+}
@@ -0,0 +1,88 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "DataModel.h"
+#include <functional>
+
+// Runtime instrumentation: duration histograms, task stack watermarks,
+// heap, queue and error counters. Exported as Prometheus text (/metrics)
+// and as a periodic MQTT health message.
+#define METRICS_HIST_BUCKETS  25       // le 1 µs, 2 µs … 2^23 µs (~8 s), +Inf
+#define HEALTH_INTERVAL_MS    30000
+#define HEALTH_TOPIC          "cubesat/health"
+#define HEALTH_JSON_MAX       768
+
+// Timed sections; each is recorded by exactly one task
+enum MetricTimer {
+    MT_SENSOR_RUN,       // SensorTask: one scheduler pass
+    MT_TELEMETRY_SAMPLE, // TelemetryTask: Serial + SD for one sample
+    MT_GPS_RX,           // GpsTask: one UART drain
+    MT_LOOP,             // Arduino loop(): web + MQTT
+    MT_SAMPLE_AGE,       // Stamp → TelemetryTask read from the bus
+    MT_UPLINK_AGE,       // Oldest sample in an MQTT batch → publish (loop task)
+    MT_SENSOR_LATENESS,  // SensorTask wake time minus its absolute deadline
+    MT_POWER_READ,       // SensorTask: I2C time for one INA226 pair reading
+    MT_COUNT
+};
+
+enum MetricTask {
+    MTASK_SENSOR, MTASK_TELEMETRY, MTASK_GPS, MTASK_MQTT_CONNECT, MTASK_LOOP, MTASK_I2C, MTASK_SERIAL,
+    MTASK_COUNT
+};
+
+// Boot milestones, stamped once each in µs since esp_timer started
+// (the ROM and bootloader before it are not included)
+enum BootMilestone {
+    BOOT_SETUP_DONE,   // setup() returned
+    BOOT_FIRST_SAMPLE, // First record on the sample bus
+    BOOT_HTTP_READY,   // Web server listening
+    BOOT_FIRST_HTTP,   // First HTTP response sent
+    BOOT_WIFI_UP,      // STA got an IP
+    BOOT_NTP_SYNC,     // First NTP sync reached SystemClock
+    BOOT_COUNT
+};
+
+struct DurationHistogram {
+    uint32_t buckets[METRICS_HIST_BUCKETS]; // Not cumulative
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t sumUs; // May tear when read from another core; fine for monitoring
+};
+
+class SensorService;
+class TelemetryService;
+class MqttService;
+class SampleBus;
+
+typedef std::function<void(const char* data, size_t len)> MetricsSink;
+
+class Metrics {
+public:
+    Metrics();
+    void attach(SensorService* s, TelemetryService* t, MqttService* m, SampleBus* b);
+    void setTask(MetricTask t, TaskHandle_t h);
+
+    // start = Metrics::cycles() at the beginning of the section
+    static uint32_t cycles() { return ESP.getCycleCount(); }
+    void stop(MetricTimer t, uint32_t start);
+    void observeUs(MetricTimer t, uint32_t us);
+    void markBoot(BootMilestone m); // Keeps the first call's time
+
+    void writePrometheus(const MetricsSink& sink);
+    size_t encodeHealthJson(char* buf, size_t size);
+
+private:
+    DurationHistogram hist[MT_COUNT];
+    TaskHandle_t tasks[MTASK_COUNT];
+    int64_t bootUs[BOOT_COUNT]; // 0 = not reached; one writer each
+    uint32_t cpuMHz;
+
+    SensorService* sensors;
+    TelemetryService* telemetry;
+    MqttService* mqtt;
+    SampleBus* bus;
+};
+
+extern Metrics metrics;
+
+#endif
@@ -1,106 +1,348 @@
 #include "MqttService.h"
+#include "TelemetryJson.h"
+#include "TelemetryFrame.h"
+#include "Metrics.h"
 
-MqttService::MqttService() : sensors(nullptr), lastPublishTime(0), client(espClient) {
+MqttService::MqttService()
+    : client(espClient), bus(nullptr), busSub(-1), powerTrigger(nullptr), lastPublishTime(0), batchTarget(MQTT_BATCH_MAX_SAMPLES), nextSeq(1), lastDrainMs(0), lastHealthMs(0), linkState(MQTT_LINK_DOWN),
+      nextAttemptMs(0), attemptStartMs(0), lastAccountMs(0), connectTaskHandle(NULL), connectResult(0) {
+    memset(&linkStats, 0, sizeof(linkStats));
+    memset(&batchStats, 0, sizeof(batchStats));
+    live.count = replay.count = 0;
+    linkStats.backoffMs = MQTT_BACKOFF_MIN_MS;
 }
 
-void MqttService::begin(SensorService* s) {
-    sensors = s;
+void MqttService::begin(SampleBus* b) {
+    bus = b;
 
 #if ENABLE_MQTT
 #if ENABLE_MQTT_TLS
     espClient.setInsecure(); // Bypass CA cert verification — uses encryption but skips validation
 #endif
     client.setServer(MQTT_BROKER, MQTT_PORT);
-    client.setBufferSize(512); // Increase buffer for large JSON payloads
+    client.setBufferSize(MQTT_BUFFER_SIZE); // Full batch (or JSON) + MQTT header and topic
     client.setCallback([this](char* topic, byte* payload, unsigned int length) {
         this->callback(topic, payload, length);
     });
+    client.setSocketTimeout((MQTT_CONNECT_TIMEOUT_MS + 999) / 1000); // CONNACK wait (s)
+    espClient.setTimeout(MQTT_CONNECT_TIMEOUT_MS);                  // TCP connect (ms)
+    lastAccountMs = millis();
+    backlog.begin();
+    busSub = bus ? bus->subscribe("mqtt") : -1;
+    xTaskCreatePinnedToCore(MqttService::connectTask, "MqttConnect", 4096, this, 1, &connectTaskHandle, 1);
+    metrics.setTask(MTASK_MQTT_CONNECT, connectTaskHandle);
     Serial.println("MqttService initialized. Waiting for WiFi...");
 #endif
 }
 
 bool MqttService::isConnected() {
-    return client.connected();
+    return linkState == MQTT_LINK_UP;
 }
 
-
 void MqttService::update() {
 #if ENABLE_MQTT
-    if (WiFi.status() == WL_CONNECTED) {
-        if (!client.connected()) {
-            reconnect();
-        }
+    updateLink();
+
+    if (linkState == MQTT_LINK_UP) {
         client.loop();
+    }
 
-        if (millis() - lastPublishTime >= PUBLISH_INTERVAL) {
-            if (currentSystemMode == MODE_SENSOR) {
-                publishTelemetry();
-            }
-            lastPublishTime = millis();
+    // Every sample passes through here and is queued for uplink whether or
+    // not the link is up (queueSample() backlogs it during outages).
+    // Decimation allows 10% jitter so a 1 s stream is not halved.
+    MeasurementData d;
+    while (bus && bus->read(busSub, d)) {
+        if (MQTT_SAMPLE_INTERVAL_MS &&
+            d.uptimeMs - lastPublishTime < MQTT_SAMPLE_INTERVAL_MS * 9 / 10) continue;
+        lastPublishTime = d.uptimeMs;
+        if (currentSystemMode == MODE_SENSOR) {
+            queueSample(d);
         }
     }
+    if (live.count && millis() - live.openedMs >= MQTT_BATCH_MAX_LATENCY_MS) {
+        flushLive();
+    }
+
+    // A frozen capture waits for the link; it is not backlogged
+    if (linkState == MQTT_LINK_UP && powerTrigger) {
+        publishCapture();
+    }
+
+    // Health is live-only: a stale snapshot is not worth backlogging
+    if (linkState == MQTT_LINK_UP && millis() - lastHealthMs >= HEALTH_INTERVAL_MS) {
+        lastHealthMs = millis();
+        publishHealth();
+    }
+
+    if (linkState == MQTT_LINK_UP && (!backlog.empty() || replay.count) &&
+        millis() - lastDrainMs >= BACKLOG_DRAIN_INTERVAL_MS) {
+        lastDrainMs = millis();
+        drainBacklog();
+    }
 #endif
 }
 
-void MqttService::reconnect() {
-    // Loop until we're reconnected
-    if (!client.connected()) {
-        Serial.print("Attempting MQTT connection...");
-        // Create a random client ID
-        String clientId = "ESP32S3Client-";
-        clientId += String(random(0xffff), HEX);
-        
-        // Attempt to connect
-        if (client.connect(clientId.c_str())) {
-            Serial.println("connected");
-            client.subscribe("cubesat/command");
+// Advances the connection state machine. Never blocks: the connect itself
+// runs on MqttConnect and the client is not touched while it is in flight.
+void MqttService::updateLink() {
+    unsigned long now = millis();
+    uint32_t elapsed = now - lastAccountMs;
+    lastAccountMs = now;
+    if (linkState == MQTT_LINK_UP) {
+        linkStats.connectedMs += elapsed;
+    } else {
+        linkStats.disconnectedMs += elapsed;
+    }
+
+    if (linkState == MQTT_LINK_CONNECTING) {
+        int result = connectResult.load();
+        if (result == 0) return; // Still in flight
+        linkStats.lastAttemptMs = now - attemptStartMs;
+        if (result > 0) {
+            linkState = MQTT_LINK_UP;
+            linkStats.backoffMs = MQTT_BACKOFF_MIN_MS;
+            Serial.printf("MQTT connected (%lu ms)\n", (unsigned long)linkStats.lastAttemptMs);
         } else {
-            Serial.print("failed, rc=");
-            Serial.print(client.state());
-            Serial.println(" try again in 5 seconds");
+            linkStats.failures++;
+            Serial.printf("MQTT connect failed, rc=%d\n", client.state());
+            scheduleRetry(true);
         }
+        return;
+    }
+
+    if (WiFi.status() != WL_CONNECTED) {
+        if (linkState == MQTT_LINK_UP) client.disconnect();
+        linkState = MQTT_LINK_DOWN;
+        return;
+    }
+
+    if (linkState == MQTT_LINK_UP) {
+        if (client.connected()) return;
+        Serial.println("MQTT connection lost");
+        scheduleRetry(false);
+        return;
+    }
+
+    if (linkState == MQTT_LINK_DOWN) {
+        nextAttemptMs = now; // WiFi just came up, try right away
+        linkState = MQTT_LINK_BACKOFF;
+    }
+
+    if ((long)(now - nextAttemptMs) >= 0 && connectTaskHandle) {
+        linkStats.attempts++;
+        attemptStartMs = now;
+        connectResult.store(0);
+        linkState = MQTT_LINK_CONNECTING;
+        xTaskNotifyGive(connectTaskHandle);
     }
 }
 
-void MqttService::publishTelemetry() {
-    if (!sensors || !client.connected()) return;
-
-    MeasurementData d = sensors->getLatestData();
-
-    auto safeNum = [](float v) { return (isnan(v) || isinf(v)) ? 0.0f : v; };
-
-    String j = "{";
-    j += "\"wifi_connected\":" + String(WiFi.status() == WL_CONNECTED ? "true" : "false") + ",";
-    j += "\"mqtt_connected\":true,"; // If we are here, MQTT is connected
-    j += "\"ts\":\"" + String(d.timestamp) + "\",";
-    j += "\"mode\":" + String(currentSystemMode) + ",";
-    j += "\"mode_str\":\"" + String(currentSystemMode == MODE_SENSOR ? "Sensor" : "Sleep") + "\",";
-    j += "\"vin\":" + String(safeNum(d.vin), 3) + ",";
-    j += "\"iin\":" + String(safeNum(d.iin), 6) + ",";
-    j += "\"pin\":" + String(safeNum(d.pin), 6) + ",";
-    j += "\"vout\":" + String(safeNum(d.vout), 3) + ",";
-    j += "\"iout\":" + String(safeNum(d.iout), 6) + ",";
-    j += "\"pout\":" + String(safeNum(d.pout), 6) + ",";
-    j += "\"eff\":" + String(safeNum(d.efficiency), 2) + ",";
-    j += "\"lat\":" + String(safeNum(d.lat), 6) + ",";
-    j += "\"lng\":" + String(safeNum(d.lng), 6) + ",";
-    j += "\"satellites\":" + String(d.satellites) + ",";
-    j += "\"batt_soc\":" + String(safeNum(d.battSoC), 2) + ",";
-    j += "\"adc_soc\":" + String(safeNum(d.adcSoC), 1) + ",";
-    j += "\"logic0\":" + String(d.logicLevels[0], 2) + ",";
-    j += "\"logic1\":" + String(d.logicLevels[1], 2) + ",";
-    j += "\"logic2\":" + String(d.logicLevels[2], 2) + ",";
-    j += "\"logic3\":" + String(d.logicLevels[3], 2) + ",";
-    j += "\"adc0\":" + String(d.adcValues[0]) + ",";
-    j += "\"adc1\":" + String(d.adcValues[1]) + ",";
-    j += "\"adc2\":" + String(d.adcValues[2]) + ",";
-    j += "\"adc3\":" + String(d.adcValues[3]);
-    j += "}";
-
-    if (client.publish(MQTT_TOPIC, j.c_str())) {
-        Serial.println("Published to " + String(MQTT_TOPIC));
+// Exponential backoff with jitter: wait a random time in [window/2, window],
+// doubling the window after each failure
+void MqttService::scheduleRetry(bool failed) {
+    if (failed) {
+        uint32_t next = linkStats.backoffMs * 2;
+        linkStats.backoffMs = (next > MQTT_BACKOFF_MAX_MS) ? MQTT_BACKOFF_MAX_MS : next;
     } else {
-        Serial.println("Publish failed");
+        linkStats.backoffMs = MQTT_BACKOFF_MIN_MS;
+    }
+    uint32_t half = linkStats.backoffMs / 2;
+    nextAttemptMs = millis() + half + random(half + 1);
+    linkState = MQTT_LINK_BACKOFF;
+}
+
+void MqttService::connectTask(void* param) {
+    MqttService* self = (MqttService*)param;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Create a random client ID
+        char clientId[24];
+        snprintf(clientId, sizeof(clientId), "ESP32S3Client-%lx", (unsigned long)random(0xffff));
+
+        // Blocking connect, bounded by MQTT_CONNECT_TIMEOUT_MS
+        bool ok = self->client.connect(clientId);
+        if (ok) {
+            self->client.subscribe("cubesat/command");
+        }
+        self->connectResult.store(ok ? 1 : -1);
+    }
+}
+
+#if ENABLE_MQTT_JSON
+static void fromFrame(const TelemetryFrame& f, MeasurementData& d) {
+    memset(&d, 0, sizeof(d));
+    d.epoch = f.epoch;
+    d.uptimeMs = f.uptimeMs;
+    d.lat = f.lat;
+    d.lng = f.lng;
+    d.vin = f.vin;
+    d.iin = f.iin;
+    d.pin = f.pin;
+    d.vinMin = f.vinMin;
+    d.vinMax = f.vinMax;
+    d.iinMin = f.iinMin;
+    d.iinMax = f.iinMax;
+    d.powerReads = f.powerReads;
+    d.vout = f.vout;
+    d.iout = f.iout;
+    d.pout = f.pout;
+    d.efficiency = f.efficiency;
+    d.battSoC = f.battSoC;
+    d.adcSoC = f.adcSoC;
+    for (int i = 0; i < 4; i++) {
+        d.logicLevels[i] = f.logicLevels[i];
+        d.adcValues[i] = f.adcValues[i];
+    }
+    d.satellites = f.satellites;
+    d.fresh = f.fresh;
+}
+#endif
+
+// Little-endian u32 at a TelemetryFrame offset (seq = 2, uptimeMs = 10)
+static uint32_t frameField32(const uint8_t* frame, size_t off) {
+    return (uint32_t)frame[off] | ((uint32_t)frame[off + 1] << 8) |
+           ((uint32_t)frame[off + 2] << 16) | ((uint32_t)frame[off + 3] << 24);
+}
+
+void MqttService::queueSample(const MeasurementData& d) {
+    bool up = linkState == MQTT_LINK_UP;
+    LinkStatus link = { WiFi.status() == WL_CONNECTED, up };
+    TelemetryFrame f;
+    toTelemetryFrame(d, link, currentSystemMode, nextSeq++, f);
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    encodeTelemetryFrame(frame, sizeof(frame), f);
+
+    // Batch live only when nothing older is waiting, to keep ordering
+    if (!up || !backlog.empty() || replay.count) {
+        backlog.push(f.seq, (const char*)frame, sizeof(frame));
+        return;
+    }
+    appendFrame(live, frame, d.uptimeMs);
+    if (live.count >= batchLimit()) {
+        flushLive();
+    }
+}
+
+void MqttService::appendFrame(Batch& b, const uint8_t* frame, uint32_t uptimeMs) {
+    if (b.count == 0) {
+        b.openedMs = millis();
+        b.oldestUptimeMs = uptimeMs;
+    }
+    memcpy(b.buf + TELEMETRY_BATCH_HEADER + (size_t)b.count * TELEMETRY_FRAME_SIZE, frame, TELEMETRY_FRAME_SIZE);
+    b.count++;
+}
+
+// Largest batch that fits the client buffer, scaled down by the AIMD
+// target after failures and capped further on a weak signal, where a lost
+// message costs more samples
+uint8_t MqttService::batchLimit() {
+    size_t overhead = 5 + 2 + strlen(MQTT_TOPIC_BIN) + TELEMETRY_BATCH_HEADER; // Fixed header, topic length, topic
+    size_t buffer = client.getBufferSize();
+    size_t fit = buffer > overhead ? (buffer - overhead) / TELEMETRY_FRAME_SIZE : 0;
+    size_t limit = fit < batchTarget ? fit : batchTarget;
+    if (WiFi.RSSI() < MQTT_WEAK_RSSI_DBM) limit /= 4;
+    if (limit < 1) limit = 1;
+    batchStats.limit = (uint16_t)limit;
+    return (uint8_t)limit;
+}
+
+// A live batch that cannot be sent goes to the backlog frame by frame
+void MqttService::flushLive() {
+    if (live.count == 0) return;
+    if (!publishBatch(live, true)) {
+        for (uint8_t i = 0; i < live.count; i++) {
+            const uint8_t* frame = live.buf + TELEMETRY_BATCH_HEADER + (size_t)i * TELEMETRY_FRAME_SIZE;
+            backlog.push(frameField32(frame, 2), (const char*)frame, TELEMETRY_FRAME_SIZE); // seq
+        }
+        Serial.printf("Batch publish failed, %u samples backlogged\n", (unsigned)live.count);
+    }
+    live.count = 0;
+}
+
+bool MqttService::publishBatch(Batch& b, bool isLive) {
+    if (linkState != MQTT_LINK_UP) return false;
+    writeTelemetryBatchHeader(b.buf, b.count, TELEMETRY_FRAME_SIZE);
+    size_t len = TELEMETRY_BATCH_HEADER + (size_t)b.count * TELEMETRY_FRAME_SIZE;
+    if (!client.publish(MQTT_TOPIC_BIN, b.buf, len)) {
+        batchStats.failures++;
+        batchTarget = batchTarget > 1 ? batchTarget / 2 : 1;
+        return false;
+    }
+    batchStats.messages++;
+    batchStats.samples += b.count;
+    batchStats.bytes += len;
+    if (batchTarget < MQTT_BATCH_MAX_SAMPLES) batchTarget++;
+    // Backlogged samples can be hours old; saturate instead of wrapping
+    uint64_t ageUs = (uint64_t)(millis() - b.oldestUptimeMs) * 1000;
+    metrics.observeUs(MT_UPLINK_AGE, ageUs > UINT32_MAX ? UINT32_MAX : (uint32_t)ageUs);
+
+#if ENABLE_MQTT_JSON
+    // JSON stays a one-document "latest sample" feed: the newest sample of
+    // each live batch, rebuilt from its frame (frame scaling is at least as
+    // fine as the JSON decimals)
+    if (isLive) {
+        TelemetryFrame f;
+        const uint8_t* last = b.buf + TELEMETRY_BATCH_HEADER + (size_t)(b.count - 1) * TELEMETRY_FRAME_SIZE;
+        if (decodeTelemetryFrame(last, TELEMETRY_FRAME_SIZE, f) == FRAME_OK) {
+            MeasurementData d;
+            fromFrame(f, d);
+            LinkStatus link = { (f.flags & TELEMETRY_FLAG_WIFI) != 0, (f.flags & TELEMETRY_FLAG_MQTT) != 0 };
+            char payload[TELEMETRY_JSON_MAX];
+            size_t n = encodeTelemetryJson(payload, sizeof(payload), d, link, (OperationMode)f.mode, f.seq);
+            if (n > 0) client.publish(MQTT_TOPIC, (const uint8_t*)payload, n);
+        }
+    }
+#endif
+    return true;
+}
+
+void MqttService::publishHealth() {
+    char payload[HEALTH_JSON_MAX];
+    size_t len = metrics.encodeHealthJson(payload, sizeof(payload));
+    if (len > 0) {
+        client.publish(HEALTH_TOPIC, (const uint8_t*)payload, len);
+    }
+}
+
+// Captures are larger than the client buffer, so they are streamed
+void MqttService::publishCapture() {
+    const uint8_t* data;
+    size_t len = powerTrigger->peek(CAPTURE_TO_MQTT, &data);
+    if (len == 0) return;
+    if (client.beginPublish(MQTT_TOPIC_CAPTURE, len, false) &&
+        client.write(data, len) == len &&
+        client.endPublish()) {
+        powerTrigger->release(CAPTURE_TO_MQTT);
+        Serial.printf("MQTT: capture published (%u bytes)\n", (unsigned)len);
+    }
+}
+
+// Replays backlogged samples oldest-first in batches, BACKLOG_DRAIN_BATCH
+// messages per step. Frames leave the backlog into `replay`, which is kept
+// and resent until the broker accepts it.
+void MqttService::drainBacklog() {
+    for (int i = 0; i < BACKLOG_DRAIN_BATCH; i++) {
+        uint8_t limit = batchLimit();
+        char frame[TELEMETRY_FRAME_SIZE];
+        while (replay.count < limit && !backlog.empty()) {
+            uint32_t seq;
+            size_t len = backlog.peek(frame, sizeof(frame), &seq);
+            if (len == TELEMETRY_FRAME_SIZE) {
+                appendFrame(replay, (const uint8_t*)frame, frameField32((const uint8_t*)frame, 10)); // uptimeMs
+                backlog.pop();
+            } else if (len > 0) {
+                backlog.discard(); // Not a frame; counted as dropped
+            } // len == 0: undeliverable entry already discarded and counted
+        }
+        if (replay.count == 0) break;
+        if (!publishBatch(replay, false)) {
+            return; // Retry on the next drain step
+        }
+        replay.count = 0;
+    }
+    if (backlog.empty() && replay.count == 0) {
+        Serial.printf("Backlog drained (%lu delivered)\n", (unsigned long)backlog.getStats().drained);
     }
 }
 
@@ -6,19 +6,84 @@
 #include <WiFiClientSecure.h>
 #include <PubSubClient.h>
 #include "DataModel.h"
-#include "SensorService.h"
+#include "SampleBus.h"
+#include "TelemetryBacklog.h"
+#include "TelemetryFrame.h"
+#include "PowerTrigger.h"
+#include <atomic>
+
+// Connection manager: attempts run on a worker task so update() never
+// blocks the Arduino loop (and with it the web server) while the broker
+// is unreachable
+#define MQTT_BACKOFF_MIN_MS     1000
+#define MQTT_BACKOFF_MAX_MS     60000
+#define MQTT_CONNECT_TIMEOUT_MS 3000  // TCP connect + CONNACK budget per attempt
+
+// Uplink batching: samples are packed into one TelemetryFrame batch per
+// message, sent when the batch is full or its oldest sample reaches the
+// latency budget
+#define MQTT_SAMPLE_INTERVAL_MS   0     // 0 = uplink every sample; else keep one per interval
+#define MQTT_BATCH_MAX_SAMPLES    32
+#define MQTT_BATCH_MAX_LATENCY_MS 5000
+#define MQTT_WEAK_RSSI_DBM        -75   // Weaker links get batches of a quarter the size
+#define MQTT_BATCH_BYTES  (TELEMETRY_BATCH_HEADER + MQTT_BATCH_MAX_SAMPLES * TELEMETRY_FRAME_SIZE)
+#define MQTT_BUFFER_SIZE  (MQTT_BATCH_BYTES + 64) // + MQTT header and topic; also covers TELEMETRY_JSON_MAX
+
+enum MqttLinkState {
+    MQTT_LINK_DOWN,       // WiFi not connected
+    MQTT_LINK_BACKOFF,    // Waiting for the next attempt
+    MQTT_LINK_CONNECTING, // Attempt in flight on the worker task
+    MQTT_LINK_UP
+};
+
+struct MqttLinkStats {
+    uint32_t attempts;
+    uint32_t failures;
+    uint32_t connectedMs;    // Cumulative time connected
+    uint32_t disconnectedMs; // Cumulative time not connected
+    uint32_t lastAttemptMs;  // Duration of the most recent attempt
+    uint32_t backoffMs;      // Current backoff window
+};
+
+struct MqttBatchStats {
+    uint32_t messages;  // Batches accepted by the client
+    uint32_t samples;   // Samples in those batches
+    uint32_t bytes;     // Payload bytes in those batches
+    uint32_t failures;  // Batch publishes that failed (samples backlogged/retried)
+    uint16_t limit;     // Current batch size limit (buffer, RSSI, failures)
+};
 
 class MqttService {
 public:
     MqttService();
-    void begin(SensorService* s);
+    void begin(SampleBus* b);
+    void setPowerTrigger(PowerTrigger* t) { powerTrigger = t; }
     void update();
     bool isConnected();
-
+    MqttLinkState getLinkState() const { return linkState; }
+    MqttLinkStats getLinkStats() const { return linkStats; }
+    BacklogStats getBacklogStats() const { return backlog.getStats(); }
+    MqttBatchStats getBatchStats() const { return batchStats; }
 
 private:
-    void reconnect();
-    void publishTelemetry();
+    static void connectTask(void* param);
+    void updateLink();
+    void scheduleRetry(bool failed);
+    struct Batch {
+        uint8_t buf[MQTT_BATCH_BYTES]; // Header + frames
+        uint8_t count;
+        unsigned long openedMs;        // millis() when the first frame went in
+        uint32_t oldestUptimeMs;       // Sample time of the first frame
+    };
+
+    void queueSample(const MeasurementData& d);
+    void appendFrame(Batch& b, const uint8_t* frame, uint32_t uptimeMs);
+    uint8_t batchLimit();
+    void flushLive();
+    bool publishBatch(Batch& b, bool isLive);
+    void drainBacklog();
+    void publishHealth();
+    void publishCapture();
     void callback(char* topic, byte* payload, unsigned int length);
 
 #if ENABLE_MQTT_TLS
@@ -28,9 +93,31 @@ private:
 #endif
 
     PubSubClient client;
-    SensorService* sensors;
-    unsigned long lastPublishTime;
-    const unsigned long PUBLISH_INTERVAL = 5000; // Publish every 5 seconds
+    SampleBus* bus;
+    int busSub;
+    PowerTrigger* powerTrigger; // Frozen captures go out on MQTT_TOPIC_CAPTURE
+    uint32_t lastPublishTime; // uptimeMs of the last sample queued for uplink
+
+    // Batching (owned by the loop task)
+    Batch live;     // Filling with new samples
+    Batch replay;   // Popped from the backlog, held until the broker takes it
+    uint8_t batchTarget; // AIMD: halved on a failed publish, +1 per success
+    MqttBatchStats batchStats;
+
+    // Store-and-forward (owned by the loop task)
+    TelemetryBacklog backlog;
+    uint32_t nextSeq;          // Uplink sequence number, gaps = lost samples
+    unsigned long lastDrainMs;
+    unsigned long lastHealthMs;
+
+    // Connection state machine (owned by the loop task)
+    MqttLinkState linkState;
+    MqttLinkStats linkStats;
+    unsigned long nextAttemptMs;
+    unsigned long attemptStartMs;
+    unsigned long lastAccountMs;
+    TaskHandle_t connectTaskHandle;
+    std::atomic<int> connectResult; // 0 = pending, 1 = connected, -1 = failed
 };
 
 #endif
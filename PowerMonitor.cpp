@@ -0,0 +1,74 @@
+#include "PowerMonitor.h"
+
+static const uint16_t AVG_COUNT[] = {1, 4, 16, 64, 128, 256, 512, 1024};
+static const uint16_t CT_US[] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+
+PowerMonitor::PowerMonitor(I2cService& b, uint8_t a, const char* n)
+    : bus(b), addr(a), name(n), dev(-1), currentLsb(PM_MAX_CURRENT_A / 32768.0f), periodUs(0) {
+}
+
+bool PowerMonitor::readRegister(uint8_t reg, uint16_t* value) {
+    I2cTxn t;
+    t.readReg((uint8_t)dev, I2C_PRIO_NORMAL, reg, 2);
+    if (!bus.run(&t)) return false;
+    *value = (uint16_t)(t.rx[0] << 8 | t.rx[1]);
+    return true;
+}
+
+bool PowerMonitor::writeRegister(uint8_t reg, uint16_t value) {
+    uint8_t data[3] = {reg, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF)};
+    I2cTxn t;
+    t.write((uint8_t)dev, I2C_PRIO_NORMAL, data, sizeof(data));
+    return bus.run(&t);
+}
+
+bool PowerMonitor::begin(Ina226Avg avg, Ina226Ct busCt, Ina226Ct shuntCt) {
+    if (dev < 0) dev = bus.addDevice(addr, name, PM_I2C_CLOCK_HZ, PM_I2C_TIMEOUT_MS);
+    if (dev < 0) return false;
+
+    uint16_t id;
+    if (!readRegister(INA226_REG_MANUFACTURER, &id) || id != INA226_MANUFACTURER_TI) return false;
+
+    // CAL = 0.00512 / (current LSB × Rshunt)
+    uint16_t cal = (uint16_t)(0.00512f / (currentLsb * PM_SHUNT_OHM));
+    uint16_t config = (uint16_t)(avg << 9 | busCt << 6 | shuntCt << 3 | INA226_MODE_CONTINUOUS);
+    periodUs = (uint32_t)(CT_US[busCt] + CT_US[shuntCt]) * AVG_COUNT[avg];
+    return writeRegister(INA226_REG_CALIBRATION, cal) && writeRegister(INA226_REG_CONFIG, config);
+}
+
+bool PowerMonitor::enableConversionReadyAlert() {
+    return writeRegister(INA226_REG_MASK_ENABLE, INA226_MASK_CNVR);
+}
+
+bool PowerMonitor::clearAlert(bool* ready) {
+    uint16_t mask;
+    if (!readRegister(INA226_REG_MASK_ENABLE, &mask)) return false;
+    if (ready) *ready = (mask & INA226_MASK_CVRF) != 0;
+    return true;
+}
+
+void PowerMonitor::prepareClearAlert(I2cTxn* t) {
+    t->readReg((uint8_t)dev, I2C_PRIO_HIGH, INA226_REG_MASK_ENABLE, 2);
+}
+
+void PowerMonitor::prepareRead(I2cTxn* t) {
+    t[0].readReg((uint8_t)dev, I2C_PRIO_HIGH, INA226_REG_BUS, 2);
+    t[1].readReg((uint8_t)dev, I2C_PRIO_HIGH, INA226_REG_CURRENT, 2);
+}
+
+bool PowerMonitor::finishRead(const I2cTxn* t, PowerReading& out) {
+    if (t[0].result != I2C_OK || t[1].result != I2C_OK) return false;
+    uint16_t busRaw = (uint16_t)(t[0].rx[0] << 8 | t[0].rx[1]);
+    int16_t currentRaw = (int16_t)(t[1].rx[0] << 8 | t[1].rx[1]);
+    out.busV = busRaw * INA226_BUS_LSB_V;
+    out.current = currentRaw * currentLsb;
+    out.power = out.busV * out.current;
+    return true;
+}
+
+bool PowerMonitor::read(PowerReading& out) {
+    I2cTxn t[PM_READ_TXNS];
+    prepareRead(t);
+    bus.run(t, PM_READ_TXNS);
+    return finishRead(t, out);
+}
@@ -0,0 +1,88 @@
+#ifndef POWER_MONITOR_H
+#define POWER_MONITOR_H
+
+#include <Arduino.h>
+#include "I2cService.h"
+
+// Register-level INA226 driver on the shared I2C bus. Each value is one
+// pointer write plus a 2-byte read joined by a repeated start, so a
+// reading (bus voltage + current) is two combined transactions instead of
+// the library's six separate ones. Power is computed locally as V × I;
+// the power register holds the same product.
+//
+// Averaging and conversion times set the sample period:
+//   (VBUS CT + VSHUNT CT) × AVG
+// and the conversion-ready flag drives the ALERT pin, so the bus is only
+// touched when a new result exists.
+#define INA226_REG_CONFIG      0x00
+#define INA226_REG_SHUNT       0x01
+#define INA226_REG_BUS         0x02
+#define INA226_REG_POWER       0x03
+#define INA226_REG_CURRENT     0x04
+#define INA226_REG_CALIBRATION 0x05
+#define INA226_REG_MASK_ENABLE 0x06
+#define INA226_REG_ALERT_LIMIT 0x07
+#define INA226_REG_MANUFACTURER 0xFE
+
+#define INA226_MANUFACTURER_TI  0x5449
+#define INA226_BUS_LSB_V        0.00125f
+#define INA226_MASK_CNVR        0x0400 // ALERT on conversion ready
+#define INA226_MASK_CVRF        0x0008 // Conversion ready flag (cleared by reading Mask/Enable)
+
+// Config register fields
+enum Ina226Avg { INA_AVG_1, INA_AVG_4, INA_AVG_16, INA_AVG_64, INA_AVG_128, INA_AVG_256, INA_AVG_512, INA_AVG_1024 };
+enum Ina226Ct  { INA_CT_140US, INA_CT_204US, INA_CT_332US, INA_CT_588US, INA_CT_1100US, INA_CT_2116US, INA_CT_4156US, INA_CT_8244US };
+#define INA226_MODE_CONTINUOUS 0x7 // Shunt and bus, continuous
+
+// Fast mode: the INA226's 2.94 MHz high-speed mode needs a master code
+// the ESP32 controller cannot send
+#define PM_I2C_CLOCK_HZ   400000
+#define PM_I2C_TIMEOUT_MS 2   // A reading is ~0.12 ms of bus time
+#define PM_READ_TXNS      2   // Transactions per reading (bus voltage, current)
+
+// Use-case presets: (avg, bus CT, shunt CT)
+#define PM_PROFILE_TELEMETRY INA_AVG_16, INA_CT_588US, INA_CT_588US   // 18.8 ms, ~53 Hz: feeds Coulomb counting and PowerTrigger
+#define PM_PROFILE_TRANSIENT INA_AVG_4,  INA_CT_332US, INA_CT_332US   // 2.7 ms: inrush shape, noisier
+#define PM_PROFILE_LOW_NOISE INA_AVG_64, INA_CT_1100US, INA_CT_1100US // 141 ms, ~7 Hz: quiescent current
+
+// Shunt and range: 0.1 Ω with the full ±81.92 mV shunt input is ±0.819 A.
+// The current LSB then equals the shunt ADC resolution (2.5 µV / 0.1 Ω).
+#define PM_SHUNT_OHM      0.1f
+#define PM_MAX_CURRENT_A  0.8192f
+
+struct PowerReading {
+    float busV;
+    float current; // A
+    float power;   // W
+};
+
+class PowerMonitor {
+public:
+    PowerMonitor(I2cService& bus, uint8_t addr, const char* name);
+    // Registers on the bus, checks the manufacturer ID, then writes
+    // calibration and config
+    bool begin(Ina226Avg avg, Ina226Ct busCt, Ina226Ct shuntCt);
+    bool enableConversionReadyAlert(); // ALERT (open drain, active low) follows CVRF
+    bool clearAlert(bool* ready);      // Reads Mask/Enable, which releases ALERT
+    bool read(PowerReading& out);      // Bus voltage + current
+    uint32_t conversionPeriodUs() const { return periodUs; }
+
+    // Batched use: fill transactions here, run them in one
+    // I2cService::run() together with other devices, then decode
+    void prepareClearAlert(I2cTxn* t);
+    void prepareRead(I2cTxn* t); // PM_READ_TXNS entries
+    bool finishRead(const I2cTxn* t, PowerReading& out);
+
+private:
+    bool readRegister(uint8_t reg, uint16_t* value);
+    bool writeRegister(uint8_t reg, uint16_t value);
+
+    I2cService& bus;
+    uint8_t addr;
+    const char* name;
+    int dev; // -1 until begin()
+    float currentLsb;
+    uint32_t periodUs;
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "PowerTrigger.h"
+#include <string.h>
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static void putFloat(uint8_t* p, float f) {
+    uint32_t u;
+    memcpy(&u, &f, 4);
+    put32(p, u);
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float getFloat(const uint8_t* p) {
+    uint32_t u = get32(p);
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+PowerTrigger::PowerTrigger()
+    : ruleCount(0), ring(nullptr), ringHead(0), ringCount(0), havePrev(false),
+      capture(nullptr), consumers(0), pending(0), captureLen(0),
+      capturing(false), firedRule(-1), triggerUs(0), triggerEpoch(0), count(0), pre(0), holdoffUntilUs(0) {
+    memset(&prev, 0, sizeof(prev));
+    memset(&stats, 0, sizeof(stats));
+    stats.lastRule = -1;
+}
+
+void PowerTrigger::begin(PowerSample* r, uint8_t* c, uint8_t consumerMask) {
+    ring = r;
+    capture = c;
+    consumers = consumerMask;
+}
+
+int PowerTrigger::addRule(const TriggerRule& r) {
+    if (ruleCount >= PTRIG_MAX_RULES || r.field >= PF_COUNT) return -1;
+    rules[ruleCount] = r;
+    return ruleCount++;
+}
+
+void PowerTrigger::addDefaultRules() {
+    TriggerRule inrush   = {PF_IIN,  TRIG_ABOVE,   PTRIG_IIN_INRUSH_A, 0};
+    TriggerRule brownout = {PF_VIN,  TRIG_BELOW,   PTRIG_VIN_BROWNOUT_V, 0};
+    TriggerRule vinSlope = {PF_VIN,  TRIG_SLOPE,   PTRIG_VIN_SLOPE_VPS, 0};
+    TriggerRule pout     = {PF_POUT, TRIG_OUTSIDE, PTRIG_POUT_MIN_W, PTRIG_POUT_MAX_W};
+    addRule(inrush);
+    addRule(brownout);
+    addRule(vinSlope);
+    addRule(pout);
+}
+
+// First rule that matches, or -1
+int PowerTrigger::evaluate(const PowerSample& s) const {
+    for (int i = 0; i < ruleCount; i++) {
+        const TriggerRule& r = rules[i];
+        float v = s.v[r.field];
+        switch (r.type) {
+            case TRIG_ABOVE:
+                if (v > r.a) return i;
+                break;
+            case TRIG_BELOW:
+                if (v < r.a) return i;
+                break;
+            case TRIG_SLOPE:
+                if (havePrev && s.tUs > prev.tUs) {
+                    float slope = (v - prev.v[r.field]) * 1e6f / (float)(s.tUs - prev.tUs);
+                    if (slope > r.a || slope < -r.a) return i;
+                }
+                break;
+            case TRIG_OUTSIDE:
+                if (v < r.a || v > r.b) return i;
+                break;
+        }
+    }
+    return -1;
+}
+
+void PowerTrigger::putSample(const PowerSample& s) {
+    uint8_t* p = capture + CAPTURE_HEADER + (size_t)count * CAPTURE_SAMPLE_SIZE;
+    put32(p, (uint32_t)(int32_t)(s.tUs - triggerUs));
+    for (int f = 0; f < PF_COUNT; f++) {
+        putFloat(p + 4 + 4 * f, s.v[f]);
+    }
+    count++;
+}
+
+void PowerTrigger::freeze() {
+    const TriggerRule& r = rules[firedRule];
+    uint8_t* p = capture;
+    memset(p, 0, CAPTURE_HEADER);
+    p[0] = CAPTURE_MAGIC;
+    p[1] = CAPTURE_VERSION;
+    p[2] = (uint8_t)firedRule;
+    p[3] = r.field;
+    p[4] = r.type;
+    put16(p + 6, count);
+    put16(p + 8, pre);
+    put32(p + 12, triggerEpoch);
+    put32(p + 16, (uint32_t)(uint64_t)triggerUs);
+    put32(p + 20, (uint32_t)((uint64_t)triggerUs >> 32));
+    putFloat(p + 24, r.a);
+    putFloat(p + 28, r.b);
+    captureLen = CAPTURE_HEADER + (size_t)count * CAPTURE_SAMPLE_SIZE;
+    capturing = false;
+    stats.captures++;
+    holdoffUntilUs = triggerUs + PTRIG_HOLDOFF_US;
+    pending.store(consumers, std::memory_order_release); // Publishes the buffer to the consumers
+}
+
+bool PowerTrigger::feed(const PowerSample& s, uint32_t epoch) {
+    if (!ring || !capture) return false;
+    bool frozen = false;
+    int hit = evaluate(s);
+
+    if (capturing) {
+        putSample(s);
+        if (hit >= 0) stats.suppressed++;
+        if (count >= pre + 1 + PTRIG_POST_SAMPLES) {
+            freeze();
+            frozen = true;
+        }
+    } else if (hit >= 0) {
+        if (pending.load(std::memory_order_acquire) != 0 || s.tUs < holdoffUntilUs) {
+            stats.suppressed++;
+        } else {
+            // Pre-trigger history, oldest first, then the trigger sample
+            capturing = true;
+            firedRule = hit;
+            triggerUs = s.tUs;
+            triggerEpoch = epoch;
+            count = 0;
+            size_t start = (ringHead + PTRIG_PRE_SAMPLES - ringCount) % PTRIG_PRE_SAMPLES;
+            for (size_t i = 0; i < ringCount; i++) {
+                putSample(ring[(start + i) % PTRIG_PRE_SAMPLES]);
+            }
+            pre = count;
+            putSample(s);
+            stats.triggers++;
+            stats.lastRule = hit;
+            if (PTRIG_POST_SAMPLES == 0) {
+                freeze();
+                frozen = true;
+            }
+        }
+    }
+
+    ring[ringHead] = s;
+    ringHead = (ringHead + 1) % PTRIG_PRE_SAMPLES;
+    if (ringCount < PTRIG_PRE_SAMPLES) ringCount++;
+    prev = s;
+    havePrev = true;
+    return frozen;
+}
+
+size_t PowerTrigger::peek(uint8_t consumer, const uint8_t** data) const {
+    if (!(pending.load(std::memory_order_acquire) & consumer)) return 0;
+    *data = capture;
+    return captureLen;
+}
+
+void PowerTrigger::release(uint8_t consumer) {
+    pending.fetch_and((uint8_t)~consumer, std::memory_order_acq_rel);
+}
+
+const char* PowerTrigger::fieldName(uint8_t f) {
+    static const char* const names[PF_COUNT] = {"vin", "iin", "pout", "efficiency"};
+    return f < PF_COUNT ? names[f] : "?";
+}
+
+const char* PowerTrigger::typeName(uint8_t t) {
+    switch (t) {
+        case TRIG_ABOVE:   return "above";
+        case TRIG_BELOW:   return "below";
+        case TRIG_SLOPE:   return "slope";
+        case TRIG_OUTSIDE: return "outside";
+    }
+    return "?";
+}
+
+bool parseCapture(const uint8_t* in, size_t len, CaptureHeader& h, const uint8_t** samples) {
+    if (!in || len < CAPTURE_HEADER || in[0] != CAPTURE_MAGIC || in[1] < 1) return false;
+    h.version = in[1];
+    h.rule = in[2];
+    h.field = in[3];
+    h.type = in[4];
+    h.count = get16(in + 6);
+    h.pre = get16(in + 8);
+    h.epoch = get32(in + 12);
+    h.triggerUs = (int64_t)((uint64_t)get32(in + 16) | ((uint64_t)get32(in + 20) << 32));
+    h.a = getFloat(in + 24);
+    h.b = getFloat(in + 28);
+    if (len < CAPTURE_HEADER + (size_t)h.count * CAPTURE_SAMPLE_SIZE || h.pre >= h.count) return false;
+    *samples = in + CAPTURE_HEADER;
+    return true;
+}
+
+void captureSample(const uint8_t* samples, uint16_t i, int32_t* dtUs, float* v) {
+    const uint8_t* p = samples + (size_t)i * CAPTURE_SAMPLE_SIZE;
+    *dtUs = (int32_t)get32(p);
+    for (int f = 0; f < PF_COUNT; f++) {
+        v[f] = getFloat(p + 4 + 4 * f);
+    }
+}
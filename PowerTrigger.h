@@ -0,0 +1,157 @@
+#ifndef POWER_TRIGGER_H
+#define POWER_TRIGGER_H
+
+// Pre-trigger burst capture on the INA226 stream.
+// Plain C++ with no Arduino dependencies: the firmware feeds it from
+// SensorService::readPower() (every INA226 conversion, ~53 Hz), the
+// ground tools replay synthetic fault waveforms through the same engine
+// (tools/ground/capture_tool).
+//
+// The last PTRIG_PRE_SAMPLES samples are kept in a ring. When a rule
+// fires, the ring, the trigger sample and the next PTRIG_POST_SAMPLES
+// samples are frozen into one capture at full resolution. The capture is
+// held until every consumer (MQTT, SD) has released it; triggers in the
+// meantime are counted as suppressed.
+//
+// Capture layout v1, little-endian:
+//   off  size  field
+//    0    1    magic 0xCD
+//    1    1    version
+//    2    1    rule         index of the rule that fired
+//    3    1    field        PowerField
+//    4    1    type         TriggerType
+//    5    1    reserved
+//    6    2    count        samples in the capture
+//    8    2    pre          samples before the trigger sample
+//   10    2    reserved
+//   12    4    epoch        wall-clock s at the trigger (0 = unknown)
+//   16    8    triggerUs    monotonic µs of the trigger sample
+//   24    4    a, b         rule parameters, float
+//   28    4
+//   32   20×n  samples      int32 dt µs from the trigger, float vin, iin, pout, efficiency
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define PTRIG_PRE_SAMPLES   50       // ~1 s before the trigger at ~53 Hz
+#define PTRIG_POST_SAMPLES  100      // ~1.9 s after it
+#define PTRIG_MAX_RULES     8
+#define PTRIG_HOLDOFF_US    10000000 // Re-arm delay after a capture is frozen
+
+// Default rules (addDefaultRules), sized for the 2S pack, the 5 V rail and
+// the ±0.82 A measurable range of the 0.1 Ω shunts (PowerMonitor.h)
+#define PTRIG_IIN_INRUSH_A   0.6f  // iin above
+#define PTRIG_VIN_BROWNOUT_V 6.4f  // vin below (pack near cutoff)
+#define PTRIG_VIN_SLOPE_VPS  5.0f  // |dvin/dt| above
+#define PTRIG_POUT_MIN_W     -0.1f // pout outside [min, max]
+#define PTRIG_POUT_MAX_W     3.5f
+
+#define CAPTURE_MAGIC       0xCD
+#define CAPTURE_VERSION     1
+#define CAPTURE_HEADER      32
+#define CAPTURE_SAMPLE_SIZE 20
+#define CAPTURE_MAX_SAMPLES (PTRIG_PRE_SAMPLES + 1 + PTRIG_POST_SAMPLES)
+#define CAPTURE_MAX_BYTES   (CAPTURE_HEADER + CAPTURE_MAX_SAMPLES * CAPTURE_SAMPLE_SIZE)
+
+// Consumers that must release a capture before the next one can start
+#define CAPTURE_TO_MQTT 0x01
+#define CAPTURE_TO_SD   0x02
+
+enum PowerField { PF_VIN, PF_IIN, PF_POUT, PF_EFF, PF_COUNT };
+
+enum TriggerType {
+    TRIG_ABOVE,   // value > a
+    TRIG_BELOW,   // value < a
+    TRIG_SLOPE,   // |d value / dt| > a per second
+    TRIG_OUTSIDE  // value < a or value > b
+};
+
+struct TriggerRule {
+    uint8_t field; // PowerField
+    uint8_t type;  // TriggerType
+    float a, b;
+};
+
+struct PowerSample {
+    int64_t tUs; // Monotonic µs
+    float v[PF_COUNT];
+};
+
+struct PowerTriggerStats {
+    uint32_t triggers;   // Rule hits that started a capture
+    uint32_t captures;   // Captures frozen for the consumers
+    uint32_t suppressed; // Rule hits during a capture, holdoff or while one was held
+    int32_t lastRule;    // -1 = none yet
+};
+
+// Decoded capture header (ground side)
+struct CaptureHeader {
+    uint8_t version, rule, field, type;
+    uint16_t count, pre;
+    uint32_t epoch;
+    int64_t triggerUs;
+    float a, b;
+};
+
+class PowerTrigger {
+public:
+    PowerTrigger();
+    // Storage comes from the caller (PSRAM on the device): `ring` holds
+    // PTRIG_PRE_SAMPLES samples, `capture` CAPTURE_MAX_BYTES.
+    // `consumers` is the CAPTURE_TO_* mask that must release each capture.
+    void begin(PowerSample* ring, uint8_t* capture, uint8_t consumers);
+    int addRule(const TriggerRule& r); // Index, or -1 when full
+    void addDefaultRules();
+
+    // Producer side: one call per INA226 reading. Returns true when a
+    // capture was just frozen.
+    bool feed(const PowerSample& s, uint32_t epoch);
+
+    // Consumer side (any task): bytes of the held capture not yet
+    // released by `consumer`, 0 if none
+    size_t peek(uint8_t consumer, const uint8_t** data) const;
+    void release(uint8_t consumer);
+
+    PowerTriggerStats getStats() const { return stats; }
+
+    static const char* fieldName(uint8_t f);
+    static const char* typeName(uint8_t t);
+
+private:
+    int evaluate(const PowerSample& s) const;
+    void putSample(const PowerSample& s);
+    void freeze();
+
+    TriggerRule rules[PTRIG_MAX_RULES];
+    int ruleCount;
+
+    PowerSample* ring;
+    size_t ringHead;  // Next slot to write
+    size_t ringCount;
+    PowerSample prev;
+    bool havePrev;
+
+    uint8_t* capture;
+    uint8_t consumers;
+    std::atomic<uint8_t> pending; // Consumers that still hold the frozen capture
+    size_t captureLen;            // Valid while pending != 0
+
+    // Capture in progress (producer only)
+    bool capturing;
+    int firedRule;
+    int64_t triggerUs;
+    uint32_t triggerEpoch;
+    uint16_t count;
+    uint16_t pre;
+    int64_t holdoffUntilUs;
+
+    PowerTriggerStats stats;
+};
+
+// Validates a capture; on success `samples` points at the first sample
+bool parseCapture(const uint8_t* in, size_t len, CaptureHeader& h, const uint8_t** samples);
+// Sample i of a parsed capture: dt µs from the trigger and PF_COUNT values
+void captureSample(const uint8_t* samples, uint16_t i, int32_t* dtUs, float* v);
+
+#endif
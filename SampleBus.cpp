@@ -0,0 +1,110 @@
+#include "SampleBus.h"
+
+SampleBus::SampleBus() : head(0), subCount(0) {
+    subLock = portMUX_INITIALIZER_UNLOCKED;
+    for (int i = 0; i < SAMPLE_BUS_SLOTS; i++) {
+        slots[i].seq.store(0, std::memory_order_relaxed);
+        memset(&slots[i].data, 0, sizeof(MeasurementData));
+    }
+    for (int i = 0; i < SAMPLE_BUS_MAX_SUBSCRIBERS; i++) {
+        Subscriber& s = subs[i];
+        s.name = nullptr;
+        s.notify.store(NULL, std::memory_order_relaxed);
+        s.cursor = s.delivered = s.overruns = s.maxLag = 0;
+    }
+}
+
+// Per-slot seqlock: readers detect a slot that was rewritten under them
+void SampleBus::publish(const MeasurementData& d) {
+    uint32_t seq = head.load(std::memory_order_relaxed) + 1;
+    Slot& s = slots[seq % SAMPLE_BUS_SLOTS];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&s.data, &d, sizeof(MeasurementData));
+    s.seq.store(seq, std::memory_order_release);
+    head.store(seq, std::memory_order_release);
+
+    int n = subCount.load(std::memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+        TaskHandle_t t = subs[i].notify.load(std::memory_order_acquire);
+        if (t) xTaskNotifyGive(t);
+    }
+}
+
+// Subscribers are set up from different tasks and cores (setup, service
+// tasks), so claiming the slot and filling it happen under the lock; the
+// producer only sees the entry once subCount is raised past it
+int SampleBus::subscribe(const char* name, TaskHandle_t notify) {
+    portENTER_CRITICAL(&subLock);
+    int i = subCount.load(std::memory_order_relaxed);
+    if (i < SAMPLE_BUS_MAX_SUBSCRIBERS) {
+        Subscriber& s = subs[i];
+        s.name = name;
+        s.notify.store(notify, std::memory_order_relaxed);
+        s.cursor = head.load(std::memory_order_acquire) + 1;
+        subCount.store(i + 1, std::memory_order_release);
+    } else {
+        i = -1;
+    }
+    portEXIT_CRITICAL(&subLock);
+    return i;
+}
+
+void SampleBus::setNotify(int sub, TaskHandle_t notify) {
+    if (sub < 0 || sub >= getSubscriberCount()) return;
+    subs[sub].notify.store(notify, std::memory_order_release);
+}
+
+bool SampleBus::copySlot(uint32_t seq, MeasurementData& out) const {
+    const Slot& s = slots[seq % SAMPLE_BUS_SLOTS];
+    if (s.seq.load(std::memory_order_acquire) != seq) return false;
+    memcpy(&out, &s.data, sizeof(MeasurementData));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == seq;
+}
+
+bool SampleBus::read(int sub, MeasurementData& out) {
+    if (sub < 0 || sub >= getSubscriberCount()) return false;
+    Subscriber& s = subs[sub];
+    for (;;) {
+        uint32_t h = head.load(std::memory_order_acquire);
+        if ((int32_t)(h - s.cursor) < 0) return false; // Caught up
+
+        // The slot after `h` may already be in the middle of a rewrite,
+        // so the oldest safely readable sequence is h - SLOTS + 2
+        uint32_t oldest = h - SAMPLE_BUS_SLOTS + 2;
+        if (h >= SAMPLE_BUS_SLOTS - 1 && (int32_t)(oldest - s.cursor) > 0) {
+            s.overruns += oldest - s.cursor;
+            s.cursor = oldest;
+        }
+        if (copySlot(s.cursor, out)) {
+            uint32_t lag = h - s.cursor;
+            if (lag > s.maxLag) s.maxLag = lag;
+            s.cursor++;
+            s.delivered++;
+            return true;
+        }
+        // Overwritten while copying; re-check the head and skip ahead
+    }
+}
+
+bool SampleBus::latest(MeasurementData& out) const {
+    for (;;) {
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (h == 0) return false;
+        if (copySlot(h, out)) return true;
+    }
+}
+
+SampleBusStats SampleBus::getStats(int sub) const {
+    SampleBusStats st = {};
+    if (sub < 0 || sub >= getSubscriberCount()) return st;
+    const Subscriber& s = subs[sub];
+    uint32_t h = head.load(std::memory_order_relaxed);
+    st.name = s.name;
+    st.delivered = s.delivered;
+    st.overruns = s.overruns;
+    st.lag = (int32_t)(h + 1 - s.cursor) > 0 ? h + 1 - s.cursor : 0;
+    st.maxLag = s.maxLag;
+    return st;
+}
@@ -0,0 +1,67 @@
+#ifndef SAMPLE_BUS_H
+#define SAMPLE_BUS_H
+
+#include "DataModel.h"
+#include <atomic>
+
+#define SAMPLE_BUS_SLOTS           16 // Ring depth: 16 s of slack at 1 Hz
+#define SAMPLE_BUS_MAX_SUBSCRIBERS 6
+
+struct SampleBusStats {
+    const char* name;
+    uint32_t delivered;
+    uint32_t overruns; // Samples overwritten before this subscriber read them
+    uint32_t lag;      // Samples published but not yet read
+    uint32_t maxLag;
+};
+
+// Single-producer, multi-consumer broadcast ring. SensorTask publishes
+// each record once; every subscriber reads every record through its own
+// cursor. The producer never waits: a subscriber that falls more than a
+// ring behind skips ahead and counts the loss as overruns.
+class SampleBus {
+public:
+    SampleBus();
+
+    // Producer side (SensorTask only)
+    void publish(const MeasurementData& d);
+
+    // Consumer side. A subscriber starts at the next published sample; if
+    // `notify` is set, that task gets a task notification per sample.
+    // Safe to call from several tasks at once.
+    int subscribe(const char* name, TaskHandle_t notify = NULL); // -1 when full
+    // Sets the task to notify after subscribing, for a consumer task that
+    // is created once its subscription exists
+    void setNotify(int sub, TaskHandle_t notify);
+    bool read(int sub, MeasurementData& out);    // Next unread sample; false if caught up
+    bool latest(MeasurementData& out) const;     // Newest sample; false before the first
+
+    uint32_t getPublished() const { return head.load(std::memory_order_relaxed); }
+    int getSubscriberCount() const { return subCount.load(std::memory_order_acquire); }
+    SampleBusStats getStats(int sub) const;
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq; // Sequence held by the slot; 0 while being written
+        MeasurementData data;
+    };
+
+    struct Subscriber {
+        const char* name;
+        std::atomic<TaskHandle_t> notify;
+        uint32_t cursor; // Next sequence to read; touched only by the subscriber
+        uint32_t delivered;
+        uint32_t overruns;
+        uint32_t maxLag;
+    };
+
+    bool copySlot(uint32_t seq, MeasurementData& out) const;
+
+    Slot slots[SAMPLE_BUS_SLOTS];
+    std::atomic<uint32_t> head; // Newest published sequence, 0 = none yet
+    Subscriber subs[SAMPLE_BUS_MAX_SUBSCRIBERS];
+    std::atomic<int> subCount;
+    portMUX_TYPE subLock; // Serializes subscribe()
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "SdLogger.h"
+
+SdLogger::SdLogger() : open(false), used(0), fileSize(0), oldestRowMs(0), lastMode(MODE_SENSOR) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool SdLogger::begin(fs::FS& fs, const char* path, const char* header) {
+    file = fs.open(path, FILE_APPEND, true);
+    if (!file) {
+        Serial.printf("SD Error: Failed to open %s for append\n", path);
+        return false;
+    }
+    open = true;
+    fileSize = file.size();
+    if (fileSize == 0 && header) {
+        file.println(header);
+        file.flush();
+        fileSize = file.size();
+    }
+    lastMode = currentSystemMode;
+    return true;
+}
+
+// After an unaligned (time/mode) flush the next buffer is trimmed so that
+// subsequent writes start on a sector boundary again
+size_t SdLogger::fillLimit() const {
+    return sizeof(buffer) - (fileSize % SD_LOG_BLOCK_SIZE);
+}
+
+void SdLogger::append(const char* row, size_t len, OperationMode mode) {
+    if (!open) {
+        stats.rowsDropped++;
+        return;
+    }
+
+    // Make everything logged in the previous mode durable before switching
+    if (mode != lastMode) {
+        flush();
+        lastMode = mode;
+    }
+
+    if (used == 0) oldestRowMs = millis();
+
+    while (len > 0) {
+        size_t room = fillLimit() - used;
+        size_t n = (len < room) ? len : room;
+        memcpy(buffer + used, row, n);
+        used += n;
+        row += n;
+        len -= n;
+        if (used >= fillLimit()) {
+            writeOut();
+            if (len > 0) oldestRowMs = millis();
+        }
+    }
+    stats.rowsWritten++;
+
+#if SD_LOG_DURABILITY == SD_DURABILITY_SYNC_ROW
+    flush();
+#endif
+}
+
+void SdLogger::poll() {
+    if (open && used > 0 && millis() - oldestRowMs >= SD_LOG_FLUSH_INTERVAL_MS) {
+        flush();
+    }
+}
+
+void SdLogger::flush() {
+    if (!open) return;
+    writeOut();
+}
+
+void SdLogger::writeOut() {
+    unsigned long t0 = micros();
+    if (used > 0) {
+        size_t written = file.write(buffer, used);
+        if (written != used) {
+            Serial.println("SD Error: short write to datalog");
+            stats.writeErrors++;
+        }
+        fileSize += written;
+        stats.bytesWritten += written;
+        used = 0;
+    }
+#if SD_LOG_DURABILITY != SD_DURABILITY_WRITE_BEHIND
+    file.flush(); // Commits file size and FAT chain
+#endif
+
+    uint32_t dt = micros() - t0;
+    stats.lastFlushUs = dt;
+    if (dt > stats.maxFlushUs) stats.maxFlushUs = dt;
+    stats.flushCount++;
+}
+
+void SdLogger::close() {
+    if (!open) return;
+    writeOut();
+    file.close();
+    open = false;
+}
@@ -0,0 +1,56 @@
+#ifndef SD_LOGGER_H
+#define SD_LOGGER_H
+
+#include "DataModel.h"
+#include <FS.h>
+
+// Write-behind buffer: whole SD sectors, flushed on size/time/mode change
+#define SD_LOG_BLOCK_SIZE        512
+#define SD_LOG_BUFFER_BLOCKS     8      // 4 KiB RAM buffer
+#define SD_LOG_FLUSH_INTERVAL_MS 5000   // Max age of buffered rows before flush
+
+// Durability policy — how far a flush goes before it is considered done
+enum SdDurability {
+    SD_DURABILITY_WRITE_BEHIND, // Flush hands data to the FS; FAT/dir entry updated on close or sync
+    SD_DURABILITY_SYNC_FLUSH,   // Every flush also syncs the file (size + FAT committed)
+    SD_DURABILITY_SYNC_ROW      // Sync after every row (legacy behaviour, slowest)
+};
+
+#define SD_LOG_DURABILITY SD_DURABILITY_SYNC_FLUSH
+
+struct SdLoggerStats {
+    uint32_t bytesWritten;  // Bytes handed to the card
+    uint32_t rowsWritten;
+    uint32_t rowsDropped;   // Rows refused because the file is not open
+    uint32_t writeErrors;   // Short writes reported by the FS
+    uint32_t flushCount;
+    uint32_t lastFlushUs;   // Latency of the most recent flush
+    uint32_t maxFlushUs;
+};
+
+class SdLogger {
+public:
+    SdLogger();
+    bool begin(fs::FS& fs, const char* path, const char* header);
+    void append(const char* row, size_t len, OperationMode mode);
+    void poll();     // Time-based flush, call regularly from the owning task
+    void flush();
+    void close();
+    bool isOpen() const { return open; }
+    SdLoggerStats getStats() const { return stats; }
+
+private:
+    void writeOut();
+    size_t fillLimit() const;
+
+    File file;
+    bool open;
+    uint8_t buffer[SD_LOG_BLOCK_SIZE * SD_LOG_BUFFER_BLOCKS];
+    size_t used;
+    uint32_t fileSize;
+    unsigned long oldestRowMs; // When the first unflushed row was buffered
+    OperationMode lastMode;
+    SdLoggerStats stats;
+};
+
+#endif
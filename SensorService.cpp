@@ -1,164 +1,497 @@
 #include "SensorService.h"
+#include "Metrics.h"
+#include "SystemClock.h"
 
 SensorService::SensorService() 
-    : ina_in(0x41), ina_out(0x51), gpsSerial(1), inaInOK(false), inaOutOK(false), rtcOK(false), 
-      dataQueuePtr(nullptr), bootTimeMs(0), totalSatsInView(0), 
-      socAccum(0.0f), lastSocMs(0), socInitialized(false) {
-    mutex = xSemaphoreCreateMutex();
-    nmeaSentence = "";
-    memset(&latest, 0, sizeof(MeasurementData));
-    for (int i = 0; i < 4; i++) {
-        adcFiltered[i] = -1.0f;
+    : ina_in(i2c, 0x41, "ina_in"), ina_out(i2c, 0x51, "ina_out"), powerReady(false), lastPowerUs(0), powerAlertTimeouts(0),
+      rtcDev(-1), rtcSec(0), rtcMonoUs(0), gpsFixSeq(0), gpsFixMs(0), inaInOK(false), inaOutOK(false), rtcOK(false), i2cErrors(0),
+      bus(nullptr), freshMask(0),
+      socAccum(0.0f), lastSocUs(0), socInitialized(false), bootTimeMs(0) {
+    memset(&current, 0, sizeof(MeasurementData));
+#if ENABLE_ADC_DMA
+    adcHandle = NULL;
+    memset(adcChanIndex, 0xFF, sizeof(adcChanIndex));
+    adcDmaOK = false;
+    adcDmaOverflows = 0;
+#endif
+
+    const uint32_t periods[CH_COUNT] = {POWER_PERIOD_MS, ADC_PERIOD_MS, GPS_PERIOD_MS, RTC_PERIOD_MS, SAMPLE_PERIOD_MS};
+    for (int i = 0; i < CH_COUNT; i++) {
+        channels[i].period = pdMS_TO_TICKS(periods[i]) ? pdMS_TO_TICKS(periods[i]) : 1;
+        channels[i].next = 0;
+        channels[i].overruns = 0;
     }
+    adcAlphaWarmup = 1.0f;
+    adcAlpha = 1.0f;
 }
 
 void SensorService::begin() {
-    Wire.begin(I2C_SDA, I2C_SCL); // 41, 42
-    Wire.setClock(100000);
-    Wire.setTimeOut(100);
+    i2c.begin(I2C_SDA, I2C_SCL); // 41, 42; starts I2cTask
     
 #if ENABLE_RTC
-    rtcOK = rtc.begin();
-    if (rtcOK && rtc.lostPower()) {
-        rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
-    }
+    rtcDev = i2c.addDevice(RTC_I2C_ADDR, "rtc", RTC_I2C_CLOCK_HZ, RTC_I2C_TIMEOUT_MS);
+    rtcOK = i2c.call(rtcDev, I2C_PRIO_LOW, SensorService::rtcBegin, this);
 #endif
 
 #if ENABLE_INA226
     Serial.println("Initializing INA226 IN (0x41)...");
-    inaInOK = ina_in.begin();
+    inaInOK = ina_in.begin(PM_PROFILE);
     if (inaInOK) {
-        ina_in.setMaxCurrentShunt(0.2, 0.1);
-        Serial.println("INA226 IN: OK");
+        Serial.printf("INA226 IN: OK (conversion %lu us)\n", (unsigned long)ina_in.conversionPeriodUs());
     } else {
         Serial.println("INA226 IN: FAILED/NOT FOUND");
     }
     
-    Serial.println("Initializing INA226 OUT (0x44)...");
-    inaOutOK = ina_out.begin();
+    Serial.println("Initializing INA226 OUT (0x51)...");
+    inaOutOK = ina_out.begin(PM_PROFILE);
     if (inaOutOK) {
-        ina_out.setMaxCurrentShunt(0.2, 0.1);
         Serial.println("INA226 OUT: OK");
     } else {
         Serial.println("INA226 OUT: FAILED/NOT FOUND");
     }
+
+#if PM_ALERT_PIN >= 0
+    // IN paces both monitors: same profile, so OUT is at most one conversion older
+    if (inaInOK && ina_in.enableConversionReadyAlert()) {
+        pinMode(PM_ALERT_PIN, INPUT_PULLUP);
+        attachInterruptArg(PM_ALERT_PIN, SensorService::onPowerAlert, this, FALLING);
+    }
+#endif
 #endif
 
 #if ENABLE_GPS
-    gpsSerial.begin(9600, SERIAL_8N1, GPS_RX_PIN, GPS_TX_PIN);
+    gps.begin(); // Starts GpsTask, fed by UART RX events
 #endif
 
-    for (int i = 0; i < 4; i++) {
-        pinMode(ADC_PINS[i], INPUT);
-    }
     bootTimeMs = millis();
+    beginAdc();
+    beginPowerTrigger();
+}
 
-    xTaskCreatePinnedToCore(SensorService::task, "SensorTask", 4096, this, 2, NULL, 0);
+// SensorTask emits a record on its first pass, so this runs once every
+// bus consumer has subscribed; a later subscriber starts at the next record
+void SensorService::start() {
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(SensorService::task, "SensorTask", 4096, this, 2, &handle, 0);
+    metrics.setTask(MTASK_SENSOR, handle);
 }
 
-MeasurementData SensorService::getLatestData() {
-    MeasurementData d;
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        d = latest;
-        xSemaphoreGive(mutex);
-    } else {
-        memset(&d, 0, sizeof(d)); // Timeout
-    }
-    return d;
+uint32_t SensorService::getAdcOverflows() const {
+#if ENABLE_ADC_DMA
+    return adcDmaOverflows;
+#else
+    return 0;
+#endif
 }
 
 void SensorService::task(void* param) {
     SensorService* self = (SensorService*)param;
+    vTaskDelay(1); // Start on a fresh tick so phaseUs sits on its boundary
+    TickType_t last = xTaskGetTickCount();
+    int64_t phaseUs = SystemClock::monoUs(); // µs at tick `last`
+    for (int i = 0; i < CH_COUNT; i++) {
+        self->channels[i].next = last; // Common phase: everything runs on the first pass
+    }
     for (;;) {
-        self->loop();
-        vTaskDelay(pdMS_TO_TICKS(1000)); // Sample rate
+        uint32_t start = Metrics::cycles();
+        TickType_t next = self->runDue(last);
+        metrics.stop(MT_SENSOR_RUN, start);
+        // Sleep until the earliest absolute deadline; never drifts by loop time
+        TickType_t prev = last;
+        vTaskDelayUntil(&last, next - last);
+
+        // Wake lateness against the deadline's µs time (WiFi/SD interrupts,
+        // higher-priority tasks on core 0)
+        phaseUs += (int64_t)(last - prev) * portTICK_PERIOD_MS * 1000;
+        int64_t late = SystemClock::monoUs() - phaseUs;
+        metrics.observeUs(MT_SENSOR_LATENESS, late > 0 ? (uint32_t)late : 0);
     }
 }
 
-void SensorService::loop() {
-    MeasurementData d = {};
-    makeTimestamp(d.timestamp, sizeof(d.timestamp));
+const char* SensorService::channelName(Channel c) {
+    static const char* const names[CH_COUNT] = {"power", "adc", "gps", "rtc", "sample"};
+    return c < CH_COUNT ? names[c] : "?";
+}
 
-    if (currentSystemMode == MODE_SENSOR) {
-#if ENABLE_INA226
-        if (inaInOK) {
-            d.vin = ina_in.getBusVoltage();
-            d.iin = ina_in.getCurrent();
-            d.pin = ina_in.getPower();
-        }
-        if (inaOutOK) {
-            d.vout = ina_out.getBusVoltage();
-            d.iout = ina_out.getCurrent();
-            d.pout = ina_out.getPower();
+// Runs every source whose deadline has passed and returns the earliest
+// upcoming deadline. Missed deadlines are skipped rather than replayed.
+TickType_t SensorService::runDue(TickType_t now) {
+    TickType_t earliest = now + pdMS_TO_TICKS(SAMPLE_PERIOD_MS);
+    for (int i = 0; i < CH_COUNT; i++) {
+        SensorChannel& ch = channels[i];
+        if ((int32_t)(now - ch.next) >= 0) {
+            switch (i) {
+                case CH_POWER:  readPower();  break;
+                case CH_ADC:    readAdc();    break;
+                case CH_GPS:    readGps();    break;
+                case CH_RTC:    readRtc();    break;
+                case CH_SAMPLE: emitSample(); break;
+            }
+            ch.next += ch.period;
+            if ((int32_t)(now - ch.next) >= 0) {
+                // Overran by more than a period: realign to the original phase
+                TickType_t behind = now - ch.next;
+                ch.next += (behind / ch.period + 1) * ch.period;
+                ch.overruns += behind / ch.period + 1;
+            }
         }
-        if (inaInOK && inaOutOK) {
-            d.efficiency = (d.pin > 0.000001f) ? (d.pout / d.pin) * 100.0f : 0.0f;
-        } else {
-            d.efficiency = 0.0f;
+        if ((int32_t)(ch.next - earliest) < 0) {
+            earliest = ch.next;
         }
-        
-        // Update State of Charge
-        updateSoC(d);
+    }
+    TickType_t after = xTaskGetTickCount();
+    if ((int32_t)(earliest - after) <= 0) {
+        earliest = after + 1;
+    }
+    return earliest;
+}
+
+void IRAM_ATTR SensorService::onPowerAlert(void* arg) {
+    ((SensorService*)arg)->powerReady = true;
+}
+
+void SensorService::readPower() {
+#if ENABLE_INA226
+    if (currentSystemMode != MODE_SENSOR) return;
+    int64_t now = SystemClock::monoUs();
+#if PM_ALERT_PIN >= 0
+    // Nothing new to read until ALERT fires. A quiet ALERT line degrades to
+    // every third conversion period; without IN, OUT is read per conversion.
+    if (!powerReady) {
+        uint32_t periodUs = inaInOK ? ina_in.conversionPeriodUs() : ina_out.conversionPeriodUs();
+        if (now - lastPowerUs < (inaInOK ? 3 : 1) * (int64_t)periodUs) return;
+        if (inaInOK && lastPowerUs) powerAlertTimeouts++; // Not the first reading after boot
+    }
+    powerReady = false;
 #endif
+    lastPowerUs = now;
 
-#if ENABLE_GPS
-        while (gpsSerial.available()) {
-            char c = gpsSerial.read();
-            gps.encode(c);
-        }
-        
-        if (gps.location.isValid()) {
-            d.lat = gps.location.lat();
-            d.lng = gps.location.lng();
+    uint32_t start = Metrics::cycles();
+    MeasurementData& d = current;
+    // One batch on the bus, one wake-up: ALERT clear, IN reading, OUT reading
+    I2cTxn txns[1 + 2 * PM_READ_TXNS];
+    size_t n = 0;
+    I2cTxn* inTxns = nullptr;
+    I2cTxn* outTxns = nullptr;
+    if (inaInOK) {
+#if PM_ALERT_PIN >= 0
+        // Clear first: a conversion finishing during the reads re-arms ALERT
+        ina_in.prepareClearAlert(&txns[n++]);
+#endif
+        inTxns = &txns[n];
+        ina_in.prepareRead(inTxns);
+        n += PM_READ_TXNS;
+    }
+    if (inaOutOK) {
+        outTxns = &txns[n];
+        ina_out.prepareRead(outTxns);
+        n += PM_READ_TXNS;
+    }
+    i2c.run(txns, n);
+
+    PowerReading r;
+    if (inaInOK) {
+#if PM_ALERT_PIN >= 0
+        if (txns[0].result != I2C_OK) i2cErrors++;
+#endif
+        if (ina_in.finishRead(inTxns, r)) {
+            d.vin = r.busV;
+            d.iin = r.current;
+            d.pin = r.power;
+            // The record carries only the last reading; the extremes keep
+            // the transients between records
+            if (d.powerReads == 0) {
+                d.vinMin = d.vinMax = d.vin;
+                d.iinMin = d.iinMax = d.iin;
+            } else {
+                if (d.vin < d.vinMin) d.vinMin = d.vin;
+                if (d.vin > d.vinMax) d.vinMax = d.vin;
+                if (d.iin < d.iinMin) d.iinMin = d.iin;
+                if (d.iin > d.iinMax) d.iinMax = d.iin;
+            }
+            if (d.powerReads < UINT8_MAX) d.powerReads++;
+        } else {
+            i2cErrors++;
         }
-        if (gps.satellites.isValid()) {
-            d.satellites = gps.satellites.value();
+    }
+    if (inaOutOK) {
+        if (ina_out.finishRead(outTxns, r)) {
+            d.vout = r.busV;
+            d.iout = r.current;
+            d.pout = r.power;
         } else {
-            d.satellites = 0;
+            i2cErrors++;
+        }
+    }
+    metrics.stop(MT_POWER_READ, start);
+    if (inaInOK && inaOutOK) {
+        d.efficiency = (d.pin > 0.000001f) ? (d.pout / d.pin) * 100.0f : 0.0f;
+    } else {
+        d.efficiency = 0.0f;
+    }
+
+    // Coulomb counting at the power-rail rate
+    updateSoC(d);
+    freshMask |= SAMPLE_FRESH_POWER;
+
+#if ENABLE_POWER_CAPTURE
+    if (inaInOK) {
+        PowerSample s;
+        s.tUs = SystemClock::monoUs();
+        s.v[PF_VIN] = d.vin;
+        s.v[PF_IIN] = d.iin;
+        s.v[PF_POUT] = d.pout;
+        s.v[PF_EFF] = d.efficiency;
+        if (powerTrigger.feed(s, systemClock.epochAt(s.tUs))) {
+            Serial.printf("Power capture frozen (rule %ld)\n", (long)powerTrigger.getStats().lastRule);
         }
+    }
 #endif
+#endif
+}
 
-        // ADC Reading and Filtering
-        float alpha = (millis() - bootTimeMs < 300000) ? 0.05f : 0.2f; 
+// Ring and capture buffer live in PSRAM when present (~4.2 KB)
+void SensorService::beginPowerTrigger() {
+#if ENABLE_POWER_CAPTURE
+    size_t ringBytes = PTRIG_PRE_SAMPLES * sizeof(PowerSample);
+    uint8_t* mem = psramFound() ? (uint8_t*)ps_malloc(ringBytes + CAPTURE_MAX_BYTES) : nullptr;
+    if (!mem) mem = (uint8_t*)malloc(ringBytes + CAPTURE_MAX_BYTES);
+    if (!mem) {
+        Serial.println("Power capture: allocation FAILED");
+        return;
+    }
+    uint8_t consumers = 0;
+#if ENABLE_MQTT
+    consumers |= CAPTURE_TO_MQTT;
+#endif
+#if ENABLE_SD
+    consumers |= CAPTURE_TO_SD;
+#endif
+    powerTrigger.begin((PowerSample*)mem, mem + ringBytes, consumers);
+    powerTrigger.addDefaultRules();
+#endif
+}
 
+// alpha = dt / (tau + dt) keeps the EMA response independent of the rate
+// it runs at (decimated DMA stream or polled reads)
+static float emaAlpha(float dtMs, float tauMs) {
+    return dtMs / (tauMs + dtMs);
+}
+
+void SensorService::beginAdc() {
+#if ENABLE_ADC_DMA
+    const float dtMs = 1000.0f * ADC_DECIMATION * 4 / ADC_DMA_SAMPLE_HZ;
+    adcAlphaWarmup = emaAlpha(dtMs, ADC_EMA_TAU_WARMUP_MS);
+    adcAlpha = emaAlpha(dtMs, ADC_EMA_TAU_MS);
+    adcFilter.begin(ADC_DECIMATION, adcAlphaWarmup);
+
+    adc_continuous_handle_cfg_t handleCfg = {};
+    handleCfg.max_store_buf_size = ADC_DMA_POOL_BYTES;
+    handleCfg.conv_frame_size = ADC_DMA_FRAME_BYTES;
+    if (adc_continuous_new_handle(&handleCfg, &adcHandle) != ESP_OK) {
+        Serial.println("ADC DMA: handle FAILED, using analogRead()");
+        return;
+    }
+
+    adc_digi_pattern_config_t pattern[4] = {};
+    for (int i = 0; i < 4; i++) {
+        adc_unit_t unit;
+        adc_channel_t channel;
+        adc_continuous_io_to_channel(ADC_PINS[i], &unit, &channel);
+        pattern[i].atten = ADC_ATTEN_DB_12; // Same full-scale range as analogRead()
+        pattern[i].channel = channel;
+        pattern[i].unit = unit;
+        pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        if (channel < SOC_ADC_MAX_CHANNEL_NUM) adcChanIndex[channel] = i;
+    }
+
+    adc_continuous_config_t digCfg = {};
+    digCfg.pattern_num = 4;
+    digCfg.adc_pattern = pattern;
+    digCfg.sample_freq_hz = ADC_DMA_SAMPLE_HZ;
+    digCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_pool_ovf = SensorService::adcPoolOverflow;
+
+    if (adc_continuous_config(adcHandle, &digCfg) == ESP_OK &&
+        adc_continuous_register_event_callbacks(adcHandle, &cbs, this) == ESP_OK &&
+        adc_continuous_start(adcHandle) == ESP_OK) {
+        adcDmaOK = true;
+        Serial.println("ADC DMA: OK");
+        return;
+    }
+    Serial.println("ADC DMA: FAILED, using analogRead()");
+    adc_continuous_deinit(adcHandle);
+    adcHandle = NULL;
+#endif
+
+    // Polled fallback: one conversion per pin per ADC_PERIOD_MS, no decimation
+    adcAlphaWarmup = emaAlpha(ADC_PERIOD_MS, ADC_EMA_TAU_WARMUP_MS);
+    adcAlpha = emaAlpha(ADC_PERIOD_MS, ADC_EMA_TAU_MS);
+    adcFilter.begin(1, adcAlphaWarmup);
+    for (int i = 0; i < 4; i++) {
+        pinMode(ADC_PINS[i], INPUT);
+    }
+}
+
+#if ENABLE_ADC_DMA
+bool IRAM_ATTR SensorService::adcPoolOverflow(adc_continuous_handle_t h, const adc_continuous_evt_data_t* e, void* user) {
+    ((SensorService*)user)->adcDmaOverflows++;
+    return false;
+}
+#endif
+
+void SensorService::readAdc() {
+    if (currentSystemMode != MODE_SENSOR) return;
+    MeasurementData& d = current;
+
+    // EMA is slower during warm-up so the comparator levels settle cleanly
+    adcFilter.setAlpha((millis() - bootTimeMs < ADC_WARMUP_MS) ? adcAlphaWarmup : adcAlpha);
+
+#if ENABLE_ADC_DMA
+    if (adcDmaOK) {
+        // Drain every completed DMA frame; decode and filter a block at a time
+        uint8_t frame[ADC_DMA_FRAME_BYTES];
+        uint16_t raw[ADC_DMA_FRAME_BYTES / SOC_ADC_DIGI_RESULT_BYTES];
+        uint8_t chan[ADC_DMA_FRAME_BYTES / SOC_ADC_DIGI_RESULT_BYTES];
+        uint32_t got = 0;
+        while (adc_continuous_read(adcHandle, frame, sizeof(frame), &got, 0) == ESP_OK) {
+            size_t n = 0;
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t* p = (const adc_digi_output_data_t*)&frame[i];
+                uint32_t ch = p->type2.channel;
+                if (ch < SOC_ADC_MAX_CHANNEL_NUM && adcChanIndex[ch] != 0xFF) {
+                    raw[n] = p->type2.data;
+                    chan[n] = adcChanIndex[ch];
+                    n++;
+                }
+            }
+            adcFilter.processBlock(raw, chan, n);
+        }
+    } else
+#endif
+    {
+        uint16_t raw[4];
+        const uint8_t chan[4] = {0, 1, 2, 3};
         for (int i = 0; i < 4; i++) {
-            int raw = analogRead(ADC_PINS[i]);
-            if (adcFiltered[i] < 0.0f) {
-                adcFiltered[i] = raw; 
-            } else {
-                adcFiltered[i] = (alpha * raw) + ((1.0f - alpha) * adcFiltered[i]);
+            raw[i] = analogRead(ADC_PINS[i]);
+        }
+        adcFilter.processBlock(raw, chan, 4);
+    }
+
+    if (!adcFilter.ready(0)) return;
+
+    for (int i = 0; i < 4; i++) {
+        d.adcValues[i] = (int)adcFilter.value(i);
+    }
+
+    // Process Comparator Logic
+    int activeCount = 0;
+    for (int i = 0; i < 4; i++) {
+        d.logicLevels[i] = 1.0f - (adcFilter.value(i) / 4095.0f);
+        if (d.logicLevels[i] > 0.5f) {
+            activeCount++;
+        }
+    }
+    d.adcSoC = activeCount * 25.0f;
+    freshMask |= SAMPLE_FRESH_ADC;
+}
+
+void SensorService::readGps() {
+#if ENABLE_GPS
+    if (currentSystemMode != MODE_SENSOR) return;
+    MeasurementData& d = current;
+    GpsFix fix;
+    if (gps.getFix(fix, gpsFixSeq)) {
+        d.satellites = fix.satellites;
+        // Satellite-count updates arrive without a new position; only a
+        // new fix time marks the GPS source fresh, as before
+        if (fix.fixMs != gpsFixMs) {
+            gpsFixMs = fix.fixMs;
+            if (fix.valid) {
+                d.lat = fix.lat;
+                d.lng = fix.lng;
             }
-            
-            d.adcValues[i] = (int)adcFiltered[i];
+            freshMask |= SAMPLE_FRESH_GPS;
         }
+    }
+#endif
+}
 
-        // Process Comparator Logic
-        int activeCount = 0;
-        for (int i = 0; i < 4; i++) {
-            d.logicLevels[i] = 1.0f - (adcFiltered[i] / 4095.0f);
-            if (d.logicLevels[i] > 0.5f) {
-                activeCount++;
+// Feeds the RTC to SystemClock (holdover when NTP/GPS are absent) and
+// rewrites it once it has drifted a second from a better source
+void SensorService::readRtc() {
+#if ENABLE_RTC
+    if (rtcOK && i2c.call(rtcDev, I2C_PRIO_LOW, SensorService::rtcRead, this)) {
+        if (systemClock.disciplineRtc(rtcSec, rtcMonoUs)) {
+            // Writing the seconds register restarts the RTC's second, so
+            // rounding keeps its phase within ±0.5 s without waiting
+            int64_t t = systemClock.epochUsAt(SystemClock::monoUs());
+            rtcSec = (uint32_t)((t + 500000) / 1000000);
+            if (i2c.call(rtcDev, I2C_PRIO_LOW, SensorService::rtcWrite, this)) {
+                Serial.println("RTC re-synced from system clock");
             }
         }
-        d.adcSoC = activeCount * 25.0f;
+        freshMask |= SAMPLE_FRESH_RTC;
     }
+#endif
+}
 
-    // Update local protected copy
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        latest = d;
-        xSemaphoreGive(mutex);
+bool SensorService::rtcBegin(void* self) {
+    SensorService* s = (SensorService*)self;
+    if (!s->rtc.begin()) return false;
+    if (s->rtc.lostPower()) {
+        s->rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
     }
+    return true;
+}
+
+bool SensorService::rtcRead(void* self) {
+    SensorService* s = (SensorService*)self;
+    s->rtcSec = s->rtc.now().unixtime();
+    s->rtcMonoUs = SystemClock::monoUs();
+    return true;
+}
+
+bool SensorService::rtcWrite(void* self) {
+    SensorService* s = (SensorService*)self;
+    s->rtc.adjust(DateTime(s->rtcSec));
+    return true;
+}
 
-    // Send to Queue for Telemetry (Always send heartbeat for timestamp continuity)
-    if (dataQueuePtr && *dataQueuePtr) {
-        xQueueSend(*dataQueuePtr, &d, pdMS_TO_TICKS(10));
+// Emits the merged record: latest value of every source, the power
+// extremes since the previous record, and which sources updated
+void SensorService::emitSample() {
+    MeasurementData d;
+    if (currentSystemMode == MODE_SENSOR) {
+        d = current;
+    } else {
+        memset(&d, 0, sizeof(d));
+    }
+    if (d.powerReads == 0) {
+        d.vinMin = d.vinMax = d.vin;
+        d.iinMin = d.iinMax = d.iin;
+    }
+    current.powerReads = 0; // Next interval starts with the next reading
+    stampSample(d);
+    d.fresh = freshMask;
+    freshMask = 0;
+
+    // One publish reaches every consumer (always sent, even in sleep mode,
+    // as a heartbeat for timestamp continuity)
+    if (bus) {
+        bus->publish(d);
+        metrics.markBoot(BOOT_FIRST_SAMPLE);
     }
 }
 
 void SensorService::updateSoC(MeasurementData& d) {
-    unsigned long now = millis();
-    if (lastSocMs == 0) {
-        lastSocMs = now;
+    // Integrates over the measured interval, so wake jitter cannot bias it
+    int64_t now = SystemClock::monoUs();
+    if (lastSocUs == 0) {
+        lastSocUs = now;
         // First run: Init from voltage
         d.battSoC = getSoCFromVoltage(d.vin);
         socAccum = d.battSoC;
@@ -167,8 +500,8 @@ void SensorService::updateSoC(MeasurementData& d) {
         return;
     }
 
-    float deltaSeconds = (now - lastSocMs) / 1000.0f;
-    lastSocMs = now;
+    float deltaSeconds = (now - lastSocUs) * 1e-6f;
+    lastSocUs = now;
 
     // 1. Coulomb Counting
     // getCurrent() returns Amps. Positive = Charging, Negative = Discharging (presumably)
@@ -180,8 +513,12 @@ void SensorService::updateSoC(MeasurementData& d) {
     // Only correct if current is very low (idle) to avoid voltage drop error
     if (abs(d.iin) < OCV_IDLE_THRESHOLD) {
         float ocvSoC = getSoCFromVoltage(d.vin);
-        // Slowly drift toward OCV to correct Coulomb Counting errors
-        socAccum = (socAccum * 0.98f) + (ocvSoC * 0.02f);
+        // Slowly drift toward OCV to correct Coulomb Counting errors; the
+        // weight scales with elapsed time so the rate does not depend on
+        // how often the power channel runs
+        float k = deltaSeconds / OCV_TAU_S;
+        if (k > 1.0f) k = 1.0f;
+        socAccum += (ocvSoC - socAccum) * k;
     }
 
     // Clamp
@@ -211,37 +548,11 @@ float SensorService::getSoCFromVoltage(float v) {
     return (v - 6.0f) * (10.0f / 0.4f);
 }
 
-void SensorService::makeTimestamp(char* out, size_t outSize) {
-#if ENABLE_RTC
-    if (rtcOK) {
-        DateTime now = rtc.now();
-        const char* days[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-        snprintf(out, outSize, "%s %04d-%02d-%02d %02d:%02d:%02d",
-                 days[now.dayOfTheWeek()],
-                 now.year(), now.month(), now.day(),
-                 now.hour(), now.minute(), now.second());
-        return;
-    }
-#endif
-    snprintf(out, outSize, "ms_%lu", (unsigned long)millis());
-}
-
-void SensorService::syncTime(struct tm* timeinfo) {
-#if ENABLE_RTC
-    if (rtcOK) {
-        rtc.adjust(DateTime(
-            timeinfo->tm_year + 1900,
-            timeinfo->tm_mon + 1,
-            timeinfo->tm_mday,
-            timeinfo->tm_hour,
-            timeinfo->tm_min,
-            timeinfo->tm_sec
-        ));
-        Serial.println("RTC Synced with NTP Time!");
-    } else {
-        Serial.println("RTC not OK, cannot sync.");
-    }
-#else
-    Serial.println("RTC not enabled, cannot sync.");
-#endif
+// Binary timestamp only; text formatting happens at the output edges.
+// No bus traffic: the wall clock comes from the disciplined SystemClock.
+void SensorService::stampSample(MeasurementData& d) {
+    d.monoUs = SystemClock::monoUs();
+    d.uptimeMs = (uint32_t)(d.monoUs / 1000);
+    d.epoch = systemClock.epochAt(d.monoUs);
+    d.timeSource = systemClock.getSource();
 }
@@ -2,25 +2,67 @@
 #define SENSOR_SERVICE_H
 
 #include "DataModel.h"
+#include "SampleBus.h"
 #include <Wire.h>
-#include <TinyGPS++.h>
+#include "GpsService.h"
 #include <RTClib.h>
-#include "INA226.h"
+#include "I2cService.h"
+#include "PowerMonitor.h"
+#include "AdcFilter.h"
+#include "PowerTrigger.h"
+#if ENABLE_ADC_DMA
+#include "esp_adc/adc_continuous.h"
+#endif
 
 // I2C Pins
 #define I2C_SDA 41
 #define I2C_SCL 42
 
+// DS3231 on the shared bus, driven through RTClib on I2cTask
+#define RTC_I2C_ADDR       0x68
+#define RTC_I2C_CLOCK_HZ   400000
+#define RTC_I2C_TIMEOUT_MS 10
+
+// INA226 (IN) ALERT, open drain → INT1 on the stack connector; -1 = no
+// line, read on every POWER_PERIOD_MS
+#define PM_ALERT_PIN 48
+#define PM_PROFILE   PM_PROFILE_TELEMETRY // See PowerMonitor.h
+
 // SoC Config (Li-ion 2S 3200mAh)
 #define BATT_CAPACITY_MAH   3200.0f
 #define BATT_FULL_V         8.4f
 #define BATT_EMPTY_V        6.0f
 #define OCV_IDLE_THRESHOLD  0.050f  // A - below this is considered idle for OCV correction
+#define OCV_TAU_S           50.0f   // s - time constant of the pull toward OCV while idle
+
+
+// Sampling periods per source (ms). Each source runs on its own absolute
+// deadline; the merged record is emitted every SAMPLE_PERIOD_MS.
+#if PM_ALERT_PIN >= 0
+#define POWER_PERIOD_MS   5      // Check the conversion-ready flag; bus traffic only per conversion (~53 Hz)
+#else
+#define POWER_PERIOD_MS   20     // INA226 pair, 50 Hz
+#endif
+#if ENABLE_ADC_DMA
+#define ADC_PERIOD_MS     10     // Drain ADC DMA frames (conversion runs in hardware)
+#else
+#define ADC_PERIOD_MS     1      // Comparator ADCs polled at 1 kHz
+#endif
+#define GPS_PERIOD_MS     10     // Pick up fixes from GpsTask as they arrive
+#define RTC_PERIOD_MS     60000  // RTC → SystemClock holdover check once per minute
+#define SAMPLE_PERIOD_MS  1000   // Merged record published on the SampleBus
 
+// Continuous ADC: 20 kS/s across the 4 pins (5 kS/s each), boxcar of 50
+// per pin → 100 Hz decimated stream per pin, then EMA
+#define ADC_DMA_SAMPLE_HZ   20000
+#define ADC_DMA_FRAME_BYTES 256   // 64 conversions per DMA frame
+#define ADC_DMA_POOL_BYTES  2048  // Driver ring between ISR and readAdc()
+#define ADC_DECIMATION      50
 
-// GPS Pins
-#define GPS_RX_PIN 21 // GPS TX -> ESP RX
-#define GPS_TX_PIN 47 // GPS RX -> ESP TX
+// ADC EMA time constants (ms) — equivalent to alpha 0.05 / 0.2 at 1 Hz
+#define ADC_EMA_TAU_WARMUP_MS 19000
+#define ADC_EMA_TAU_MS        4000
+#define ADC_WARMUP_MS         300000
 
 // ADC Pins — ordered by physical socket: Pin37→38→39→40
 // ADC0=GPIO3(Pin37), ADC1=GPIO2(Pin38), ADC2=GPIO14(Pin39), ADC3=GPIO1(Pin40)
@@ -30,45 +72,95 @@ class SensorService {
 public:
     SensorService();
     void begin();
-    MeasurementData getLatestData(); 
-    void syncTime(struct tm* timeinfo);
+    void start(); // Starts SensorTask; call after the bus consumers subscribe
+    bool getLatestData(MeasurementData& out) { return bus && bus->latest(out); } // false until the first sample exists
+    GpsStats getGpsStats() { return gps.getStats(); }
+    bool getGpsFix(GpsFix& out) { return gps.getLatestFix(out); }
+    uint32_t getI2cErrors() const { return i2cErrors; }
+    I2cBus& getI2cBus() { return i2c.getBus(); } // Per-device and recovery stats
+    uint32_t getPowerAlertTimeouts() const { return powerAlertTimeouts; }
+    uint32_t getAdcOverflows() const;
+    PowerTrigger* getPowerTrigger() { return &powerTrigger; } // Captures for MQTT/SD
+
+    enum Channel { CH_POWER, CH_ADC, CH_GPS, CH_RTC, CH_SAMPLE, CH_COUNT };
+    static const char* channelName(Channel c);
+    uint32_t getOverruns(Channel c) const { return channels[c].overruns; }
 
 private:
+
+    struct SensorChannel {
+        TickType_t period;
+        TickType_t next; // Absolute deadline, advanced by whole periods
+        volatile uint32_t overruns; // Periods skipped because the source ran late
+    };
+
     static void task(void* param);
-    void loop();
-    void makeTimestamp(char* out, size_t outSize);
+    TickType_t runDue(TickType_t now);
+    void readPower();
+    void readAdc();
+    void beginAdc();
+    void readGps();
+    void readRtc();
+    void emitSample();
+    void stampSample(MeasurementData& d);
     void updateSoC(MeasurementData& d);
     float getSoCFromVoltage(float voltage);
 
 
-    INA226 ina_in; // 0x41
-    INA226 ina_out; // 0x44
+    I2cService i2c; // Owns Wire; declared before the drivers that use it
+    PowerMonitor ina_in;  // 0x41
+    PowerMonitor ina_out; // 0x51
+    static void IRAM_ATTR onPowerAlert(void* arg);
+    volatile bool powerReady;          // Set by the ALERT interrupt
+    int64_t lastPowerUs;               // monoUs of the last reading
+    uint32_t powerAlertTimeouts;       // Readings forced because ALERT stayed quiet
     RTC_DS3231 rtc;
-    TinyGPSPlus gps;
-    HardwareSerial gpsSerial;
+    int rtcDev;
+    uint32_t rtcSec;     // In/out of the RTC calls below
+    int64_t rtcMonoUs;   // monoUs right after the read
+    static bool rtcBegin(void* self); // Run on I2cTask via I2cService::call
+    static bool rtcRead(void* self);
+    static bool rtcWrite(void* self);
+    GpsService gps;
+    uint32_t gpsFixSeq; // Last fix consumed from GpsTask
+    uint32_t gpsFixMs;  // GpsFix::fixMs of the position in `current`
 
     bool inaInOK;
     bool inaOutOK;
     bool rtcOK;
+    volatile uint32_t i2cErrors; // INA226 transactions that failed
 
-    MeasurementData latest;
-    SemaphoreHandle_t mutex;
-    QueueHandle_t* dataQueuePtr; // Pointer to the main queue
-    
-    // GPS NMEA Parsing State
-    String nmeaSentence;
-    int totalSatsInView;
+    SampleBus* bus; // Every merged record is published here
+
+    // Fed with every INA226 reading (SensorTask); captures are drained by
+    // MqttService and TelemetryService
+    PowerTrigger powerTrigger;
+    void beginPowerTrigger();
+
+    // Multi-rate scheduler state
+    SensorChannel channels[CH_COUNT];
+    MeasurementData current; // Merged state, updated by each source at its own rate
+    uint8_t freshMask;
 
     // SoC State
     float socAccum;        // Current SoC %
-    unsigned long lastSocMs;
+    int64_t lastSocUs;     // SystemClock::monoUs() of the previous integration step
     bool socInitialized;
 
-    float adcFiltered[4];
+    AdcFilter adcFilter;
+    float adcAlphaWarmup;
+    float adcAlpha;
+#if ENABLE_ADC_DMA
+    adc_continuous_handle_t adcHandle;
+    uint8_t adcChanIndex[SOC_ADC_MAX_CHANNEL_NUM]; // ADC1 channel → ADC_PINS index
+    bool adcDmaOK;
+    volatile uint32_t adcDmaOverflows;              // Pool overruns reported by the driver
+    static bool adcPoolOverflow(adc_continuous_handle_t h, const adc_continuous_evt_data_t* e, void* user);
+#endif
     unsigned long bootTimeMs;
     
 public:
-    void setDataQueue(QueueHandle_t* q) { dataQueuePtr = q; }
+    void setSampleBus(SampleBus* b) { bus = b; }
 };
 
 #endif
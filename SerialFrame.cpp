@@ -0,0 +1,58 @@
+#include "SerialFrame.h"
+
+size_t encodeSerialFrame(uint8_t* out, size_t outSize, const uint8_t* payload, size_t len) {
+    if (!out || len == 0 || len > SERIAL_FRAME_MAX_PAYLOAD || outSize < SERIAL_FRAME_SIZE(len)) return 0;
+    size_t o = 0;
+    out[o++] = SERIAL_FRAME_DELIM;
+    // Each code byte holds the distance to the next zero (or the block end)
+    size_t code = o++;
+    uint8_t run = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (payload[i] == 0) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+        } else {
+            out[o++] = payload[i];
+            run++;
+        }
+    }
+    out[code] = run;
+    out[o++] = SERIAL_FRAME_DELIM;
+    return o;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) {
+            if (in[i] == 0) return 0;
+            out[o++] = in[i++];
+        }
+        // A short block stands for a zero, except at the very end
+        if (code < 0xFF && i < len) out[o++] = 0;
+    }
+    return o;
+}
+
+bool SerialFrameReader::feed(uint8_t b) {
+    if (done) {
+        len = 0;
+        done = false;
+    }
+    if (b != SERIAL_FRAME_DELIM) {
+        if (len < sizeof(buf)) buf[len++] = b;
+        else overlong = true;
+        return false;
+    }
+    if (overlong) {
+        overruns++;
+        overlong = false;
+        len = 0;
+        return false;
+    }
+    done = len > 0;
+    return done;
+}
@@ -0,0 +1,52 @@
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+// COBS framing for binary telemetry on the serial port.
+// Plain C++ with no Arduino dependencies: the firmware encodes with it
+// (SerialSink, binary mode), the ground tools decode with it
+// (tools/ground/telemetry_decode --serial).
+//
+// Consistent Overhead Byte Stuffing removes every 0x00 from the payload
+// at a cost of one byte per 254, so 0x00 marks frame boundaries and a
+// receiver that starts mid-stream or loses bytes resynchronizes at the
+// next one. Each frame is sent as 0x00, COBS(payload), 0x00; the leading
+// delimiter cuts off any log text printed on the same port before it.
+// The payload is a TelemetryFrame, which carries its own CRC-16.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SERIAL_FRAME_DELIM 0x00
+#define SERIAL_FRAME_MAX_PAYLOAD 254 // One COBS block; longer payloads are refused
+
+// Encoded size of a `len`-byte payload, delimiters included
+#define SERIAL_FRAME_SIZE(len) ((len) + 3)
+
+// Writes 0x00, COBS(payload), 0x00. Returns the frame length, or 0 if the
+// payload is empty, too long or does not fit in `outSize`.
+size_t encodeSerialFrame(uint8_t* out, size_t outSize, const uint8_t* payload, size_t len);
+
+// Decodes one COBS block (delimiters stripped) in place or into `out`,
+// which needs `len` bytes. Returns the payload length, or 0 if malformed.
+size_t cobsDecode(const uint8_t* in, size_t len, uint8_t* out);
+
+// Splits a byte stream at 0x00 delimiters. feed() returns true when
+// packet()/length() hold a complete, still encoded block.
+class SerialFrameReader {
+public:
+    SerialFrameReader() : len(0), overlong(false), done(false), overruns(0) {}
+    bool feed(uint8_t b);
+    const uint8_t* packet() const { return buf; }
+    size_t length() const { return len; }
+    // Blocks longer than the buffer, discarded (usually log text between frames)
+    unsigned long getOverruns() const { return overruns; }
+
+private:
+    uint8_t buf[SERIAL_FRAME_MAX_PAYLOAD + 1];
+    size_t len;
+    bool overlong;
+    bool done; // packet() was handed out; start over on the next byte
+    unsigned long overruns;
+};
+
+#endif
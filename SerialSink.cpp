@@ -0,0 +1,46 @@
+#include "SerialSink.h"
+#include "Metrics.h"
+#include "esp_timer.h"
+
+SerialSink::SerialSink(Print& o) : out(o), ring(NULL) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool SerialSink::begin() {
+    ring = xRingbufferCreate(SERIAL_SINK_BUFFER_BYTES, RINGBUF_TYPE_NOSPLIT);
+    if (!ring) {
+        Serial.println("SerialSink: ring allocation FAILED");
+        return false;
+    }
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(SerialSink::task, "SerialTask", SERIAL_SINK_TASK_STACK, this, SERIAL_SINK_TASK_PRIO, &handle, 0);
+    metrics.setTask(MTASK_SERIAL, handle);
+    return true;
+}
+
+bool SerialSink::write(const void* data, size_t len) {
+    if (!ring || xRingbufferSend(ring, data, len, 0) != pdTRUE) {
+        stats.dropped++;
+        stats.droppedBytes += len;
+        return false;
+    }
+    uint32_t used = SERIAL_SINK_BUFFER_BYTES - xRingbufferGetCurFreeSize(ring);
+    if (used > stats.queuedMax) stats.queuedMax = used;
+    return true;
+}
+
+void SerialSink::task(void* param) {
+    SerialSink* self = (SerialSink*)param;
+    for (;;) {
+        size_t len = 0;
+        uint8_t* item = (uint8_t*)xRingbufferReceive(self->ring, &len, portMAX_DELAY);
+        if (!item) continue;
+        int64_t start = esp_timer_get_time();
+        self->out.write(item, len); // Blocks here, at line rate, instead of in the producer
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+        vRingbufferReturnItem(self->ring, item);
+        self->stats.frames++;
+        self->stats.bytes += len;
+        if (us > self->stats.writeMaxUs) self->stats.writeMaxUs = us;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef SERIAL_SINK_H
+#define SERIAL_SINK_H
+
+#include <Arduino.h>
+#include <freertos/ringbuf.h>
+
+// Serial output without blocking the producer. write() copies a whole
+// frame into a FreeRTOS ring buffer and returns; SerialTask drains it into
+// the UART driver at line rate. A frame that does not fit is dropped whole
+// and counted, so the port never carries a torn frame.
+#define SERIAL_SINK_BUFFER_BYTES 4096 // ~17 text or ~50 binary frames
+#define SERIAL_SINK_TASK_PRIO    1
+#define SERIAL_SINK_TASK_STACK   2048
+
+// Sample output format on the serial port
+enum SerialFormat {
+    SERIAL_FORMAT_TEXT,  // /*...*/ CSV lines for Serial Studio, ~200 bytes
+    SERIAL_FORMAT_BINARY // COBS-framed TelemetryFrame (SerialFrame.h), 73 bytes
+};
+
+struct SerialSinkStats {
+    uint32_t frames;       // Handed to the UART driver
+    uint32_t bytes;
+    uint32_t dropped;      // Frames refused because the ring was full
+    uint32_t droppedBytes;
+    uint32_t queuedMax;    // Peak ring usage in bytes, item headers included (approximate)
+    uint32_t writeMaxUs;   // Longest single UART write, i.e. how long SerialTask blocked
+};
+
+class SerialSink {
+public:
+    SerialSink(Print& out = Serial);
+    bool begin();
+    // Never blocks; false if the frame was dropped
+    bool write(const void* data, size_t len);
+    SerialSinkStats getStats() const { return stats; }
+
+private:
+    static void task(void* param);
+
+    Print& out;
+    RingbufHandle_t ring;
+    SerialSinkStats stats; // Producer: dropped*, queuedMax; SerialTask: the rest
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "SystemClock.h"
+#include <esp_sntp.h>
+
+static int32_t clampUs(int64_t us) {
+    if (us > INT32_MAX) return INT32_MAX;
+    if (us < INT32_MIN) return INT32_MIN;
+    return (int32_t)us;
+}
+
+SystemClock::SystemClock()
+    : source(CLOCK_SRC_NONE), baseMonoUs(0), baseEpochUs(0), driftPpb(0), driftKnown(false),
+      driftSrc(CLOCK_SRC_NONE), driftMonoUs(0), driftEpochUs(0), lastErrorUs(0), rtcErrorUs(0), steps(0) {
+    lock = portMUX_INITIALIZER_UNLOCKED;
+    memset(syncs, 0, sizeof(syncs));
+}
+
+void SystemClock::begin() {
+    sntp_set_time_sync_notification_cb(SystemClock::onSntpSync);
+}
+
+// Runs on the lwIP task right after SNTP set the system time
+void SystemClock::onSntpSync(struct timeval* tv) {
+    int64_t mono = monoUs();
+    int64_t ref = ((int64_t)tv->tv_sec + CLOCK_TZ_OFFSET_S) * 1000000 + tv->tv_usec;
+    systemClock.discipline(CLOCK_SRC_NTP, ref, mono);
+}
+
+// Caller holds lock
+int64_t SystemClock::predictLocked(int64_t mono) const {
+    if (source == CLOCK_SRC_NONE) return 0;
+    int64_t dt = mono - baseMonoUs;
+    return baseEpochUs + dt - dt * driftPpb / 1000000000;
+}
+
+// Caller holds lock
+void SystemClock::acceptLocked(ClockSource src, int64_t refEpochUs, int64_t atMonoUs) {
+    int64_t error = source == CLOCK_SRC_NONE ? 0 : refEpochUs - predictLocked(atMonoUs);
+    bool step = source == CLOCK_SRC_NONE || error > CLOCK_STEP_US || error < -CLOCK_STEP_US;
+    if (step) steps++;
+    lastErrorUs = clampUs(error);
+
+    // Rate error against an earlier reference from the same source; its
+    // constant latency cancels out
+    if (step || src != driftSrc) {
+        driftSrc = src;
+        driftMonoUs = atMonoUs;
+        driftEpochUs = refEpochUs;
+    } else {
+        int64_t monoSpan = atMonoUs - driftMonoUs;
+        if (monoSpan >= (int64_t)CLOCK_DRIFT_MIN_SPAN_MS * 1000) {
+            int64_t fast = monoSpan - (refEpochUs - driftEpochUs);
+            int64_t ppb = fast * 1000000000 / monoSpan;
+            int64_t maxPpb = (int64_t)CLOCK_MAX_DRIFT_PPM * 1000;
+            if (ppb > maxPpb) ppb = maxPpb;
+            if (ppb < -maxPpb) ppb = -maxPpb;
+            driftPpb = driftKnown ? (int32_t)((driftPpb + ppb) / 2) : (int32_t)ppb;
+            driftKnown = true;
+            driftMonoUs = atMonoUs;
+            driftEpochUs = refEpochUs;
+        }
+    }
+
+    baseMonoUs = atMonoUs;
+    baseEpochUs = refEpochUs;
+    source = src;
+    syncs[src]++;
+}
+
+bool SystemClock::discipline(ClockSource src, int64_t refEpochUs, int64_t atMonoUs) {
+    portENTER_CRITICAL(&lock);
+    int64_t sinceSync = atMonoUs - baseMonoUs;
+    bool accept = source == CLOCK_SRC_NONE ||
+                  src > source ||
+                  (src == source && sinceSync >= (int64_t)CLOCK_MIN_SYNC_INTERVAL_MS * 1000) ||
+                  sinceSync >= (int64_t)CLOCK_HOLDOVER_MS * 1000;
+    if (accept) acceptLocked(src, refEpochUs, atMonoUs);
+    portEXIT_CRITICAL(&lock);
+    return accept;
+}
+
+bool SystemClock::disciplineRtc(uint32_t rtcSec, int64_t atMonoUs) {
+    // The RTC second started somewhere in the last 1 s: take the midpoint
+    int64_t lo = (int64_t)rtcSec * 1000000;
+    int64_t mid = lo + 500000;
+
+    portENTER_CRITICAL(&lock);
+    int64_t pred = predictLocked(atMonoUs);
+    rtcErrorUs = source == CLOCK_SRC_NONE ? 0 : clampUs(mid - pred);
+    bool better = source > CLOCK_SRC_RTC && atMonoUs - baseMonoUs < (int64_t)CLOCK_HOLDOVER_MS * 1000;
+    bool consistent = source != CLOCK_SRC_NONE && pred >= lo - 1000000 && pred < lo + 2000000; // Within a second of the RTC window
+    if (!better && !consistent) acceptLocked(CLOCK_SRC_RTC, mid, atMonoUs);
+    portEXIT_CRITICAL(&lock);
+    return better && !consistent;
+}
+
+int64_t SystemClock::epochUsAt(int64_t mono) const {
+    portENTER_CRITICAL(&lock);
+    int64_t t = predictLocked(mono);
+    portEXIT_CRITICAL(&lock);
+    return t;
+}
+
+ClockStats SystemClock::getStats() const {
+    ClockStats s;
+    portENTER_CRITICAL(&lock);
+    s.source = source;
+    s.driftPpm = driftPpb / 1000.0f;
+    s.lastErrorUs = lastErrorUs;
+    s.rtcErrorUs = rtcErrorUs;
+    s.syncAgeS = source == CLOCK_SRC_NONE ? 0 : (uint32_t)((monoUs() - baseMonoUs) / 1000000);
+    memcpy(s.syncs, syncs, sizeof(syncs));
+    s.steps = steps;
+    portEXIT_CRITICAL(&lock);
+    return s;
+}
+
+// Days-from-civil (proleptic Gregorian), no libc time zone involved
+uint32_t SystemClock::epochFromCivil(int year, int month, int day, int hour, int minute, int second) {
+    year -= month <= 2;
+    int era = year / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int32_t days = era * 146097 + doe - 719468;
+    return (uint32_t)days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+const char* SystemClock::sourceName(ClockSource s) {
+    switch (s) {
+        case CLOCK_SRC_NONE: return "none";
+        case CLOCK_SRC_RTC:  return "rtc";
+        case CLOCK_SRC_GPS:  return "gps";
+        case CLOCK_SRC_NTP:  return "ntp";
+        default:             return "?";
+    }
+}
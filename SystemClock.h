@@ -0,0 +1,83 @@
+#ifndef SYSTEM_CLOCK_H
+#define SYSTEM_CLOCK_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// Monotonic microsecond clock (esp_timer, never steps) mapped to wall-clock
+// time by an anchor that is disciplined against the best available
+// reference: NTP > GPS > RTC. Samples are stamped from this clock; text
+// formatting happens only at the output edges.
+#define CLOCK_TZ_OFFSET_S          (7 * 3600) // Wall clock (RTC, MeasurementData::epoch) is local time, UTC+7
+#define CLOCK_MIN_SYNC_INTERVAL_MS 60000      // Same-source re-anchors closer than this are ignored
+#define CLOCK_HOLDOVER_MS          21600000   // A better source steers for 6 h before lower ones may take over
+#define CLOCK_DRIFT_MIN_SPAN_MS    3000000    // Drift is estimated over >= 50 min between same-source syncs (SNTP resyncs hourly)
+#define CLOCK_MAX_DRIFT_PPM        200        // Crystal error clamp
+#define CLOCK_STEP_US              500000     // Larger corrections are steps, not drift evidence
+#define CLOCK_GPS_LATENCY_US       0          // RMC arrival after the top of its second (module specific)
+
+enum ClockSource : uint8_t {
+    CLOCK_SRC_NONE, // Never synced: epoch reads as 0
+    CLOCK_SRC_RTC,  // DS3231, 1 s resolution
+    CLOCK_SRC_GPS,  // NMEA RMC time, stamped at sentence arrival
+    CLOCK_SRC_NTP,  // SNTP sync notification
+    CLOCK_SRC_COUNT
+};
+
+struct ClockStats {
+    ClockSource source;     // Source currently steering the wall clock
+    float driftPpm;         // Estimated crystal error (+ = local clock fast)
+    int32_t lastErrorUs;    // Reference minus prediction at the last accepted sync
+    int32_t rtcErrorUs;     // RTC minus prediction at the last RTC read (±0.5 s resolution)
+    uint32_t syncAgeS;      // Since the last accepted sync
+    uint32_t syncs[CLOCK_SRC_COUNT];
+    uint32_t steps;         // Accepted syncs that moved the wall clock by > CLOCK_STEP_US
+};
+
+class SystemClock {
+public:
+    SystemClock();
+    void begin(); // Hooks SNTP sync notifications
+
+    static int64_t monoUs() { return esp_timer_get_time(); }
+
+    // refEpochUs is local wall-clock µs observed at monotonic time atMonoUs.
+    // Returns true if the reference was accepted.
+    bool discipline(ClockSource src, int64_t refEpochUs, int64_t atMonoUs);
+    // RTC seconds read at atMonoUs. Steers only when nothing better is
+    // current; returns true if the RTC is off by more than a second from
+    // a better source and should be rewritten.
+    bool disciplineRtc(uint32_t rtcSec, int64_t atMonoUs);
+
+    int64_t epochUsAt(int64_t mono) const; // 0 if never synced
+    uint32_t epochAt(int64_t mono) const { return (uint32_t)(epochUsAt(mono) / 1000000); }
+    ClockSource getSource() const { return source; }
+    ClockStats getStats() const;
+
+    static uint32_t epochFromCivil(int year, int month, int day, int hour, int minute, int second);
+    static const char* sourceName(ClockSource s);
+
+private:
+    static void onSntpSync(struct timeval* tv);
+    int64_t predictLocked(int64_t mono) const;
+    void acceptLocked(ClockSource src, int64_t refEpochUs, int64_t atMonoUs);
+
+    mutable portMUX_TYPE lock; // Disciplined from SensorTask, GpsTask and the lwIP task
+    ClockSource source;
+    int64_t baseMonoUs;
+    int64_t baseEpochUs;
+    int32_t driftPpb;
+    bool driftKnown;
+    // Drift baseline: an earlier reference from the same source
+    ClockSource driftSrc;
+    int64_t driftMonoUs;
+    int64_t driftEpochUs;
+    int32_t lastErrorUs;
+    int32_t rtcErrorUs;
+    uint32_t syncs[CLOCK_SRC_COUNT];
+    uint32_t steps;
+};
+
+extern SystemClock systemClock;
+
+#endif
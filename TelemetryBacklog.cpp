@@ -0,0 +1,274 @@
+#include "TelemetryBacklog.h"
+#if BACKLOG_SPILL_SD
+#include <SD_MMC.h>
+#endif
+
+TelemetryBacklog::TelemetryBacklog()
+    : ring(nullptr), capacity(0), head(0), tail(0), used(0), count(0),
+      spillCount(0), spillReadPos(0), spillBytes(0), spillPeekLen(0), dropped(0), drained(0), highWater(0) {
+#if BACKLOG_SPILL_SD
+    spillUnflushed = false;
+    spillBufPos = 0;
+    spillBufLen = 0;
+#endif
+}
+
+bool TelemetryBacklog::begin() {
+    if (psramFound()) {
+        ring = (uint8_t*)ps_malloc(BACKLOG_PSRAM_BYTES);
+        capacity = BACKLOG_PSRAM_BYTES;
+    }
+    if (!ring) {
+        ring = (uint8_t*)malloc(BACKLOG_HEAP_BYTES);
+        capacity = BACKLOG_HEAP_BYTES;
+    }
+    if (!ring) {
+        capacity = 0;
+        Serial.println("Backlog: allocation FAILED");
+        return false;
+    }
+#if BACKLOG_SPILL_SD
+    // Leftover spill from before a reboot is not replayed: its sequence
+    // numbers belong to the previous session
+    if (SD_MMC.exists(BACKLOG_SPILL_FILE)) SD_MMC.remove(BACKLOG_SPILL_FILE);
+#endif
+    Serial.printf("Backlog: %u bytes in %s\n", (unsigned)capacity, psramFound() ? "PSRAM" : "heap");
+    return true;
+}
+
+void TelemetryBacklog::copyIn(size_t pos, const void* src, size_t n) {
+    const uint8_t* s = (const uint8_t*)src;
+    size_t first = capacity - pos;
+    if (first > n) first = n;
+    memcpy(ring + pos, s, first);
+    memcpy(ring, s + first, n - first);
+}
+
+void TelemetryBacklog::copyOut(size_t pos, void* dst, size_t n) const {
+    uint8_t* d = (uint8_t*)dst;
+    size_t first = capacity - pos;
+    if (first > n) first = n;
+    memcpy(d, ring + pos, first);
+    memcpy(d + first, ring, n - first);
+}
+
+uint16_t TelemetryBacklog::lenAt(size_t pos) const {
+    uint16_t len;
+    copyOut(pos, &len, sizeof(len));
+    return len;
+}
+
+bool TelemetryBacklog::push(uint32_t seq, const char* data, size_t len) {
+    size_t need = HEADER + len;
+    if (!ring || len > 0xFFFF || need > capacity) {
+        dropped++;
+        return false;
+    }
+
+#if BACKLOG_DROP_POLICY == BACKLOG_DROP_DECIMATE && !BACKLOG_SPILL_SD
+    if (capacity - used < need) decimate();
+#endif
+    while (capacity - used < need) {
+        if (!evictOldest()) return false;
+    }
+
+    uint16_t len16 = (uint16_t)len;
+    copyIn(head, &len16, sizeof(len16));
+    copyIn((head + 2) % capacity, &seq, sizeof(seq));
+    copyIn((head + HEADER) % capacity, data, len);
+    head = (head + need) % capacity;
+    used += need;
+    count++;
+    if (used > highWater) highWater = used;
+    return true;
+}
+
+// Removes the oldest RAM entry, spilling it to SD when enabled
+bool TelemetryBacklog::evictOldest() {
+    if (count == 0) return false;
+    uint16_t len = lenAt(tail);
+    if (!spill(tail, len)) dropped++;
+    tail = (tail + HEADER + len) % capacity;
+    used -= HEADER + len;
+    count--;
+    return true;
+}
+
+// Keeps every other entry (oldest first), compacting the ring in place.
+// Halves the time resolution of the outage instead of losing its start.
+void TelemetryBacklog::decimate() {
+    if (count < 2) return;
+    size_t rd = tail;
+    size_t wr = tail;
+    uint32_t kept = 0;
+    size_t keptBytes = 0;
+    uint8_t tmp[256];
+
+    for (uint32_t i = 0; i < count; i++) {
+        size_t recLen = HEADER + lenAt(rd);
+        if (i % 2 == 0) {
+            // wr never overtakes rd, so chunked forward copying is safe
+            for (size_t off = 0; off < recLen; off += sizeof(tmp)) {
+                size_t n = recLen - off;
+                if (n > sizeof(tmp)) n = sizeof(tmp);
+                copyOut((rd + off) % capacity, tmp, n);
+                copyIn((wr + off) % capacity, tmp, n);
+            }
+            wr = (wr + recLen) % capacity;
+            kept++;
+            keptBytes += recLen;
+        } else {
+            dropped++;
+        }
+        rd = (rd + recLen) % capacity;
+    }
+    head = wr;
+    used = keptBytes;
+    count = kept;
+}
+
+bool TelemetryBacklog::spill(size_t pos, uint16_t len) {
+#if BACKLOG_SPILL_SD
+    size_t recLen = HEADER + len;
+    if (spillBytes + recLen > BACKLOG_SPILL_MAX_BYTES) return false;
+    if (!spillOut) spillOut = SD_MMC.open(BACKLOG_SPILL_FILE, FILE_APPEND, true);
+    if (!spillOut) return false;
+    uint8_t tmp[256];
+    bool ok = true;
+    for (size_t off = 0; off < recLen && ok; off += sizeof(tmp)) {
+        size_t n = recLen - off;
+        if (n > sizeof(tmp)) n = sizeof(tmp);
+        copyOut((pos + off) % capacity, tmp, n);
+        ok = spillOut.write(tmp, n) == n;
+    }
+    spillBytes += recLen; // Counted even if short, the file offset moved anyway
+    spillUnflushed = true;
+    if (ok) spillCount++;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+// Makes at least `need` unpopped bytes available in spillBuf, reading
+// only what was appended so the read handle never hits end of file
+bool TelemetryBacklog::fillSpill(size_t need) {
+#if BACKLOG_SPILL_SD
+    size_t have = spillBufLen - spillBufPos;
+    if (have >= need) return true;
+    if (need > sizeof(spillBuf)) return false;
+    memmove(spillBuf, spillBuf + spillBufPos, have);
+    spillBufPos = 0;
+    spillBufLen = have;
+
+    if (spillUnflushed) {
+        spillOut.flush();
+        spillUnflushed = false;
+    }
+    if (!spillIn) spillIn = SD_MMC.open(BACKLOG_SPILL_FILE, FILE_READ);
+    if (!spillIn) return false;
+    size_t n = sizeof(spillBuf) - have;
+    if (n > spillBytes - spillReadPos) n = spillBytes - spillReadPos;
+    size_t got = n ? spillIn.read(spillBuf + have, n) : 0;
+    spillReadPos += got;
+    spillBufLen += got;
+    return spillBufLen >= need;
+#else
+    return false;
+#endif
+}
+
+void TelemetryBacklog::resetSpill() {
+#if BACKLOG_SPILL_SD
+    spillOut.close();
+    spillIn.close();
+    SD_MMC.remove(BACKLOG_SPILL_FILE);
+    spillUnflushed = false;
+    spillBufPos = 0;
+    spillBufLen = 0;
+#endif
+    spillCount = 0;
+    spillReadPos = 0;
+    spillBytes = 0;
+}
+
+size_t TelemetryBacklog::peekSpill(char* out, size_t outSize, uint32_t* seq) {
+#if BACKLOG_SPILL_SD
+    uint16_t len16 = 0;
+    bool ok = fillSpill(HEADER);
+    if (ok) {
+        memcpy(&len16, spillBuf + spillBufPos, 2);
+        ok = len16 <= outSize && fillSpill(HEADER + len16);
+    }
+    if (!ok) {
+        // Lost, short or corrupt: nothing after this point can be trusted
+        Serial.printf("Backlog: spill file unreadable, %lu entries lost\n", (unsigned long)spillCount);
+        dropped += spillCount;
+        resetSpill();
+        return 0;
+    }
+    memcpy(seq, spillBuf + spillBufPos + 2, 4);
+    memcpy(out, spillBuf + spillBufPos + HEADER, len16);
+    spillPeekLen = len16;
+    return len16;
+#else
+    return 0;
+#endif
+}
+
+size_t TelemetryBacklog::peek(char* out, size_t outSize, uint32_t* seq) {
+    if (spillCount > 0) {
+        size_t n = peekSpill(out, outSize, seq);
+        if (n > 0) return n;
+    }
+    if (count == 0) return 0;
+    uint16_t len = lenAt(tail);
+    if (len > outSize) {
+        // Cannot be delivered with this buffer; drop it rather than stall
+        tail = (tail + HEADER + len) % capacity;
+        used -= HEADER + len;
+        count--;
+        dropped++;
+        return 0;
+    }
+    copyOut((tail + 2) % capacity, seq, sizeof(*seq));
+    copyOut((tail + HEADER) % capacity, out, len);
+    return len;
+}
+
+// Removes the entry peek() returned: spill first, then RAM
+bool TelemetryBacklog::removePeeked() {
+    if (spillCount > 0) {
+#if BACKLOG_SPILL_SD
+        spillBufPos += HEADER + spillPeekLen;
+#endif
+        if (--spillCount == 0) resetSpill();
+        return true;
+    }
+    if (count == 0) return false;
+    uint16_t len = lenAt(tail);
+    tail = (tail + HEADER + len) % capacity;
+    used -= HEADER + len;
+    count--;
+    return true;
+}
+
+void TelemetryBacklog::pop() {
+    if (removePeeked()) drained++;
+}
+
+void TelemetryBacklog::discard() {
+    if (removePeeked()) dropped++;
+}
+
+BacklogStats TelemetryBacklog::getStats() const {
+    BacklogStats s;
+    s.entries = count;
+    s.bytes = used;
+    s.capacity = capacity;
+    s.spilled = spillCount;
+    s.dropped = dropped;
+    s.drained = drained;
+    s.highWater = highWater;
+    return s;
+}
@@ -0,0 +1,96 @@
+#ifndef TELEMETRY_BACKLOG_H
+#define TELEMETRY_BACKLOG_H
+
+#include "DataModel.h"
+#include <FS.h>
+
+// Store-and-forward buffer for encoded samples while MQTT/WiFi is down.
+// Entries are 83-byte TelemetryFrames (89 B with the record header).
+#define BACKLOG_PSRAM_BYTES    (1024 * 1024) // ~11800 samples (~3.3 h at 1 Hz)
+#define BACKLOG_HEAP_BYTES     (32 * 1024)   // Fallback when no PSRAM is present (~7 min at 1 Hz)
+#define BACKLOG_DRAIN_BATCH    2             // Batched messages per drain step
+#define BACKLOG_DRAIN_INTERVAL_MS 100        // → up to 20 msg/s (640 samples/s) while catching up
+#define BACKLOG_SPILL_FILE     "/backlog.bin"
+#ifndef BACKLOG_SPILL_SD
+#define BACKLOG_SPILL_SD       ENABLE_SD     // Spill evicted entries to SD instead of dropping
+#endif
+#define BACKLOG_SPILL_MAX_BYTES (64UL * 1024 * 1024)
+#define BACKLOG_SPILL_READ_BYTES 4096        // Spill replay reads this much per SD access
+
+enum BacklogDropPolicy {
+    BACKLOG_DROP_OLDEST,  // Evict the oldest entries to make room
+    BACKLOG_DROP_DECIMATE // Thin the backlog to every other entry, then evict oldest if still full
+};
+
+// With SD spill enabled nothing is decimated; the oldest entries move to
+// the card and are only dropped once BACKLOG_SPILL_MAX_BYTES is reached
+
+#define BACKLOG_DROP_POLICY BACKLOG_DROP_DECIMATE
+
+struct BacklogStats {
+    uint32_t entries;     // In RAM
+    uint32_t bytes;       // In RAM, including record headers
+    uint32_t capacity;
+    uint32_t spilled;     // Entries currently in the SD spill file
+    uint32_t dropped;     // Entries lost to the drop policy, a bad spill file or discard()
+    uint32_t drained;     // Entries delivered after an outage
+    uint32_t highWater;   // Peak RAM bytes
+};
+
+// Byte ring of variable-length records: [len:2][seq:4][payload:len].
+// Order is preserved end to end; the spill file always holds older
+// entries than the ring, so it is drained first.
+class TelemetryBacklog {
+public:
+    TelemetryBacklog();
+    bool begin();
+
+    bool push(uint32_t seq, const char* data, size_t len);
+    size_t peek(char* out, size_t outSize, uint32_t* seq); // 0 when empty
+    void pop();                                            // Drop the entry returned by peek()
+    void discard();                                        // pop(), but undeliverable: counted as dropped
+    bool empty() const { return count == 0 && spillCount == 0; }
+    BacklogStats getStats() const;
+
+private:
+    static const size_t HEADER = 6;
+
+    void copyIn(size_t pos, const void* src, size_t n);
+    void copyOut(size_t pos, void* dst, size_t n) const;
+    uint16_t lenAt(size_t pos) const;
+    bool evictOldest();
+    void decimate();
+    bool spill(size_t pos, uint16_t len);
+    size_t peekSpill(char* out, size_t outSize, uint32_t* seq);
+    bool fillSpill(size_t need);
+    void resetSpill();
+    bool removePeeked();
+
+    uint8_t* ring;
+    size_t capacity;
+    size_t head;   // Next write offset
+    size_t tail;   // Oldest record offset
+    size_t used;
+    uint32_t count;
+
+    // The spill file stays open for append and for read while it holds
+    // entries; replay reads it BACKLOG_SPILL_READ_BYTES at a time
+    uint32_t spillCount;
+    uint32_t spillReadPos;  // File offset of the next byte to read into spillBuf
+    uint32_t spillBytes;    // Bytes appended to the spill file
+    uint16_t spillPeekLen;  // Payload length of the entry returned by peekSpill()
+#if BACKLOG_SPILL_SD
+    File spillOut;
+    File spillIn;
+    bool spillUnflushed;    // Appended since spillOut was last flushed
+    uint8_t spillBuf[BACKLOG_SPILL_READ_BYTES];
+    size_t spillBufPos;     // Oldest unpopped spill record in spillBuf
+    size_t spillBufLen;
+#endif
+
+    uint32_t dropped;
+    uint32_t drained;
+    uint32_t highWater;
+};
+
+#endif
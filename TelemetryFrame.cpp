@@ -0,0 +1,155 @@
+#include "TelemetryFrame.h"
+#include <math.h>
+#include <string.h>
+
+// Scales and saturates to the field's integer range
+static int32_t scaled(double v, double scale, double lo, double hi) {
+    if (isnan(v)) return 0;
+    double s = v * scale;
+    if (s < lo) s = lo;
+    if (s > hi) s = hi;
+    return (int32_t)lround(s);
+}
+
+static int32_t s16(double v, double scale) { return scaled(v, scale, INT16_MIN, INT16_MAX); }
+static int32_t u16(double v, double scale) { return scaled(v, scale, 0, UINT16_MAX); }
+static int32_t s32(double v, double scale) { return scaled(v, scale, INT32_MIN, INT32_MAX); }
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t telemetryFrameCrc(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t encodeTelemetryFrame(uint8_t* out, size_t outSize, const TelemetryFrame& f) {
+    if (!out || outSize < TELEMETRY_FRAME_SIZE) return 0;
+    uint8_t* p = out;
+    p[0] = TELEMETRY_FRAME_MAGIC;
+    p[1] = TELEMETRY_FRAME_VERSION;
+    put32(p + 2, f.seq);
+    put32(p + 6, f.epoch);
+    put32(p + 10, f.uptimeMs);
+    put32(p + 14, (uint32_t)s32(f.lat, 1e7));
+    put32(p + 18, (uint32_t)s32(f.lng, 1e7));
+    put16(p + 22, (uint16_t)u16(f.vin, 1e3));
+    put32(p + 24, (uint32_t)s32(f.iin, 1e6));
+    put32(p + 28, (uint32_t)s32(f.pin, 1e6));
+    put16(p + 32, (uint16_t)u16(f.vout, 1e3));
+    put32(p + 34, (uint32_t)s32(f.iout, 1e6));
+    put32(p + 38, (uint32_t)s32(f.pout, 1e6));
+    put16(p + 42, (uint16_t)s16(f.efficiency, 100));
+    put16(p + 44, (uint16_t)u16(f.battSoC, 100));
+    put16(p + 46, (uint16_t)u16(f.adcSoC, 100));
+    for (int i = 0; i < 4; i++) {
+        put16(p + 48 + 2 * i, (uint16_t)s16(f.logicLevels[i], 100));
+        put16(p + 56 + 2 * i, (uint16_t)f.adcValues[i]);
+    }
+    p[64] = f.satellites;
+    p[65] = f.fresh;
+    p[66] = f.mode;
+    p[67] = f.flags;
+    put16(p + 68, (uint16_t)u16(f.vinMin, 1e3));
+    put16(p + 70, (uint16_t)u16(f.vinMax, 1e3));
+    put32(p + 72, (uint32_t)s32(f.iinMin, 1e6));
+    put32(p + 76, (uint32_t)s32(f.iinMax, 1e6));
+    p[80] = f.powerReads;
+    put16(p + 81, telemetryFrameCrc(p, 81));
+    return TELEMETRY_FRAME_SIZE;
+}
+
+TelemetryFrameStatus decodeTelemetryFrame(const uint8_t* in, size_t len, TelemetryFrame& f) {
+    if (!in || len < TELEMETRY_FRAME_SIZE_V1) return FRAME_TOO_SHORT;
+    if (in[0] != TELEMETRY_FRAME_MAGIC) return FRAME_BAD_MAGIC;
+    if (in[1] < 1) return FRAME_BAD_VERSION;
+    if (get16(in + len - 2) != telemetryFrameCrc(in, len - 2)) return FRAME_BAD_CRC;
+
+    memset(&f, 0, sizeof(f));
+    f.version = in[1];
+    f.seq = get32(in + 2);
+    f.epoch = get32(in + 6);
+    f.uptimeMs = get32(in + 10);
+    f.lat = (int32_t)get32(in + 14) * 1e-7;
+    f.lng = (int32_t)get32(in + 18) * 1e-7;
+    f.vin = get16(in + 22) * 1e-3f;
+    f.iin = (int32_t)get32(in + 24) * 1e-6f;
+    f.pin = (int32_t)get32(in + 28) * 1e-6f;
+    f.vout = get16(in + 32) * 1e-3f;
+    f.iout = (int32_t)get32(in + 34) * 1e-6f;
+    f.pout = (int32_t)get32(in + 38) * 1e-6f;
+    f.efficiency = (int16_t)get16(in + 42) * 0.01f;
+    f.battSoC = get16(in + 44) * 0.01f;
+    f.adcSoC = get16(in + 46) * 0.01f;
+    for (int i = 0; i < 4; i++) {
+        f.logicLevels[i] = (int16_t)get16(in + 48 + 2 * i) * 0.01f;
+        f.adcValues[i] = (int16_t)get16(in + 56 + 2 * i);
+    }
+    f.satellites = in[64];
+    f.fresh = in[65];
+    f.mode = in[66];
+    f.flags = in[67];
+    if (f.version >= 2 && len >= TELEMETRY_FRAME_SIZE) {
+        f.vinMin = get16(in + 68) * 1e-3f;
+        f.vinMax = get16(in + 70) * 1e-3f;
+        f.iinMin = (int32_t)get32(in + 72) * 1e-6f;
+        f.iinMax = (int32_t)get32(in + 76) * 1e-6f;
+        f.powerReads = in[80];
+    } else {
+        f.vinMin = f.vinMax = f.vin;
+        f.iinMin = f.iinMax = f.iin;
+    }
+    return FRAME_OK;
+}
+
+void writeTelemetryBatchHeader(uint8_t* out, uint8_t count, uint8_t frameSize) {
+    out[0] = TELEMETRY_BATCH_MAGIC;
+    out[1] = TELEMETRY_BATCH_VERSION;
+    out[2] = count;
+    out[3] = frameSize;
+}
+
+bool parseTelemetryBatch(const uint8_t* in, size_t len, const uint8_t** frames,
+                         uint8_t* count, uint8_t* frameSize) {
+    if (!in || len < TELEMETRY_BATCH_HEADER || in[0] != TELEMETRY_BATCH_MAGIC) return false;
+    if (in[3] < TELEMETRY_FRAME_SIZE_V1) return false;
+    if (len != TELEMETRY_BATCH_HEADER + (size_t)in[2] * in[3]) return false;
+    *frames = in + TELEMETRY_BATCH_HEADER;
+    *count = in[2];
+    *frameSize = in[3];
+    return true;
+}
+
+const char* telemetryFrameStatusName(TelemetryFrameStatus s) {
+    switch (s) {
+        case FRAME_OK:          return "ok";
+        case FRAME_TOO_SHORT:   return "too short";
+        case FRAME_BAD_MAGIC:   return "bad magic";
+        case FRAME_BAD_VERSION: return "bad version";
+        case FRAME_BAD_CRC:     return "bad crc";
+    }
+    return "?";
+}
@@ -0,0 +1,108 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+// Compact binary telemetry frame (cubesat/telemetry/bin).
+// Plain C++ with no Arduino dependencies: the same encoder/decoder is
+// built into the firmware and into the ground tools (tools/ground/).
+//
+// Layout v2, little-endian, 83 bytes (v1 is the first 68 bytes + crc):
+//   off  size  field
+//    0    1    magic 0xCB
+//    1    1    version
+//    2    4    seq          uplink sequence number
+//    6    4    epoch        s (0 = wall clock unknown)
+//   10    4    uptimeMs
+//   14    4    lat, lng     int32, 1e-7 deg
+//   18    4
+//   22    2    vin          uint16, mV
+//   24    4    iin          int32, µA
+//   28    4    pin          int32, µW
+//   32    2    vout         uint16, mV
+//   34    4    iout         int32, µA
+//   38    4    pout         int32, µW
+//   42    2    efficiency   int16, 0.01 %
+//   44    2    battSoC      uint16, 0.01 %
+//   46    2    adcSoC       uint16, 0.01 %
+//   48    8    logic[4]     int16, 0.01
+//   56    8    adc[4]       int16, raw counts
+//   64    1    satellites
+//   65    1    fresh        SAMPLE_FRESH_* mask
+//   66    1    mode         OperationMode
+//   67    1    flags        bit0 wifi, bit1 mqtt
+//   68    2    vinMin       uint16, mV    extremes of the power readings
+//   70    2    vinMax       uint16, mV    folded into this record (v2)
+//   72    4    iinMin       int32, µA
+//   76    4    iinMax       int32, µA
+//   80    1    powerReads   readings folded in (0 = none, extremes = vin/iin)
+//   81    2    crc          CRC-16/CCITT-FALSE over bytes 0..len-3
+//
+// Later versions only append fields before the CRC, so a v1 decoder can
+// read the v1 prefix of any newer frame.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_FRAME_MAGIC   0xCB
+#define TELEMETRY_FRAME_VERSION 2
+#define TELEMETRY_FRAME_SIZE    83
+#define TELEMETRY_FRAME_SIZE_V1 70 // Smallest frame the decoder accepts
+
+// Batch container: several frames in one MQTT message
+//   0  magic 0xCC, 1  version, 2  frame count, 3  frame size, then frames
+// Each frame keeps its own CRC, so one corrupt frame does not void the rest.
+#define TELEMETRY_BATCH_MAGIC   0xCC
+#define TELEMETRY_BATCH_VERSION 1
+#define TELEMETRY_BATCH_HEADER  4
+
+#define TELEMETRY_FLAG_WIFI 0x01
+#define TELEMETRY_FLAG_MQTT 0x02
+
+// Decoded frame in engineering units
+struct TelemetryFrame {
+    uint32_t seq;
+    uint32_t epoch;
+    uint32_t uptimeMs;
+    double lat, lng;
+    float vin, iin, pin;
+    float vinMin, vinMax; // v1 frames decode these as vin/iin
+    float iinMin, iinMax;
+    float vout, iout, pout;
+    float efficiency;
+    float battSoC;
+    float adcSoC;
+    float logicLevels[4];
+    int16_t adcValues[4];
+    uint8_t satellites;
+    uint8_t fresh;
+    uint8_t mode;
+    uint8_t flags;
+    uint8_t powerReads;
+    uint8_t version; // Set by the decoder
+};
+
+enum TelemetryFrameStatus {
+    FRAME_OK,
+    FRAME_TOO_SHORT,
+    FRAME_BAD_MAGIC,
+    FRAME_BAD_VERSION,
+    FRAME_BAD_CRC
+};
+
+// Returns TELEMETRY_FRAME_SIZE, or 0 if `outSize` is too small.
+// Out-of-range values saturate; NaN is sent as 0.
+size_t encodeTelemetryFrame(uint8_t* out, size_t outSize, const TelemetryFrame& f);
+
+TelemetryFrameStatus decodeTelemetryFrame(const uint8_t* in, size_t len, TelemetryFrame& f);
+
+void writeTelemetryBatchHeader(uint8_t* out, uint8_t count, uint8_t frameSize);
+
+// Validates a batch container; on success `frames` points at the first
+// frame and count/frameSize describe the rest
+bool parseTelemetryBatch(const uint8_t* in, size_t len, const uint8_t** frames,
+                         uint8_t* count, uint8_t* frameSize);
+
+const char* telemetryFrameStatusName(TelemetryFrameStatus s);
+
+uint16_t telemetryFrameCrc(const uint8_t* data, size_t len);
+
+#endif
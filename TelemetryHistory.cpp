@@ -0,0 +1,243 @@
+#include "TelemetryHistory.h"
+#include "SystemClock.h"
+
+static const char* const FIELD_NAMES[HF_COUNT] = {
+    "vin", "iin", "pin", "vout", "iout", "pout", "eff",
+    "batt_soc", "adc_soc", "adc0", "adc1", "adc2", "adc3", "satellites"
+};
+
+static const char* const RES_NAMES[HR_COUNT] = {"raw", "1m", "15m"};
+
+static void* allocLarge(size_t bytes) {
+    void* p = psramFound() ? ps_malloc(bytes) : nullptr;
+    return p;
+}
+
+TelemetryHistory::TelemetryHistory() : raw(nullptr), rawHead(0), rawCount(0) {
+    memset(rollups, 0, sizeof(rollups));
+    rollups[0].capacity = HISTORY_1M_CAPACITY;
+    rollups[0].periodMs = 60UL * 1000;
+    rollups[1].capacity = HISTORY_15M_CAPACITY;
+    rollups[1].periodMs = 15UL * 60 * 1000;
+}
+
+bool TelemetryHistory::begin() {
+    raw = (HistoryRaw*)allocLarge(sizeof(HistoryRaw) * HISTORY_RAW_CAPACITY);
+    for (int i = 0; i < 2; i++) {
+        rollups[i].buf = (HistoryBucket*)allocLarge(sizeof(HistoryBucket) * rollups[i].capacity);
+    }
+    if (!raw || !rollups[0].buf || !rollups[1].buf) {
+        Serial.println("History: PSRAM allocation FAILED, /history disabled");
+        free(raw);
+        free(rollups[0].buf);
+        free(rollups[1].buf);
+        raw = nullptr;
+        rollups[0].buf = rollups[1].buf = nullptr;
+        return false;
+    }
+    return true;
+}
+
+int TelemetryHistory::fieldIndex(const char* name) {
+    for (int i = 0; i < HF_COUNT; i++) {
+        if (strcmp(name, FIELD_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+void TelemetryHistory::append(const MeasurementData& d) {
+    if (!raw) return;
+
+    HistoryRaw& r = raw[rawHead];
+    r.tMs = (uint64_t)(d.monoUs / 1000);
+    r.v[HF_VIN] = d.vin;
+    r.v[HF_IIN] = d.iin;
+    r.v[HF_PIN] = d.pin;
+    r.v[HF_VOUT] = d.vout;
+    r.v[HF_IOUT] = d.iout;
+    r.v[HF_POUT] = d.pout;
+    r.v[HF_EFF] = d.efficiency;
+    r.v[HF_BATT_SOC] = d.battSoC;
+    r.v[HF_ADC_SOC] = d.adcSoC;
+    for (int i = 0; i < 4; i++) {
+        r.v[HF_ADC0 + i] = d.adcValues[i];
+    }
+    r.v[HF_SATS] = d.satellites;
+
+    rawHead = (rawHead + 1) % HISTORY_RAW_CAPACITY;
+    if (rawCount < HISTORY_RAW_CAPACITY) rawCount++;
+
+    // Rollup extremes of vin/iin come from every power reading, not just
+    // the one the record kept
+    float lo[HF_COUNT], hi[HF_COUNT];
+    memcpy(lo, r.v, sizeof(lo));
+    memcpy(hi, r.v, sizeof(hi));
+    lo[HF_VIN] = d.vinMin;
+    hi[HF_VIN] = d.vinMax;
+    lo[HF_IIN] = d.iinMin;
+    hi[HF_IIN] = d.iinMax;
+    for (int i = 0; i < 2; i++) {
+        roll(rollups[i], r.tMs, r.v, lo, hi);
+    }
+}
+
+// O(fields) per sample: fold into the open bucket, close it when the
+// sample falls into the next period
+void TelemetryHistory::roll(BucketRing& r, uint64_t tMs, const float* v,
+                            const float* lo, const float* hi) {
+    uint64_t start = tMs - (tMs % r.periodMs);
+    if (r.open.n > 0 && r.open.tMs != start) {
+        r.buf[r.head] = r.open;
+        r.head = (r.head + 1) % r.capacity;
+        if (r.count < r.capacity) r.count++;
+        r.open.n = 0;
+    }
+    if (r.open.n == 0) {
+        r.open.tMs = start;
+        for (int f = 0; f < HF_COUNT; f++) {
+            r.open.min[f] = lo[f];
+            r.open.max[f] = hi[f];
+            r.open.sum[f] = 0.0f;
+        }
+    }
+    for (int f = 0; f < HF_COUNT; f++) {
+        if (lo[f] < r.open.min[f]) r.open.min[f] = lo[f];
+        if (hi[f] > r.open.max[f]) r.open.max[f] = hi[f];
+        r.open.sum[f] += v[f];
+    }
+    r.open.n++;
+}
+
+// Binary search over the time-ordered ring: index (0 = oldest) of the
+// first entry with t >= sinceMs
+uint32_t TelemetryHistory::firstRaw(uint64_t sinceMs) const {
+    uint32_t oldest = (rawHead + HISTORY_RAW_CAPACITY - rawCount) % HISTORY_RAW_CAPACITY;
+    uint32_t lo = 0, hi = rawCount;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (raw[(oldest + mid) % HISTORY_RAW_CAPACITY].tMs < sinceMs) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+uint32_t TelemetryHistory::firstBucket(const BucketRing& r, uint64_t sinceMs) const {
+    uint32_t oldest = (r.head + r.capacity - r.count) % r.capacity;
+    uint32_t lo = 0, hi = r.count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        const HistoryBucket& b = r.buf[(oldest + mid) % r.capacity];
+        if (b.tMs + r.periodMs <= sinceMs) lo = mid + 1; // Bucket ends before `since`
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Small buffered writer so the response goes out in ~1 KB chunks
+class HistoryWriter {
+public:
+    explicit HistoryWriter(const HistorySink& s) : sink(s), len(0) {}
+    ~HistoryWriter() { flush(); }
+
+    void raw(const char* s) {
+        while (*s) {
+            if (len == sizeof(buf)) flush();
+            buf[len++] = *s++;
+        }
+    }
+    void num(float v) {
+        char tmp[20];
+        if (isnan(v) || isinf(v)) v = 0.0f;
+        snprintf(tmp, sizeof(tmp), "%.6g", v);
+        raw(tmp);
+    }
+    void u64(uint64_t v) {
+        char tmp[24];
+        snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)v);
+        raw(tmp);
+    }
+    void flush() {
+        if (len) sink(buf, len);
+        len = 0;
+    }
+
+private:
+    const HistorySink& sink;
+    char buf[1024];
+    size_t len;
+};
+
+int TelemetryHistory::resIndex(const char* name) {
+    for (int i = 0; i < HR_COUNT; i++) {
+        if (strcmp(name, RES_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+bool TelemetryHistory::query(const char* field, const char* res, uint64_t sinceMs, const HistorySink& sink) {
+    int f = fieldIndex(field);
+    int r = resIndex(res);
+    if (f < 0 || r < 0 || !raw) return false;
+
+    HistoryWriter w(sink);
+    w.raw("{\"field\":\"");
+    w.raw(FIELD_NAMES[f]);
+    w.raw("\",\"res\":\"");
+    w.raw(RES_NAMES[r]);
+    w.raw("\",\"now\":");
+    w.u64((uint64_t)(SystemClock::monoUs() / 1000));
+
+    if (r == HR_RAW) {
+        uint32_t first = firstRaw(sinceMs);
+        uint32_t n = rawCount - first;
+        if (n > HISTORY_MAX_POINTS) {
+            first = rawCount - HISTORY_MAX_POINTS; // Keep the most recent points
+            n = HISTORY_MAX_POINTS;
+        }
+        uint32_t oldest = (rawHead + HISTORY_RAW_CAPACITY - rawCount) % HISTORY_RAW_CAPACITY;
+        w.raw(",\"t\":[");
+        for (uint32_t i = 0; i < n; i++) {
+            if (i) w.raw(",");
+            w.u64(raw[(oldest + first + i) % HISTORY_RAW_CAPACITY].tMs);
+        }
+        w.raw("],\"v\":[");
+        for (uint32_t i = 0; i < n; i++) {
+            if (i) w.raw(",");
+            w.num(raw[(oldest + first + i) % HISTORY_RAW_CAPACITY].v[f]);
+        }
+        w.raw("]}");
+        return true;
+    }
+
+    // Closed buckets plus the one still accumulating
+    const BucketRing& ring = rollups[r - 1];
+    uint32_t first = firstBucket(ring, sinceMs);
+    uint32_t closed = ring.count - first;
+    bool withOpen = ring.open.n > 0 && ring.open.tMs + ring.periodMs > sinceMs;
+    uint32_t n = closed + (withOpen ? 1 : 0);
+    if (n > HISTORY_MAX_POINTS) {
+        first += n - HISTORY_MAX_POINTS;
+        closed -= n - HISTORY_MAX_POINTS;
+    }
+    uint32_t oldest = (ring.head + ring.capacity - ring.count) % ring.capacity;
+
+    static const char* const KEYS[4] = {",\"t\":[", "],\"min\":[", "],\"max\":[", "],\"mean\":["};
+    for (int col = 0; col < 4; col++) {
+        w.raw(KEYS[col]);
+        for (uint32_t i = 0; i <= closed; i++) {
+            const HistoryBucket* b;
+            if (i < closed) b = &ring.buf[(oldest + first + i) % ring.capacity];
+            else if (withOpen) b = &ring.open;
+            else break;
+            if (i) w.raw(",");
+            switch (col) {
+                case 0: w.u64(b->tMs); break;
+                case 1: w.num(b->min[f]); break;
+                case 2: w.num(b->max[f]); break;
+                case 3: w.num(b->sum[f] / b->n); break;
+            }
+        }
+    }
+    w.raw("]}");
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef TELEMETRY_HISTORY_H
+#define TELEMETRY_HISTORY_H
+
+#include "DataModel.h"
+#include <functional>
+
+// In-memory (PSRAM) history: raw samples plus 1 min / 15 min rollups,
+// updated incrementally as samples arrive
+#define HISTORY_RAW_CAPACITY   3600  // 1 h of 1 s samples
+#define HISTORY_1M_CAPACITY    1440  // 24 h
+#define HISTORY_15M_CAPACITY   672   // 7 days
+#define HISTORY_MAX_POINTS     600   // Per query response
+
+// Queryable fields — names match the telemetry JSON keys
+enum HistoryField {
+    HF_VIN, HF_IIN, HF_PIN, HF_VOUT, HF_IOUT, HF_POUT, HF_EFF,
+    HF_BATT_SOC, HF_ADC_SOC, HF_ADC0, HF_ADC1, HF_ADC2, HF_ADC3, HF_SATS,
+    HF_COUNT
+};
+
+enum HistoryRes { HR_RAW, HR_1M, HR_15M, HR_COUNT };
+
+struct HistoryRaw {
+    uint64_t tMs; // monoUs / 1000 of the sample; unlike uptimeMs it does not wrap
+    float v[HF_COUNT];
+};
+
+struct HistoryBucket {
+    uint64_t tMs; // Bucket start (monotonic ms)
+    uint32_t n;
+    float min[HF_COUNT];
+    float max[HF_COUNT];
+    float sum[HF_COUNT];
+};
+
+// Receives formatted output in chunks (e.g. WebServer::sendContent)
+typedef std::function<void(const char* data, size_t len)> HistorySink;
+
+class TelemetryHistory {
+public:
+    TelemetryHistory();
+    bool begin();
+    void append(const MeasurementData& d);
+
+    // Writes {"field":..,"res":..,"now":..,"t":[..],...} for points with
+    // t >= sinceMs (monotonic ms, as `t`). Returns false for an unknown
+    // field/resolution.
+    bool query(const char* field, const char* res, uint64_t sinceMs, const HistorySink& sink);
+
+    static int fieldIndex(const char* name); // -1 if unknown
+    static int resIndex(const char* name);
+
+private:
+    struct BucketRing {
+        HistoryBucket* buf;
+        uint32_t capacity;
+        uint32_t head;   // Next write index
+        uint32_t count;
+        uint32_t periodMs;
+        HistoryBucket open; // Bucket being accumulated, not yet in buf
+    };
+
+    void roll(BucketRing& r, uint64_t tMs, const float* v, const float* lo, const float* hi);
+    uint32_t firstRaw(uint64_t sinceMs) const;
+    uint32_t firstBucket(const BucketRing& r, uint64_t sinceMs) const;
+
+    HistoryRaw* raw;
+    uint32_t rawHead;
+    uint32_t rawCount;
+    BucketRing rollups[2]; // HR_1M, HR_15M
+};
+
+#endif
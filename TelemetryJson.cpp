@@ -0,0 +1,152 @@
+#include "TelemetryJson.h"
+
+namespace {
+
+const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// Bounded append-only writer over a fixed buffer
+struct JsonWriter {
+    char* p;
+    char* end;
+    bool ok;
+
+    JsonWriter(char* buf, size_t size) : p(buf), end(buf + size - 1), ok(size > 0) {}
+
+    void raw(const char* s) {
+        while (*s) {
+            if (p >= end) { ok = false; return; }
+            *p++ = *s++;
+        }
+    }
+
+    void uint(uint64_t v) {
+        char tmp[20];
+        int n = 0;
+        do {
+            tmp[n++] = '0' + (v % 10);
+            v /= 10;
+        } while (v);
+        if (p + n > end) { ok = false; return; }
+        while (n) *p++ = tmp[--n];
+    }
+
+    void integer(int32_t v) {
+        if (v < 0) {
+            raw("-");
+            uint((uint64_t)(-(int64_t)v));
+        } else {
+            uint((uint64_t)v);
+        }
+    }
+
+    // Fixed-point formatting, rounded half away from zero like printf("%.*f")
+    void fixed(double v, int decimals) {
+        if (isnan(v) || isinf(v)) v = 0.0;
+        bool neg = v < 0.0;
+        if (neg) v = -v;
+        if (v > 1e12) v = 1e12; // Clamp garbage readings instead of overflowing
+        uint32_t scale = POW10[decimals];
+        uint64_t scaled = (uint64_t)(v * scale + 0.5);
+        if (neg && scaled) raw("-");
+        uint(scaled / scale);
+        if (decimals == 0) return;
+        uint32_t frac = (uint32_t)(scaled % scale);
+        char tmp[8];
+        tmp[0] = '.';
+        for (int i = decimals; i > 0; i--) {
+            tmp[i] = '0' + (frac % 10);
+            frac /= 10;
+        }
+        tmp[decimals + 1] = '\0';
+        raw(tmp);
+    }
+
+    void key(const char* k) {
+        raw("\"");
+        raw(k);
+        raw("\":");
+    }
+
+    void boolean(bool b) { raw(b ? "true" : "false"); }
+};
+
+} // namespace
+
+size_t encodeTelemetryJson(char* out, size_t outSize, const MeasurementData& d,
+                           const LinkStatus& link, OperationMode mode, uint32_t seq) {
+    if (!out || outSize == 0) return 0;
+    JsonWriter w(out, outSize);
+
+    w.raw("{");
+    if (seq) {
+        w.key("seq"); w.uint(seq); w.raw(",");
+    }
+    w.key("wifi_connected"); w.boolean(link.wifiConnected);
+    w.raw(","); w.key("mqtt_connected"); w.boolean(link.mqttConnected);
+    char ts[32];
+    formatTimestamp(d, ts, sizeof(ts));
+    w.raw(","); w.key("ts"); w.raw("\""); w.raw(ts); w.raw("\"");
+    w.raw(","); w.key("mode"); w.integer((int32_t)mode);
+    w.raw(","); w.key("mode_str"); w.raw(mode == MODE_SENSOR ? "\"Sensor\"" : "\"Sleep\"");
+    w.raw(","); w.key("vin"); w.fixed(d.vin, 3);
+    w.raw(","); w.key("iin"); w.fixed(d.iin, 6);
+    w.raw(","); w.key("pin"); w.fixed(d.pin, 6);
+    w.raw(","); w.key("vout"); w.fixed(d.vout, 3);
+    w.raw(","); w.key("iout"); w.fixed(d.iout, 6);
+    w.raw(","); w.key("pout"); w.fixed(d.pout, 6);
+    w.raw(","); w.key("eff"); w.fixed(d.efficiency, 2);
+    w.raw(","); w.key("lat"); w.fixed(d.lat, 6);
+    w.raw(","); w.key("lng"); w.fixed(d.lng, 6);
+    w.raw(","); w.key("satellites"); w.integer(d.satellites);
+    w.raw(","); w.key("batt_soc"); w.fixed(d.battSoC, 2);
+    w.raw(","); w.key("adc_soc"); w.fixed(d.adcSoC, 1);
+
+    static const char* const LOGIC_KEYS[4] = {"logic0", "logic1", "logic2", "logic3"};
+    static const char* const ADC_KEYS[4] = {"adc0", "adc1", "adc2", "adc3"};
+    for (int i = 0; i < 4; i++) {
+        w.raw(","); w.key(LOGIC_KEYS[i]); w.fixed(d.logicLevels[i], 2);
+    }
+    for (int i = 0; i < 4; i++) {
+        w.raw(","); w.key(ADC_KEYS[i]); w.integer(d.adcValues[i]);
+    }
+    w.raw("}");
+
+    if (!w.ok) {
+        out[0] = '\0';
+        return 0;
+    }
+    *w.p = '\0';
+    return (size_t)(w.p - out);
+}
+
+void toTelemetryFrame(const MeasurementData& d, const LinkStatus& link, OperationMode mode,
+                      uint32_t seq, TelemetryFrame& f) {
+    f.seq = seq;
+    f.epoch = d.epoch;
+    f.uptimeMs = d.uptimeMs;
+    f.lat = d.lat;
+    f.lng = d.lng;
+    f.vin = d.vin;
+    f.iin = d.iin;
+    f.pin = d.pin;
+    f.vinMin = d.vinMin;
+    f.vinMax = d.vinMax;
+    f.iinMin = d.iinMin;
+    f.iinMax = d.iinMax;
+    f.powerReads = d.powerReads;
+    f.vout = d.vout;
+    f.iout = d.iout;
+    f.pout = d.pout;
+    f.efficiency = d.efficiency;
+    f.battSoC = d.battSoC;
+    f.adcSoC = d.adcSoC;
+    for (int i = 0; i < 4; i++) {
+        f.logicLevels[i] = d.logicLevels[i];
+        f.adcValues[i] = d.adcValues[i];
+    }
+    f.satellites = d.satellites;
+    f.fresh = d.fresh;
+    f.mode = (uint8_t)mode;
+    f.flags = (link.wifiConnected ? TELEMETRY_FLAG_WIFI : 0) | (link.mqttConnected ? TELEMETRY_FLAG_MQTT : 0);
+    f.version = TELEMETRY_FRAME_VERSION;
+}
@@ -0,0 +1,27 @@
+#ifndef TELEMETRY_JSON_H
+#define TELEMETRY_JSON_H
+
+#include "DataModel.h"
+#include "TelemetryFrame.h"
+
+// Worst-case size of one encoded telemetry document (including NUL)
+#define TELEMETRY_JSON_MAX 640
+
+// Link state reported alongside each sample
+struct LinkStatus {
+    bool wifiConnected;
+    bool mqttConnected;
+};
+
+// Encodes one sample as the telemetry JSON document shared by MQTT and HTTP.
+// Writes into the caller's buffer without touching the heap. NaN/Inf are
+// reported as 0. `seq` is the uplink sequence number (0 = omit).
+// Returns the document length, or 0 if it did not fit.
+size_t encodeTelemetryJson(char* out, size_t outSize, const MeasurementData& d,
+                           const LinkStatus& link, OperationMode mode, uint32_t seq = 0);
+
+// Fills a binary TelemetryFrame from one sample
+void toTelemetryFrame(const MeasurementData& d, const LinkStatus& link, OperationMode mode,
+                      uint32_t seq, TelemetryFrame& f);
+
+#endif
@@ -1,11 +1,19 @@
 #include "TelemetryService.h"
+#include "Metrics.h"
+#include "SystemClock.h"
+#include "SerialFrame.h"
+#include "TelemetryJson.h"
 
-TelemetryService::TelemetryService() : dataQueuePtr(nullptr) {
+TelemetryService::TelemetryService() : bus(nullptr), busSub(-1), powerTrigger(nullptr), serialSeq(0) {
+#if SD_LOG_GORILLA
+    gorBlockStartMs = 0;
+#endif
     sdMutex = xSemaphoreCreateMutex();
 }
 
-bool TelemetryService::begin(QueueHandle_t* q) {
-    dataQueuePtr = q;
+bool TelemetryService::begin(SampleBus* b) {
+    bus = b;
+    serialSink.begin();
 
 #if ENABLE_SD
     SD_MMC.setPins(SD_MMC_CLK, SD_MMC_CMD, SD_MMC_D0);
@@ -14,19 +22,23 @@ bool TelemetryService::begin(QueueHandle_t* q) {
     } else {
         Serial.println("SD_MMC mounted");
         if (!SD_MMC.exists("/photos")) SD_MMC.mkdir("/photos");
+        if (!SD_MMC.exists(SD_CAPTURE_DIR)) SD_MMC.mkdir(SD_CAPTURE_DIR);
         
-        // CSV Header
-        if (!SD_MMC.exists("/datalog.csv")) {
-             File f = SD_MMC.open("/datalog.csv", FILE_WRITE);
-             if (f) {
-                 f.println("Timestamp,Mode,Vin(V),Iin(A),Pin(W),Vout(V),Iout(A),Pout(W),Efficiency(%),Latitude,Longitude,Satellites,ADC0,ADC1,ADC2,ADC3,SoC(%),adcSoC(%),Logic0,Logic1,Logic2,Logic3");
-                 f.close();
-             }
-        }
+        // Log file stays open; CSV header is written if the file is new
+        sdLog.begin(SD_MMC, SD_LOG_FILE, SD_LOG_HEADER);
+#if SD_LOG_GORILLA
+        gorLog.begin(SD_MMC, SD_GORILLA_FILE, nullptr); // Blocks are self-describing
+#endif
     }
 #endif
 
-    xTaskCreatePinnedToCore(TelemetryService::task, "TelemetryTask", 4096, this, 1, NULL, 0);
+    // Subscribe before the task exists so it never runs without a cursor;
+    // the wake-up handle is attached once the task is created
+    busSub = bus ? bus->subscribe("telemetry") : -1;
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(TelemetryService::task, "TelemetryTask", 4096, this, 1, &handle, 0);
+    if (bus) bus->setNotify(busSub, handle);
+    metrics.setTask(MTASK_TELEMETRY, handle);
     return true;
 }
 
@@ -38,50 +50,170 @@ void TelemetryService::task(void* param) {
 }
 
 void TelemetryService::loop() {
+    // Woken by SampleBus on each publish; drain everything that is new
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
     MeasurementData d;
-    // Wait for data from SensorService
-    if (dataQueuePtr && *dataQueuePtr && xQueueReceive(*dataQueuePtr, &d, pdMS_TO_TICKS(100)) == pdPASS) {
-        latestTimestamp = String(d.timestamp);
-        logToSerial(d); // Serial Studio
-        logToSD(d);     // SD Card
+    while (bus && bus->read(busSub, d)) {
+        handleSample(d);
+    }
+#if ENABLE_SD
+    // Time-based flush of the write-behind buffer
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        sdLog.poll();
+#if SD_LOG_GORILLA
+        if (gorEnc.count() > 0 && millis() - gorBlockStartMs >= SD_GORILLA_BLOCK_MS) {
+            closeGorillaBlock();
+        }
+        gorLog.poll();
+#endif
+        xSemaphoreGive(sdMutex);
     }
+    if (powerTrigger) saveCapture();
+#endif
 }
 
-void TelemetryService::logToSerial(const MeasurementData& d) {
+void TelemetryService::handleSample(const MeasurementData& d) {
+    metrics.observeUs(MT_SAMPLE_AGE, (uint32_t)(SystemClock::monoUs() - d.monoUs));
+    uint32_t start = Metrics::cycles();
+    char ts[32];
+    formatTimestamp(d, ts, sizeof(ts));
+    logToSerial(d, ts); // Serial Studio
+    logToSD(d, ts);     // SD Card
+    logToGorilla(d);    // SD Card, compressed
+    metrics.stop(MT_TELEMETRY_SAMPLE, start);
+}
+
+SdLoggerStats TelemetryService::getSdStats() {
+    SdLoggerStats s = {};
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+        s = sdLog.getStats();
+        xSemaphoreGive(sdMutex);
+    }
+    return s;
+}
+
+// One CSV row without line ending, shared by Serial and SD
+static int formatRow(char* out, size_t size, const MeasurementData& d, const char* ts) {
     const char* modeStr = (currentSystemMode == MODE_SENSOR) ? "SENSOR" : "SLEEP";
-    Serial.printf("/*%s,%s,%.3f,%.6f,%.6f,%.3f,%.6f,%.6f,%.2f,%.6f,%.6f,%d,%d,%d,%d,%d,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f*/\n",
-        d.timestamp, modeStr,
+    int len = snprintf(out, size, "%s,%s,%.3f,%.6f,%.6f,%.3f,%.6f,%.6f,%.2f,%.6f,%.6f,%d,%d,%d,%d,%d,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%.3f,%.3f,%.6f,%.6f,%u",
+        ts, modeStr,
         d.vin, d.iin, d.pin,
         d.vout, d.iout, d.pout,
         d.efficiency,
         d.lat, d.lng,
         d.satellites,
         d.adcValues[0], d.adcValues[1], d.adcValues[2], d.adcValues[3], d.battSoC,
-        d.adcSoC, d.logicLevels[0], d.logicLevels[1], d.logicLevels[2], d.logicLevels[3]
+        d.adcSoC, d.logicLevels[0], d.logicLevels[1], d.logicLevels[2], d.logicLevels[3],
+        d.vinMin, d.vinMax, d.iinMin, d.iinMax, (unsigned)d.powerReads
     );
+    if (len >= (int)size) len = size - 1;
+    return len;
 }
 
-void TelemetryService::logToSD(const MeasurementData& d) {
+// Queued on the sink; SerialTask does the UART write
+void TelemetryService::logToSerial(const MeasurementData& d, const char* ts) {
+    if (SERIAL_FORMAT == SERIAL_FORMAT_BINARY) {
+        TelemetryFrame f;
+        LinkStatus link = { false, false }; // Not known here
+        toTelemetryFrame(d, link, currentSystemMode, serialSeq++, f);
+        uint8_t payload[TELEMETRY_FRAME_SIZE];
+        uint8_t frame[SERIAL_FRAME_SIZE(TELEMETRY_FRAME_SIZE)];
+        encodeTelemetryFrame(payload, sizeof(payload), f);
+        size_t len = encodeSerialFrame(frame, sizeof(frame), payload, sizeof(payload));
+        if (len) serialSink.write(frame, len);
+        return;
+    }
+
+    char line[256];
+    int len = formatRow(line + 2, sizeof(line) - 5, d, ts);
+    if (len <= 0) return;
+    line[0] = '/';
+    line[1] = '*';
+    memcpy(line + 2 + len, "*/\n", 3);
+    serialSink.write(line, len + 5);
+}
+
+void TelemetryService::logToSD(const MeasurementData& d, const char* ts) {
 #if ENABLE_SD
+    char row[256];
+    int len = formatRow(row, sizeof(row) - 1, d, ts);
+    if (len <= 0) return;
+    row[len++] = '\n';
+
     if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        File f = SD_MMC.open("/datalog.csv", FILE_APPEND);
-        if (f) {
-            const char* modeStr = (currentSystemMode == MODE_SENSOR) ? "SENSOR" : "SLEEP";
-            f.printf("%s,%s,%.3f,%.6f,%.6f,%.3f,%.6f,%.6f,%.2f,%.6f,%.6f,%d,%d,%d,%d,%d,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f\n",
-                d.timestamp, modeStr,
-                d.vin, d.iin, d.pin,
-                d.vout, d.iout, d.pout,
-                d.efficiency,
-                d.lat, d.lng,
-                d.satellites,
-                d.adcValues[0], d.adcValues[1], d.adcValues[2], d.adcValues[3], d.battSoC,
-                d.adcSoC, d.logicLevels[0], d.logicLevels[1], d.logicLevels[2], d.logicLevels[3]
-            );
-            f.close();
-        } else {
-            Serial.println("SD Error: Failed to open /datalog.csv for append");
-        }
+        sdLog.append(row, len, currentSystemMode);
         xSemaphoreGive(sdMutex);
     }
 #endif
 }
+
+void TelemetryService::logToGorilla(const MeasurementData& d) {
+#if SD_LOG_GORILLA
+    GorillaValue v[GS_COUNT];
+    v[GS_UPTIME].u = d.uptimeMs;
+    v[GS_EPOCH].u = d.epoch;
+    v[GS_VIN].f = d.vin;
+    v[GS_IIN].f = d.iin;
+    v[GS_PIN].f = d.pin;
+    v[GS_VOUT].f = d.vout;
+    v[GS_IOUT].f = d.iout;
+    v[GS_POUT].f = d.pout;
+    v[GS_EFF].f = d.efficiency;
+    v[GS_BATT_SOC].f = d.battSoC;
+    v[GS_ADC_SOC].f = d.adcSoC;
+    for (int i = 0; i < 4; i++) {
+        v[GS_LOGIC0 + i].f = d.logicLevels[i];
+        v[GS_ADC0 + i].i = d.adcValues[i];
+    }
+    v[GS_LAT].i = (int32_t)lround(d.lat * 1e7);
+    v[GS_LNG].i = (int32_t)lround(d.lng * 1e7);
+    v[GS_SATS].i = d.satellites;
+    v[GS_FRESH].i = d.fresh;
+    v[GS_MODE].i = currentSystemMode;
+
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000)) != pdTRUE) return;
+    if (gorEnc.count() == 0 || !gorEnc.append(v)) {
+        // First sample, or the block is full: start a new one
+        closeGorillaBlock();
+        gorEnc.begin(gorBlock, sizeof(gorBlock), GORILLA_SAMPLE_TYPES, GS_COUNT);
+        gorEnc.append(v);
+        gorBlockStartMs = millis();
+    }
+    xSemaphoreGive(sdMutex);
+#endif
+}
+
+// Caller holds sdMutex
+void TelemetryService::closeGorillaBlock() {
+#if SD_LOG_GORILLA
+    if (gorEnc.count() == 0) return;
+    size_t len = gorEnc.finish();
+    gorLog.append((const char*)gorBlock, len, currentSystemMode);
+    gorEnc.begin(gorBlock, sizeof(gorBlock), GORILLA_SAMPLE_TYPES, GS_COUNT); // Empty until the next sample
+#endif
+}
+
+// Writes a frozen PowerTrigger capture to its own file. A failed write is
+// dropped rather than retried so it cannot block later captures.
+void TelemetryService::saveCapture() {
+#if ENABLE_SD
+    const uint8_t* data;
+    size_t len = powerTrigger->peek(CAPTURE_TO_SD, &data);
+    if (len == 0) return;
+    CaptureHeader h = {};
+    const uint8_t* samples;
+    char path[48];
+    if (parseCapture(data, len, h, &samples) && h.epoch) {
+        snprintf(path, sizeof(path), SD_CAPTURE_DIR "/cap_%lu.bin", (unsigned long)h.epoch);
+    } else {
+        snprintf(path, sizeof(path), SD_CAPTURE_DIR "/cap_ms%lu.bin", (unsigned long)(h.triggerUs / 1000));
+    }
+    if (xSemaphoreTake(sdMutex, pdMS_TO_TICKS(1000)) != pdTRUE) return;
+    File f = SD_MMC.open(path, FILE_WRITE);
+    bool ok = f && f.write(data, len) == len;
+    if (f) f.close();
+    xSemaphoreGive(sdMutex);
+    powerTrigger->release(CAPTURE_TO_SD);
+    Serial.printf("Capture %s %s (%u bytes)\n", path, ok ? "saved" : "write FAILED", (unsigned)len);
+#endif
+}
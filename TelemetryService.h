@@ -4,26 +4,63 @@
 #include "DataModel.h"
 #include <FS.h>
 #include <SD_MMC.h>
+#include "SdLogger.h"
+#include "SampleBus.h"
+#include "GorillaCodec.h"
+#include "PowerTrigger.h"
+#include "SerialSink.h"
 
 // SD_MMC Pins (1-bit mode)
 #define SD_MMC_CMD 38
 #define SD_MMC_CLK 39
 #define SD_MMC_D0  40
 
+#define SD_LOG_FILE "/datalog.csv"
+#define SD_LOG_HEADER "Timestamp,Mode,Vin(V),Iin(A),Pin(W),Vout(V),Iout(A),Pout(W),Efficiency(%),Latitude,Longitude,Satellites,ADC0,ADC1,ADC2,ADC3,SoC(%),adcSoC(%),Logic0,Logic1,Logic2,Logic3,VinMin(V),VinMax(V),IinMin(A),IinMax(A),PowerReads"
+
+// Compressed copy of the log (GorillaCodec blocks, ~10x smaller than CSV);
+// decode with tools/ground/gorilla_tool
+#define SD_LOG_GORILLA          ENABLE_SD
+#define SD_GORILLA_FILE         "/datalog.gor"
+#define SD_GORILLA_BLOCK_BYTES  2048
+#define SD_GORILLA_BLOCK_MS     60000 // Close a block after this long even if not full
+
+// Sample format on Serial; binary needs tools/ground/telemetry_decode --serial
+#define SERIAL_FORMAT SERIAL_FORMAT_TEXT
+
+#define SD_CAPTURE_DIR "/captures" // One PowerTrigger capture per file, cap_<epoch|ms>.bin
+
 class TelemetryService {
 public:
     TelemetryService();
-    bool begin(QueueHandle_t* q);
+    bool begin(SampleBus* bus);
+    void setPowerTrigger(PowerTrigger* t) { powerTrigger = t; }
+    SdLoggerStats getSdStats();
+    SerialSinkStats getSerialStats() const { return serialSink.getStats(); }
 
 private:
     static void task(void* param);
     void loop();
-    void logToSerial(const MeasurementData& d);
-    void logToSD(const MeasurementData& d);
+    void logToSerial(const MeasurementData& d, const char* ts);
+    void logToSD(const MeasurementData& d, const char* ts);
+    void handleSample(const MeasurementData& d);
+    void logToGorilla(const MeasurementData& d);
+    void closeGorillaBlock();
+    void saveCapture();
 
-    QueueHandle_t* dataQueuePtr;
+    SampleBus* bus;
+    int busSub; // Subscribed in begin(); TelemetryTask is woken per sample
+    PowerTrigger* powerTrigger;
+    SerialSink serialSink;
+    uint32_t serialSeq; // Binary frames; gaps at the decoder are sink drops
     SemaphoreHandle_t sdMutex;
-    String latestTimestamp; // Last known timestamp
+    SdLogger sdLog;
+#if SD_LOG_GORILLA
+    SdLogger gorLog;
+    GorillaEncoder gorEnc;
+    uint8_t gorBlock[SD_GORILLA_BLOCK_BYTES];
+    unsigned long gorBlockStartMs;
+#endif
 };
 
 #endif
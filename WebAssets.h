@@ -0,0 +1,104 @@
+// Generated by tools/build_web_assets.py from web/ — do not edit.
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+struct WebAsset {
+    const char* path;
+    const char* mime;
+    const uint8_t* gz;  // gzip-compressed body
+    size_t gzLen;
+    const char* etag;   // Quoted content hash
+    bool immutable;     // Versioned URL, cache for a year
+};
+
+// app.css: 186 bytes, 163 gzipped
+static const uint8_t WEB_APP_CSS_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4d, 0x8d, 0xc1, 0x0a, 0xc3, 0x20,
+    0x10, 0x44, 0xef, 0xfd, 0x8a, 0x40, 0xe8, 0xd1, 0x12, 0x69, 0x4e, 0xfa, 0x35, 0x9b, 0xb8, 0xda,
+    0xa5, 0xea, 0x06, 0xdd, 0x10, 0x43, 0xe8, 0xbf, 0x37, 0x6d, 0x2f, 0xbd, 0x0d, 0x33, 0x8f, 0x37,
+    0x13, 0xbb, 0xfd, 0x98, 0x60, 0x7e, 0x86, 0xc2, 0x6b, 0x76, 0xa6, 0xd7, 0x5a, 0xdb, 0x99, 0x23,
+    0x17, 0xd3, 0x23, 0xa2, 0xf5, 0x9c, 0x45, 0x79, 0x48, 0x14, 0x77, 0x53, 0x21, 0x57, 0x55, 0xb1,
+    0x90, 0xb7, 0x82, 0x4d, 0x14, 0x44, 0x0a, 0xd9, 0xcc, 0x98, 0x05, 0x8b, 0x7d, 0x5d, 0x28, 0x85,
+    0x23, 0x41, 0x53, 0x1b, 0x39, 0x79, 0x18, 0x3d, 0x0c, 0xd7, 0xb3, 0xbc, 0x55, 0x01, 0x59, 0xeb,
+    0x31, 0x71, 0x71, 0x58, 0x8c, 0x5e, 0x5a, 0x57, 0x39, 0x92, 0xeb, 0xfa, 0x71, 0x1c, 0xed, 0x02,
+    0xce, 0x51, 0x0e, 0x27, 0xbc, 0x34, 0x9b, 0xa0, 0x04, 0xca, 0xdf, 0xdc, 0xc1, 0x2a, 0x6c, 0x7f,
+    0xa2, 0xfb, 0xf0, 0x19, 0xff, 0x0e, 0x23, 0x7a, 0x39, 0xcd, 0x6f, 0xcc, 0x14, 0x06, 0x04, 0xba,
+    0x00, 0x00, 0x00,
+};
+
+// app.js: 1032 bytes, 419 gzipped
+static const uint8_t WEB_APP_JS_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x53, 0xdf, 0x6f, 0xd3, 0x30,
+    0x10, 0x7e, 0xcf, 0x5f, 0xf1, 0xf1, 0x80, 0x9c, 0xa8, 0x23, 0x85, 0x3d, 0x6e, 0x0a, 0x13, 0x8c,
+    0x21, 0x81, 0x60, 0x08, 0xa5, 0xda, 0x6b, 0xe5, 0xc5, 0x97, 0xce, 0x52, 0x62, 0x0f, 0xfb, 0x9a,
+    0xad, 0x1a, 0xfd, 0xdf, 0xb9, 0x24, 0x6b, 0x19, 0x2d, 0x52, 0x01, 0xf1, 0x10, 0xc7, 0xbe, 0xfb,
+    0x7e, 0x9d, 0x25, 0x4f, 0xa7, 0xf8, 0x64, 0x3b, 0x82, 0xd1, 0xf1, 0xe6, 0xda, 0xeb, 0x60, 0x4e,
+    0xe0, 0x1d, 0xa1, 0xa4, 0xd0, 0x51, 0x78, 0x51, 0x92, 0x63, 0x5c, 0x74, 0xb2, 0x46, 0x44, 0x0e,
+    0xa4, 0x5b, 0xd4, 0xc1, 0xb7, 0x98, 0xd2, 0x50, 0x4b, 0x2a, 0xef, 0x22, 0x83, 0x22, 0x0a, 0x38,
+    0xba, 0x1b, 0x91, 0xa5, 0x5f, 0x86, 0x8a, 0x52, 0xf5, 0x88, 0x51, 0xd9, 0x69, 0x42, 0x31, 0xf7,
+    0xae, 0xa5, 0x18, 0xf5, 0x82, 0x04, 0x9a, 0x52, 0x97, 0xa1, 0x78, 0x8d, 0x87, 0x04, 0xe0, 0xb0,
+    0x1a, 0xfe, 0xc0, 0xa8, 0x65, 0xa4, 0xff, 0xb1, 0xfc, 0x72, 0x99, 0xdf, 0xea, 0x10, 0x49, 0x90,
+    0xb9, 0xd1, 0xac, 0x45, 0xa3, 0x87, 0x18, 0x5f, 0x2d, 0x5b, 0x11, 0xcd, 0x17, 0xc4, 0x17, 0x0d,
+    0xf5, 0xdb, 0xb7, 0xab, 0x0f, 0x26, 0x55, 0x3d, 0x46, 0x65, 0xb9, 0x75, 0x8e, 0xc2, 0x8c, 0xee,
+    0x79, 0x23, 0x22, 0x99, 0xad, 0x5b, 0xd8, 0x7a, 0x95, 0x9a, 0x23, 0xb8, 0x65, 0xd3, 0x1c, 0xe1,
+    0xf8, 0x90, 0x56, 0xeb, 0x0d, 0xcd, 0x85, 0xb8, 0xa3, 0x67, 0xf2, 0x4d, 0xe3, 0x00, 0x3f, 0xf2,
+    0xfc, 0xce, 0xd6, 0x76, 0x8f, 0xde, 0x17, 0xe7, 0x32, 0xa4, 0xa3, 0x8a, 0xc9, 0xe0, 0x0c, 0xea,
+    0x7c, 0x73, 0x50, 0x38, 0x81, 0x7a, 0x67, 0xe3, 0xb6, 0xab, 0x0e, 0x7b, 0xb4, 0xdf, 0x98, 0xf7,
+    0x23, 0x4a, 0xf1, 0x3f, 0x7a, 0xb8, 0xf0, 0x37, 0x0e, 0x48, 0x3b, 0xab, 0xf1, 0xf9, 0xeb, 0x6c,
+    0x96, 0xfd, 0x8b, 0xd9, 0xe2, 0x36, 0xee, 0xb9, 0x45, 0xcd, 0xd4, 0x34, 0x96, 0x29, 0x8e, 0xfc,
+    0x4e, 0x07, 0x5c, 0x6b, 0x2e, 0x39, 0x0c, 0xed, 0xce, 0x3a, 0x49, 0x90, 0x0e, 0x9b, 0x9c, 0xfd,
+    0x7b, 0x7b, 0x4f, 0x26, 0x3d, 0xce, 0x30, 0x81, 0xba, 0x52, 0x59, 0x9f, 0xe1, 0x72, 0xfa, 0xe6,
+    0xd1, 0xda, 0xd6, 0x3d, 0x50, 0xc8, 0x3c, 0x8f, 0xbe, 0xc2, 0xb3, 0xa2, 0xc0, 0xd2, 0x19, 0xaa,
+    0xad, 0x23, 0x93, 0x6d, 0x44, 0x27, 0x05, 0x14, 0xbe, 0xcb, 0x37, 0xc1, 0x4f, 0xec, 0x56, 0xf9,
+    0xd5, 0xa0, 0xfc, 0xfc, 0x0f, 0x66, 0x11, 0xea, 0xce, 0x2c, 0xa3, 0xc1, 0x61, 0xa6, 0x36, 0x95,
+    0x58, 0xee, 0x90, 0x25, 0xb8, 0xd4, 0x7f, 0x97, 0xfb, 0xec, 0x49, 0x6f, 0x9b, 0xf3, 0xe5, 0x98,
+    0x13, 0xe9, 0xb9, 0x6f, 0xe5, 0x19, 0x69, 0xf6, 0x21, 0xfb, 0xf5, 0x3a, 0xd6, 0xa8, 0x34, 0x57,
+    0x37, 0xf2, 0x12, 0x33, 0x3c, 0xac, 0x93, 0xf5, 0x69, 0xf2, 0x03, 0xf8, 0x7c, 0x2d, 0x28, 0x08,
+    0x04, 0x00, 0x00,
+};
+
+// index.html: 911 bytes, 469 gzipped
+static const uint8_t WEB_INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x93, 0x51, 0x6f, 0xd3, 0x30,
+    0x14, 0x85, 0xdf, 0xf3, 0x2b, 0xcc, 0x5e, 0x02, 0xd2, 0xda, 0x24, 0x4b, 0xb5, 0xd1, 0xe1, 0x78,
+    0x12, 0x6b, 0xe1, 0x85, 0x8d, 0x42, 0x2a, 0x21, 0x9e, 0x26, 0xc7, 0xbe, 0x6d, 0x4c, 0x13, 0x3b,
+    0xd8, 0xb7, 0x2d, 0xfd, 0xf7, 0xd8, 0x69, 0x27, 0x6d, 0x95, 0x82, 0x78, 0xb2, 0x73, 0x73, 0xbf,
+    0x73, 0x8e, 0x73, 0x1d, 0xfa, 0x66, 0xf6, 0xf5, 0x7e, 0xf9, 0x73, 0x31, 0x27, 0x35, 0xb6, 0x0d,
+    0x8b, 0xe8, 0xf3, 0x02, 0x5c, 0xfa, 0xa5, 0x05, 0xe4, 0x44, 0xf3, 0x16, 0x8a, 0x78, 0xa7, 0x60,
+    0xdf, 0x19, 0x8b, 0x31, 0x11, 0x46, 0x23, 0x68, 0x2c, 0xe2, 0xbd, 0x92, 0x58, 0x17, 0x12, 0x76,
+    0x4a, 0xc0, 0xa8, 0x7f, 0xb8, 0x24, 0x4a, 0x2b, 0x54, 0xbc, 0x19, 0x39, 0xc1, 0x1b, 0x28, 0xb2,
+    0xd8, 0x8b, 0xa0, 0xc2, 0x06, 0xd8, 0xbc, 0x5c, 0xe4, 0x57, 0xa3, 0x32, 0x27, 0xf7, 0xdb, 0x0a,
+    0x1c, 0x47, 0x9a, 0x1c, 0xeb, 0x11, 0x6d, 0x94, 0xde, 0x10, 0x0b, 0x4d, 0x11, 0x3b, 0x3c, 0x34,
+    0xe0, 0x6a, 0x00, 0xef, 0x52, 0x5b, 0x58, 0x15, 0x71, 0xc2, 0xbb, 0x6e, 0x2c, 0x9c, 0xbb, 0xdb,
+    0x15, 0x93, 0x4c, 0xdc, 0x40, 0x26, 0x20, 0x83, 0x9b, 0xe9, 0x14, 0x26, 0xbd, 0x74, 0x72, 0xca,
+    0x59, 0x19, 0x79, 0x08, 0xa9, 0x33, 0x76, 0x52, 0x27, 0x33, 0xee, 0xea, 0xca, 0x70, 0x2b, 0x7d,
+    0x4f, 0xc6, 0xa2, 0x88, 0x4a, 0xb5, 0x23, 0xa2, 0xe1, 0xce, 0x05, 0x1b, 0x8e, 0x5b, 0x17, 0xf8,
+    0x3a, 0x67, 0xb3, 0x3e, 0x3e, 0x29, 0xfb, 0x9a, 0x6f, 0xce, 0x59, 0xf4, 0x43, 0x7d, 0x52, 0xe4,
+    0x96, 0x50, 0xd7, 0x71, 0x4d, 0x94, 0x0c, 0xc0, 0xd3, 0x5e, 0xad, 0x54, 0xcc, 0xbe, 0x18, 0x2e,
+    0x95, 0x5e, 0x8f, 0xc7, 0x63, 0x9a, 0x84, 0xb7, 0x8c, 0x56, 0x36, 0x61, 0xd1, 0xc3, 0xb7, 0xe5,
+    0xf2, 0x1c, 0x68, 0x7f, 0x23, 0x0e, 0x02, 0x8f, 0x46, 0xc2, 0xe8, 0xfb, 0x7c, 0x76, 0x0e, 0x69,
+    0x3b, 0x88, 0x7c, 0x5e, 0x94, 0xa4, 0xe4, 0xe8, 0xce, 0x91, 0x75, 0xe7, 0x06, 0x99, 0x8f, 0x1c,
+    0x11, 0xec, 0xe1, 0x1c, 0xa9, 0xf8, 0x70, 0xb2, 0x07, 0x9f, 0xec, 0x55, 0x7f, 0xeb, 0x0b, 0x4f,
+    0x0e, 0xed, 0x3f, 0x4c, 0xc4, 0x66, 0xdb, 0x11, 0xef, 0x75, 0xee, 0xc3, 0xa5, 0x70, 0x46, 0x0c,
+    0x82, 0x34, 0xf1, 0x33, 0x79, 0x1e, 0x4d, 0x3f, 0x7a, 0xef, 0xc6, 0xed, 0x5a, 0xe9, 0x51, 0x65,
+    0x10, 0x4d, 0x7b, 0x4b, 0xae, 0xd2, 0xee, 0xcf, 0x87, 0x30, 0xa8, 0x6a, 0xeb, 0x0b, 0x9a, 0x18,
+    0x2d, 0x1a, 0x25, 0x36, 0xc5, 0xc5, 0x0a, 0x50, 0xd4, 0x6f, 0xe3, 0xc4, 0x01, 0x86, 0xc4, 0x77,
+    0x6d, 0xe1, 0x40, 0x3b, 0x63, 0xe3, 0x77, 0x17, 0xac, 0xec, 0x77, 0x24, 0xd4, 0x69, 0x72, 0x04,
+    0xff, 0x4f, 0xa1, 0x01, 0xe8, 0x7a, 0x81, 0xb0, 0x79, 0x81, 0xbe, 0xcc, 0x19, 0x8e, 0x26, 0x39,
+    0xf2, 0xd7, 0xa7, 0xea, 0x1b, 0xa8, 0x13, 0x56, 0x75, 0x48, 0x9c, 0x15, 0xa7, 0x8b, 0xfb, 0x2b,
+    0xdc, 0xdb, 0xf4, 0xfd, 0xf5, 0x75, 0xba, 0xe2, 0x59, 0x3e, 0x99, 0xca, 0x2a, 0x4d, 0xf3, 0x98,
+    0xf9, 0xaf, 0xd0, 0x77, 0x06, 0xe9, 0xd3, 0xcd, 0x4d, 0x8e, 0xff, 0xdd, 0x5f, 0xc3, 0xc1, 0x88,
+    0xae, 0x8f, 0x03, 0x00, 0x00,
+};
+
+static const WebAsset WEB_ASSETS[] = {
+    { "/app.css", "text/css", WEB_APP_CSS_GZ, sizeof(WEB_APP_CSS_GZ), "\"41c7e1ce1e799e41\"", true },
+    { "/app.js", "application/javascript", WEB_APP_JS_GZ, sizeof(WEB_APP_JS_GZ), "\"08660fa1349db003\"", true },
+    { "/", "text/html", WEB_INDEX_HTML_GZ, sizeof(WEB_INDEX_HTML_GZ), "\"d5bfff62b7a143bd\"", false },
+};
+
+#define WEB_ASSET_COUNT (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))
+
+#endif
@@ -1,176 +1,312 @@
 #include "WebService.h"
 #include "MqttService.h"
+#include "TelemetryJson.h"
+#include "Metrics.h"
+#include "SystemClock.h"
 #include "esp_eap_client.h"
 #include "esp_wifi.h"
+#include "lwip/sockets.h"
 
-WebService::WebService() : server(80), sensors(nullptr), mqtt(nullptr) {}
+WebService::WebService()
+    : server(80), sensors(nullptr), mqtt(nullptr), bus(nullptr), busSub(-1), historyOK(false),
+      wifiState(WIFI_LINK_BACKOFF), wifiGotIp(false), wifiLost(false), wifiStateMs(0), wifiNextMs(0),
+      wifiBackoffMs(WIFI_BACKOFF_MIN_MS), sntpStarted(false), ntpSynced(false), ssePendingValid(false), sseLastPushMs(0), sseLastKeepaliveMs(0) {
+    memset(&ssePending, 0, sizeof(ssePending));
+}
 
-void WebService::begin(SensorService* s, MqttService* m) {
+void WebService::begin(SensorService* s, MqttService* m, SampleBus* b) {
     sensors = s;
     mqtt = m;
+    bus = b;
+    historyOK = history.begin();
+    busSub = bus ? bus->subscribe("web") : -1;
 
 #if ENABLE_WIFI
     WiFi.mode(WIFI_AP_STA);
     WiFi.softAP("Cubesat_GROUP4", "12345678");
+    Serial.print("AP IP Address: ");
+    Serial.println(WiFi.softAPIP());
 
+    // Reconnects are paced by the link state machine, not the driver
+    WiFi.setAutoReconnect(false);
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t) { onWifiEvent(event); });
 #if ENABLE_WIFI_ENTERPRISE
     WiFi.disconnect(true);
     esp_eap_client_set_identity((uint8_t *)EAP_IDENTITY, strlen(EAP_IDENTITY));
     esp_eap_client_set_username((uint8_t *)EAP_USERNAME, strlen(EAP_USERNAME));
     esp_eap_client_set_password((uint8_t *)EAP_PASSWORD, strlen(EAP_PASSWORD));
     esp_wifi_sta_enterprise_enable();
-    WiFi.begin(WIFI_SSID); // For eduroam, SSID is often "eduroam"
-#else
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
 #endif
-    Serial.print("Connecting to WiFi ");
-    
-    // Wait up to 10 seconds for STA connection
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
-    Serial.println("");
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.print("Connected! IP Address: ");
-        Serial.println(WiFi.localIP());
-
-        // Sync Time using NTP
-        configTime(7 * 3600, 0, "pool.ntp.org", "time.nist.gov");
-        Serial.println("Waiting for NTP time sync...");
-        struct tm timeinfo;
-        int retries = 0;
-        while (!getLocalTime(&timeinfo) && retries < 10) {
-            delay(500);
-            Serial.print(".");
-            retries++;
-        }
-        
-        if (retries < 10) {
-            Serial.println("\nTime synchronized.");
-            if (sensors) {
-                sensors->syncTime(&timeinfo);
-            }
-        } else {
-            Serial.println("\nFailed to obtain NTP time.");
-        }
 
-    } else {
-        Serial.println("WiFi STA Connection Failed. Running in AP Mode only.");
-        Serial.print("AP IP Address: ");
-        Serial.println(WiFi.softAPIP());
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* a = &WEB_ASSETS[i];
+        route(a->path, [this, a]() { serveAsset(*a); });
     }
+    route("/json", std::bind(&WebService::handleJSON, this));
+    route("/events", std::bind(&WebService::handleEvents, this)); // Live stream (SSE)
+    route("/history", std::bind(&WebService::handleHistory, this));
+    route("/metrics", std::bind(&WebService::handleMetrics, this)); // Prometheus text
+    route("/status", std::bind(&WebService::handleStatus, this)); // Plain text
+    route("/setMode", std::bind(&WebService::handleSetMode, this));
 
-    server.on("/", HTTP_GET, std::bind(&WebService::handleRoot, this));
-    server.on("/json", HTTP_GET, std::bind(&WebService::handleJSON, this));
-    server.on("/status", HTTP_GET, std::bind(&WebService::handleStatus, this)); // Plain text
-    server.on("/setMode", HTTP_GET, std::bind(&WebService::handleSetMode, this));
-
+    const char* headerKeys[] = {"If-None-Match"};
+    server.collectHeaders(headerKeys, 1);
     server.begin();
+    metrics.markBoot(BOOT_HTTP_READY);
     Serial.println("WebService started");
+
+    startWifi(); // Returns at once; updateWifi() follows it up
 #endif
 }
 
-void WebService::update() {
-#if ENABLE_WIFI
-    static unsigned long lastCheck = 0;
-    if (millis() - lastCheck > 10000) { // Check every 10s
-        lastCheck = millis();
-        if (WiFi.status() != WL_CONNECTED) {
-            Serial.println("WiFi connection lost. Reconnecting...");
-            // Re-trigger connection if not already connecting
-            // For WPA2 Enterprise or regular
+// All routes are GET; the wrapper stamps the first response for the boot
+// metrics
+void WebService::route(const char* path, std::function<void()> handler) {
+    server.on(path, HTTP_GET, [handler]() {
+        handler();
+        metrics.markBoot(BOOT_FIRST_HTTP);
+    });
+}
+
+// WiFi event task: only flags; updateWifi() acts on them from loop()
+void WebService::onWifiEvent(arduino_event_id_t event) {
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) wifiGotIp = true;
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) wifiLost = true;
+}
+
+void WebService::startWifi() {
+    wifiGotIp = false;
+    wifiLost = false;
+    wifiState = WIFI_LINK_CONNECTING;
+    wifiStateMs = millis();
 #if ENABLE_WIFI_ENTERPRISE
-            WiFi.begin(WIFI_SSID);
+    WiFi.begin(WIFI_SSID); // For eduroam, SSID is often "eduroam"
 #else
-            WiFi.begin(WIFI_SSID, WIFI_PASS);
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
 #endif
-        }
+    Serial.println("Connecting to WiFi...");
+}
+
+// Advances the STA link. Never blocks: the SoftAP, the server and the
+// sample pipeline keep running while it associates or backs off.
+void WebService::updateWifi() {
+    unsigned long now = millis();
+    switch (wifiState) {
+        case WIFI_LINK_CONNECTING:
+            if (wifiGotIp) {
+                wifiGotIp = false;
+                wifiLost = false;
+                wifiState = WIFI_LINK_UP;
+                wifiBackoffMs = WIFI_BACKOFF_MIN_MS;
+                Serial.printf("WiFi connected (%lu ms), IP Address: ", now - wifiStateMs);
+                Serial.println(WiFi.localIP());
+                metrics.markBoot(BOOT_WIFI_UP);
+                if (!sntpStarted) {
+                    // Every SNTP update disciplines SystemClock, which in
+                    // turn keeps the RTC set (SensorService::readRtc).
+                    // Samples keep their monotonic stamps across the step.
+                    configTime(CLOCK_TZ_OFFSET_S, 0, "pool.ntp.org", "time.nist.gov");
+                    sntpStarted = true;
+                }
+            } else if (wifiLost || now - wifiStateMs > WIFI_CONNECT_TIMEOUT_MS) {
+                Serial.println("WiFi STA connection failed. Running in AP mode only.");
+                scheduleWifiRetry(true);
+            }
+            break;
+        case WIFI_LINK_UP:
+            if (wifiLost) {
+                Serial.println("WiFi connection lost. Reconnecting...");
+                scheduleWifiRetry(false);
+            }
+            break;
+        case WIFI_LINK_BACKOFF:
+            if ((long)(now - wifiNextMs) >= 0) startWifi();
+            break;
+    }
+
+    if (sntpStarted && !ntpSynced && systemClock.getStats().syncs[CLOCK_SRC_NTP]) {
+        ntpSynced = true;
+        metrics.markBoot(BOOT_NTP_SYNC);
+        Serial.println("Time synchronized (NTP).");
+    }
+}
+
+// Same policy as the MQTT link: a random wait in [window/2, window],
+// doubling the window after each failed attempt
+void WebService::scheduleWifiRetry(bool failed) {
+    if (failed) {
+        uint32_t next = wifiBackoffMs * 2;
+        wifiBackoffMs = (next > WIFI_BACKOFF_MAX_MS) ? WIFI_BACKOFF_MAX_MS : next;
+    } else {
+        wifiBackoffMs = WIFI_BACKOFF_MIN_MS;
     }
+    WiFi.disconnect(); // Abandons the attempt; the AP stays up
+    uint32_t half = wifiBackoffMs / 2;
+    wifiNextMs = millis() + half + random(half + 1);
+    wifiState = WIFI_LINK_BACKOFF;
+}
+
+void WebService::update() {
+#if ENABLE_WIFI
+    updateWifi();
 #endif
+    consumeSamples();
     server.handleClient();
+    pushEvents();
+}
+
+// Every sample goes into history (kept even when nobody is looking at the
+// dashboard); the newest one is queued for the SSE stream
+void WebService::consumeSamples() {
+    MeasurementData d;
+    while (bus && bus->read(busSub, d)) {
+        if (historyOK) history.append(d);
+        ssePending = d;
+        ssePendingValid = true;
+    }
+}
+
+// GET /history?field=vin&res=raw|1m|15m&since=<monotonic ms>
+// Streamed with chunked encoding, so the response is never built in RAM
+void WebService::handleHistory() {
+    if (!historyOK) { server.send(503, "text/plain", "History unavailable"); return; }
+    String field = server.hasArg("field") ? server.arg("field") : String("pin");
+    String res = server.hasArg("res") ? server.arg("res") : String("raw");
+    uint64_t since = server.hasArg("since") ? strtoull(server.arg("since").c_str(), nullptr, 10) : 0;
+
+    if (TelemetryHistory::fieldIndex(field.c_str()) < 0 || TelemetryHistory::resIndex(res.c_str()) < 0) {
+        server.send(400, "text/plain", "Unknown field or res");
+        return;
+    }
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.send(200, "application/json", "");
+    history.query(field.c_str(), res.c_str(), since, [this](const char* data, size_t len) {
+        server.sendContent(data, len);
+    });
+    server.sendContent(""); // Terminating chunk
 }
 
-void WebService::handleRoot() {
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-    html += "<title>ESP32-S3 Cubesat</title>";
-    html += "<style>body{background:#111;color:#eee;font-family:sans-serif;text-align:center;} img{max-width:100%;} .status{border:1px solid #444;padding:10px;margin:10px auto;width:300px;text-align:left;}</style>";
-    html += "</head><body>";
-    html += "<h1>Cubesat Dashboard</h1>";
-    
-    html += "<div class='status'>";
-    html += "<h3>Device Status</h3>";
-    html += "WiFi : <span id='st_wifi'>Loading...</span><br/>";
-    html += "MQTT : <span id='st_mqtt'>Loading...</span><br/>";
-    html += "Node-RED : <span id='st_nr'>Loading...</span><br/>";
-    html += "GPS Sats : <span id='st_gps'>Loading...</span><br/>";
-    html += "Battery : <span id='st_bat'>Loading...</span><br/>";
-    html += "Mode : <span id='mode_str'>Loading...</span><br/>";
-    html += "Backup Bat : <span id='st_adcsoc'>Loading...</span><br/>";
-    html += "</div>";
-
-    html += "<div style='margin-bottom: 20px;'>";
-    html += "<button onclick=\"fetch('/setMode?m=sensor')\">Sensor Mode</button> ";
-    html += "<button onclick=\"fetch('/setMode?m=sleep')\">Sleep</button>";
-    html += "</div>";
-    
-    html += "<div id='data'>Loading...</div>";
-    html += "<script>setInterval(async()=>{";
-    html += "  try {";
-    html += "    const r=await fetch('/json');const d=await r.json();";
-    html += "    document.getElementById('data').innerText = JSON.stringify(d,null,2);";
-    html += "    document.getElementById('mode_str').innerText = d.mode_str;";
-    html += "    document.getElementById('st_wifi').innerText = d.wifi_connected ? 'Connected' : 'Disconnected';";
-    html += "    document.getElementById('st_mqtt').innerText = d.mqtt_connected ? 'Connected' : 'Disconnected';";
-    html += "    document.getElementById('st_nr').innerText = d.mqtt_connected ? 'Connected (via MQTT)' : 'Disconnected';";
-    html += "    document.getElementById('st_gps').innerText = d.satellites;";
-    html += "    var batStr = d.vin ? (d.vin.toFixed(2) + 'V') : 'N/A';";
-    html += "    if(d.batt_soc !== undefined) batStr += ' | ' + d.batt_soc.toFixed(1) + '%';";
-    html += "    document.getElementById('st_bat').innerText = batStr;";
-    html += "    document.getElementById('st_adcsoc').innerText = (d.adc_soc !== undefined) ? (d.adc_soc.toFixed(0) + '% (Comparator)') : 'N/A';";
-    html += "  } catch(e) {}";
-    html += "},2000);</script>";
-    html += "</body></html>";
-    server.send(200, "text/html", html);
+// Dashboard assets are gzipped at build time (tools/build_web_assets.py)
+// and served straight from flash. The page itself is revalidated with its
+// ETag on every load; CSS/JS use versioned URLs and are cached for a year.
+void WebService::serveAsset(const WebAsset& a) {
+    server.sendHeader("ETag", a.etag);
+    server.sendHeader("Cache-Control", a.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+    if (server.hasHeader("If-None-Match") && strstr(server.header("If-None-Match").c_str(), a.etag)) {
+        server.send(304);
+        return;
+    }
+    server.sendHeader("Content-Encoding", "gzip");
+    server.sendHeader("Vary", "Accept-Encoding");
+    server.send_P(200, a.mime, (const char*)a.gz, a.gzLen);
 }
 
 void WebService::handleJSON() {
     if (!sensors) { server.send(500); return; }
-    MeasurementData d = sensors->getLatestData();
-
-    String j = "{";
-    j += "\"wifi_connected\":" + String(WiFi.status() == WL_CONNECTED ? "true" : "false") + ",";
-    bool mqttConn = mqtt ? mqtt->isConnected() : false;
-    j += "\"mqtt_connected\":" + String(mqttConn ? "true" : "false") + ",";
-    j += "\"mode\":" + String(currentSystemMode) + ",";
-    j += "\"mode_str\":\"" + String(currentSystemMode == MODE_SENSOR ? "Sensor" : "Sleep") + "\",";
-    j += "\"ts\":\"" + String(d.timestamp) + "\",";
-    j += "\"vin\":" + String(d.vin, 3) + ",";
-    j += "\"iin\":" + String(d.iin, 6) + ",";
-    j += "\"pin\":" + String(d.pin, 6) + ",";
-    j += "\"vout\":" + String(d.vout, 3) + ",";
-    j += "\"iout\":" + String(d.iout, 6) + ",";
-    j += "\"pout\":" + String(d.pout, 6) + ",";
-    j += "\"eff\":" + String(d.efficiency, 2) + ",";
-    j += "\"lat\":" + String(d.lat, 6) + ",";
-    j += "\"lng\":" + String(d.lng, 6) + ",";
-    j += "\"satellites\":" + String(d.satellites) + ",";
-    j += "\"batt_soc\":" + String(d.battSoC, 2) + ",";
-    j += "\"adc_soc\":" + String(d.adcSoC, 1) + ",";
-    j += "\"logic0\":" + String(d.logicLevels[0], 2) + ",";
-    j += "\"logic1\":" + String(d.logicLevels[1], 2) + ",";
-    j += "\"logic2\":" + String(d.logicLevels[2], 2) + ",";
-    j += "\"logic3\":" + String(d.logicLevels[3], 2) + ",";
-    j += "\"adc0\":" + String(d.adcValues[0]) + ",";
-    j += "\"adc1\":" + String(d.adcValues[1]) + ",";
-    j += "\"adc2\":" + String(d.adcValues[2]) + ",";
-    j += "\"adc3\":" + String(d.adcValues[3]);
-    j += "}";
-    server.send(200, "application/json", j);
+    MeasurementData d;
+    if (!sensors->getLatestData(d)) { server.send(503, "text/plain", "No sample yet"); return; }
+
+    LinkStatus link = { WiFi.status() == WL_CONNECTED, mqtt ? mqtt->isConnected() : false };
+    char payload[TELEMETRY_JSON_MAX];
+    size_t len = encodeTelemetryJson(payload, sizeof(payload), d, link, currentSystemMode);
+    if (len == 0) { server.send(500); return; }
+    server.send_P(200, "application/json", payload, len);
+}
+
+// Takes over the connection as an SSE stream. The WebServer drops its own
+// reference after this handler returns; our copy keeps the socket open.
+void WebService::handleEvents() {
+    int slot = -1;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (!sseClients[i].connected()) {
+            sseClients[i].stop();
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        server.send(503, "text/plain", "Too many stream clients");
+        return;
+    }
+
+    WiFiClient c = server.client();
+    c.setNoDelay(true);
+    c.print("HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n"
+            "Access-Control-Allow-Origin: *\r\n\r\n"
+            "retry: 2000\n\n");
+    sseClients[slot] = c;
+    // Send the current sample to the new client right away
+    ssePendingValid = sensors && sensors->getLatestData(ssePending);
+}
+
+// Returns false if the client could not take the whole event; a slow or
+// dead client is dropped rather than allowed to stall the loop.
+// WiFiClient::write() waits up to ~10 s for send-buffer space, so the
+// socket is written directly with MSG_DONTWAIT: an event either fits in
+// the free send buffer now or the client is behind and gets cut off (a
+// partial event would corrupt the stream anyway; EventSource reconnects).
+bool WebService::sseWrite(WiFiClient& c, const char* data, size_t len) {
+    int fd = c.fd();
+    if (fd < 0) return false;
+    ssize_t n = send(fd, data, len, MSG_DONTWAIT);
+    return n == (ssize_t)len;
+}
+
+void WebService::pushEvents() {
+    unsigned long now = millis();
+    bool any = false;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sseClients[i].connected()) any = true;
+    }
+    if (!any) {
+        ssePendingValid = false;
+        return;
+    }
+
+    if (now - sseLastPushMs < SSE_MIN_INTERVAL_MS) return;
+
+    bool fresh = ssePendingValid;
+    bool keepalive = now - sseLastKeepaliveMs >= SSE_KEEPALIVE_MS;
+    if (!fresh && !keepalive) return;
+
+    // One encode for all clients: "data: <json>\n\n"
+    char event[TELEMETRY_JSON_MAX + 8];
+    size_t len;
+    if (fresh) {
+        memcpy(event, "data: ", 6);
+        LinkStatus link = { WiFi.status() == WL_CONNECTED, mqtt ? mqtt->isConnected() : false };
+        size_t n = encodeTelemetryJson(event + 6, sizeof(event) - 8, ssePending, link, currentSystemMode);
+        ssePendingValid = false;
+        if (n == 0) return;
+        memcpy(event + 6 + n, "\n\n", 2);
+        len = n + 8;
+        sseLastPushMs = now;
+    } else {
+        memcpy(event, ":\n\n", 3);
+        len = 3;
+    }
+    sseLastKeepaliveMs = now;
+
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        WiFiClient& c = sseClients[i];
+        if (!c.connected()) continue;
+        if (!sseWrite(c, event, len)) {
+            c.stop();
+        }
+    }
+}
+
+void WebService::handleMetrics() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4", "");
+    metrics.writePrometheus([this](const char* data, size_t len) {
+        server.sendContent(data, len);
+    });
+    server.sendContent(""); // Terminating chunk
 }
 
 void WebService::handleStatus() {
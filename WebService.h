@@ -5,23 +5,75 @@
 #include <WebServer.h>
 #include "DataModel.h"
 #include "SensorService.h"
+#include "WebAssets.h"
+#include "TelemetryHistory.h"
+
+// Server-Sent Events live stream (/events): one encode per sample,
+// written to every connected dashboard
+#define SSE_MAX_CLIENTS      4
+#define SSE_MIN_INTERVAL_MS  200    // Rate limit: at most 5 pushes/s
+#define SSE_KEEPALIVE_MS     15000  // Comment line to detect dead clients
+
+// STA bring-up runs in the background: begin() returns with the SoftAP and
+// the server up, WiFi events drive the link from update()
+#define WIFI_CONNECT_TIMEOUT_MS 10000 // Association + DHCP budget per attempt
+#define WIFI_BACKOFF_MIN_MS     2000
+#define WIFI_BACKOFF_MAX_MS     60000
+
+enum WifiLinkState {
+    WIFI_LINK_CONNECTING, // WiFi.begin() issued, waiting for an IP
+    WIFI_LINK_UP,
+    WIFI_LINK_BACKOFF     // Waiting for the next attempt; AP only
+};
 
 class MqttService; // Forward declaration
 
 class WebService {
 public:
     WebService();
-    void begin(SensorService* sensors, MqttService* mqtt);
+    void begin(SensorService* sensors, MqttService* mqtt, SampleBus* bus);
     void update(); // Call in loop() or task
 
 private:
     WebServer server;
     SensorService* sensors;
     MqttService* mqtt;
+    SampleBus* bus;
+    int busSub; // Feeds history and the SSE stream
+
+    TelemetryHistory history;
+    bool historyOK;
+
+    // STA link; the flags are set from the WiFi event task
+    WifiLinkState wifiState;
+    volatile bool wifiGotIp;
+    volatile bool wifiLost;
+    unsigned long wifiStateMs; // Attempt start
+    unsigned long wifiNextMs;  // Next attempt while backing off
+    uint32_t wifiBackoffMs;
+    bool sntpStarted;
+    bool ntpSynced;
+
+    WiFiClient sseClients[SSE_MAX_CLIENTS];
+    MeasurementData ssePending; // Newest sample not yet pushed
+    bool ssePendingValid;
+    unsigned long sseLastPushMs;
+    unsigned long sseLastKeepaliveMs;
 
+    void startWifi();
+    void updateWifi();
+    void scheduleWifiRetry(bool failed);
+    void onWifiEvent(arduino_event_id_t event);
+    void route(const char* path, std::function<void()> handler);
 
-    void handleRoot();
+    void serveAsset(const WebAsset& a);
     void handleJSON();
+    void handleEvents();
+    void handleHistory();
+    void consumeSamples();
+    void handleMetrics();
+    void pushEvents();
+    bool sseWrite(WiFiClient& c, const char* data, size_t len);
     void handleStatus();
     void handleSetMode();
 };
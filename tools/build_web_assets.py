@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Regenerates WebAssets.h from the dashboard sources in web/.
+
+Each file is gzip-compressed (deterministically, so unchanged sources give
+an unchanged header) and embedded as a PROGMEM array with a content-hash
+ETag. `{{name}}` placeholders in index.html are replaced by the hash of
+that asset so the CSS/JS URLs change whenever their content does, which
+lets them be cached as immutable.
+
+Run from the sketch folder after editing anything in web/:
+    python3 tools/build_web_assets.py
+"""
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB = os.path.join(ROOT, "web")
+OUT = os.path.join(ROOT, "WebAssets.h")
+
+# (file, URL path, MIME type, immutable). Immutable assets are referenced
+# with a ?v=<hash> query, so they can be cached for a year.
+ASSETS = [
+    ("app.css", "/app.css", "text/css", True),
+    ("app.js", "/app.js", "application/javascript", True),
+    ("index.html", "/", "text/html", False),
+]
+
+
+def digest(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def main():
+    hashes = {}
+    entries = []
+    arrays = []
+    for fname, path, mime, immutable in ASSETS:
+        with open(os.path.join(WEB, fname), "rb") as f:
+            src = f.read()
+        # Versioned references to assets already processed
+        src = re.sub(rb"\{\{([\w.]+)\}\}", lambda m: hashes[m.group(1).decode()].encode(), src)
+        hashes[fname] = digest(src)
+        gz = gzip.compress(src, compresslevel=9, mtime=0)
+        ident = "WEB_" + re.sub(r"\W", "_", fname).upper() + "_GZ"
+        arrays.append("// %s: %d bytes, %d gzipped\n" % (fname, len(src), len(gz)) + c_array(ident, gz))
+        entries.append('    { "%s", "%s", %s, sizeof(%s), "\\"%s\\"", %s },'
+                       % (path, mime, ident, ident, hashes[fname], "true" if immutable else "false"))
+
+    with open(OUT, "w", newline="\n") as f:
+        f.write("// Generated by tools/build_web_assets.py from web/ — do not edit.\n")
+        f.write("#ifndef WEB_ASSETS_H\n#define WEB_ASSETS_H\n\n#include <Arduino.h>\n\n")
+        f.write("struct WebAsset {\n"
+                "    const char* path;\n"
+                "    const char* mime;\n"
+                "    const uint8_t* gz;  // gzip-compressed body\n"
+                "    size_t gzLen;\n"
+                "    const char* etag;   // Quoted content hash\n"
+                "    bool immutable;     // Versioned URL, cache for a year\n"
+                "};\n\n")
+        f.write("\n".join(arrays))
+        f.write("\nstatic const WebAsset WEB_ASSETS[] = {\n%s\n};\n\n" % "\n".join(entries))
+        f.write("#define WEB_ASSET_COUNT (sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]))\n\n#endif\n")
+
+
+if __name__ == "__main__":
+    main()
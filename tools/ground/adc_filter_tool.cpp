@@ -0,0 +1,259 @@
+// Checks the firmware comparator-ADC filter (AdcFilter) off-target and
+// measures its throughput against the DMA conversion rate.
+//
+// Build (host):
+//   g++ -O2 -std=c++11 -I../.. adc_filter_tool.cpp ../../AdcFilter.cpp -o adc_filter_tool
+//
+// Usage:
+//   ./adc_filter_tool test          decimation, EMA priming, channel skip, step
+//                                   response and noise checks (exit 1 on failure)
+//   ./adc_filter_tool bench [N]     N conversions through processBlock() in DMA-frame
+//                                   blocks; reports ns/conversion and headroom
+
+#include "AdcFilter.h"
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Firmware defaults (SensorService.h)
+#define SAMPLE_HZ    20000 // ADC_DMA_SAMPLE_HZ, all four pins interleaved
+#define FRAME_CONV   64    // ADC_DMA_FRAME_BYTES / SOC_ADC_DIGI_RESULT_BYTES
+#define DECIMATION   50    // ADC_DECIMATION
+#define TAU_MS       4000  // ADC_EMA_TAU_MS
+
+static const float DT_MS = 1000.0f * DECIMATION * ADC_FILTER_CHANNELS / SAMPLE_HZ;
+static const float ALPHA = DT_MS / (TAU_MS + DT_MS); // emaAlpha() in SensorService
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+// Interleaved stream as the DMA delivers it: ch0, ch1, ch2, ch3, ch0, ...
+// value(ch, k) gives the k-th conversion of a channel
+template <typename F>
+static void interleave(size_t perChannel, std::vector<uint16_t>& raw, std::vector<uint8_t>& chan, F value) {
+    raw.clear();
+    chan.clear();
+    for (size_t k = 0; k < perChannel; k++) {
+        for (uint8_t ch = 0; ch < ADC_FILTER_CHANNELS; ch++) {
+            raw.push_back(value(ch, k));
+            chan.push_back(ch);
+        }
+    }
+}
+
+// Feeds in DMA-frame-sized blocks, so decimation windows straddle blocks
+static size_t feed(AdcFilter& f, const std::vector<uint16_t>& raw, const std::vector<uint8_t>& chan,
+                   size_t block = FRAME_CONV) {
+    size_t produced = 0;
+    for (size_t i = 0; i < raw.size(); i += block) {
+        size_t n = raw.size() - i < block ? raw.size() - i : block;
+        produced += f.processBlock(&raw[i], &chan[i], n);
+    }
+    return produced;
+}
+
+static void testDecimation() {
+    // Per-channel ramps: each boxcar output is the exact mean of its window
+    std::vector<uint16_t> raw;
+    std::vector<uint8_t> chan;
+    interleave(4 * DECIMATION + 7, raw, chan, [](uint8_t ch, size_t k) { return (uint16_t)(ch * 1000 + k); });
+
+    AdcFilter f;
+    f.begin(DECIMATION, 1.0f); // alpha 1: the EMA passes the boxcar through
+    size_t produced = feed(f, raw, chan);
+
+    bool ok = produced == 4 * ADC_FILTER_CHANNELS;
+    for (uint8_t ch = 0; ch < ADC_FILTER_CHANNELS; ch++) {
+        // Last complete window is k = 150..199; the 7 trailing conversions are still pending
+        double expect = ch * 1000 + (3 * DECIMATION + 4 * DECIMATION - 1) / 2.0;
+        ok = ok && f.outputCount(ch) == 4 && fabs(f.value(ch) - expect) < 1e-3;
+    }
+    check(ok, "decimation", "%zu outputs for %zu conversions (1 per %d per channel), window means exact",
+          produced, raw.size(), DECIMATION);
+
+    // Decimation 1 is the polled analogRead() path: every conversion is an output
+    AdcFilter p;
+    p.begin(1, 1.0f);
+    size_t polled = feed(p, raw, chan, ADC_FILTER_CHANNELS);
+    check(polled == raw.size() && p.value(2) == raw[raw.size() - 2], "decimation=1",
+          "%zu outputs, last value passed through", polled);
+}
+
+static void testPriming() {
+    AdcFilter f;
+    f.begin(DECIMATION, ALPHA);
+    std::vector<uint16_t> raw;
+    std::vector<uint8_t> chan;
+
+    // One conversion short of a full window: nothing is ready yet
+    interleave(DECIMATION - 1, raw, chan, [](uint8_t, size_t) { return (uint16_t)3000; });
+    feed(f, raw, chan);
+    bool notReady = true;
+    for (uint8_t ch = 0; ch < ADC_FILTER_CHANNELS; ch++) notReady = notReady && !f.ready(ch);
+
+    // Completing the window primes the EMA with the mean itself, not a
+    // step up from 0 that would take seconds to settle
+    interleave(1, raw, chan, [](uint8_t, size_t) { return (uint16_t)3000; });
+    feed(f, raw, chan);
+    bool primed = f.ready(0) && f.value(0) == 3000.0f;
+
+    // From then on the EMA applies: one window at 1000 moves it by alpha
+    interleave(DECIMATION, raw, chan, [](uint8_t, size_t) { return (uint16_t)1000; });
+    feed(f, raw, chan);
+    double expect = 3000.0 + ALPHA * (1000.0 - 3000.0);
+    bool smoothed = fabs(f.value(0) - expect) < 1e-2;
+
+    check(notReady && primed && smoothed, "ema priming",
+          "not ready after %d conversions, primed to %.1f, next output %.3f (expect %.3f)",
+          DECIMATION - 1, 3000.0, f.value(0), expect);
+}
+
+static void testChannelSkip() {
+    // Reference stream vs. the same stream with foreign channels spliced in
+    std::mt19937 rng(7);
+    std::vector<uint16_t> raw, mixedRaw;
+    std::vector<uint8_t> chan, mixedChan;
+    interleave(3 * DECIMATION, raw, chan, [&](uint8_t, size_t) { return (uint16_t)(rng() % 4096); });
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (i % 5 == 0) {
+            // Unmapped DMA channel (0xFF from adcChanIndex) and a just-out-of-range index
+            mixedRaw.push_back(4095);
+            mixedChan.push_back(i % 10 == 0 ? 0xFF : ADC_FILTER_CHANNELS);
+        }
+        mixedRaw.push_back(raw[i]);
+        mixedChan.push_back(chan[i]);
+    }
+
+    AdcFilter a, b;
+    a.begin(DECIMATION, ALPHA);
+    b.begin(DECIMATION, ALPHA);
+    size_t pa = feed(a, raw, chan);
+    size_t pb = feed(b, mixedRaw, mixedChan);
+    bool same = pa == pb;
+    for (uint8_t ch = 0; ch < ADC_FILTER_CHANNELS; ch++) {
+        same = same && a.value(ch) == b.value(ch) && a.outputCount(ch) == b.outputCount(ch);
+    }
+    check(same, "channel skip", "%zu foreign conversions ignored, outputs identical",
+          mixedRaw.size() - raw.size());
+
+    // Channels decimate independently: a pin missing from the stream never primes
+    std::vector<uint16_t> r3;
+    std::vector<uint8_t> c3;
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (chan[i] == 3) continue;
+        r3.push_back(raw[i]);
+        c3.push_back(chan[i]);
+    }
+    AdcFilter c;
+    c.begin(DECIMATION, ALPHA);
+    feed(c, r3, c3);
+    check(c.ready(0) && c.ready(2) && !c.ready(3), "independent", "channel 3 absent: not ready, others unaffected");
+}
+
+static void testStep() {
+    // 0 -> 4000 step at the firmware rate; after one time constant the EMA
+    // output should have covered 1 - 1/e of it
+    AdcFilter f;
+    f.begin(DECIMATION, ALPHA);
+    std::vector<uint16_t> raw;
+    std::vector<uint8_t> chan;
+    interleave(DECIMATION, raw, chan, [](uint8_t, size_t) { return (uint16_t)0; });
+    feed(f, raw, chan);
+    size_t outputsPerTau = (size_t)lroundf(TAU_MS / DT_MS);
+    interleave(outputsPerTau * DECIMATION, raw, chan, [](uint8_t, size_t) { return (uint16_t)4000; });
+    feed(f, raw, chan);
+    double frac = f.value(1) / 4000.0;
+    check(fabs(frac - (1.0 - exp(-1.0))) < 0.01, "step", "%.1f%% after tau = %d ms (%zu outputs, expect 63.2%%)",
+          frac * 100.0, TAU_MS, outputsPerTau);
+}
+
+static void testNoise() {
+    // White noise of sigma 40 counts: the boxcar alone (alpha 1) divides
+    // it by sqrt(decimation)
+    std::mt19937 rng(11);
+    std::normal_distribution<double> noise(0.0, 40.0);
+    AdcFilter f;
+    f.begin(DECIMATION, 1.0f);
+    std::vector<uint16_t> raw(ADC_FILTER_CHANNELS);
+    std::vector<uint8_t> chan(ADC_FILTER_CHANNELS);
+    double sum = 0.0, sum2 = 0.0;
+    int n = 0;
+    for (int k = 0; k < 2000 * DECIMATION; k++) {
+        for (uint8_t ch = 0; ch < ADC_FILTER_CHANNELS; ch++) {
+            raw[ch] = (uint16_t)lround(2048.0 + noise(rng));
+            chan[ch] = ch;
+        }
+        uint32_t before = f.outputCount(0);
+        f.processBlock(raw.data(), chan.data(), ADC_FILTER_CHANNELS);
+        if (f.outputCount(0) != before) {
+            sum += f.value(0);
+            sum2 += (double)f.value(0) * f.value(0);
+            n++;
+        }
+    }
+    double mean = sum / n;
+    double sd = sqrt(sum2 / n - mean * mean);
+    double expect = 40.0 / sqrt((double)DECIMATION);
+    check(fabs(sd - expect) < 0.1 * expect, "noise", "sigma 40.0 -> %.2f counts over %d outputs (expect %.2f)",
+          sd, n, expect);
+}
+
+static int test() {
+    printf("decimation %d, alpha %.5f (tau %d ms at %.0f Hz per channel)\n", DECIMATION, ALPHA, TAU_MS,
+           1000.0f / DT_MS);
+    testDecimation();
+    testPriming();
+    testChannelSkip();
+    testStep();
+    testNoise();
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
+
+static int bench(long n) {
+    std::mt19937 rng(3);
+    std::vector<uint16_t> raw;
+    std::vector<uint8_t> chan;
+    interleave(FRAME_CONV * 256 / ADC_FILTER_CHANNELS, raw, chan, [&](uint8_t, size_t) { return (uint16_t)(rng() % 4096); });
+
+    AdcFilter f;
+    f.begin(DECIMATION, ALPHA);
+    volatile size_t sink = 0;
+    long done = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (done < n) {
+        for (size_t i = 0; i < raw.size() && done < n; i += FRAME_CONV) {
+            sink += f.processBlock(&raw[i], &chan[i], FRAME_CONV);
+            done += FRAME_CONV;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / done;
+    printf("%ld conversions in %d-conversion blocks: %.2f ns/conversion, %.1f MS/s\n", done, FRAME_CONV, ns,
+           1e3 / ns);
+    printf("DMA rate %d S/s -> %.4f%% of one host core (ESP32-S3 roughly 10-20x slower)\n", SAMPLE_HZ,
+           SAMPLE_HZ * ns * 1e-7);
+    return sink == 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && !strcmp(argv[1], "test")) return test();
+    if (argc >= 2 && !strcmp(argv[1], "bench")) return bench(argc >= 3 ? atol(argv[2]) : 100000000L);
+    fprintf(stderr, "usage: %s test | bench [N]\n", argv[0]);
+    return 2;
+}
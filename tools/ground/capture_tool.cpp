@@ -0,0 +1,250 @@
+// Ground-side tool for PowerTrigger captures (cubesat/capture, /captures/*.bin).
+//
+// Build (host):
+//   g++ -O2 -std=c++11 -I../.. capture_tool.cpp ../../PowerTrigger.cpp -o capture_tool
+//
+// Usage:
+//   ./capture_tool replay                   replay synthetic fault waveforms through the
+//                                           firmware trigger engine and check latency and
+//                                           capture completeness (exit 1 on failure)
+//   ./capture_tool decode cap_*.bin > capture.csv
+//   mosquitto_sub -h broker.hivemq.com -t cubesat/capture -F %x | ./capture_tool decode -
+
+#include "PowerTrigger.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#define PERIOD_US 18800 // INA226 conversion period, PM_PROFILE_TELEMETRY
+
+static void printCapture(const uint8_t* data, size_t len, const char* source) {
+    CaptureHeader h;
+    const uint8_t* samples;
+    if (!parseCapture(data, len, h, &samples)) {
+        fprintf(stderr, "%s: not a capture (%zu bytes)\n", source, len);
+        return;
+    }
+    fprintf(stderr, "%s: rule %u (%s %s %g %g), epoch %lu, %u samples, %u before trigger\n",
+            source, h.rule, PowerTrigger::fieldName(h.field), PowerTrigger::typeName(h.type), h.a, h.b,
+            (unsigned long)h.epoch, h.count, h.pre);
+    for (uint16_t i = 0; i < h.count; i++) {
+        int32_t dt;
+        float v[PF_COUNT];
+        captureSample(samples, i, &dt, v);
+        printf("%lu,%ld,%.4f,%.5f,%.5f,%.2f\n", (unsigned long)h.epoch, (long)dt, v[PF_VIN], v[PF_IIN],
+               v[PF_POUT], v[PF_EFF]);
+    }
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int decode(int argc, char** argv) {
+    printf("epoch,dt_us,vin,iin,pout,efficiency\n");
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "-")) {
+            // One hex-encoded capture per line
+            std::string line;
+            int c;
+            while ((c = getchar()) != EOF) {
+                if (c != '\n') {
+                    line += (char)c;
+                    continue;
+                }
+                std::vector<uint8_t> buf;
+                for (size_t k = 0; k + 1 < line.size(); k += 2) {
+                    int hi = hexNibble(line[k]), lo = hexNibble(line[k + 1]);
+                    if (hi < 0 || lo < 0) break;
+                    buf.push_back((uint8_t)(hi << 4 | lo));
+                }
+                if (!buf.empty()) printCapture(buf.data(), buf.size(), "stdin");
+                line.clear();
+            }
+            continue;
+        }
+        FILE* f = fopen(argv[i], "rb");
+        if (!f) { perror(argv[i]); continue; }
+        std::vector<uint8_t> buf(CAPTURE_MAX_BYTES * 2);
+        size_t n = fread(buf.data(), 1, buf.size(), f);
+        fclose(f);
+        printCapture(buf.data(), n, argv[i]);
+    }
+    return 0;
+}
+
+// ---- Replay ------------------------------------------------------------
+
+struct Scenario {
+    const char* name;
+    int expectRule;    // -1 = must not trigger
+    double onsetS;     // Physical onset of the fault
+    void (*shape)(double t, double onset, float* v);
+};
+
+// Healthy rails: 7.8 V pack, 120 mA in, 5 V × 150 mA out
+static void nominal(float* v) {
+    v[PF_VIN] = 7.8f;
+    v[PF_IIN] = 0.12f;
+    v[PF_POUT] = 0.75f;
+    v[PF_EFF] = 80.0f;
+}
+
+static void steady(double, double, float* v) { nominal(v); }
+
+static void inrush(double t, double onset, float* v) {
+    nominal(v);
+    if (t >= onset && t < onset + 0.04) v[PF_IIN] = 0.8f; // 40 ms load switch inrush (near full scale)
+}
+
+static void brownout(double t, double onset, float* v) {
+    nominal(v);
+    // Slow sag at 0.4 V/s (below the slope rule) that crosses 6.4 V at onset
+    if (t >= onset - 3.5) v[PF_VIN] = (float)(7.8 - 0.4 * (t - onset + 3.5));
+}
+
+static void dropout(double t, double onset, float* v) {
+    nominal(v);
+    if (t >= onset && t < onset + 0.1) v[PF_VIN] = 7.3f; // 0.5 V dip in < 1 sample: slope only
+}
+
+static void overload(double t, double onset, float* v) {
+    nominal(v);
+    if (t >= onset) v[PF_POUT] = 3.8f;
+}
+
+static const Scenario SCENARIOS[] = {
+    {"steady",   -1, 10.0,  steady},
+    {"inrush",    0, 10.005, inrush},
+    {"brownout",  1, 10.0,  brownout},
+    {"dropout",   2, 10.011, dropout},
+    {"overload",  3, 10.013, overload},
+};
+
+static bool runScenario(const Scenario& sc, std::mt19937& rng) {
+    std::normal_distribution<float> noiseV(0.0f, 0.004f), noiseI(0.0f, 0.001f);
+    std::uniform_int_distribution<int> jitter(-500, 500);
+
+    std::vector<PowerSample> ring(PTRIG_PRE_SAMPLES);
+    std::vector<uint8_t> cap(CAPTURE_MAX_BYTES);
+    PowerTrigger trig;
+    trig.begin(ring.data(), cap.data(), CAPTURE_TO_MQTT);
+    trig.addDefaultRules();
+
+    std::vector<PowerSample> fed;
+    int64_t frozenAtUs = -1;
+    int64_t baseUs = 5000000; // Boot-relative like esp_timer
+    for (int k = 0; k < 20 * 1000000 / PERIOD_US; k++) {
+        PowerSample s;
+        s.tUs = baseUs + (int64_t)k * PERIOD_US + jitter(rng);
+        double t = (s.tUs - baseUs) * 1e-6;
+        sc.shape(t, sc.onsetS, s.v);
+        s.v[PF_VIN] += noiseV(rng);
+        s.v[PF_IIN] += noiseI(rng);
+        fed.push_back(s);
+        if (trig.feed(s, 1790000000u + (uint32_t)t) && frozenAtUs < 0) frozenAtUs = s.tUs;
+    }
+
+    PowerTriggerStats st = trig.getStats();
+    const uint8_t* data;
+    size_t len = trig.peek(CAPTURE_TO_MQTT, &data);
+    if (sc.expectRule < 0) {
+        bool ok = st.triggers == 0 && len == 0;
+        printf("%-9s %s: %lu triggers\n", sc.name, ok ? "PASS" : "FAIL", (unsigned long)st.triggers);
+        return ok;
+    }
+
+    CaptureHeader h;
+    const uint8_t* samples;
+    if (len == 0 || !parseCapture(data, len, h, &samples)) {
+        printf("%-9s FAIL: no capture (%lu triggers)\n", sc.name, (unsigned long)st.triggers);
+        return false;
+    }
+
+    // Latency: trigger sample time minus physical onset
+    double latencyMs = (h.triggerUs - baseUs) * 1e-3 - sc.onsetS * 1e3;
+
+    // Completeness: full pre/post windows, every fed sample present in
+    // order and bit-exact
+    size_t trigIdx = 0;
+    while (trigIdx < fed.size() && fed[trigIdx].tUs != h.triggerUs) trigIdx++;
+    bool complete = h.count == CAPTURE_MAX_SAMPLES && h.pre == PTRIG_PRE_SAMPLES && trigIdx < fed.size();
+    size_t mismatches = 0;
+    for (uint16_t i = 0; complete && i < h.count; i++) {
+        int32_t dt;
+        float v[PF_COUNT];
+        captureSample(samples, i, &dt, v);
+        const PowerSample& ref = fed[trigIdx - h.pre + i];
+        if (dt != (int32_t)(ref.tUs - h.triggerUs) || memcmp(v, ref.v, sizeof(v))) mismatches++;
+    }
+    double spanMs = complete ? (fed[trigIdx - h.pre + h.count - 1].tUs - fed[trigIdx - h.pre].tUs) * 1e-3 : 0;
+
+    bool ok = complete && mismatches == 0 && h.rule == sc.expectRule &&
+              latencyMs >= 0 && latencyMs <= PERIOD_US * 1.5e-3 && st.captures == 1;
+    printf("%-9s %s: rule %u (%s %s), latency %.1f ms, %u/%u samples (%u pre), span %.0f ms, "
+           "%zu mismatches, %lu suppressed, frozen %.0f ms after trigger\n",
+           sc.name, ok ? "PASS" : "FAIL", h.rule, PowerTrigger::fieldName(h.field), PowerTrigger::typeName(h.type),
+           latencyMs, h.count, (unsigned)CAPTURE_MAX_SAMPLES, h.pre, spanMs, mismatches,
+           (unsigned long)st.suppressed, (frozenAtUs - h.triggerUs) * 1e-3);
+    return ok;
+}
+
+// Faults 2 s apart: the second lands inside the first capture and the
+// holdoff; a third after the holdoff is suppressed while the first
+// capture is still held, then captured once it is released
+static bool runHoldoff() {
+    std::vector<PowerSample> ring(PTRIG_PRE_SAMPLES);
+    std::vector<uint8_t> cap(CAPTURE_MAX_BYTES);
+    PowerTrigger trig;
+    trig.begin(ring.data(), cap.data(), CAPTURE_TO_MQTT | CAPTURE_TO_SD);
+    trig.addDefaultRules();
+
+    const double faults[] = {5.0, 7.0, 20.0, 40.0};
+    int released = 0;
+    for (int k = 0; k < 60 * 1000000 / PERIOD_US; k++) {
+        PowerSample s;
+        s.tUs = (int64_t)k * PERIOD_US;
+        double t = s.tUs * 1e-6;
+        nominal(s.v);
+        for (double f : faults) {
+            if (t >= f && t < f + 0.03) s.v[PF_IIN] = 0.8f;
+        }
+        trig.feed(s, 0);
+        const uint8_t* data;
+        if (t >= 30.0 && !released && trig.peek(CAPTURE_TO_MQTT, &data)) {
+            trig.release(CAPTURE_TO_MQTT);
+            trig.release(CAPTURE_TO_SD);
+            released = 1;
+        }
+    }
+    PowerTriggerStats st = trig.getStats();
+    bool ok = st.triggers == 2 && st.captures == 2 && st.suppressed >= 2;
+    printf("%-9s %s: %lu triggers, %lu captures, %lu suppressed\n", "holdoff", ok ? "PASS" : "FAIL",
+           (unsigned long)st.triggers, (unsigned long)st.captures, (unsigned long)st.suppressed);
+    return ok;
+}
+
+static int replay() {
+    std::mt19937 rng(7);
+    int failures = 0;
+    for (const Scenario& sc : SCENARIOS) {
+        if (!runScenario(sc, rng)) failures++;
+    }
+    if (!runHoldoff()) failures++;
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && !strcmp(argv[1], "replay")) return replay();
+    if (argc > 2 && !strcmp(argv[1], "decode")) return decode(argc, argv);
+    fprintf(stderr, "usage: %s replay | decode FILE... | decode -\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,243 @@
+// Ground-side tool for GorillaCodec blocks (/datalog.gor on the SD card).
+//
+// Build (host):
+//   g++ -O2 -std=c++11 -I../.. gorilla_tool.cpp ../../GorillaCodec.cpp -o gorilla_tool
+//
+// Usage:
+//   ./gorilla_tool decode datalog.gor > datalog_decoded.csv
+//   ./gorilla_tool bench datalog.csv [block_bytes]    compress a recorded CSV log
+//   ./gorilla_tool bench --synthetic N [block_bytes]  random-walk trace of N samples
+
+#include "GorillaCodec.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+typedef std::vector<GorillaValue> Sample;
+
+static void printHeader() {
+    for (int c = 0; c < GS_COUNT; c++) {
+        printf("%s%s", c ? "," : "", GORILLA_SAMPLE_NAMES[c]);
+    }
+    printf("\n");
+}
+
+static void printSample(const GorillaValue* v, uint8_t channels, const uint8_t* types) {
+    for (uint8_t c = 0; c < channels; c++) {
+        if (c) printf(",");
+        if (types[c] == GORILLA_FLOAT) printf("%.6g", v[c].f);
+        else if (types[c] == GORILLA_COUNTER) printf("%u", v[c].u);
+        else printf("%d", v[c].i);
+    }
+    printf("\n");
+}
+
+static int decodeFile(const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (!in) { perror(path); return 1; }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(in);
+
+    printHeader();
+    size_t pos = 0, blocks = 0, samples = 0;
+    while (pos < data.size()) {
+        GorillaDecoder d;
+        if (!d.begin(data.data() + pos, data.size() - pos)) {
+            fprintf(stderr, "bad block at offset %zu, stopping\n", pos);
+            break;
+        }
+        uint8_t types[GORILLA_MAX_CHANNELS];
+        for (uint8_t c = 0; c < d.channelCount(); c++) types[c] = d.channelType(c);
+        GorillaValue v[GORILLA_MAX_CHANNELS];
+        while (d.next(v)) {
+            printSample(v, d.channelCount(), types);
+            samples++;
+        }
+        pos += d.blockBytes();
+        blocks++;
+    }
+    fprintf(stderr, "%zu blocks, %zu samples, %zu bytes\n", blocks, samples, data.size());
+    return 0;
+}
+
+// datalog.csv row → sample (column order of SD_LOG_HEADER)
+static bool parseCsvRow(const char* line, Sample& s, uint32_t& firstEpoch, size_t row) {
+    char ts[64], mode[16];
+    double vin, iin, pin, vout, iout, pout, eff, lat, lng, soc, adcSoc, logic[4];
+    int sats, adc[4];
+    int n = sscanf(line, "%63[^,],%15[^,],%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%d,%d,%d,%d,%d,%lf,%lf,%lf,%lf,%lf,%lf",
+                   ts, mode, &vin, &iin, &pin, &vout, &iout, &pout, &eff, &lat, &lng, &sats,
+                   &adc[0], &adc[1], &adc[2], &adc[3], &soc, &adcSoc, &logic[0], &logic[1], &logic[2], &logic[3]);
+    if (n != 22) return false;
+
+    uint32_t epoch = 0, uptime = 0;
+    if (!strncmp(ts, "ms_", 3)) {
+        uptime = (uint32_t)strtoul(ts + 3, nullptr, 10);
+    } else {
+        struct tm tm = {};
+        char day[16];
+        if (sscanf(ts, "%15s %d-%d-%d %d:%d:%d", day, &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                   &tm.tm_hour, &tm.tm_min, &tm.tm_sec) == 7) {
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            epoch = (uint32_t)timegm(&tm);
+            if (row == 0) firstEpoch = epoch;
+            uptime = (epoch - firstEpoch) * 1000;
+        } else {
+            uptime = (uint32_t)(row * 1000);
+        }
+    }
+
+    s.assign(GS_COUNT, GorillaValue());
+    s[GS_UPTIME].u = uptime;
+    s[GS_EPOCH].u = epoch;
+    s[GS_VIN].f = (float)vin;
+    s[GS_IIN].f = (float)iin;
+    s[GS_PIN].f = (float)pin;
+    s[GS_VOUT].f = (float)vout;
+    s[GS_IOUT].f = (float)iout;
+    s[GS_POUT].f = (float)pout;
+    s[GS_EFF].f = (float)eff;
+    s[GS_BATT_SOC].f = (float)soc;
+    s[GS_ADC_SOC].f = (float)adcSoc;
+    for (int i = 0; i < 4; i++) {
+        s[GS_LOGIC0 + i].f = (float)logic[i];
+        s[GS_ADC0 + i].i = adc[i];
+    }
+    s[GS_LAT].i = (int32_t)lround(lat * 1e7);
+    s[GS_LNG].i = (int32_t)lround(lng * 1e7);
+    s[GS_SATS].i = sats;
+    s[GS_FRESH].i = 0;
+    s[GS_MODE].i = strcmp(mode, "SENSOR") ? 1 : 0;
+    return true;
+}
+
+// INA226-like random walk with noise, 1 Hz
+static void synthesize(size_t n, std::vector<Sample>& out) {
+    srand(42);
+    double vin = 7.9, iin = 0.12, vout = 5.0, iout = 0.15, soc = 85.0, adc[4] = {2048, 1800, 1500, 900};
+    uint32_t epoch = 1790000000;
+    for (size_t i = 0; i < n; i++) {
+        vin += ((rand() % 21) - 10) * 0.0005;
+        iin += ((rand() % 21) - 10) * 0.00005;
+        iout += ((rand() % 21) - 10) * 0.00005;
+        soc -= 0.0005;
+        Sample s(GS_COUNT, GorillaValue());
+        s[GS_UPTIME].u = (uint32_t)(i * 1000 + (rand() % 3));
+        s[GS_EPOCH].u = epoch + (uint32_t)i;
+        s[GS_VIN].f = (float)vin;
+        s[GS_IIN].f = (float)iin;
+        s[GS_PIN].f = (float)(vin * iin);
+        s[GS_VOUT].f = (float)vout;
+        s[GS_IOUT].f = (float)iout;
+        s[GS_POUT].f = (float)(vout * iout);
+        s[GS_EFF].f = (float)(100.0 * vout * iout / (vin * iin));
+        s[GS_BATT_SOC].f = (float)soc;
+        s[GS_ADC_SOC].f = 64.5f;
+        for (int c = 0; c < 4; c++) {
+            adc[c] += ((rand() % 5) - 2) * 0.5;
+            s[GS_ADC0 + c].i = (int32_t)adc[c];
+            s[GS_LOGIC0 + c].f = (float)(adc[c] * 3.3 / 4095.0);
+        }
+        s[GS_LAT].i = 137291230 + (rand() % 5);
+        s[GS_LNG].i = 1007752340 + (rand() % 5);
+        s[GS_SATS].i = 9;
+        s[GS_FRESH].i = 0x0F;
+        out.push_back(s);
+    }
+}
+
+static int bench(int argc, char** argv) {
+    std::vector<Sample> trace;
+    size_t csvBytes = 0;
+    int argi = 2;
+    if (argc > 3 && !strcmp(argv[2], "--synthetic")) {
+        synthesize((size_t)atol(argv[3]), trace);
+        argi = 4;
+    } else if (argc > 2) {
+        FILE* in = fopen(argv[2], "r");
+        if (!in) { perror(argv[2]); return 1; }
+        char line[512];
+        uint32_t firstEpoch = 0;
+        Sample s;
+        while (fgets(line, sizeof(line), in)) {
+            if (parseCsvRow(line, s, firstEpoch, trace.size())) {
+                trace.push_back(s);
+                csvBytes += strlen(line);
+            }
+        }
+        fclose(in);
+        argi = 3;
+    } else {
+        fprintf(stderr, "bench needs a CSV file or --synthetic N\n");
+        return 2;
+    }
+    if (trace.empty()) {
+        fprintf(stderr, "no samples\n");
+        return 1;
+    }
+    size_t blockBytes = argc > argi ? (size_t)atol(argv[argi]) : 2048;
+
+    std::vector<uint8_t> out;
+    std::vector<uint8_t> block(blockBytes);
+    size_t blocks = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    GorillaEncoder e;
+    e.begin(block.data(), block.size(), GORILLA_SAMPLE_TYPES, GS_COUNT);
+    for (size_t i = 0; i < trace.size(); i++) {
+        if (!e.append(trace[i].data())) {
+            size_t len = e.finish();
+            out.insert(out.end(), block.begin(), block.begin() + len);
+            blocks++;
+            e.begin(block.data(), block.size(), GORILLA_SAMPLE_TYPES, GS_COUNT);
+            e.append(trace[i].data());
+        }
+    }
+    size_t len = e.finish();
+    out.insert(out.end(), block.begin(), block.begin() + len);
+    blocks++;
+    auto t1 = std::chrono::steady_clock::now();
+
+    size_t pos = 0, k = 0, mismatches = 0;
+    GorillaValue v[GORILLA_MAX_CHANNELS];
+    while (pos < out.size()) {
+        GorillaDecoder d;
+        if (!d.begin(out.data() + pos, out.size() - pos)) break;
+        while (d.next(v)) {
+            if (k < trace.size() && memcmp(v, trace[k].data(), sizeof(GorillaValue) * GS_COUNT)) mismatches++;
+            k++;
+        }
+        pos += d.blockBytes();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    size_t rawBytes = trace.size() * GS_COUNT * sizeof(GorillaValue);
+    double encS = std::chrono::duration<double>(t1 - t0).count();
+    double decS = std::chrono::duration<double>(t2 - t1).count();
+    printf("samples        %zu (%zu blocks of <= %zu B)\n", trace.size(), blocks, blockBytes);
+    if (csvBytes) printf("csv            %zu B (%.1f B/sample)\n", csvBytes, (double)csvBytes / trace.size());
+    printf("raw binary     %zu B (%zu B/sample)\n", rawBytes, GS_COUNT * sizeof(GorillaValue));
+    printf("gorilla        %zu B (%.1f B/sample)\n", out.size(), (double)out.size() / trace.size());
+    if (csvBytes) printf("ratio vs csv   %.1fx\n", (double)csvBytes / out.size());
+    printf("ratio vs raw   %.1fx\n", (double)rawBytes / out.size());
+    printf("encode         %.1f MB/s raw, %.0f ns/sample\n", rawBytes / encS / 1e6, encS * 1e9 / trace.size());
+    printf("decode         %.1f MB/s raw, %.0f ns/sample\n", rawBytes / decS / 1e6, decS * 1e9 / trace.size());
+    printf("round trip     %s (%zu/%zu samples, %zu mismatches)\n",
+           (k == trace.size() && mismatches == 0) ? "exact" : "FAILED", k, trace.size(), mismatches);
+    return (k == trace.size() && mismatches == 0) ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 2 && !strcmp(argv[1], "decode")) return decodeFile(argv[2]);
+    if (argc > 1 && !strcmp(argv[1], "bench")) return bench(argc, argv);
+    fprintf(stderr, "usage: %s decode FILE.gor | bench FILE.csv [block] | bench --synthetic N [block]\n", argv[0]);
+    return 2;
+}
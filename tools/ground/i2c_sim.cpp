@@ -0,0 +1,392 @@
+// Runs the firmware I2C bus manager (I2cBus) against a simulated bus with
+// injected faults: NACKs, a slave holding SDA low mid-byte, clock
+// stretching, SCL stuck low and a wedged controller.
+//
+// Build (host):
+//   g++ -O2 -std=c++11 -I../.. i2c_sim.cpp ../../I2cBus.cpp -o i2c_sim
+//
+// Usage:
+//   ./i2c_sim [load seconds]   fault scenarios, then the SensorTask load
+//                              (53 Hz power batches + RTC) with random
+//                              recoverable faults; exit 1 on failure
+
+#include "I2cBus.h"
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define INA_IN  0x41
+#define INA_OUT 0x51
+#define RTC     0x68
+#define SLOW    0x48 // A 100 kHz part, for the clock scenario
+
+struct SimDevice {
+    uint8_t addr;
+    uint32_t maxHz;
+    bool present;
+    int nackNext;       // NACK this many attempts
+    uint16_t regs[256];
+    uint8_t ptr;
+    uint32_t overspeed; // Transfers above maxHz
+};
+
+// Time is virtual: transfers, timeouts, pulses and delays advance `t`
+class SimPort : public I2cPort {
+public:
+    int64_t t = 0;
+    uint32_t clockHz = 100000;
+    uint16_t timeoutMs = 50;
+    bool attached = true;
+    bool wedged = false;        // Controller stuck, lines idle
+    int sdaHeldBits = 0;        // Slave holds SDA for this many more SCL clocks
+    int64_t sclLowUntil = 0;    // Slave stretches SCL until then
+    uint32_t pulses = 0;
+    std::vector<SimDevice> devices;
+
+    void add(uint8_t addr, uint32_t maxHz, bool present = true) {
+        SimDevice d;
+        memset(&d, 0, sizeof(d));
+        d.addr = addr;
+        d.maxHz = maxHz;
+        d.present = present;
+        for (int r = 0; r < 256; r++) d.regs[r] = (uint16_t)(addr << 8 | r);
+        devices.push_back(d);
+    }
+    SimDevice* find(uint8_t addr) {
+        for (SimDevice& d : devices) {
+            if (d.addr == addr && d.present) return &d;
+        }
+        return nullptr;
+    }
+    void bits(uint32_t n) { t += (int64_t)n * 1000000 / clockHz; }
+    int timeout() {
+        t += (int64_t)timeoutMs * 1000;
+        return I2C_ERR_TIMEOUT;
+    }
+
+    int transfer(uint8_t addr, const uint8_t* tx, uint8_t txLen, uint8_t* rx, uint8_t rxLen) override {
+        if (!attached) return I2C_ERR_BUS;
+        if (wedged || sdaHeldBits > 0) return timeout();
+        if (t < sclLowUntil) {
+            if (sclLowUntil - t > (int64_t)timeoutMs * 1000) return timeout();
+            t = sclLowUntil;
+        }
+        SimDevice* d = find(addr);
+        bits(10); // START + address + ACK
+        if (!d) return I2C_ERR_NACK_ADDR;
+        if (d->nackNext > 0) {
+            d->nackNext--;
+            return I2C_ERR_NACK_ADDR;
+        }
+        if (clockHz > d->maxHz) d->overspeed++;
+        bits(9 * txLen + 1);
+        if (txLen >= 1) d->ptr = tx[0];
+        if (txLen >= 3) d->regs[d->ptr] = (uint16_t)(tx[1] << 8 | tx[2]);
+        if (rxLen) {
+            bits(10 + 9 * rxLen); // Repeated START + address + data
+            for (uint8_t i = 0; i < rxLen; i++) {
+                uint16_t r = d->regs[(uint8_t)(d->ptr + i / 2)];
+                rx[i] = (i & 1) ? (uint8_t)r : (uint8_t)(r >> 8);
+            }
+        }
+        return I2C_OK;
+    }
+    void setClock(uint32_t hz) override { clockHz = hz; }
+    void setTimeout(uint16_t ms) override { timeoutMs = ms; }
+    bool scl() override { return t >= sclLowUntil; }
+    bool sda() override { return sdaHeldBits == 0; }
+    void release() override { attached = false; }
+    void pulse() override {
+        t += 10;
+        pulses++;
+        if (sdaHeldBits > 0) sdaHeldBits--;
+    }
+    void stop() override { t += 15; }
+    void attach() override {
+        attached = true;
+        wedged = false;
+        t += 50; // Driver re-init
+    }
+    int64_t nowUs() override { return t; }
+    void delayUs(uint32_t us) override { t += us; }
+};
+
+struct Rig {
+    SimPort port;
+    I2cBus bus;
+    int inaIn, inaOut, rtc, slow, ghost;
+
+    Rig() {
+        port.add(INA_IN, 400000);
+        port.add(INA_OUT, 400000);
+        port.add(RTC, 400000);
+        port.add(SLOW, 100000);
+        port.add(0x22, 400000, false); // Registered but never answers
+        bus.begin(&port);
+        inaIn = bus.addDevice(INA_IN, "ina_in", 400000, 2);
+        inaOut = bus.addDevice(INA_OUT, "ina_out", 400000, 2);
+        rtc = bus.addDevice(RTC, "rtc", 400000, 10);
+        slow = bus.addDevice(SLOW, "slow", 100000, 5);
+        ghost = bus.addDevice(0x22, "ghost", 400000, 2);
+    }
+    void drain() {
+        while (bus.process()) {
+        }
+    }
+    // One transaction, run to completion
+    int one(int dev, uint8_t reg = 0x02) {
+        I2cTxn t;
+        t.readReg((uint8_t)dev, I2C_PRIO_HIGH, reg, 2);
+        bus.submit(&t);
+        drain();
+        return t.result;
+    }
+};
+
+static bool report(const char* name, bool ok, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static bool report(const char* name, bool ok, const char* fmt, ...) {
+    printf("%-13s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    return ok;
+}
+
+// ---- Scenarios -----------------------------------------------------------
+
+static std::vector<int> order;
+static void record(I2cTxn* t) { order.push_back((int)(intptr_t)t->user); }
+
+static bool rtcCallOk(void* arg) {
+    SimPort* p = (SimPort*)arg;
+    uint8_t reg = 0, rx[7];
+    return p->transfer(RTC, &reg, 1, rx, 7) == I2C_OK;
+}
+
+static bool scenarioPriority() {
+    Rig r;
+    order.clear();
+    I2cTxn low[2], normal, high[3];
+    for (int i = 0; i < 2; i++) low[i].invoke((uint8_t)r.rtc, I2C_PRIO_LOW, rtcCallOk, &r.port);
+    normal.readReg((uint8_t)r.inaOut, I2C_PRIO_NORMAL, 0x04, 2);
+    high[0].readReg((uint8_t)r.inaIn, I2C_PRIO_HIGH, 0x02, 2);
+    high[1].readReg((uint8_t)r.inaIn, I2C_PRIO_HIGH, 0x04, 2);
+    high[2].readReg((uint8_t)r.inaOut, I2C_PRIO_HIGH, 0x02, 2);
+    I2cTxn* all[] = {&low[0], &low[1], &normal, &high[0], &high[1], &high[2]};
+    const int ids[] = {5, 6, 4, 1, 2, 3};
+    for (int i = 0; i < 6; i++) {
+        all[i]->done = record;
+        all[i]->user = (void*)(intptr_t)ids[i];
+    }
+    r.bus.submit(low, 2);
+    r.bus.submit(&normal);
+    r.bus.submit(high, 2); // Batch
+    r.bus.process();       // Runs high[0]
+    r.bus.submit(&high[2]); // Arrives late, still ahead of normal and low
+    r.drain();
+
+    bool inOrder = order.size() == 6;
+    char got[32] = "";
+    for (size_t i = 0; i < order.size(); i++) {
+        snprintf(got + strlen(got), sizeof(got) - strlen(got), "%d", order[i]);
+        if (order[i] != (int)i + 1) inOrder = false;
+    }
+    bool data = high[1].rx[0] == INA_IN && high[1].rx[1] == 0x04 && normal.rx[0] == INA_OUT;
+    bool results = true;
+    for (I2cTxn* t : all) results = results && t->result == I2C_OK;
+    return report("priority", inOrder && data && results, "completion order %s (want 123456), data %s, results %s",
+                  got, data ? "ok" : "wrong", results ? "ok" : "failed");
+}
+
+static bool scenarioClock() {
+    Rig r;
+    int64_t fastUs = 0, slowUs = 0;
+    for (int i = 0; i < 10; i++) {
+        int dev = (i & 1) ? r.slow : r.inaIn;
+        int64_t t0 = r.port.t;
+        r.one(dev);
+        ((i & 1) ? slowUs : fastUs) += r.port.t - t0;
+    }
+    SimDevice* slow = r.port.find(SLOW);
+    SimDevice* fast = r.port.find(INA_IN);
+    I2cBusStats s = r.bus.getStats();
+    bool ok = slow->overspeed == 0 && fast->overspeed == 0 && s.clockSwitches == 9;
+    return report("clock", ok, "%lu clock switches, overspeed %lu/%lu, read %.0f us at 400 kHz vs %.0f us at 100 kHz",
+                  (unsigned long)s.clockSwitches, (unsigned long)fast->overspeed, (unsigned long)slow->overspeed,
+                  fastUs / 5.0, slowUs / 5.0);
+}
+
+static bool scenarioNack() {
+    Rig r;
+    r.port.find(INA_IN)->nackNext = 1;
+    int first = r.one(r.inaIn);
+    int ghost = r.one(r.ghost);
+    I2cDeviceStats in = r.bus.getDeviceStats(r.inaIn);
+    I2cDeviceStats gh = r.bus.getDeviceStats(r.ghost);
+    I2cBusStats b = r.bus.getStats();
+    bool ok = first == I2C_OK && in.retries == 1 && in.nacks == 1 && in.errors == 0 &&
+              ghost == I2C_ERR_NACK_ADDR && gh.nacks == 1 + I2C_RETRIES && gh.errors == 1 &&
+              b.resets == 0 && b.recoveries == 0;
+    return report("nack", ok, "retried NACK -> %s, absent device -> %s after %lu attempts, %lu recoveries",
+                  I2cBus::resultName(first), I2cBus::resultName(ghost), (unsigned long)gh.nacks,
+                  (unsigned long)(b.resets + b.recoveries));
+}
+
+static bool scenarioStuckSda() {
+    Rig r;
+    r.port.sdaHeldBits = 5; // Slave reset by a brown-out mid-byte
+    int res = r.one(r.inaIn);
+    I2cBusStats b = r.bus.getStats();
+    I2cDeviceStats s = r.bus.getDeviceStats(r.inaIn);
+    bool ok = res == I2C_OK && b.recoveries == 1 && b.recoveryPulses == 5 && s.timeouts == 1 && s.retries == 1;
+    return report("stuck-sda", ok, "%s after %lu pulses, bus time %.2f ms", I2cBus::resultName(res),
+                  (unsigned long)b.recoveryPulses, s.busMaxUs * 1e-3);
+}
+
+static bool scenarioStuckSdaLong() {
+    Rig r;
+    r.port.sdaHeldBits = I2C_RECOVERY_PULSES + 3;
+    int first = r.one(r.inaIn);
+    // Within the backoff: fail without touching the bus
+    int64_t t0 = r.port.t;
+    int shedResult = I2C_OK;
+    for (int i = 0; i < 50; i++) shedResult = r.one(r.inaIn);
+    int64_t shedUs = r.port.t - t0;
+    // After it: the probe clocks out the remaining bits
+    r.port.t += I2C_STUCK_BACKOFF_US;
+    int after = r.one(r.inaIn);
+    I2cBusStats b = r.bus.getStats();
+    bool ok = first != I2C_OK && shedResult == I2C_ERR_BUS && b.shed == 50 && shedUs == 0 &&
+              b.recoveryFailures == 1 && b.recoveries == 1 && after == I2C_OK;
+    return report("stuck-sda-12", ok, "first %s, %lu shed in %lld us, after backoff %s (%lu pulses total)",
+                  I2cBus::resultName(first), (unsigned long)b.shed, (long long)shedUs, I2cBus::resultName(after),
+                  (unsigned long)b.recoveryPulses);
+}
+
+static bool scenarioStretch() {
+    Rig r;
+    r.port.sclLowUntil = r.port.t + 1000; // Within the 2 ms device timeout
+    int shortRes = r.one(r.inaIn);
+    I2cDeviceStats s1 = r.bus.getDeviceStats(r.inaIn);
+    r.port.sclLowUntil = r.port.t + 8000; // Past it
+    int longRes = r.one(r.inaIn);
+    I2cDeviceStats s2 = r.bus.getDeviceStats(r.inaIn);
+    I2cBusStats b = r.bus.getStats();
+    bool ok = shortRes == I2C_OK && s1.timeouts == 0 && longRes == I2C_OK && s2.timeouts == 1 &&
+              b.sclStuck == 0 && b.resets == 1;
+    return report("stretch", ok, "1 ms stretch %s (%.2f ms), 8 ms stretch %s after waiting for SCL (%.2f ms)",
+                  I2cBus::resultName(shortRes), s1.busMaxUs * 1e-3, I2cBus::resultName(longRes),
+                  (s2.busSumUs - s1.busSumUs) * 1e-3);
+}
+
+static bool scenarioSclStuck() {
+    Rig r;
+    r.port.sclLowUntil = INT64_MAX;
+    int res = r.one(r.inaIn);
+    int64_t t0 = r.port.t;
+    for (int i = 0; i < 50; i++) r.one(r.inaIn);
+    int64_t shedUs = r.port.t - t0;
+    I2cBusStats b = r.bus.getStats();
+    I2cDeviceStats s = r.bus.getDeviceStats(r.inaIn);
+    bool ok = res != I2C_OK && b.sclStuck == 1 && b.shed == 50 && shedUs == 0;
+    return report("scl-stuck", ok, "%s after %.1f ms, then %lu shed in %lld us", I2cBus::resultName(res),
+                  s.busMaxUs * 1e-3, (unsigned long)b.shed, (long long)shedUs);
+}
+
+static bool scenarioWedged() {
+    Rig r;
+    r.port.wedged = true;
+    int res = r.one(r.rtc);
+    I2cBusStats b = r.bus.getStats();
+    bool ok = res == I2C_OK && b.resets == 1 && r.port.pulses == 0;
+    return report("wedged", ok, "%s after a controller reset, %lu pulses", I2cBus::resultName(res),
+                  (unsigned long)r.port.pulses);
+}
+
+// SensorTask's pattern: a 5-transaction power batch per INA226 conversion
+// (18.8 ms), an RTC read per minute, and random recoverable faults
+static bool scenarioLoad(int seconds) {
+    Rig r;
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> fault(0, 999);
+    std::uniform_int_distribution<int> sdaBits(1, 8);
+    uint32_t batches = 0, failedBatches = 0, faults = 0;
+    const int64_t period = 18800;
+    for (int64_t next = 0; next < (int64_t)seconds * 1000000; next += period) {
+        if (r.port.t < next) r.port.t = next;
+        // ~1 fault per second across the types
+        switch (fault(rng) / 10) {
+            case 0: r.port.find(INA_OUT)->nackNext = 1; faults++; break;
+            case 1: r.port.sdaHeldBits = sdaBits(rng); faults++; break;
+            case 2: r.port.sclLowUntil = r.port.t + 500 + fault(rng) * 10; faults++; break;
+            case 3: r.port.wedged = true; faults++; break;
+            default: break;
+        }
+        I2cTxn batch[5];
+        batch[0].readReg((uint8_t)r.inaIn, I2C_PRIO_HIGH, 0x06, 2);
+        batch[1].readReg((uint8_t)r.inaIn, I2C_PRIO_HIGH, 0x02, 2);
+        batch[2].readReg((uint8_t)r.inaIn, I2C_PRIO_HIGH, 0x04, 2);
+        batch[3].readReg((uint8_t)r.inaOut, I2C_PRIO_HIGH, 0x02, 2);
+        batch[4].readReg((uint8_t)r.inaOut, I2C_PRIO_HIGH, 0x04, 2);
+        I2cTxn rtc;
+        bool rtcDue = (next / 1000000) % 60 == 0 && next % 1000000 < period;
+        if (rtcDue) {
+            rtc.invoke((uint8_t)r.rtc, I2C_PRIO_LOW, rtcCallOk, &r.port);
+            r.bus.submit(&rtc);
+        }
+        r.bus.submit(batch, 5);
+        r.drain();
+        batches++;
+        for (I2cTxn& t : batch) {
+            if (t.result != I2C_OK) {
+                failedBatches++;
+                break;
+            }
+        }
+    }
+
+    printf("\n%-8s %7s %6s %7s %6s %9s %9s %9s\n", "device", "txns", "failed", "retries", "tmout", "mean us", "max us",
+           "bus us");
+    for (int i = 0; i < r.bus.getDeviceCount(); i++) {
+        I2cDeviceStats s = r.bus.getDeviceStats(i);
+        if (!s.txns) continue;
+        printf("%-8s %7lu %6lu %7lu %6lu %9.1f %9lu %9.1f\n", r.bus.getDevice(i).name, (unsigned long)s.txns,
+               (unsigned long)s.errors, (unsigned long)s.retries, (unsigned long)s.timeouts,
+               (double)s.latencySumUs / s.txns, (unsigned long)s.latencyMaxUs, (double)s.busSumUs / s.txns);
+    }
+    I2cBusStats b = r.bus.getStats();
+    printf("bus: %lu resets, %lu recoveries (%lu pulses), %lu failed, %lu scl stuck, %lu shed, queue max %lu\n\n",
+           (unsigned long)b.resets, (unsigned long)b.recoveries, (unsigned long)b.recoveryPulses,
+           (unsigned long)b.recoveryFailures, (unsigned long)b.sclStuck, (unsigned long)b.shed,
+           (unsigned long)b.queueMax);
+
+    bool ok = failedBatches == 0 && b.recoveryFailures == 0 && r.port.find(INA_IN)->overspeed == 0;
+    return report("load", ok, "%ds, %lu power batches, %lu injected faults, %lu batches failed", seconds,
+                  (unsigned long)batches, (unsigned long)faults, (unsigned long)failedBatches);
+}
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 600;
+    if (seconds <= 0) {
+        fprintf(stderr, "usage: %s [load seconds]\n", argv[0]);
+        return 2;
+    }
+    int failures = 0;
+    failures += !scenarioPriority();
+    failures += !scenarioClock();
+    failures += !scenarioNack();
+    failures += !scenarioStuckSda();
+    failures += !scenarioStuckSdaLong();
+    failures += !scenarioStretch();
+    failures += !scenarioSclStuck();
+    failures += !scenarioWedged();
+    failures += !scenarioLoad(seconds);
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+// Ground-side decoder for cubesat/telemetry/bin messages (batches of
+// frames, or single frames), and for the COBS-framed binary serial output
+// (SERIAL_FORMAT_BINARY).
+//
+// Build (host):
+//   g++ -O2 -std=c++11 -I../.. telemetry_decode.cpp ../../TelemetryFrame.cpp ../../SerialFrame.cpp -o telemetry_decode
+//
+// Usage:
+//   mosquitto_sub -h broker.hivemq.com -t cubesat/telemetry/bin -F %x | ./telemetry_decode
+//   ./telemetry_decode --json < frames.hex
+//   ./telemetry_decode --raw capture.bin       concatenated v1 frames
+//   stty -F /dev/ttyACM0 115200 raw && ./telemetry_decode --serial /dev/ttyACM0
+//   ./telemetry_decode --serial log.bin        serial capture; log text goes to stderr
+//   ./telemetry_decode --bench [N]             encode/decode timing
+
+#include "TelemetryFrame.h"
+#include "SerialFrame.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static void printCsvHeader() {
+    printf("seq,epoch,uptime_ms,mode,wifi,mqtt,fresh,vin,iin,pin,vout,iout,pout,eff,lat,lng,satellites,"
+           "batt_soc,adc_soc,logic0,logic1,logic2,logic3,adc0,adc1,adc2,adc3,"
+           "vin_min,vin_max,iin_min,iin_max,power_reads\n");
+}
+
+static void printCsv(const TelemetryFrame& f) {
+    printf("%u,%u,%u,%u,%d,%d,0x%02x,%.3f,%.6f,%.6f,%.3f,%.6f,%.6f,%.2f,%.7f,%.7f,%u,%.2f,%.2f,"
+           "%.2f,%.2f,%.2f,%.2f,%d,%d,%d,%d,%.3f,%.3f,%.6f,%.6f,%u\n",
+           f.seq, f.epoch, f.uptimeMs, f.mode,
+           (f.flags & TELEMETRY_FLAG_WIFI) != 0, (f.flags & TELEMETRY_FLAG_MQTT) != 0, f.fresh,
+           f.vin, f.iin, f.pin, f.vout, f.iout, f.pout, f.efficiency, f.lat, f.lng, f.satellites,
+           f.battSoC, f.adcSoC, f.logicLevels[0], f.logicLevels[1], f.logicLevels[2], f.logicLevels[3],
+           f.adcValues[0], f.adcValues[1], f.adcValues[2], f.adcValues[3],
+           f.vinMin, f.vinMax, f.iinMin, f.iinMax, f.powerReads);
+}
+
+static void printJson(const TelemetryFrame& f) {
+    printf("{\"seq\":%u,\"epoch\":%u,\"uptime_ms\":%u,\"mode\":%u,\"wifi_connected\":%s,\"mqtt_connected\":%s,"
+           "\"fresh\":%u,\"vin\":%.3f,\"iin\":%.6f,\"pin\":%.6f,\"vout\":%.3f,\"iout\":%.6f,\"pout\":%.6f,"
+           "\"eff\":%.2f,\"lat\":%.7f,\"lng\":%.7f,\"satellites\":%u,\"batt_soc\":%.2f,\"adc_soc\":%.2f,"
+           "\"logic\":[%.2f,%.2f,%.2f,%.2f],\"adc\":[%d,%d,%d,%d],"
+           "\"vin_min\":%.3f,\"vin_max\":%.3f,\"iin_min\":%.6f,\"iin_max\":%.6f,\"power_reads\":%u}\n",
+           f.seq, f.epoch, f.uptimeMs, f.mode,
+           (f.flags & TELEMETRY_FLAG_WIFI) ? "true" : "false", (f.flags & TELEMETRY_FLAG_MQTT) ? "true" : "false",
+           f.fresh, f.vin, f.iin, f.pin, f.vout, f.iout, f.pout, f.efficiency, f.lat, f.lng, f.satellites,
+           f.battSoC, f.adcSoC, f.logicLevels[0], f.logicLevels[1], f.logicLevels[2], f.logicLevels[3],
+           f.adcValues[0], f.adcValues[1], f.adcValues[2], f.adcValues[3],
+           f.vinMin, f.vinMax, f.iinMin, f.iinMax, f.powerReads);
+}
+
+static bool parseHex(const char* line, std::vector<uint8_t>& out) {
+    out.clear();
+    int hi = -1;
+    for (const char* p = line; *p; p++) {
+        int v;
+        if (*p >= '0' && *p <= '9') v = *p - '0';
+        else if (*p >= 'a' && *p <= 'f') v = *p - 'a' + 10;
+        else if (*p >= 'A' && *p <= 'F') v = *p - 'A' + 10;
+        else if (*p == ' ' || *p == '\r' || *p == '\n' || *p == '\t') continue;
+        else return false;
+        if (hi < 0) {
+            hi = v;
+        } else {
+            out.push_back((uint8_t)(hi << 4 | v));
+            hi = -1;
+        }
+    }
+    return hi < 0 && !out.empty();
+}
+
+struct Decoder {
+    bool json;
+    uint32_t lastSeq;
+    unsigned long frames, errors, gaps;
+
+    // One MQTT payload: a batch container or a bare frame
+    void message(const uint8_t* data, size_t len) {
+        const uint8_t* frames;
+        uint8_t count, frameSize;
+        if (len > 0 && data[0] == TELEMETRY_BATCH_MAGIC) {
+            if (!parseTelemetryBatch(data, len, &frames, &count, &frameSize)) {
+                fprintf(stderr, "message: bad batch header\n");
+                errors++;
+                return;
+            }
+            for (uint8_t i = 0; i < count; i++) {
+                handle(frames + (size_t)i * frameSize, frameSize);
+            }
+            return;
+        }
+        handle(data, len);
+    }
+
+    void handle(const uint8_t* data, size_t len) {
+        TelemetryFrame f;
+        TelemetryFrameStatus st = decodeTelemetryFrame(data, len, f);
+        if (st != FRAME_OK) {
+            fprintf(stderr, "frame %lu: %s\n", frames + errors, telemetryFrameStatusName(st));
+            errors++;
+            return;
+        }
+        if (frames > 0 && f.seq > lastSeq + 1) {
+            gaps += f.seq - lastSeq - 1;
+        }
+        lastSeq = f.seq;
+        frames++;
+        if (json) printJson(f);
+        else printCsv(f);
+    }
+};
+
+static bool printable(const uint8_t* p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if ((p[i] < 0x20 || p[i] > 0x7E) && p[i] != '\r' && p[i] != '\n' && p[i] != '\t') return false;
+    }
+    return true;
+}
+
+// Raw serial stream: COBS frames between 0x00 delimiters, with the
+// firmware's log lines in between
+static void readSerial(FILE* in, Decoder& dec) {
+    SerialFrameReader reader;
+    uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD];
+    int c;
+    while ((c = fgetc(in)) != EOF) {
+        if (!reader.feed((uint8_t)c)) continue;
+        const uint8_t* p = reader.packet();
+        size_t len = reader.length();
+        size_t n = cobsDecode(p, len, payload);
+        if (n && payload[0] == TELEMETRY_FRAME_MAGIC) {
+            dec.handle(payload, n);
+        } else if (printable(p, len)) {
+            fwrite(p, 1, len, stderr);
+        } else {
+            fprintf(stderr, "serial: %zu undecodable bytes\n", len);
+            dec.errors++;
+        }
+        fflush(stdout);
+    }
+    if (reader.getOverruns()) {
+        fprintf(stderr, "serial: %lu blocks over %d bytes skipped (log text)\n",
+                reader.getOverruns(), SERIAL_FRAME_MAX_PAYLOAD + 1);
+    }
+}
+
+static int bench(long n) {
+    TelemetryFrame f = {};
+    f.lat = 13.729123; f.lng = 100.775234; f.epoch = 1790000000; f.uptimeMs = 123456789;
+    f.vin = 7.912f; f.iin = 0.123456f; f.pin = 0.976543f;
+    f.vinMin = 7.85f; f.vinMax = 7.95f; f.iinMin = 0.12f; f.iinMax = 0.31f; f.powerReads = 53;
+    f.vout = 5.012f; f.iout = 0.150123f; f.pout = 0.752345f;
+    f.efficiency = 77.04f; f.battSoC = 81.23f; f.adcSoC = 64.5f; f.satellites = 9;
+    for (int i = 0; i < 4; i++) { f.logicLevels[i] = 1.65f; f.adcValues[i] = 2048; }
+
+    uint8_t buf[TELEMETRY_FRAME_SIZE];
+    TelemetryFrame out;
+    volatile uint32_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+        f.seq = (uint32_t)i;
+        sink += (uint32_t)encodeTelemetryFrame(buf, sizeof(buf), f);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+        buf[2] = (uint8_t)i; // Defeat hoisting; CRC then fails, which is still a full pass
+        sink += decodeTelemetryFrame(buf, sizeof(buf), out);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    encodeTelemetryFrame(buf, sizeof(buf), f);
+    if (decodeTelemetryFrame(buf, sizeof(buf), out) != FRAME_OK) {
+        fprintf(stderr, "round trip failed\n");
+        return 1;
+    }
+
+    double enc = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double dec = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    uint8_t serial[SERIAL_FRAME_SIZE(TELEMETRY_FRAME_SIZE)];
+    uint8_t back[TELEMETRY_FRAME_SIZE];
+    size_t serialLen = encodeSerialFrame(serial, sizeof(serial), buf, sizeof(buf));
+    if (!serialLen || cobsDecode(serial + 1, serialLen - 2, back) != sizeof(back) ||
+        memcmp(back, buf, sizeof(back)) != 0) {
+        fprintf(stderr, "serial round trip failed\n");
+        return 1;
+    }
+
+    // A v1 frame is the v2 prefix with its own CRC; it decodes with the
+    // extremes set to vin/iin
+    uint8_t v1[TELEMETRY_FRAME_SIZE_V1];
+    memcpy(v1, buf, TELEMETRY_FRAME_SIZE_V1 - 2);
+    v1[1] = 1;
+    uint16_t crc = telemetryFrameCrc(v1, TELEMETRY_FRAME_SIZE_V1 - 2);
+    v1[TELEMETRY_FRAME_SIZE_V1 - 2] = crc & 0xFF;
+    v1[TELEMETRY_FRAME_SIZE_V1 - 1] = crc >> 8;
+    TelemetryFrame old;
+    if (decodeTelemetryFrame(v1, sizeof(v1), old) != FRAME_OK || old.version != 1 ||
+        old.vin != out.vin || old.vinMax != old.vin || old.iinMin != old.iin || old.powerReads != 0) {
+        fprintf(stderr, "v1 decode failed\n");
+        return 1;
+    }
+
+    printf("frame size   %d bytes (v%d), %zu on serial\n", TELEMETRY_FRAME_SIZE, TELEMETRY_FRAME_VERSION, serialLen);
+    printf("encode       %.1f ns/frame\n", enc);
+    printf("decode+crc   %.1f ns/frame\n", dec);
+    printf("round trip   vin %.3f iin %.6f (max %.6f) lat %.7f soc %.2f\n", out.vin, out.iin, out.iinMax,
+           out.lat, out.battSoC);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Decoder dec = {false, 0, 0, 0, 0};
+    const char* rawPath = nullptr;
+    const char* serialPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            dec.json = true;
+        } else if (!strcmp(argv[i], "--raw") && i + 1 < argc) {
+            rawPath = argv[++i];
+        } else if (!strcmp(argv[i], "--serial") && i + 1 < argc) {
+            serialPath = argv[++i];
+        } else if (!strcmp(argv[i], "--bench")) {
+            return bench(i + 1 < argc ? atol(argv[i + 1]) : 1000000);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--raw FILE] [--serial FILE|-] [--bench [N]]  (hex frames on stdin)\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!dec.json) printCsvHeader();
+
+    if (serialPath) {
+        FILE* in = strcmp(serialPath, "-") ? fopen(serialPath, "rb") : stdin;
+        if (!in) { perror(serialPath); return 1; }
+        readSerial(in, dec);
+        if (in != stdin) fclose(in);
+    } else if (rawPath) {
+        FILE* in = fopen(rawPath, "rb");
+        if (!in) { perror(rawPath); return 1; }
+        // Frame size follows the version byte, so v1 and v2 files both read
+        uint8_t frame[TELEMETRY_FRAME_SIZE];
+        while (fread(frame, 1, 2, in) == 2) {
+            size_t size = frame[1] >= 2 ? TELEMETRY_FRAME_SIZE : TELEMETRY_FRAME_SIZE_V1;
+            if (fread(frame + 2, 1, size - 2, in) != size - 2) break;
+            dec.handle(frame, size);
+        }
+        fclose(in);
+    } else {
+        char line[1024];
+        std::vector<uint8_t> frame;
+        while (fgets(line, sizeof(line), stdin)) {
+            if (!parseHex(line, frame)) {
+                if (line[0] != '\n') dec.errors++;
+                continue;
+            }
+            dec.message(frame.data(), frame.size());
+        }
+    }
+
+    fprintf(stderr, "%lu frames, %lu errors, %lu missing seq\n", dec.frames, dec.errors, dec.gaps);
+    return dec.errors ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+// Checks TelemetryBacklog's SD spill off-target, built with
+// BACKLOG_SPILL_SD 1 on the host SD shim: order and content through RAM
+// and spill, appends while the spill is being replayed, file handles and
+// read batching, and that a short or corrupt spill file and discard()
+// are counted in `dropped`.
+//
+// Build (host):
+//   make -C tools/host
+//
+// Usage:
+//   ./build/backlog_test     exit 1 on failure
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "SD_MMC.h"
+#include "TelemetryBacklog.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+static const size_t ENTRY = 83; // A TelemetryFrame
+static const size_t RECORD = 6 + ENTRY;
+static std::string spillPath;
+
+// Payload derived from the sequence number, so every copy can be checked
+static void entryFor(uint32_t seq, char* out) {
+    for (size_t i = 0; i < ENTRY; i++) out[i] = (char)(seq * 31 + i * 7);
+}
+
+// Consumer side: sequence numbers must rise, payloads must match
+struct Reader {
+    uint32_t delivered = 0, lastSeq = 0, bad = 0;
+
+    bool next(TelemetryBacklog& b) {
+        char buf[ENTRY], want[ENTRY];
+        uint32_t seq;
+        size_t len = b.peek(buf, sizeof(buf), &seq);
+        if (len == 0) return !b.empty(); // Entry dropped; keep going if more remain
+        entryFor(seq, want);
+        if (len != ENTRY || memcmp(buf, want, ENTRY) != 0 || seq <= lastSeq) bad++;
+        lastSeq = seq;
+        delivered++;
+        b.pop();
+        return true;
+    }
+};
+
+// Overwrites `n` bytes at `off` in the spill file, or truncates it there
+static void damageSpill(long off, size_t n, bool truncate) {
+    if (truncate) {
+        if (::truncate(spillPath.c_str(), off) != 0) perror("truncate");
+        return;
+    }
+    FILE* f = fopen(spillPath.c_str(), "r+b");
+    if (!f) return;
+    fseek(f, off, SEEK_SET);
+    for (size_t i = 0; i < n; i++) fputc(0xFF, f);
+    fclose(f);
+}
+
+// Fills the RAM ring and spills ~`total` - capacity entries, reads the
+// first one, damages the file further in and drains the rest
+static void damaged(const char* name, bool truncate) {
+    TelemetryBacklog b;
+    b.begin();
+    const uint32_t total = 20000;
+    char e[ENTRY];
+    for (uint32_t s = 1; s <= total; s++) {
+        entryFor(s, e);
+        b.push(s, e, ENTRY);
+    }
+    uint32_t spilled = b.getStats().spilled;
+    Reader r;
+    r.next(b); // Flushes the append handle, so the damage lands on disk
+    damageSpill(1000 * RECORD + (truncate ? 3 : 0), 2, truncate);
+    while (r.next(b)) {}
+    BacklogStats s = b.getStats();
+    check(r.bad == 0 && s.dropped > 0 && s.drained + s.dropped == total && s.spilled == 0 &&
+              !SD_MMC.exists(BACKLOG_SPILL_FILE),
+          name, "%lu spilled; %lu delivered in order, %lu counted as dropped, spill file removed",
+          (unsigned long)spilled, (unsigned long)s.drained, (unsigned long)s.dropped);
+}
+
+int main() {
+    char dir[] = "/tmp/backlog_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    sim::mountSd(dir);
+    SD_MMC.begin();
+    spillPath = std::string(dir) + BACKLOG_SPILL_FILE;
+    char e[ENTRY];
+
+    // Round trip: 30 000 entries, ~18 000 of them through the spill file
+    {
+        TelemetryBacklog b;
+        check(b.begin(), "begin", "PSRAM ring allocated");
+        const uint32_t total = 30000;
+        sim::SdCounters c0 = sim::sdCounters();
+        for (uint32_t s = 1; s <= total; s++) {
+            entryFor(s, e);
+            b.push(s, e, ENTRY);
+        }
+        BacklogStats s = b.getStats();
+        uint32_t spilled = s.spilled;
+        Reader r;
+        while (r.next(b)) {}
+        sim::SdCounters c1 = sim::sdCounters();
+        s = b.getStats();
+        check(spilled > 10000 && r.bad == 0 && r.delivered == total && s.drained == total && s.dropped == 0 &&
+                  !SD_MMC.exists(BACKLOG_SPILL_FILE),
+              "round trip", "%lu entries, %lu via SD: all delivered in order, none dropped, spill file removed",
+              (unsigned long)total, (unsigned long)spilled);
+        uint64_t maxReads = (uint64_t)spilled * RECORD / (BACKLOG_SPILL_READ_BYTES - RECORD) + 1;
+        check(c1.opens - c0.opens == 2 && c1.writes - c0.writes == spilled && c1.reads - c0.reads <= maxReads,
+              "sd access", "%llu opens, %llu writes, %llu reads (%.0f entries per read) for %lu spilled entries",
+              (unsigned long long)(c1.opens - c0.opens), (unsigned long long)(c1.writes - c0.writes),
+              (unsigned long long)(c1.reads - c0.reads), (double)spilled / (c1.reads - c0.reads),
+              (unsigned long)spilled);
+    }
+
+    // Replay while the full ring keeps spilling: 3 entries out per 2 in
+    {
+        TelemetryBacklog b;
+        b.begin();
+        uint32_t seq = 0;
+        for (; seq < 20000;) {
+            entryFor(++seq, e);
+            b.push(seq, e, ENTRY);
+        }
+        Reader r;
+        uint32_t peakSpill = 0;
+        while (seq < 40000) {
+            for (int i = 0; i < 2; i++) {
+                entryFor(++seq, e);
+                b.push(seq, e, ENTRY);
+            }
+            for (int i = 0; i < 3; i++) r.next(b);
+            if (b.getStats().spilled > peakSpill) peakSpill = b.getStats().spilled;
+        }
+        while (r.next(b)) {}
+        BacklogStats s = b.getStats();
+        check(r.bad == 0 && r.delivered == seq && s.dropped == 0 && s.spilled == 0, "interleaved",
+              "%lu entries pushed while replaying (spill peak %lu): all delivered in order, none dropped",
+              (unsigned long)seq, (unsigned long)peakSpill);
+    }
+
+    damaged("short spill", true);
+    damaged("corrupt spill", false);
+
+    // An entry the caller cannot use is discarded and counted
+    {
+        TelemetryBacklog b;
+        b.begin();
+        entryFor(1, e);
+        b.push(1, e, 10);
+        entryFor(2, e);
+        b.push(2, e, ENTRY);
+        char buf[ENTRY];
+        uint32_t seq;
+        size_t len = b.peek(buf, sizeof(buf), &seq);
+        if (len != ENTRY) b.discard();
+        len = b.peek(buf, sizeof(buf), &seq);
+        b.pop();
+        BacklogStats s = b.getStats();
+        check(len == ENTRY && seq == 2 && s.dropped == 1 && s.drained == 1 && b.empty(), "discard",
+              "a 10-byte entry is discarded and counted as dropped; the next frame follows");
+    }
+
+    unlink(spillPath.c_str());
+    rmdir(dir);
+    printf("\n%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+// Stress test for the SampleBus seqlock on real host threads: one writer
+// publishes as fast as it can while subscriber threads read() every record
+// and other threads poll latest(), as TelemetryTask, the MQTT loop and the
+// web handlers do on the device. Every record is derived from its
+// sequence number, so a torn or zeroed copy shows up as a mismatch.
+//
+// The simulator in host_sim runs one task at a time and cannot interleave
+// a reader inside the writer's memcpy; this runs the firmware SampleBus.cpp
+// unchanged on std::thread instead. It needs more than one host core to
+// overlap copies; on one core it relies on preemption mid-copy.
+//
+// Build (host):
+//   make -C tools/host
+//
+// Usage:
+//   ./build/bus_stress [seconds] [subscribers] [latest readers]
+//       defaults 5 s, 4 subscribers (every other one slow), 2 latest()
+//       readers; exit 1 on failure
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "SampleBus.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+// Record n: every field, padding included, is a function of n (n >= 1)
+static void makeRecord(uint32_t n, MeasurementData& d) {
+    memset(&d, 0, sizeof(d));
+    d.uptimeMs = n;
+    d.monoUs = (int64_t)n * 1000;
+    d.epoch = n ^ 0x5a5a5a5au;
+    d.lat = n * 1e-3;
+    d.lng = -d.lat;
+    d.vin = (float)(n & 0xffff);
+    d.iin = -d.vin;
+    d.pin = d.vin * 0.5f;
+    d.vout = (float)(n >> 16);
+    d.iout = d.vin + 1;
+    d.pout = d.vin + 2;
+    d.efficiency = d.vin + 3;
+    d.battSoC = d.vin + 4;
+    d.adcSoC = d.vin + 5;
+    for (int i = 0; i < 4; i++) {
+        d.logicLevels[i] = (float)((n >> i) & 1);
+        d.adcValues[i] = (int16_t)((n + i) & 0x7fff);
+    }
+    d.satellites = (uint8_t)n;
+    d.fresh = (uint8_t)(n >> 8);
+    d.timeSource = (uint8_t)(n >> 24);
+}
+
+static bool intact(const MeasurementData& d) {
+    if (d.uptimeMs == 0) return false;
+    MeasurementData want;
+    makeRecord(d.uptimeMs, want);
+    return memcmp(&d, &want, sizeof(d)) == 0;
+}
+
+struct ReaderResult {
+    uint64_t reads = 0;
+    uint64_t bad = 0;       // Torn or zeroed copies
+    uint64_t backwards = 0; // Sequence not after the previous one
+    uint64_t skipped = 0;   // Sequences jumped over (subscribers: must equal overruns)
+    uint32_t last = 0;
+};
+
+static SampleBus bus;
+static std::atomic<bool> writing(true);
+static std::atomic<uint32_t> published(0);
+
+// Control: the writer also copies each record into a plain buffer that one
+// thread reads without the seqlock. Torn copies there show the run really
+// overlapped reads with writes.
+static MeasurementData unguarded;
+
+static void writer(double seconds) {
+    MeasurementData d;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    uint32_t n = 0;
+    while ((++n & 0xff) || std::chrono::steady_clock::now() < end) {
+        makeRecord(n, d);
+        bus.publish(d);
+        memcpy((void*)&unguarded, &d, sizeof(d));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        published.store(n, std::memory_order_relaxed);
+    }
+    writing.store(false, std::memory_order_release);
+}
+
+// A slow subscriber sleeps every 64 reads, so it falls a ring behind and
+// exercises the overrun path
+static void subscriber(int sub, bool slow, ReaderResult& r) {
+    MeasurementData d;
+    for (;;) {
+        bool done = !writing.load(std::memory_order_acquire);
+        if (!bus.read(sub, d)) {
+            if (done) return; // Drained after the writer stopped
+            std::this_thread::yield();
+            continue;
+        }
+        r.reads++;
+        if (!intact(d)) {
+            r.bad++;
+            continue;
+        }
+        uint32_t n = d.uptimeMs;
+        if (n <= r.last) r.backwards++;
+        else r.skipped += n - r.last - 1;
+        r.last = n;
+        if (slow && (r.reads & 63) == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+static void latestReader(ReaderResult& r) {
+    MeasurementData d;
+    while (writing.load(std::memory_order_acquire)) {
+        if (!bus.latest(d)) continue;
+        r.reads++;
+        if (!intact(d)) {
+            r.bad++;
+            continue;
+        }
+        if (d.uptimeMs < r.last) r.backwards++;
+        r.last = d.uptimeMs;
+    }
+}
+
+static void controlReader(ReaderResult& r) {
+    MeasurementData d;
+    while (writing.load(std::memory_order_acquire)) {
+        memcpy(&d, (const void*)&unguarded, sizeof(d));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        r.reads++;
+        if (d.uptimeMs && !intact(d)) r.bad++;
+    }
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5.0;
+    int subs = argc > 2 ? atoi(argv[2]) : 4;
+    int latests = argc > 3 ? atoi(argv[3]) : 2;
+    if (seconds <= 0 || subs < 1 || subs > SAMPLE_BUS_MAX_SUBSCRIBERS || latests < 0) {
+        fprintf(stderr, "usage: %s [seconds] [subscribers 1-%d] [latest readers]\n", argv[0],
+                SAMPLE_BUS_MAX_SUBSCRIBERS);
+        return 2;
+    }
+
+    static const char* names[SAMPLE_BUS_MAX_SUBSCRIBERS] = {"sub0", "sub1", "sub2", "sub3", "sub4", "sub5"};
+    for (int i = 0; i < subs; i++) bus.subscribe(names[i]);
+
+    printf("%.1f s, %d subscribers (%d slow), %d latest() readers, %u host cores\n\n", seconds, subs, subs / 2,
+           latests, std::thread::hardware_concurrency());
+
+    std::vector<ReaderResult> subResults(subs), latestResults(latests);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < subs; i++) threads.emplace_back(subscriber, i, (i & 1) != 0, std::ref(subResults[i]));
+    for (int i = 0; i < latests; i++) threads.emplace_back(latestReader, std::ref(latestResults[i]));
+    ReaderResult control;
+    threads.emplace_back(controlReader, std::ref(control));
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread w(writer, seconds);
+    w.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    for (std::thread& t : threads) t.join();
+
+    uint32_t total = published.load();
+    printf("  %-8s %12s %12s %12s %10s\n", "reader", "reads", "overruns", "last seq", "max lag");
+    uint64_t bad = 0, backwards = 0, reads = 0;
+    bool accounted = true, drained = true;
+    for (int i = 0; i < subs; i++) {
+        const ReaderResult& r = subResults[i];
+        SampleBusStats st = bus.getStats(i);
+        printf("  %-8s %12llu %12u %12u %10u\n", st.name, (unsigned long long)r.reads, st.overruns, r.last, st.maxLag);
+        bad += r.bad;
+        backwards += r.backwards;
+        reads += r.reads;
+        if (r.skipped != st.overruns || r.reads != st.delivered || st.delivered + st.overruns != total) {
+            accounted = false;
+        }
+        if (r.last != total || st.lag != 0) drained = false;
+    }
+    for (int i = 0; i < latests; i++) {
+        const ReaderResult& r = latestResults[i];
+        printf("  latest%-2d %12llu %12s %12u %10s\n", i, (unsigned long long)r.reads, "-", r.last, "-");
+        bad += r.bad;
+        backwards += r.backwards;
+        reads += r.reads;
+    }
+    printf("\n%u records published in %.2f s (%.0f ns each, %.1f M/s)\n\n", total, elapsed, elapsed * 1e9 / total,
+           total / elapsed * 1e-6);
+
+    printf("unguarded control: %llu of %llu plain copies torn\n\n", (unsigned long long)control.bad,
+           (unsigned long long)control.reads);
+
+    check(bad == 0, "intact", "%llu of %llu copies torn or zeroed", (unsigned long long)bad, (unsigned long long)reads);
+    check(backwards == 0, "order", "%llu reads went backwards", (unsigned long long)backwards);
+    check(accounted, "accounting", "delivered + overruns = %u published for every subscriber, gaps = overruns", total);
+    check(drained, "drained", "every subscriber ends on the last record with no lag");
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,358 @@
+// Checks TelemetryHistory (the /history store) off-target: raw ring
+// contents and wrap, the `since` binary search, 1 min / 15 min rollups
+// against a double-precision reference, the per-response point limit,
+// field mapping, ordering across the 32-bit uptimeMs wrap and error
+// cases. Then times append() and query().
+//
+// Build (host):
+//   make -C tools/host
+//
+// Usage:
+//   ./build/history_test     exit 1 on failure
+
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TelemetryHistory.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+// Sample k, taken at monotonic ms t: every field distinct and varying
+// within a minute, so min/max/mean and the field mapping are all visible
+static MeasurementData sampleAt(uint32_t k, uint64_t t) {
+    MeasurementData d;
+    memset(&d, 0, sizeof(d));
+    d.monoUs = (int64_t)t * 1000;
+    d.uptimeMs = (uint32_t)t; // Wraps after 49.7 days; history must not
+    double x = k * 0.37;
+    d.vin = (float)(7.4 + 0.5 * sin(x));
+    d.iin = (float)(0.2 + 0.1 * cos(x * 1.3));
+    d.pin = d.vin * d.iin;
+    // Extremes of the power readings behind the record; every 7th has a
+    // radio burst the record value missed
+    d.vinMin = d.vin - 0.01f * (1 + k % 3);
+    d.vinMax = d.vin + 0.01f * (k % 4);
+    d.iinMin = d.iin - 0.005f;
+    d.iinMax = d.iin + (k % 7 == 0 ? 0.2f : 0.0f);
+    d.powerReads = 53;
+    d.vout = (float)(5.0 + 0.01 * sin(x * 2.1));
+    d.iout = (float)(0.25 + 0.05 * sin(x * 0.7));
+    d.pout = d.vout * d.iout;
+    d.efficiency = (float)(80 + 10 * sin(x * 0.11));
+    d.battSoC = (float)(50 + 40 * sin(k * 1e-4));
+    d.adcSoC = (float)(25 * (k % 5));
+    for (int i = 0; i < 4; i++) d.adcValues[i] = (int16_t)((k * (i + 3)) % 4096);
+    d.satellites = (uint8_t)(k % 13);
+    return d;
+}
+
+// History time of a sample
+static uint64_t tOf(const MeasurementData& d) {
+    return (uint64_t)(d.monoUs / 1000);
+}
+
+static double fieldOf(const MeasurementData& d, int f) {
+    switch (f) {
+        case HF_VIN: return d.vin;
+        case HF_IIN: return d.iin;
+        case HF_PIN: return d.pin;
+        case HF_VOUT: return d.vout;
+        case HF_IOUT: return d.iout;
+        case HF_POUT: return d.pout;
+        case HF_EFF: return d.efficiency;
+        case HF_BATT_SOC: return d.battSoC;
+        case HF_ADC_SOC: return d.adcSoC;
+        case HF_ADC0: case HF_ADC1: case HF_ADC2: case HF_ADC3: return d.adcValues[f - HF_ADC0];
+        case HF_SATS: return d.satellites;
+    }
+    return 0;
+}
+
+// Rollup min/max of vin/iin come from the record's extremes
+static double lowOf(const MeasurementData& d, int f) {
+    return f == HF_VIN ? d.vinMin : f == HF_IIN ? d.iinMin : fieldOf(d, f);
+}
+
+static double highOf(const MeasurementData& d, int f) {
+    return f == HF_VIN ? d.vinMax : f == HF_IIN ? d.iinMax : fieldOf(d, f);
+}
+
+static const char* const FIELDS[HF_COUNT] = {"vin", "iin", "pin", "vout", "iout", "pout", "eff",
+                                              "batt_soc", "adc_soc", "adc0", "adc1", "adc2", "adc3", "satellites"};
+
+// One query response, parsed
+struct Response {
+    bool ok = false;
+    std::string json;
+    size_t chunks = 0, maxChunk = 0;
+    std::map<std::string, std::vector<double>> arrays;
+    std::string field, res;
+};
+
+static Response query(TelemetryHistory& h, const char* field, const char* res, uint64_t since) {
+    Response r;
+    r.ok = h.query(field, res, since, [&r](const char* data, size_t len) {
+        r.json.append(data, len);
+        r.chunks++;
+        if (len > r.maxChunk) r.maxChunk = len;
+    });
+    const char* p = r.json.c_str();
+    while ((p = strchr(p, '"'))) {
+        const char* k = p + 1;
+        const char* ke = strchr(k, '"');
+        if (!ke) break;
+        std::string key(k, ke);
+        p = ke + 1;
+        if (*p != ':') continue;
+        p++;
+        if (*p == '[') {
+            std::vector<double>& a = r.arrays[key];
+            p++;
+            while (*p && *p != ']') {
+                char* end;
+                a.push_back(strtod(p, &end));
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (*p == '"') {
+            const char* ve = strchr(p + 1, '"');
+            (key == "field" ? r.field : r.res) = std::string(p + 1, ve);
+            p = ve + 1;
+        }
+    }
+    return r;
+}
+
+// Printed with %.6g
+static bool close6(double a, double b) {
+    return fabs(a - b) <= fabs(b) * 1e-5 + 1e-6;
+}
+
+struct RefBucket {
+    uint64_t tMs;
+    uint32_t n;
+    double min, max, sum;
+};
+
+// Double-precision rollup of field f over samples [from, to)
+static std::vector<RefBucket> reference(const std::vector<MeasurementData>& s, int f, uint32_t periodMs) {
+    std::vector<RefBucket> out;
+    for (const MeasurementData& d : s) {
+        uint64_t start = tOf(d) - tOf(d) % periodMs;
+        double v = fieldOf(d, f), lo = lowOf(d, f), hi = highOf(d, f);
+        if (out.empty() || out.back().tMs != start) out.push_back(RefBucket{start, 0, lo, hi, 0});
+        RefBucket& b = out.back();
+        b.n++;
+        b.min = std::min(b.min, lo);
+        b.max = std::max(b.max, hi);
+        b.sum += v;
+    }
+    return out;
+}
+
+// The last `keep` reference buckets against a rollup response; returns
+// the worst relative mean error, or -1 on a mismatch
+static double compareRollup(const Response& r, const std::vector<RefBucket>& ref, size_t keep) {
+    const std::vector<double>& t = r.arrays.at("t");
+    const std::vector<double>& mn = r.arrays.at("min");
+    const std::vector<double>& mx = r.arrays.at("max");
+    const std::vector<double>& me = r.arrays.at("mean");
+    if (t.size() != keep || mn.size() != keep || mx.size() != keep || me.size() != keep) return -1;
+    double worst = 0;
+    for (size_t i = 0; i < keep; i++) {
+        const RefBucket& b = ref[ref.size() - keep + i];
+        if ((uint64_t)t[i] != b.tMs || !close6(mn[i], b.min) || !close6(mx[i], b.max)) return -1;
+        double mean = b.sum / b.n;
+        double err = fabs(me[i] - mean) / std::max(fabs(mean), 1e-3);
+        if (err > worst) worst = err;
+    }
+    return worst;
+}
+
+int main() {
+    // 30 h at 1 s with ±200 ms jitter, as SensorTask delivers records,
+    // starting 20 h before uptimeMs wraps
+    const uint64_t WRAP_MS = 1ULL << 32;
+    const uint64_t T0 = WRAP_MS - 20 * 3600 * 1000ULL + 123456;
+    const uint32_t N = 30 * 3600;
+    std::vector<MeasurementData> samples;
+    samples.reserve(N);
+    uint32_t seed = 1;
+    for (uint32_t k = 0; k < N; k++) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t jitter = (seed >> 16) % 400;
+        samples.push_back(sampleAt(k, T0 + k * 1000 + jitter));
+    }
+
+    TelemetryHistory h;
+    check(h.begin(), "begin", "PSRAM rings allocated");
+
+    std::vector<MeasurementData> fed;
+    for (uint32_t k = 0; k < 2000; k++) {
+        h.append(samples[k]);
+        fed.push_back(samples[k]);
+    }
+
+    // Raw before the ring wraps: newest HISTORY_MAX_POINTS, exact values
+    Response r = query(h, "vin", "raw", 0);
+    bool ok = r.ok && r.field == "vin" && r.res == "raw" && r.arrays["t"].size() == HISTORY_MAX_POINTS &&
+              r.arrays["v"].size() == HISTORY_MAX_POINTS;
+    for (size_t i = 0; ok && i < HISTORY_MAX_POINTS; i++) {
+        const MeasurementData& d = fed[fed.size() - HISTORY_MAX_POINTS + i];
+        ok = (uint64_t)r.arrays["t"][i] == tOf(d) && close6(r.arrays["v"][i], d.vin);
+    }
+    check(ok, "raw latest", "since=0 returns the newest %d of 2000 samples, oldest first", HISTORY_MAX_POINTS);
+
+    // `since` between two samples starts at the later one; past the newest is empty
+    uint32_t k0 = 1700;
+    r = query(h, "iin", "raw", tOf(fed[k0]) - 1);
+    ok = r.ok && r.arrays["t"].size() == 2000 - k0 && (uint64_t)r.arrays["t"][0] == tOf(fed[k0]) &&
+         close6(r.arrays["v"][0], fed[k0].iin);
+    Response empty = query(h, "iin", "raw", tOf(fed.back()) + 1);
+    ok = ok && empty.ok && empty.arrays["t"].empty() && empty.arrays["v"].empty();
+    check(ok, "raw since", "since inside the ring starts at the next sample (%zu points); after the newest: none",
+          r.arrays["t"].size());
+
+    // After the ring wraps only the last HISTORY_RAW_CAPACITY remain
+    for (uint32_t k = 2000; k < 5000; k++) {
+        h.append(samples[k]);
+        fed.push_back(samples[k]);
+    }
+    uint32_t oldestKept = 5000 - HISTORY_RAW_CAPACITY;
+    Response before = query(h, "vin", "raw", tOf(fed[oldestKept - 1]));
+    ok = before.arrays["t"].size() == HISTORY_MAX_POINTS &&
+         (uint64_t)before.arrays["t"][0] == tOf(fed[5000 - HISTORY_MAX_POINTS]);
+    Response tail = query(h, "vin", "raw", tOf(fed[4990]));
+    ok = ok && tail.arrays["t"].size() == 10 && (uint64_t)tail.arrays["t"][0] == tOf(fed[4990]);
+    check(ok, "raw wrap", "after 5000 samples the ring holds the last %d; since still finds the right sample",
+          HISTORY_RAW_CAPACITY);
+
+    // Every field maps to its MeasurementData member
+    int mapped = 0;
+    for (int f = 0; f < HF_COUNT; f++) {
+        Response q = query(h, FIELDS[f], "raw", tOf(fed[4999]));
+        if (q.ok && q.arrays["v"].size() == 1 && close6(q.arrays["v"][0], fieldOf(fed[4999], f))) mapped++;
+    }
+    check(mapped == HF_COUNT, "fields", "%d/%d fields return their own value", mapped, HF_COUNT);
+
+    // Feed the rest: 30 h, so the 1 min ring (24 h) wraps too
+    for (uint32_t k = 5000; k < N; k++) {
+        h.append(samples[k]);
+        fed.push_back(samples[k]);
+    }
+
+    // 1 min: 1440 closed buckets + the open one, truncated to the newest 600
+    double worst1m = 0;
+    bool ok1m = true;
+    for (int f = 0; f < HF_COUNT; f++) {
+        std::vector<RefBucket> ref = reference(fed, f, 60000);
+        Response q = query(h, FIELDS[f], "1m", 0);
+        double e = q.ok ? compareRollup(q, ref, HISTORY_MAX_POINTS) : -1;
+        if (e < 0) ok1m = false;
+        else worst1m = std::max(worst1m, e);
+    }
+    check(ok1m && worst1m < 1e-5, "rollup 1m",
+          "newest %d buckets (incl. the open one) match min/max/mean for all fields, mean error %.1e",
+          HISTORY_MAX_POINTS, worst1m);
+
+    // 15 min: 120 buckets, all returned
+    double worst15 = 0;
+    bool ok15 = true;
+    size_t n15 = 0;
+    for (int f = 0; f < HF_COUNT; f++) {
+        std::vector<RefBucket> ref = reference(fed, f, 900000);
+        n15 = ref.size();
+        Response q = query(h, FIELDS[f], "15m", 0);
+        double e = q.ok ? compareRollup(q, ref, ref.size()) : -1;
+        if (e < 0) ok15 = false;
+        else worst15 = std::max(worst15, e);
+    }
+    check(ok15 && worst15 < 1e-5, "rollup 15m", "all %zu buckets match min/max/mean for all fields, mean error %.1e",
+          n15, worst15);
+
+    // since inside a bucket includes that bucket; the 1 min ring wrapped
+    std::vector<RefBucket> ref1 = reference(fed, HF_VIN, 60000);
+    const RefBucket& mid = ref1[ref1.size() - 11];
+    Response q = query(h, "vin", "1m", mid.tMs + 30000);
+    ok = q.ok && q.arrays["t"].size() == 11 && (uint64_t)q.arrays["t"][0] == mid.tMs;
+    Response all1m = query(h, "vin", "1m", ref1[ref1.size() - HISTORY_1M_CAPACITY - 1].tMs);
+    ok = ok && all1m.arrays["t"].size() == HISTORY_MAX_POINTS;
+    check(ok, "rollup since", "since mid-bucket returns that bucket and the %zu after it", q.arrays["t"].size() - 1);
+
+    // The rings span the uptimeMs wrap: buckets stay in order and `since`
+    // past 2^32 ms finds the samples after it
+    uint64_t wrapEdge = WRAP_MS - WRAP_MS % 900000;
+    Response span = query(h, "vin", "15m", wrapEdge - 5 * 900000);
+    ok = span.ok && span.arrays["t"].size() > 5 && (uint64_t)span.arrays["t"][5] == wrapEdge;
+    for (size_t i = 1; ok && i < span.arrays["t"].size(); i++) ok = span.arrays["t"][i] > span.arrays["t"][i - 1];
+    Response after = query(h, "vin", "raw", tOf(fed.back()) - 30000);
+    ok = ok && fed.back().uptimeMs < fed.front().uptimeMs && after.arrays["t"].size() >= 29 &&
+         after.arrays["t"].size() <= 31 && (uint64_t)after.arrays["t"].back() == tOf(fed.back());
+    check(ok, "64-bit time", "uptimeMs wrapped at %.1f h; 15m buckets stay ordered across it, raw since past 2^32 ms works",
+          (WRAP_MS - T0) / 3600e3);
+
+    // Bad requests write nothing; the response goes out in <= 1 KB chunks
+    Response bad1 = query(h, "volts", "raw", 0);
+    Response bad2 = query(h, "vin", "5m", 0);
+    check(!bad1.ok && !bad2.ok && bad1.json.empty() && bad2.json.empty(), "bad request",
+          "unknown field or resolution returns false and sends nothing");
+    Response big = query(h, "vin", "1m", 0);
+    check(big.maxChunk <= 1024 && big.chunks > 1, "chunks", "%zu bytes in %zu chunks, largest %zu", big.json.size(),
+          big.chunks, big.maxChunk);
+
+    // Non-finite raw values are sent as 0, so the document stays valid JSON
+    TelemetryHistory hn;
+    hn.begin();
+    MeasurementData d = sampleAt(0, 1000);
+    d.vin = NAN;
+    d.iin = INFINITY;
+    hn.append(d);
+    Response nv = query(hn, "vin", "raw", 0);
+    Response ni = query(hn, "iin", "raw", 0);
+    check(nv.json.find("nan") == std::string::npos && ni.json.find("inf") == std::string::npos &&
+              nv.arrays["v"].size() == 1 && nv.arrays["v"][0] == 0 && ni.arrays["v"][0] == 0,
+          "nan/inf", "raw NaN and Inf are sent as 0");
+
+    // Cost: append() per sample, and a recent query against full rings
+    const uint32_t REPS = 200000;
+    std::vector<MeasurementData> more;
+    more.reserve(REPS);
+    for (uint32_t k = N; k < N + REPS; k++) more.push_back(sampleAt(k, T0 + k * 1000));
+    auto t0 = std::chrono::steady_clock::now();
+    for (const MeasurementData& m : more) h.append(m);
+    double appendNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / REPS;
+    size_t sink = 0;
+    const int QUERIES = 2000;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERIES; i++) {
+        h.query("vin", "raw", tOf(more[REPS - 60]), [&sink](const char*, size_t len) { sink += len; });
+    }
+    double recentUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / QUERIES;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERIES; i++) {
+        h.query("vin", "1m", 0, [&sink](const char*, size_t len) { sink += len; });
+    }
+    double fullUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / QUERIES;
+    printf("\nappend %.0f ns/sample; query: last minute raw %.1f us, %d x 1m buckets %.1f us (x86 host)\n\n",
+           appendNs, recentUs, HISTORY_MAX_POINTS, fullUs);
+
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,951 @@
+// Runs the unchanged firmware (the sketch and every service in the
+// repository root) on Linux against the shims in shim/ and the device
+// models in sim/. Time is virtual: the scheduler in sim/SimKernel.h jumps
+// over idle time, so a simulated day takes seconds, and host CPU time is
+// charged per task and per Metrics section to give each stage's cost.
+//
+// Build (host):
+//   make -C tools/host
+//
+// Usage:
+//   ./build/host_sim day [hours] [-no-ap] [-v]
+//       a day in orbit (default 24 h): power and ALERT pacing, GPS, RTC,
+//       SNTP, WiFi outages, SampleBus → Telemetry/MQTT; per-task and
+//       per-stage cost, then checks (exit 1 on failure)
+//   ./build/host_sim reconnect [-v]
+//       an hour against a broker that is stopped (refused), unreachable
+//       (blackhole) and hung (stalled), each for 10 minutes and restarted:
+//       backoff, attempt budget, reconnect time, loop() and /json latency,
+//       link metrics and uplink delivery by sequence number
+//   ./build/host_sim batching [-v]
+//       20 minutes per batch limit (client buffer capped to 1-4 frames,
+//       then the default): messages/s, bytes/s and sample age at the
+//       broker, delivery by sequence number
+//   ./build/host_sim sse-load [-v]
+//       SSE_MAX_CLIENTS dashboards polling /json every 2 s, then on
+//       /events streams, then one stream too many each, then two that stop
+//       reading: update age, loopTask CPU per update, 503s and drops
+//   -no-ap  no access point: GPS and the RTC keep time, MQTT backlogs
+//   -v      copies the firmware's Serial output to stdout
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <WebServer.h>
+#include <Wire.h>
+#include <esp_adc/adc_continuous.h>
+#include <cstdarg>
+#include <deque>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sim/Devices.h"
+#include "sim/SimKernel.h"
+#include "sim/SimNet.h"
+
+#include "DataModel.h"
+#include "Metrics.h"
+#include "MqttService.h"
+#include "SampleBus.h"
+#include "SensorService.h"
+#include "SystemClock.h"
+#include "TelemetryFrame.h"
+#include "WebService.h"
+
+// The sketch (CubesatProject.ino)
+void setup();
+void loop();
+extern SampleBus sampleBus;
+extern SensorService sensorService;
+extern MqttService mqttService;
+
+#define SEC 1000000LL
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+// Scenario phase (index into the scenario's timeline) and the longest
+// loop() call in virtual time per phase. The `loop` Metrics section only
+// counts CPU; a loop held up in a blocking call shows here.
+static size_t phase = 0;
+static std::vector<int64_t> loopMaxUs(1, 0);
+
+// The Arduino core's loopTask: setup() once, then loop() forever
+static void loopTask(void*) {
+    setup();
+    for (;;) {
+        int64_t t = sim::nowUs();
+        loop();
+        int64_t d = sim::nowUs() - t;
+        if (d > loopMaxUs[phase]) loopMaxUs[phase] = d;
+    }
+}
+
+// Extra SampleBus subscriber that checks every record against the
+// scenario's truth. Its work is simulator time, not firmware cost.
+struct Probe {
+    int sub = -1;
+    uint32_t samples = 0;
+    int64_t firstUs = 0, lastUs = 0;
+    int64_t maxGapUs = 0;
+    uint32_t freshPower = 0, freshGps = 0;
+    double maxVinErr = 0, maxIinErr = 0;
+    uint32_t adcMismatch = 0; // After the EMA has settled
+    int64_t maxClockErrUs = 0; // While NTP or GPS steers
+    double sumClockErrUs = 0;
+    uint32_t clockSamples = 0;
+    uint32_t bursts = 0;          // Radio bursts wholly between two records
+    uint32_t burstsInRange = 0;   // ... visible in that record's iin min/max
+    uint32_t burstRecords = 0;    // Records whose own iin fell inside a burst
+    uint32_t rangeViolations = 0; // vin/iin outside their own min/max
+    std::vector<int64_t> times; // monoUs of every record, in bus order
+    bool keepTs = false;        // sse-load: map the JSON "ts" of each record to its monoUs
+    std::map<std::string, int64_t> tsTimes;
+};
+static Probe probe;
+static sim::WorldConfig simWorld; // As installed by boot()
+
+// Radio bursts lasting burstUs every burstEveryUs fall between 1 s
+// records most of the time; the record's min/max must still show them
+static void observeBursts(const MeasurementData& d, int64_t prevUs) {
+    if (d.vin < d.vinMin || d.vin > d.vinMax || d.iin < d.iinMin || d.iin > d.iinMax) probe.rangeViolations++;
+    const int64_t margin = 50000; // Conversion time plus a reading's age
+    int64_t every = simWorld.burstEveryUs;
+    for (int64_t k = (prevUs + margin) / every * every; k < d.monoUs; k += every) {
+        if (k < 120 * SEC || k - margin < prevUs || k + simWorld.burstUs + margin > d.monoUs) continue;
+        double rise = sim::powerAt(k + simWorld.burstUs / 2).iin - sim::powerAt(k - 10000).iin;
+        probe.bursts++;
+        if (d.iinMax - d.iinMin > rise / 2) probe.burstsInRange++;
+    }
+    int64_t phase = (d.monoUs - 30000) % every; // Age of the last conversion
+    if (d.monoUs > 120 * SEC && phase > 10000 && phase < simWorld.burstUs - 10000) probe.burstRecords++;
+}
+
+static void observe(const MeasurementData& d) {
+    if (probe.samples) {
+        int64_t gap = d.monoUs - probe.lastUs;
+        if (gap > probe.maxGapUs) probe.maxGapUs = gap;
+        observeBursts(d, probe.lastUs);
+    } else {
+        probe.firstUs = d.monoUs;
+    }
+    probe.lastUs = d.monoUs;
+    probe.samples++;
+    probe.times.push_back(d.monoUs);
+    if (probe.keepTs) {
+        char ts[32];
+        formatTimestamp(d, ts, sizeof(ts));
+        probe.tsTimes[ts] = d.monoUs;
+    }
+    if (d.fresh & SAMPLE_FRESH_POWER) probe.freshPower++;
+    if (d.fresh & SAMPLE_FRESH_GPS) probe.freshGps++;
+
+    // Power: the last conversion is at most ~2 periods old; skip edges
+    sim::PowerTruth p = sim::powerAt(d.monoUs);
+    sim::PowerTruth q = sim::powerAt(d.monoUs - 20000);
+    if (d.fresh & SAMPLE_FRESH_POWER && fabs(p.iin - q.iin) < 1e-6 && fabs(p.vin - q.vin) < 1e-3) {
+        probe.maxVinErr = std::max(probe.maxVinErr, fabs(d.vin - p.vin));
+        probe.maxIinErr = std::max(probe.maxIinErr, fabs(d.iin - p.iin));
+    }
+
+    // Comparators: one step per quarter of charge, away from the thresholds
+    if (d.monoUs > 120 * SEC) {
+        double r = fmod(p.soc, 25.0);
+        if (r > 13.0 || r < 12.0) {
+            int want = (int)((p.soc + 12.5) / 25.0) * 25;
+            if ((int)d.adcSoC != want) probe.adcMismatch++;
+        }
+    }
+
+    if (d.timeSource == CLOCK_SRC_NTP || d.timeSource == CLOCK_SRC_GPS) {
+        int64_t err = systemClock.epochUsAt(d.monoUs) - sim::trueLocalUs(d.monoUs);
+        if (llabs(err) > llabs(probe.maxClockErrUs)) probe.maxClockErrUs = err;
+        probe.sumClockErrUs += (double)err;
+        probe.clockSamples++;
+    }
+}
+
+static void probeTask(void*) {
+    probe.sub = sampleBus.subscribe("probe", xTaskGetCurrentTaskHandle());
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        sim::ShimScope shim;
+        MeasurementData d;
+        while (sampleBus.read(probe.sub, d)) observe(d);
+    }
+}
+
+// Broker side
+struct TopicCount {
+    uint64_t messages = 0, bytes = 0;
+};
+static std::map<std::string, TopicCount> published;
+
+// Uplink sequence numbers seen by the broker, from the batch frames
+static std::map<uint32_t, int> seqSeen;
+static uint64_t badFrames = 0;
+
+// Every batch as the broker received it
+struct UplinkBatch {
+    int64_t arrivalUs;
+    size_t wireBytes;           // PUBLISH packet
+    std::vector<int64_t> ageUs; // Per frame: arrival less the sample's uptimeMs
+};
+static std::vector<UplinkBatch> batches;
+
+static void onPublish(const sim::BrokerMessage& m) {
+    TopicCount& t = published[m.topic];
+    t.messages++;
+    t.bytes += m.payload.size();
+    if (m.topic != MQTT_TOPIC_BIN) return;
+    const uint8_t* frames;
+    uint8_t count, size;
+    if (!parseTelemetryBatch(m.payload.data(), m.payload.size(), &frames, &count, &size)) {
+        badFrames++;
+        return;
+    }
+    // Fixed header (remaining length < 16 KiB: two bytes at most), topic
+    size_t remaining = 2 + m.topic.size() + m.payload.size();
+    UplinkBatch b{m.arrivalUs, 1 + (remaining < 128 ? 1 : 2) + remaining, {}};
+    for (uint8_t i = 0; i < count; i++) {
+        TelemetryFrame f;
+        if (decodeTelemetryFrame(frames + (size_t)i * size, size, f) != FRAME_OK) {
+            badFrames++;
+        } else {
+            seqSeen[f.seq]++;
+            b.ageUs.push_back(m.arrivalUs - f.uptimeMs * 1000LL);
+        }
+    }
+    batches.push_back(std::move(b));
+}
+
+// Metrics sections from the firmware's own Prometheus export
+struct Section {
+    double sum = 0, max = 0;
+    unsigned long count = 0;
+};
+
+static std::map<std::string, Section> sections() {
+    std::string text;
+    metrics.writePrometheus([&](const char* data, size_t len) { text.append(data, len); });
+    std::map<std::string, Section> out;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+        char name[48];
+        double v;
+        if (sscanf(line.c_str(), "cubesat_duration_seconds_sum{timer=\"%47[^\"]\"} %lf", name, &v) == 2) {
+            out[name].sum = v;
+        } else if (sscanf(line.c_str(), "cubesat_duration_seconds_count{timer=\"%47[^\"]\"} %lf", name, &v) == 2) {
+            out[name].count = (unsigned long)v;
+        } else if (sscanf(line.c_str(), "cubesat_duration_max_seconds{timer=\"%47[^\"]\"} %lf", name, &v) == 2) {
+            out[name].max = v;
+        }
+    }
+    return out;
+}
+
+static void boot(const sim::WorldConfig& world) {
+    simWorld = world;
+    sim::installWorld(world);
+    sim::brokerListen(MQTT_BROKER, MQTT_PORT, 40000, 2e6);
+    sim::brokerOnPublish(onPublish);
+    xTaskCreatePinnedToCore(probeTask, "probe", 4096, NULL, 1, NULL, 1);
+    xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, NULL, 1, NULL, 1);
+}
+
+static void report(double simS, double hostS) {
+    printf("\n%.1f h simulated in %.2f s host time (%.0fx real time)\n\n", simS / 3600, hostS, simS / hostS);
+
+    printf("Tasks (host CPU in firmware code; shims and device models separate):\n");
+    printf("  %-14s %4s %4s %12s %10s %10s %12s %10s\n", "task", "prio", "core", "firmware ms", "us/sim s",
+           "shim ms", "host stack", "switches");
+    uint64_t fwTotal = 0;
+    for (const sim::TaskStats& t : sim::taskStats()) {
+        fwTotal += t.firmwareNs;
+        printf("  %-14s %4d %4d %12.1f %10.2f %10.1f %5u/%-6u %10llu\n", t.name.c_str(), t.prio, t.core,
+               t.firmwareNs * 1e-6, t.firmwareNs * 1e-3 / simS, t.shimNs * 1e-6, t.stackUsed, t.stackBytes,
+               (unsigned long long)t.switches);
+    }
+    sim::KernelStats k = sim::kernelStats();
+    printf("  firmware total %.1f ms (%.3f%% of one host core); events %llu (%.1f ms), scheduler %.1f ms, "
+           "%llu switches\n\n",
+           fwTotal * 1e-6, fwTotal * 1e-7 / simS, (unsigned long long)k.events, k.eventNs * 1e-6,
+           k.schedulerNs * 1e-6, (unsigned long long)k.switches);
+
+    printf("Stages (Metrics sections, host µs):\n");
+    printf("  %-18s %10s %10s %10s\n", "section", "count", "mean", "max");
+    for (const auto& s : sections()) {
+        if (!s.second.count) continue;
+        printf("  %-18s %10lu %10.2f %10.0f\n", s.first.c_str(), s.second.count, s.second.sum * 1e6 / s.second.count,
+               s.second.max * 1e6);
+    }
+
+    sim::DeviceStats dev = sim::deviceStats();
+    sim::I2cBusStats i2c = sim::i2cBusStats();
+    sim::AdcStats adc = sim::adcStats();
+    sim::NetStats net = sim::netStats();
+    sim::BrokerStats broker = sim::brokerStats();
+    printf("\nDevices: INA226 %llu ALERTs, %llu register reads; RTC %llu reads, %llu writes; GPS %llu bytes, "
+           "%llu sentences\n",
+           (unsigned long long)dev.inaConversions, (unsigned long long)dev.inaReads, (unsigned long long)dev.rtcReads,
+           (unsigned long long)dev.rtcWrites, (unsigned long long)dev.gpsBytes, (unsigned long long)dev.gpsSentences);
+    printf("I2C: %llu transfers, %.1f s on the wire (%.2f%%), %llu NACKs, %llu timeouts\n",
+           (unsigned long long)i2c.transfers, i2c.busyUs * 1e-6, i2c.busyUs * 1e-4 / simS,
+           (unsigned long long)i2c.nacks, (unsigned long long)i2c.timeouts);
+    printf("ADC DMA: %llu frames, %llu dropped\n", (unsigned long long)adc.frames, (unsigned long long)adc.dropped);
+    printf("Network: %llu connections, %llu STA drops, %llu SNTP syncs (%llu failed)\n",
+           (unsigned long long)net.conns, (unsigned long long)net.staDrops, (unsigned long long)net.sntpSyncs,
+           (unsigned long long)net.sntpFailures);
+    printf("Broker: %llu sessions, %llu messages, %llu bytes\n", (unsigned long long)broker.connects,
+           (unsigned long long)broker.messages, (unsigned long long)broker.bytes);
+    for (const auto& t : published) {
+        printf("  %-24s %8llu messages %10llu bytes\n", t.first.c_str(), (unsigned long long)t.second.messages,
+               (unsigned long long)t.second.bytes);
+    }
+    ClockStats c = systemClock.getStats();
+    printf("Clock: source %s, drift %.2f ppm, syncs RTC %lu GPS %lu NTP %lu, %lu steps\n\n",
+           SystemClock::sourceName(c.source), c.driftPpm, (unsigned long)c.syncs[CLOCK_SRC_RTC],
+           (unsigned long)c.syncs[CLOCK_SRC_GPS], (unsigned long)c.syncs[CLOCK_SRC_NTP], (unsigned long)c.steps);
+}
+
+// Uplink delivery as the broker saw it: every sequence number from 1 to the
+// newest exactly once. MQTT here is QoS 0, so samples published into a
+// connection whose path has silently died are gone; `lossWindow(t)` says
+// whether a sample taken at t may be one of them.
+static void checkDelivery(std::function<bool(int64_t)> lossWindow) {
+    uint32_t newest = seqSeen.empty() ? 0 : seqSeen.rbegin()->first;
+    uint32_t missing = 0, unexplained = 0, duplicates = 0;
+    for (uint32_t q = 1; q <= newest; q++) {
+        auto it = seqSeen.find(q);
+        if (it == seqSeen.end()) {
+            missing++;
+            // The MQTT subscriber and the probe see the same records in
+            // order; seq q is the q-th, give or take the subscription order
+            int64_t t = q <= probe.times.size() ? probe.times[q - 1] : -1;
+            if (!lossWindow || t < 0 || !lossWindow(t)) unexplained++;
+        } else if (it->second > 1) {
+            duplicates += it->second - 1;
+        }
+    }
+    BacklogStats backlog = mqttService.getBacklogStats();
+    check(newest + 10 >= probe.samples && unexplained == 0 && duplicates == 0 && badFrames == 0 &&
+              backlog.entries == 0,
+          "delivery", "seq 1..%lu at the broker: %lu missing (%lu outside a dead-path window), %lu duplicates, "
+          "%llu bad frames; backlog %lu drained, %lu left",
+          (unsigned long)newest, (unsigned long)missing, (unsigned long)unexplained, (unsigned long)duplicates,
+          (unsigned long long)badFrames, (unsigned long)backlog.drained, (unsigned long)backlog.entries);
+}
+
+static int day(double hours, const sim::WorldConfig& world, bool noAp) {
+    const int64_t endUs = (int64_t)(hours * 3600 * SEC);
+    if (noAp) {
+        sim::addApOutage(0, endUs + 1);
+    } else {
+        // Two AP outages, 5 and 20 minutes, if the day is long enough
+        sim::addApOutage(3 * 3600 * SEC, 3 * 3600 * SEC + 300 * SEC);
+        sim::addApOutage(15 * 3600 * SEC, 15 * 3600 * SEC + 1200 * SEC);
+    }
+    boot(world);
+
+    uint64_t t0 = sim::hostNs();
+    sim::run(endUs);
+    double hostS = (sim::hostNs() - t0) * 1e-9;
+    double simS = endUs * 1e-6;
+    report(simS, hostS);
+
+    // Checks
+    double period = probe.samples > 1 ? (probe.lastUs - probe.firstUs) * 1e-6 / (probe.samples - 1) : 0;
+    check(probe.samples + 2 >= simS && fabs(period - 1.0) < 1e-4 && probe.maxGapUs < 1100000, "samples",
+          "%lu records, mean period %.6f s, longest gap %.1f ms", (unsigned long)probe.samples, period,
+          probe.maxGapUs * 1e-3);
+
+    // Every consumer subscribes before SensorTask starts, so each one
+    // accounts for every record from the first
+    uint32_t overruns = 0, lagMax = 0, late = 0;
+    for (int i = 0; i < sampleBus.getSubscriberCount(); i++) {
+        SampleBusStats b = sampleBus.getStats(i);
+        overruns += b.overruns;
+        if (b.maxLag > lagMax) lagMax = b.maxLag;
+        if (b.delivered + b.overruns + b.lag != probe.samples) late++;
+    }
+    check(overruns == 0 && late == 0, "bus overruns",
+          "%lu across %d subscribers, max lag %lu; %lu subscribers missed the first records", (unsigned long)overruns,
+          sampleBus.getSubscriberCount(), (unsigned long)lagMax, (unsigned long)late);
+
+    check(probe.freshPower + 2 >= probe.samples && sensorService.getPowerAlertTimeouts() == 0, "power pacing",
+          "power fresh in %lu/%lu records, %lu ALERT timeouts, %lu I2C errors", (unsigned long)probe.freshPower,
+          (unsigned long)probe.samples, (unsigned long)sensorService.getPowerAlertTimeouts(),
+          (unsigned long)sensorService.getI2cErrors());
+
+    check(probe.maxVinErr < 0.01 && probe.maxIinErr < 0.005, "power values", "vin within %.1f mV, iin within %.2f mA of the rails",
+          probe.maxVinErr * 1e3, probe.maxIinErr * 1e3);
+
+    check(probe.bursts > 0 && probe.burstsInRange == probe.bursts && probe.rangeViolations == 0, "power extremes",
+          "%lu/%lu radio bursts between records show in iin min/max (%lu records caught one in iin), %lu out of range",
+          (unsigned long)probe.burstsInRange, (unsigned long)probe.bursts, (unsigned long)probe.burstRecords,
+          (unsigned long)probe.rangeViolations);
+
+    check(probe.adcMismatch == 0 && sensorService.getAdcOverflows() == 0, "adc soc",
+          "%lu records disagree with the comparators, %lu DMA overflows", (unsigned long)probe.adcMismatch,
+          (unsigned long)sensorService.getAdcOverflows());
+
+    GpsStats g = sensorService.getGpsStats();
+    GpsFix fix = {};
+    sensorService.getGpsFix(fix);
+    const int inView = 11 + 6 + 3; // GPGSV + GLGSV + GAGSV from the sim receiver
+    check(probe.freshGps + 60 >= probe.samples && g.checksumFailures == 0 && g.overruns == 0 &&
+              (!world.gpsPresent || fix.satsInView == inView), "gps",
+          "position fresh in %lu records, %u in view over all constellations, %.1f sentences/s, %lu checksum failures, "
+          "%lu overruns", (unsigned long)probe.freshGps, fix.satsInView, g.sentenceRate,
+          (unsigned long)g.checksumFailures, (unsigned long)g.overruns);
+
+    ClockStats c = systemClock.getStats();
+    double meanErrMs = probe.clockSamples ? probe.sumClockErrUs / probe.clockSamples * 1e-3 : 0;
+    // NTP is right on arrival; GPS time is late by the RMC line's arrival
+    // after the top of its second, which CLOCK_GPS_LATENCY_US can remove
+    int64_t clockLimitUs = c.source == CLOCK_SRC_GPS ? 250000 : 100000;
+    check(probe.clockSamples + 60 >= probe.samples && llabs(probe.maxClockErrUs) < clockLimitUs, "clock",
+          "%s-steered, %lu records against true time: error mean %+.2f ms, worst %+.2f ms",
+          SystemClock::sourceName(c.source), (unsigned long)probe.clockSamples, meanErrMs, probe.maxClockErrUs * 1e-3);
+    bool driftDue = hours >= 2;
+    check(!driftDue || fabs(c.driftPpm - world.crystalPpm) < 1.0, "clock drift",
+          "estimated %.2f ppm, crystal %.2f ppm%s", c.driftPpm, world.crystalPpm, driftDue ? "" : " (too short)");
+
+    TopicCount tel = published[MQTT_TOPIC_BIN];
+    BacklogStats backlog = mqttService.getBacklogStats();
+    if (noAp) {
+        check(tel.messages == 0 && backlog.entries > 0, "mqtt", "no AP: %lu entries (%lu bytes) held, %lu dropped",
+              (unsigned long)backlog.entries, (unsigned long)backlog.bytes, (unsigned long)backlog.dropped);
+    } else {
+        check(tel.messages > 0 && backlog.dropped == 0, "mqtt", "%llu batches on %s, backlog dropped %lu",
+              (unsigned long long)tel.messages, MQTT_TOPIC_BIN, (unsigned long)backlog.dropped);
+        // An AP outage drops the link at once, so nothing is lost in flight
+        checkDelivery(nullptr);
+    }
+
+    printf("%s (%d failed)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
+
+// Broker outages against the connection state machine: the broker process
+// stopped (refused), the host unreachable (blackhole), and a broker that
+// accepts TCP but never answers (stalled), each followed by a restart
+struct Phase {
+    int64_t startUs;
+    sim::BrokerMode mode;
+    const char* name;
+};
+
+struct Attempt {
+    int64_t startUs, endUs;
+    bool ok;
+    uint32_t backoffMs; // Window drawn after a failure
+    size_t phase;
+};
+
+struct PhaseStats {
+    int64_t lostUs = -1;   // Link first seen down after the phase began
+    int64_t upUs = -1;     // Link first seen up after the phase began
+    uint32_t http = 0, httpDone = 0;
+    int64_t httpMaxUs = 0;
+};
+
+static int reconnect() {
+    static const Phase PHASES[] = {
+        {0, sim::BROKER_UP, "up"},
+        {600 * SEC, sim::BROKER_REFUSED, "refused"},
+        {1200 * SEC, sim::BROKER_UP, "restart"},
+        {1500 * SEC, sim::BROKER_BLACKHOLE, "blackhole"},
+        {2100 * SEC, sim::BROKER_UP, "restart"},
+        {2400 * SEC, sim::BROKER_STALLED, "stalled"},
+        {3000 * SEC, sim::BROKER_UP, "restart"},
+    };
+    const size_t N = sizeof(PHASES) / sizeof(PHASES[0]);
+    const int64_t endUs = 3600 * SEC;
+
+    sim::WorldConfig world;
+    boot(world);
+    loopMaxUs.assign(N, 0);
+    std::vector<PhaseStats> ps(N);
+    for (size_t i = 1; i < N; i++) {
+        sim::at(PHASES[i].startUs, [i] {
+            phase = i;
+            sim::brokerSetMode(PHASES[i].mode);
+        });
+    }
+
+    // Link state every 10 ms (the loop's own period)
+    static std::vector<Attempt> attempts;
+    static uint32_t seenAttempts = 0;
+    static MqttLinkState lastState = MQTT_LINK_DOWN;
+    std::function<void()> watch = [&ps, &watch] {
+        MqttLinkState st = mqttService.getLinkState();
+        MqttLinkStats ls = mqttService.getLinkStats();
+        int64_t now = sim::nowUs();
+        if (ls.attempts != seenAttempts) {
+            seenAttempts = ls.attempts;
+            attempts.push_back(Attempt{now, -1, false, 0, phase});
+        }
+        if (lastState == MQTT_LINK_CONNECTING && st != MQTT_LINK_CONNECTING && !attempts.empty()) {
+            Attempt& a = attempts.back();
+            a.endUs = now;
+            a.ok = st == MQTT_LINK_UP;
+            a.backoffMs = a.ok ? 0 : ls.backoffMs;
+        }
+        if (st == MQTT_LINK_UP && ps[phase].upUs < 0) ps[phase].upUs = now;
+        if (st != MQTT_LINK_UP && ps[phase].lostUs < 0) ps[phase].lostUs = now;
+        lastState = st;
+        sim::after(10000, watch);
+    };
+    sim::at(10000, watch);
+
+    // A dashboard polling /json once a second over the SoftAP
+    std::function<void()> poll = [&ps, &poll] {
+        auto c = std::make_shared<sim::HttpClientModel>();
+        c->uri = "/json";
+        size_t ph = phase;
+        ps[ph].http++;
+        c->onDone = [&ps, ph](sim::HttpClientModel& m) {
+            if (m.status != 200) return;
+            ps[ph].httpDone++;
+            ps[ph].httpMaxUs = std::max(ps[ph].httpMaxUs, m.doneUs - m.sentUs);
+        };
+        sim::httpGet(sim::nowUs(), c);
+        sim::after(SEC, poll);
+    };
+    sim::at(60 * SEC + SEC / 2, poll);
+
+    uint64_t t0 = sim::hostNs();
+    sim::run(endUs);
+    report(endUs * 1e-6, (sim::hostNs() - t0) * 1e-9);
+
+    printf("Broker phases:\n");
+    printf("  %-10s %8s %9s %9s %10s %10s %10s %10s %10s %9s\n", "phase", "start s", "attempts", "failures",
+           "attempt ms", "max wait s", "lost s", "up s", "loop ms", "/json ms");
+    bool backoffOk = true, budgetOk = true, reconnectOk = true, loopOk = true, httpOk = true;
+    uint32_t maxWindow = 0;
+    for (size_t i = 0; i < N; i++) {
+        uint32_t n = 0, fails = 0;
+        int64_t attemptUs = 0, maxWaitUs = 0;
+        for (size_t k = 0; k < attempts.size(); k++) {
+            const Attempt& a = attempts[k];
+            if (a.phase != i || a.endUs < 0) continue;
+            n++;
+            attemptUs += a.endUs - a.startUs;
+            if ((a.endUs - a.startUs) > (MQTT_CONNECT_TIMEOUT_MS + 200) * 1000LL) budgetOk = false;
+            if (a.ok) continue;
+            fails++;
+            maxWindow = std::max(maxWindow, a.backoffMs);
+            // The next attempt starts in [window/2, window] after this one
+            // failed; the loop and this watch each add up to 10 ms
+            if (k + 1 < attempts.size()) {
+                int64_t wait = attempts[k + 1].startUs - a.endUs;
+                maxWaitUs = std::max(maxWaitUs, wait);
+                if (wait < a.backoffMs * 500LL - 20000 || wait > a.backoffMs * 1000LL + 20000) backoffOk = false;
+            }
+        }
+        const PhaseStats& p = ps[i];
+        double lostS = p.lostUs >= 0 ? (p.lostUs - PHASES[i].startUs) * 1e-6 : -1;
+        double upS = p.upUs >= 0 ? (p.upUs - PHASES[i].startUs) * 1e-6 : -1;
+        printf("  %-10s %8.0f %9lu %9lu %10.0f %10.1f %10.1f %10.1f %10.1f %9.1f\n", PHASES[i].name,
+               PHASES[i].startUs * 1e-6, (unsigned long)n, (unsigned long)fails, n ? attemptUs * 1e-3 / n : 0.0,
+               maxWaitUs * 1e-6, PHASES[i].mode == sim::BROKER_UP ? -1.0 : lostS, upS, loopMaxUs[i] * 1e-3,
+               p.httpMaxUs * 1e-3);
+        if (PHASES[i].mode == sim::BROKER_UP && i > 0 &&
+            (p.upUs < 0 || p.upUs - PHASES[i].startUs > (MQTT_BACKOFF_MAX_MS + MQTT_CONNECT_TIMEOUT_MS + 500) * 1000LL)) {
+            reconnectOk = false;
+        }
+        if (loopMaxUs[i] > 50000) loopOk = false;
+        if (p.httpDone + 1 < p.http || p.httpMaxUs > 100000) httpOk = false;
+    }
+    printf("\n");
+
+    MqttLinkStats ls = mqttService.getLinkStats();
+    check(backoffOk && maxWindow == MQTT_BACKOFF_MAX_MS, "backoff",
+          "%lu attempts, %lu failed; every retry in [window/2, window], window doubled to %lu ms",
+          (unsigned long)ls.attempts, (unsigned long)ls.failures, (unsigned long)maxWindow);
+    check(budgetOk, "attempt budget", "every attempt ended within %d ms", MQTT_CONNECT_TIMEOUT_MS);
+    check(reconnectOk, "reconnect", "link back within one max backoff window after each restart");
+    check(loopOk, "loop", "loop() never held up for more than 50 ms of virtual time");
+    check(httpOk, "http", "every /json poll answered within 100 ms in every phase");
+    uint32_t accounted = ls.connectedMs + ls.disconnectedMs;
+    check(accounted + 1000 >= endUs / 1000 - 5000 && accounted <= endUs / 1000, "link metrics",
+          "connected %.1f min + disconnected %.1f min of %.1f min", ls.connectedMs / 60000.0,
+          ls.disconnectedMs / 60000.0, endUs / 6e7);
+    // Blackhole and stalled: publishes still succeed into the TCP buffer
+    // until the keepalive notices, so samples from the open live batch
+    // (taken up to MQTT_BATCH_MAX_LATENCY_MS earlier) until detection are
+    // lost. Refused resets the connection at once: nothing may go missing.
+    checkDelivery([&ps](int64_t t) {
+        for (size_t i = 0; i < N; i++) {
+            if (PHASES[i].mode != sim::BROKER_BLACKHOLE && PHASES[i].mode != sim::BROKER_STALLED) continue;
+            int64_t from = PHASES[i].startUs - (MQTT_BATCH_MAX_LATENCY_MS + 2000) * 1000LL;
+            if (t >= from && t <= ps[i].lostUs + 2 * SEC) return true;
+        }
+        return false;
+    });
+
+    printf("%s (%d failed)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
+
+// Dashboard load on the SoftAP: the same number of clients polling /json
+// every 2 s (the page before /events) and then holding /events streams,
+// then more streams than SSE_MAX_CLIENTS, then streams whose tab stops
+// reading. Each update is matched to its record by "ts" for its age on
+// arrival; loopTask CPU per phase is the firmware's cost of serving them.
+enum WebPhaseId { WEB_BOOT, WEB_IDLE, WEB_POLL, WEB_STREAM, WEB_OVERLOAD, WEB_STALLED };
+
+struct WebPhase {
+    int64_t startUs;
+    const char* name;
+};
+
+struct WebStats {
+    uint64_t loopNs = 0; // loopTask CPU in firmware code
+    uint32_t updates = 0, failed = 0, unmatched = 0;
+    uint64_t bytes = 0;  // Headers included for /json
+    double sumAgeUs = 0;
+    int64_t maxAgeUs = 0;
+};
+
+struct EventStream {
+    std::shared_ptr<sim::HttpClientModel> c;
+    std::string buf;
+    uint32_t events = 0;
+    int64_t closedUs = -1;
+};
+
+static void countUpdate(WebStats& w, const std::string& json, size_t bytes, int64_t arrivalUs) {
+    w.updates++;
+    w.bytes += bytes;
+    size_t k = json.find("\"ts\":\"");
+    size_t e = k == std::string::npos ? k : json.find('"', k + 6);
+    auto it = e == std::string::npos ? probe.tsTimes.end() : probe.tsTimes.find(json.substr(k + 6, e - k - 6));
+    if (it == probe.tsTimes.end()) {
+        w.unmatched++;
+        return;
+    }
+    int64_t age = arrivalUs - it->second;
+    w.sumAgeUs += (double)age;
+    if (age > w.maxAgeUs) w.maxAgeUs = age;
+}
+
+static uint64_t loopTaskNs() {
+    for (const sim::TaskStats& t : sim::taskStats()) {
+        if (t.name == "loopTask") return t.firmwareNs;
+    }
+    return 0;
+}
+
+static int sseLoad() {
+    static const WebPhase PHASES[] = {
+        {0, "boot"},
+        {120 * SEC, "idle"},
+        {300 * SEC, "poll"},
+        {900 * SEC, "stream"},
+        {1500 * SEC, "overload"},
+        {1800 * SEC, "stalled"},
+    };
+    const size_t N = sizeof(PHASES) / sizeof(PHASES[0]);
+    const int64_t endUs = 2400 * SEC;
+    const int CLIENTS = SSE_MAX_CLIENTS;
+
+    sim::WorldConfig world;
+    probe.keepTs = true;
+    boot(world);
+    loopMaxUs.assign(N, 0);
+    std::vector<WebStats> ws(N);
+    std::vector<uint64_t> cpuMark(N + 1, 0);
+    for (size_t i = 1; i < N; i++) {
+        sim::at(PHASES[i].startUs, [i, &cpuMark] {
+            phase = i;
+            cpuMark[i] = loopTaskNs();
+        });
+    }
+
+    // Pollers, spread over the sample period, until the streams take over
+    std::function<void(int)> poll = [&ws, &poll](int k) {
+        if (sim::nowUs() >= PHASES[WEB_STREAM].startUs) return;
+        auto c = std::make_shared<sim::HttpClientModel>();
+        c->uri = "/json";
+        auto body = std::make_shared<std::string>();
+        c->onBody = [body](sim::HttpClientModel&, const char* data, size_t len, int64_t) { body->append(data, len); };
+        c->onDone = [&ws, body](sim::HttpClientModel& m) {
+            if (m.status != 200) ws[phase].failed++;
+            else countUpdate(ws[phase], *body, m.head.size() + m.bodyBytes, m.doneUs);
+        };
+        sim::httpGet(sim::nowUs(), c);
+        sim::after(2 * SEC, [&poll, k] { poll(k); });
+    };
+    for (int k = 0; k < CLIENTS; k++) {
+        sim::at(PHASES[WEB_POLL].startUs + k * SEC * 5 / 8, [&poll, k] { poll(k); });
+    }
+
+    // EventSource clients; events are split on the blank line
+    static std::deque<EventStream> streams;
+    auto openStream = [&ws](int64_t atUs) {
+        streams.emplace_back();
+        EventStream* s = &streams.back();
+        s->c = std::make_shared<sim::HttpClientModel>();
+        s->c->uri = "/events";
+        s->c->onBody = [s, &ws](sim::HttpClientModel&, const char* data, size_t len, int64_t arrivalUs) {
+            s->buf.append(data, len);
+            size_t end;
+            while ((end = s->buf.find("\n\n")) != std::string::npos) {
+                std::string ev = s->buf.substr(0, end);
+                s->buf.erase(0, end + 2);
+                if (ev.compare(0, 6, "data: ")) continue; // retry: and keepalives
+                s->events++;
+                countUpdate(ws[phase], ev, ev.size() + 2, arrivalUs);
+            }
+        };
+        s->c->onDone = [s](sim::HttpClientModel&) { s->closedUs = sim::nowUs(); };
+        sim::httpGet(atUs, s->c);
+    };
+    for (int k = 0; k < CLIENTS; k++) openStream(PHASES[WEB_STREAM].startUs + k * SEC / 10);
+    for (int k = 0; k < CLIENTS; k++) openStream(PHASES[WEB_OVERLOAD].startUs + k * SEC / 10);
+    // Two tabs go to the background; a minute later two new ones get their slots
+    sim::at(PHASES[WEB_STALLED].startUs, [] {
+        sim::httpSetRate(*streams[0].c, 0);
+        sim::httpSetRate(*streams[1].c, 0);
+    });
+    openStream(PHASES[WEB_STALLED].startUs + 60 * SEC);
+    openStream(PHASES[WEB_STALLED].startUs + 60 * SEC + SEC / 10);
+
+    uint64_t t0 = sim::hostNs();
+    sim::run(endUs);
+    cpuMark[N] = loopTaskNs();
+    report(endUs * 1e-6, (sim::hostNs() - t0) * 1e-9);
+
+    // Loop CPU per update delivered, the idle loop included: what each
+    // update costs the device at this client count
+    std::vector<double> nsPerUpdate(N, 0);
+    printf("Dashboard load (%d clients):\n", CLIENTS);
+    printf("  %-10s %8s %8s %8s %10s %12s %12s %10s %12s %9s\n", "phase", "start s", "updates", "per s",
+           "bytes/upd", "age mean ms", "age max ms", "loop us/s", "us/update", "loop ms");
+    for (size_t i = 0; i < N; i++) {
+        WebStats& w = ws[i];
+        double durS = ((i + 1 < N ? PHASES[i + 1].startUs : endUs) - PHASES[i].startUs) * 1e-6;
+        w.loopNs = cpuMark[i + 1] - cpuMark[i];
+        if (w.updates) nsPerUpdate[i] = (double)w.loopNs / w.updates;
+        printf("  %-10s %8.0f %8lu %8.2f %10.0f %12.1f %12.1f %10.1f %12.2f %9.1f\n", PHASES[i].name,
+               PHASES[i].startUs * 1e-6, (unsigned long)w.updates, w.updates / durS,
+               w.updates ? (double)w.bytes / w.updates : 0.0, w.updates ? w.sumAgeUs * 1e-3 / w.updates : 0.0,
+               w.maxAgeUs * 1e-3, w.loopNs * 1e-3 / durS, nsPerUpdate[i] * 1e-3, loopMaxUs[i] * 1e-3);
+    }
+    printf("\n");
+
+    const WebStats& pw = ws[WEB_POLL];
+    const WebStats& sw = ws[WEB_STREAM];
+    uint32_t unmatched = 0, failed = 0;
+    for (const WebStats& w : ws) {
+        unmatched += w.unmatched;
+        failed += w.failed;
+    }
+    check(pw.updates + 2 * CLIENTS >= 300 * CLIENTS && failed == 0 && unmatched == 0, "poll",
+          "%lu /json responses, %lu failed, %lu not matched to a record", (unsigned long)pw.updates,
+          (unsigned long)failed, (unsigned long)unmatched);
+    double streamS = (PHASES[WEB_OVERLOAD].startUs - PHASES[WEB_STREAM].startUs) * 1e-6;
+    bool everyOne = true;
+    for (int k = 0; k < CLIENTS; k++) {
+        if (streams[k].events + 3 < streamS || (k >= 2 && streams[k].closedUs >= 0)) everyOne = false;
+    }
+    double pollAge = pw.updates ? pw.sumAgeUs / pw.updates : 0, streamAge = sw.updates ? sw.sumAgeUs / sw.updates : 0;
+    check(everyOne && sw.updates + 2 * CLIENTS >= streamS * CLIENTS && streamAge < 50000, "stream",
+          "every sample to all %d streams, mean age %.1f ms against %.1f ms polling", CLIENTS, streamAge * 1e-3,
+          pollAge * 1e-3);
+    check(nsPerUpdate[WEB_STREAM] < nsPerUpdate[WEB_POLL], "stream cpu",
+          "%.2f us of loop CPU per update streamed, %.2f us per update polled (idle loop included)", nsPerUpdate[WEB_STREAM] * 1e-3,
+          nsPerUpdate[WEB_POLL] * 1e-3);
+    uint32_t refused = 0;
+    for (int k = CLIENTS; k < 2 * CLIENTS; k++) {
+        if (streams[k].c->status == 503 && streams[k].closedUs >= 0) refused++;
+    }
+    check(refused == (uint32_t)CLIENTS, "overload", "%lu of %d streams over SSE_MAX_CLIENTS answered 503",
+          (unsigned long)refused, CLIENTS);
+    bool dropped = true, reused = true;
+    int64_t dropMaxUs = 0;
+    for (int k = 0; k < 2; k++) {
+        int64_t d = streams[k].closedUs - PHASES[WEB_STALLED].startUs;
+        if (streams[k].closedUs < 0 || d > 30 * SEC) dropped = false;
+        dropMaxUs = std::max(dropMaxUs, d);
+    }
+    for (size_t k = 2 * CLIENTS; k < streams.size(); k++) {
+        if (streams[k].c->status != 200 || streams[k].closedUs >= 0 || streams[k].events < 500) reused = false;
+    }
+    check(dropped && reused, "stalled", "readers that stop are dropped after %.1f s; their slots serve new streams",
+          dropMaxUs * 1e-6);
+    int64_t loopMax = *std::max_element(loopMaxUs.begin() + WEB_IDLE, loopMaxUs.end());
+    check(loopMax < 20000, "loop", "longest loop() %.1f ms of virtual time after boot (10 ms of it the delay)",
+          loopMax * 1e-3);
+
+    printf("%s (%d failed)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
+
+// Uplink batching against the broker stand-in, one firmware run per batch
+// limit. sim::capMqttBuffer() sizes the client buffer to hold that many
+// frames; uncapped, MQTT_BATCH_MAX_LATENCY_MS bounds a batch at 1 Hz. The
+// firmware boots once per process, so each run is a forked child that
+// hands back its figures over a pipe.
+struct BatchResult {
+    uint16_t bufferBytes; // 0 = uncapped
+    uint16_t limit;       // MqttBatchStats::limit at the end
+    uint32_t messages, samples, failures;
+    double seconds;
+    uint64_t wireBytes;   // PUBLISH packets, TCP/IP headers not included
+    int64_t ageMeanUs, ageP50Us, ageMaxUs;
+    uint32_t newest, missing, duplicates, bad;
+};
+
+static const int64_t BATCH_FROM_US = 120 * SEC; // After boot and the first connect
+static const int64_t BATCH_END_US = 1320 * SEC;
+
+static BatchResult batchRun(uint16_t bufferBytes) {
+    sim::capMqttBuffer(bufferBytes);
+    sim::WorldConfig world;
+    boot(world);
+    sim::run(BATCH_END_US);
+
+    BatchResult r = {};
+    r.bufferBytes = bufferBytes;
+    MqttBatchStats bs = mqttService.getBatchStats();
+    r.limit = bs.limit;
+    r.failures = bs.failures;
+    r.seconds = (BATCH_END_US - BATCH_FROM_US) * 1e-6;
+    std::vector<int64_t> ages;
+    for (const UplinkBatch& b : batches) {
+        if (b.arrivalUs < BATCH_FROM_US) continue;
+        r.messages++;
+        r.samples += b.ageUs.size();
+        r.wireBytes += b.wireBytes;
+        ages.insert(ages.end(), b.ageUs.begin(), b.ageUs.end());
+    }
+    if (!ages.empty()) {
+        std::sort(ages.begin(), ages.end());
+        double sum = 0;
+        for (int64_t a : ages) sum += (double)a;
+        r.ageMeanUs = (int64_t)(sum / ages.size());
+        r.ageP50Us = ages[ages.size() / 2];
+        r.ageMaxUs = ages.back();
+    }
+    r.newest = seqSeen.empty() ? 0 : seqSeen.rbegin()->first;
+    for (uint32_t q = 1; q <= r.newest; q++) {
+        auto it = seqSeen.find(q);
+        if (it == seqSeen.end()) r.missing++;
+        else r.duplicates += it->second - 1;
+    }
+    r.bad = (uint32_t)badFrames;
+    return r;
+}
+
+static bool batchFork(uint16_t bufferBytes, BatchResult& r) {
+    int fds[2];
+    if (pipe(fds)) return false;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        BatchResult out = batchRun(bufferBytes);
+        _exit(write(fds[1], &out, sizeof(out)) == (ssize_t)sizeof(out) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t n = read(fds[0], &r, sizeof(r));
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    return n == (ssize_t)sizeof(r) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int batching() {
+    // Client buffer for n frames, as MqttService::batchLimit() counts it
+    const uint16_t overhead = 5 + 2 + strlen(MQTT_TOPIC_BIN) + TELEMETRY_BATCH_HEADER;
+    static const int LIMITS[] = {1, 2, 3, 4, 0};
+    const int IP_HEADERS = 40; // IPv4 + TCP, one segment per message
+
+    printf("Uplink batching, %.0f s per run at 1 Hz (PUBLISH bytes + %d B TCP/IP per message):\n",
+           (BATCH_END_US - BATCH_FROM_US) * 1e-6, IP_HEADERS);
+    printf("  %-8s %7s %7s %10s %10s %10s %12s %12s %12s %9s\n", "buffer", "limit", "mean", "messages/s",
+           "bytes/s", "B/sample", "age mean s", "age p50 s", "age max s", "missing");
+    bool ran = true, sized = true, delivered = true, bounded = true, cheaper = true;
+    double lastBytes = 1e9, lastAge = -1;
+    for (int n : LIMITS) {
+        BatchResult r;
+        uint16_t buffer = n ? overhead + n * TELEMETRY_FRAME_SIZE : 0;
+        if (!batchFork(buffer, r) || r.messages == 0) {
+            ran = false;
+            continue;
+        }
+        double perMsg = (double)r.samples / r.messages;
+        double bytesS = (r.wireBytes + (double)IP_HEADERS * r.messages) / r.seconds;
+        char bufName[16];
+        snprintf(bufName, sizeof(bufName), "%u", (unsigned)buffer);
+        printf("  %-8s %7u %7.2f %10.3f %10.1f %10.1f %12.3f %12.3f %12.3f %9lu\n", n ? bufName : "default",
+               (unsigned)r.limit, perMsg, r.messages / r.seconds, bytesS, bytesS * r.seconds / r.samples,
+               r.ageMeanUs * 1e-6, r.ageP50Us * 1e-6, r.ageMaxUs * 1e-6, (unsigned long)r.missing);
+        // Capped: full batches of n. Uncapped: the window closes a batch
+        // once its oldest sample is MQTT_BATCH_MAX_LATENCY_MS old, and the
+        // sample read in that same update() still joins it
+        int want = n ? n : MQTT_BATCH_MAX_LATENCY_MS / SAMPLE_PERIOD_MS + 1;
+        if (fabs(perMsg - want) > 0.05 * want + 0.05 || (n && r.limit != n)) sized = false;
+        if (r.missing || r.duplicates || r.bad || r.failures || r.newest + 10 < BATCH_END_US / SEC) delivered = false;
+        if (r.ageMaxUs > (MQTT_BATCH_MAX_LATENCY_MS + 100) * 1000LL) bounded = false;
+        if (bytesS >= lastBytes || r.ageMeanUs * 1e-6 <= lastAge) cheaper = false;
+        lastBytes = bytesS;
+        lastAge = r.ageMeanUs * 1e-6;
+    }
+    printf("\n");
+
+    check(ran, "runs", "one firmware run per batch limit");
+    check(sized, "batch size", "capped runs send full batches of the limit; uncapped, the %d ms window closes them",
+          MQTT_BATCH_MAX_LATENCY_MS);
+    check(delivered, "delivery", "every sequence number at the broker once, no failed publishes");
+    check(bounded, "latency", "no sample older than MQTT_BATCH_MAX_LATENCY_MS + 100 ms at the broker");
+    check(cheaper, "tradeoff", "each larger batch costs fewer bytes/s and more latency");
+
+    printf("%s (%d failed)\n", failures ? "FAILED" : "OK", failures);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    bool verbose = false, noAp = false;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) verbose = true;
+        else if (!strcmp(argv[i], "-no-ap")) noAp = true;
+        else args.push_back(argv[i]);
+    }
+    sim::setConsole(verbose ? stdout : nullptr);
+
+    sim::WorldConfig world;
+    int rc = 2;
+    if (!args.empty() && !strcmp(args[0], "day")) rc = day(args.size() >= 2 ? atof(args[1]) : 24.0, world, noAp);
+    else if (!args.empty() && !strcmp(args[0], "reconnect")) rc = reconnect();
+    else if (!args.empty() && !strcmp(args[0], "sse-load")) rc = sseLoad();
+    else if (!args.empty() && !strcmp(args[0], "batching")) rc = batching();
+    else fprintf(stderr, "usage: %s day [hours] [-no-ap] [-v] | reconnect [-v] | sse-load [-v] | batching [-v]\n",
+                 argv[0]);
+
+    // The device never destroys its globals; static destructors here would
+    // tear the shims down under the firmware's objects
+    fflush(stdout);
+    _exit(rc);
+}
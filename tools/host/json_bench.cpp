@@ -0,0 +1,263 @@
+// Compares the heap-free telemetry JSON encoder (TelemetryJson.cpp) with
+// the String concatenation it replaced in MqttService::publishTelemetry()
+// and WebService::handleJSON(). Both run on the host; String is the shim
+// in shim/WString.h, which keeps the ESP32 core's allocation pattern and
+// counts its heap calls.
+//
+// Build (host):
+//   make -C tools/host
+//
+// Usage:
+//   ./build/json_bench [N]   output equivalence, NaN/Inf, worst-case size and
+//                            truncation checks, then N documents (default
+//                            200000) through each encoder; exit 1 on failure
+
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TelemetryJson.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char* name, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+static void check(bool ok, const char* name, const char* fmt, ...) {
+    printf("%-14s %s: ", name, ok ? "PASS" : "FAIL");
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (!ok) failures++;
+}
+
+// The String version, as MqttService::publishTelemetry() built it before
+// TelemetryJson (d.timestamp was a char array then; formatTimestamp() now)
+static String stringJson(const MeasurementData& d, const LinkStatus& link, OperationMode mode) {
+    auto safeNum = [](float v) { return (isnan(v) || isinf(v)) ? 0.0f : v; };
+    char ts[32];
+    formatTimestamp(d, ts, sizeof(ts));
+
+    String j = "{";
+    j += "\"wifi_connected\":" + String(link.wifiConnected ? "true" : "false") + ",";
+    j += "\"mqtt_connected\":" + String(link.mqttConnected ? "true" : "false") + ",";
+    j += "\"ts\":\"" + String(ts) + "\",";
+    j += "\"mode\":" + String(mode) + ",";
+    j += "\"mode_str\":\"" + String(mode == MODE_SENSOR ? "Sensor" : "Sleep") + "\",";
+    j += "\"vin\":" + String(safeNum(d.vin), 3) + ",";
+    j += "\"iin\":" + String(safeNum(d.iin), 6) + ",";
+    j += "\"pin\":" + String(safeNum(d.pin), 6) + ",";
+    j += "\"vout\":" + String(safeNum(d.vout), 3) + ",";
+    j += "\"iout\":" + String(safeNum(d.iout), 6) + ",";
+    j += "\"pout\":" + String(safeNum(d.pout), 6) + ",";
+    j += "\"eff\":" + String(safeNum(d.efficiency), 2) + ",";
+    j += "\"lat\":" + String(safeNum(d.lat), 6) + ",";
+    j += "\"lng\":" + String(safeNum(d.lng), 6) + ",";
+    j += "\"satellites\":" + String(d.satellites) + ",";
+    j += "\"batt_soc\":" + String(safeNum(d.battSoC), 2) + ",";
+    j += "\"adc_soc\":" + String(safeNum(d.adcSoC), 1) + ",";
+    j += "\"logic0\":" + String(d.logicLevels[0], 2) + ",";
+    j += "\"logic1\":" + String(d.logicLevels[1], 2) + ",";
+    j += "\"logic2\":" + String(d.logicLevels[2], 2) + ",";
+    j += "\"logic3\":" + String(d.logicLevels[3], 2) + ",";
+    j += "\"adc0\":" + String(d.adcValues[0]) + ",";
+    j += "\"adc1\":" + String(d.adcValues[1]) + ",";
+    j += "\"adc2\":" + String(d.adcValues[2]) + ",";
+    j += "\"adc3\":" + String(d.adcValues[3]);
+    j += "}";
+    return j;
+}
+
+// A plausible sample: 2S pack, 5 V rail, Bangkok, comparators
+static MeasurementData randomSample(std::mt19937& rng) {
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    MeasurementData d;
+    memset(&d, 0, sizeof(d));
+    d.epoch = 1780272000u + (uint32_t)(u(rng) * 86400 * 365);
+    d.uptimeMs = (uint32_t)(u(rng) * 4e9);
+    d.monoUs = (int64_t)d.uptimeMs * 1000;
+    d.lat = 13.7 + u(rng) * 0.1;
+    d.lng = 100.7 + u(rng) * 0.1;
+    d.vin = (float)(6.4 + u(rng) * 2.0);
+    d.iin = (float)(u(rng) * 1.2 - 0.4);
+    d.pin = d.vin * d.iin;
+    d.vout = (float)(4.9 + u(rng) * 0.2);
+    d.iout = (float)(u(rng) * 0.5);
+    d.pout = d.vout * d.iout;
+    d.efficiency = (float)(u(rng) * 100);
+    d.battSoC = (float)(u(rng) * 100);
+    d.adcSoC = (float)((int)(u(rng) * 5) * 25);
+    for (int i = 0; i < 4; i++) {
+        d.logicLevels[i] = u(rng) < 0.5 ? 0.0f : 1.0f;
+        d.adcValues[i] = (int16_t)(u(rng) * 4096);
+    }
+    d.satellites = (uint8_t)(u(rng) * 13);
+    return d;
+}
+
+// "key":value pairs of a flat document, in order
+static std::vector<std::pair<std::string, std::string>> fields(const char* doc) {
+    std::vector<std::pair<std::string, std::string>> out;
+    const char* p = doc + 1;
+    while (*p == '"') {
+        const char* k = p + 1;
+        const char* ke = strchr(k, '"');
+        const char* v = ke + 2;
+        const char* ve = v;
+        if (*v == '"') ve = strchr(v + 1, '"') + 1;
+        else while (*ve && *ve != ',' && *ve != '}') ve++;
+        out.emplace_back(std::string(k, ke), std::string(v, ve));
+        p = *ve ? ve + 1 : ve;
+    }
+    return out;
+}
+
+static std::string value(const char* doc, const char* key) {
+    for (const auto& f : fields(doc)) {
+        if (f.first == key) return f.second;
+    }
+    return "";
+}
+
+// Same keys in the same order, equal text or numbers within rounding: the
+// last printed digit, plus float precision where the String code passed a
+// double through safeNum(float)
+static bool equivalent(const char* a, const char* b) {
+    auto fa = fields(a), fb = fields(b);
+    if (fa.size() != fb.size() || fa.empty()) return false;
+    for (size_t i = 0; i < fa.size(); i++) {
+        if (fa[i].first != fb[i].first) return false;
+        const std::string& x = fa[i].second;
+        const std::string& y = fb[i].second;
+        if (x == y) continue;
+        if (x[0] == '"' || y[0] == '"') return false;
+        size_t dot = x.find('.');
+        int decimals = dot == std::string::npos ? 0 : (int)(x.size() - dot - 1);
+        double vx = atof(x.c_str()), vy = atof(y.c_str());
+        if (fabs(vx - vy) > pow(10.0, -decimals) * 1.01 + fabs(vx) * 6e-8) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    long n = argc > 1 ? atol(argv[1]) : 200000;
+    if (n <= 0) {
+        fprintf(stderr, "usage: %s [N]\n", argv[0]);
+        return 2;
+    }
+    std::mt19937 rng(1);
+    LinkStatus link = {true, true};
+    char buf[TELEMETRY_JSON_MAX];
+
+    // Same document as the String version. Only lat/lng may differ in the
+    // text: the String code narrowed them to float (~0.4 m at 100°)
+    int equiv = 0, sameText = 0;
+    const int SAMPLES = 10000;
+    for (int i = 0; i < SAMPLES; i++) {
+        MeasurementData d = randomSample(rng);
+        OperationMode mode = (i & 1) ? MODE_SENSOR : MODE_SLEEP;
+        String s = stringJson(d, link, mode);
+        encodeTelemetryJson(buf, sizeof(buf), d, link, mode);
+        if (equivalent(s.c_str(), buf)) equiv++;
+        auto fs = fields(s.c_str()), fe = fields(buf);
+        bool same = fs.size() == fe.size();
+        for (size_t k = 0; same && k < fs.size(); k++) {
+            if (fs[k].first != "lat" && fs[k].first != "lng" && fs[k] != fe[k]) same = false;
+        }
+        if (same) sameText++;
+    }
+    check(equiv == SAMPLES && sameText == SAMPLES, "equivalent",
+          "%d/%d documents match the String version, %d identical apart from lat/lng", equiv, SAMPLES, sameText);
+
+    // NaN/Inf in every float field come out as 0
+    MeasurementData bad = randomSample(rng);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    bad.lat = nan;
+    bad.lng = -inf;
+    bad.vin = bad.pin = bad.iout = bad.efficiency = bad.adcSoC = nan;
+    bad.iin = bad.vout = bad.battSoC = inf;
+    bad.pout = -inf;
+    for (int i = 0; i < 4; i++) bad.logicLevels[i] = i & 1 ? nan : inf;
+    size_t len = encodeTelemetryJson(buf, sizeof(buf), bad, link, MODE_SENSOR);
+    static const char* const FLOATS[] = {"vin", "iin", "pin", "vout", "iout", "pout", "eff", "lat",
+                                         "lng", "batt_soc", "adc_soc", "logic0", "logic1", "logic2", "logic3"};
+    int zeros = 0;
+    for (const char* k : FLOATS) {
+        if (value(buf, k) == "0.000" || value(buf, k) == "0.000000" || value(buf, k) == "0.00" ||
+            value(buf, k) == "0.0") {
+            zeros++;
+        }
+    }
+    String s = stringJson(bad, link, MODE_SENSOR);
+    check(len && zeros == 15, "nan/inf", "%d/15 float fields are 0 (the String version sent logic0 %s, logic1 %s)",
+          zeros, value(s.c_str(), "logic0").c_str(), value(s.c_str(), "logic1").c_str());
+
+    // Worst case fits TELEMETRY_JSON_MAX
+    MeasurementData big;
+    memset(&big, 0, sizeof(big));
+    big.epoch = 0;
+    big.uptimeMs = UINT32_MAX;
+    big.lat = big.lng = -1e15;
+    big.vin = big.iin = big.pin = big.vout = big.iout = big.pout = -1e30f;
+    big.efficiency = big.battSoC = big.adcSoC = -1e30f;
+    for (int i = 0; i < 4; i++) {
+        big.logicLevels[i] = -1e30f;
+        big.adcValues[i] = INT16_MIN;
+    }
+    big.satellites = 255;
+    LinkStatus noLink = {false, false};
+    len = encodeTelemetryJson(buf, sizeof(buf), big, noLink, MODE_SLEEP, UINT32_MAX);
+    check(len > 0 && len < TELEMETRY_JSON_MAX, "worst case", "%zu of %d bytes with every field at its widest", len,
+          TELEMETRY_JSON_MAX);
+
+    // A buffer one byte short fails cleanly; the exact size works
+    MeasurementData d = randomSample(rng);
+    size_t need = encodeTelemetryJson(buf, sizeof(buf), d, link, MODE_SENSOR, 12345) + 1;
+    char small[TELEMETRY_JSON_MAX];
+    memset(small, 'x', sizeof(small));
+    size_t shortLen = encodeTelemetryJson(small, need - 1, d, link, MODE_SENSOR, 12345);
+    bool shortOk = shortLen == 0 && small[0] == '\0' && small[need - 1] == 'x';
+    size_t exactLen = encodeTelemetryJson(small, need, d, link, MODE_SENSOR, 12345);
+    check(shortOk && exactLen == need - 1 && !strcmp(small, buf), "truncation",
+          "%zu-byte buffer returns 0 and writes nothing past it; %zu bytes fit", need - 1, need);
+
+    // Benchmark: the same records through both
+    std::vector<MeasurementData> records(1024);
+    for (MeasurementData& r : records) r = randomSample(rng);
+    size_t sink = 0;
+
+    sim::resetStringStats();
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+        String j = stringJson(records[i & 1023], link, MODE_SENSOR);
+        sink += j.length();
+    }
+    double stringNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+    sim::StringStats st = sim::stringStats();
+
+    sim::resetStringStats();
+    t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+        sink += encodeTelemetryJson(buf, sizeof(buf), records[i & 1023], link, MODE_SENSOR);
+    }
+    double encNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+    sim::StringStats es = sim::stringStats();
+
+    printf("\n%ld documents (%zu bytes)\n", n, sink);
+    printf("  %-14s %10s %10s %10s %10s %12s\n", "encoder", "ns/doc", "mallocs", "reallocs", "frees", "heap B/doc");
+    printf("  %-14s %10.0f %10.1f %10.1f %10.1f %12.0f\n", "String", stringNs, (double)st.mallocs / n,
+           (double)st.reallocs / n, (double)st.frees / n, (double)st.bytes / n);
+    printf("  %-14s %10.0f %10.1f %10.1f %10.1f %12.0f\n", "TelemetryJson", encNs, (double)es.mallocs / n,
+           (double)es.reallocs / n, (double)es.frees / n, (double)es.bytes / n);
+    printf("  %.1fx faster\n\n", stringNs / encNs);
+    printf("%s (%d failed)\n", failures ? "FAILED" : "all passed", failures);
+    return failures ? 1 : 0;
+}
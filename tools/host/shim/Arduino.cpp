@@ -0,0 +1,386 @@
+#include "Arduino.h"
+#include "esp_timer.h"
+#include "../sim/SimKernel.h"
+#include <stdarg.h>
+#include <map>
+
+#define UART_FIFO_BYTES 128
+#define UART_COUNT      3
+#define PSRAM_BYTES     (8u * 1024 * 1024)
+#define HEAP_BYTES      (320u * 1024) // Internal DRAM left to the sketch
+
+// Print
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) break;
+        n++;
+    }
+    return n;
+}
+
+// As the core: a 64-byte stack buffer, the heap for longer output
+size_t Print::printf(const char* format, ...) {
+    char small[64];
+    char* buf = small;
+    va_list ap;
+    va_start(ap, format);
+    int len = vsnprintf(small, sizeof(small), format, ap);
+    va_end(ap);
+    if (len < 0) return 0;
+    if ((size_t)len >= sizeof(small)) {
+        buf = (char*)malloc(len + 1);
+        if (!buf) return 0;
+        va_start(ap, format);
+        vsnprintf(buf, len + 1, format, ap);
+        va_end(ap);
+    }
+    size_t n = write((const uint8_t*)buf, len);
+    if (buf != small) free(buf);
+    return n;
+}
+
+size_t Print::print(long n, int base) {
+    char buf[72];
+    if (base == 10) snprintf(buf, sizeof(buf), "%ld", n);
+    else return print((unsigned long)n, base);
+    return write(buf);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[72];
+    if (base == 16) snprintf(buf, sizeof(buf), "%lX", n);
+    else if (base == 8) snprintf(buf, sizeof(buf), "%lo", n);
+    else snprintf(buf, sizeof(buf), "%lu", n);
+    return write(buf);
+}
+
+size_t Print::print(double n, int digits) {
+    char buf[340];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return write(buf);
+}
+
+// UARTs
+
+static HardwareSerial* uarts[UART_COUNT];
+static FILE* console;
+
+HardwareSerial Serial(0);
+
+HardwareSerial::HardwareSerial(int nr)
+    : uartNr(nr), begun(false), byteUs10(868), txEndUs10(0), txCount(0), rx(nullptr), rxSize(256),
+      rxHead(0), rxLen(0), fifoFull(120) {
+    if (nr >= 0 && nr < UART_COUNT) uarts[nr] = this;
+}
+
+HardwareSerial::~HardwareSerial() {
+    if (uartNr >= 0 && uartNr < UART_COUNT && uarts[uartNr] == this) uarts[uartNr] = nullptr;
+    free(rx);
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin) {
+    byteUs10 = baud ? (int64_t)(100000000ULL / baud) : 868; // 10 bits per character
+    if (!rx) rx = (uint8_t*)malloc(rxSize);
+    begun = rx != nullptr;
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size) {
+    if (begun) return 0; // The core refuses once the driver is installed
+    rxSize = size;
+    return size;
+}
+
+bool HardwareSerial::setRxFIFOFull(uint8_t bytes) {
+    fifoFull = bytes;
+    return true;
+}
+
+void HardwareSerial::onReceive(OnReceiveCb cb, bool onlyOnTimeout) {
+    rxCb = cb;
+}
+
+void HardwareSerial::onReceiveError(OnReceiveErrorCb cb) {
+    errCb = cb;
+}
+
+int HardwareSerial::available() {
+    return (int)rxLen;
+}
+
+int HardwareSerial::read() {
+    if (!rxLen) return -1;
+    uint8_t c = rx[rxHead];
+    rxHead = (rxHead + 1) % rxSize;
+    rxLen--;
+    return c;
+}
+
+int HardwareSerial::peek() {
+    return rxLen ? rx[rxHead] : -1;
+}
+
+// The driver ring takes what fits; the rest is lost and reported as
+// UART_BUFFER_FULL_ERROR, then the data event follows
+void HardwareSerial::hostReceive(const uint8_t* data, size_t len) {
+    if (!begun) return;
+    size_t room = rxSize - rxLen;
+    size_t n = len < room ? len : room;
+    for (size_t i = 0; i < n; i++) rx[(rxHead + rxLen + i) % rxSize] = data[i];
+    rxLen += n;
+    if (n < len && errCb) errCb(UART_BUFFER_FULL_ERROR);
+    if (n && rxCb) rxCb();
+}
+
+int HardwareSerial::availableForWrite() {
+    int64_t now10 = sim::nowUs() * 10;
+    int64_t queued = txEndUs10 > now10 ? (txEndUs10 - now10 + byteUs10 - 1) / byteUs10 : 0;
+    return queued < UART_FIFO_BYTES ? (int)(UART_FIFO_BYTES - queued) : 0;
+}
+
+// Returns once the last byte is in the FIFO: a write longer than the FIFO
+// blocks for the excess at line rate
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (!size) return 0;
+    {
+        sim::ShimScope shim;
+        if (console && uartNr == 0) fwrite(buffer, 1, size, console);
+    }
+    txCount += size;
+    int64_t now10 = sim::nowUs() * 10;
+    int64_t start = txEndUs10 > now10 ? txEndUs10 : now10;
+    txEndUs10 = start + (int64_t)size * byteUs10;
+    int64_t fits10 = txEndUs10 - (int64_t)UART_FIFO_BYTES * byteUs10;
+    if (fits10 > now10 && sim::currentTask() && !sim::inInterrupt()) {
+        sim::sleepUntil((fits10 + 9) / 10);
+    }
+    return size;
+}
+
+// Time
+
+int64_t esp_timer_get_time() {
+    return sim::nowUs();
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(sim::nowUs() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)sim::nowUs();
+}
+
+void delay(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim::busy(us);
+}
+
+void yield() {
+    vTaskDelay(0);
+}
+
+// GPIO: the level is the external driver's if there is one, else the
+// pin's own output, else its pull (floating inputs read high)
+
+struct Pin {
+    uint8_t mode = INPUT;
+    int out = HIGH;
+    int ext = -1; // Driven by a device model
+    int irqMode = 0;
+    void (*fn)(void) = nullptr;
+    void (*fnArg)(void*) = nullptr;
+    void* arg = nullptr;
+};
+
+static std::map<int, Pin>& pins() {
+    static std::map<int, Pin> p;
+    return p;
+}
+
+static std::function<uint16_t(int)> analogSource;
+
+static int levelOf(const Pin& p) {
+    bool drivesLow = (p.mode & OUTPUT) == OUTPUT && p.out == LOW;
+    if (p.ext == LOW || drivesLow) return LOW; // Open drain: either side can pull low
+    if (p.ext == HIGH) return HIGH;
+    if ((p.mode & OUTPUT) == OUTPUT && !(p.mode & OPEN_DRAIN)) return p.out;
+    return (p.mode & PULLDOWN) ? LOW : HIGH;
+}
+
+static void setLevel(Pin& p, int before) {
+    int after = levelOf(p);
+    if (after == before || !p.irqMode) return;
+    bool edge = (after == HIGH && (p.irqMode & RISING)) || (after == LOW && (p.irqMode & FALLING));
+    if (!edge) return;
+    if (p.fnArg) p.fnArg(p.arg);
+    else if (p.fn) p.fn();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    Pin& p = pins()[pin];
+    int before = levelOf(p);
+    p.mode = mode;
+    setLevel(p, before);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    Pin& p = pins()[pin];
+    int before = levelOf(p);
+    p.out = val ? HIGH : LOW;
+    setLevel(p, before);
+}
+
+int digitalRead(uint8_t pin) {
+    return levelOf(pins()[pin]);
+}
+
+uint16_t analogRead(uint8_t pin) {
+    sim::ShimScope shim;
+    return analogSource ? analogSource(pin) : 4095;
+}
+
+void analogReadResolution(uint8_t bits) {
+}
+
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode) {
+    Pin& p = pins()[pin];
+    p.fn = fn;
+    p.fnArg = nullptr;
+    p.irqMode = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode) {
+    Pin& p = pins()[pin];
+    p.fn = nullptr;
+    p.fnArg = fn;
+    p.arg = arg;
+    p.irqMode = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+    Pin& p = pins()[pin];
+    p.fn = nullptr;
+    p.fnArg = nullptr;
+    p.irqMode = 0;
+}
+
+// Random numbers: xorshift64*, reproducible from the seed
+
+static uint64_t rngState = 0x9E3779B97F4A7C15ull;
+
+uint32_t esp_random() {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (uint32_t)((rngState * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+long random(long howbig) {
+    if (howbig <= 0) return 0;
+    return (long)(esp_random() % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+}
+
+// System. Heap figures are not modelled beyond PSRAM allocations; the
+// host allocator says nothing about ESP32 fragmentation.
+
+EspClass ESP;
+static uint64_t psramAllocated;
+
+uint32_t EspClass::getFreeHeap() {
+    return HEAP_BYTES / 2;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    return HEAP_BYTES / 2;
+}
+
+uint32_t EspClass::getMaxAllocHeap() {
+    return HEAP_BYTES / 4;
+}
+
+uint32_t EspClass::getHeapSize() {
+    return HEAP_BYTES;
+}
+
+uint32_t EspClass::getPsramSize() {
+    return PSRAM_BYTES;
+}
+
+uint32_t EspClass::getFreePsram() {
+    return psramAllocated < PSRAM_BYTES ? (uint32_t)(PSRAM_BYTES - psramAllocated) : 0;
+}
+
+// CCOUNT at 240 MHz, advanced only by host time spent in firmware code:
+// Metrics histograms then hold this machine's cost of each section,
+// without the simulator's own work or any virtual waiting
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(sim::firmwareNs() * 240 / 1000);
+}
+
+void EspClass::restart() {
+    fprintf(stderr, "sim: ESP.restart() at t=%lld us\n", (long long)sim::nowUs());
+    exit(3);
+}
+
+bool psramFound() {
+    return true;
+}
+
+void* ps_malloc(size_t size) {
+    if (psramAllocated + size > PSRAM_BYTES) return nullptr;
+    void* p = malloc(size);
+    if (p) psramAllocated += size;
+    return p;
+}
+
+namespace sim {
+
+void gpioDrive(int pin, int level) {
+    Pin& p = pins()[pin];
+    int before = levelOf(p);
+    p.ext = level < 0 ? -1 : (level ? HIGH : LOW);
+    setLevel(p, before);
+}
+
+int gpioLevel(int pin) {
+    return levelOf(pins()[pin]);
+}
+
+void uartReceive(int uartNr, const uint8_t* data, size_t len) {
+    if (uartNr >= 0 && uartNr < UART_COUNT && uarts[uartNr]) uarts[uartNr]->hostReceive(data, len);
+}
+
+int uartRxFifoFull(int uartNr) {
+    return uartNr >= 0 && uartNr < UART_COUNT && uarts[uartNr] ? uarts[uartNr]->rxFifoFull() : 0;
+}
+
+void setAnalogSource(std::function<uint16_t(int pin)> fn) {
+    analogSource = fn;
+}
+
+void setConsole(FILE* out) {
+    console = out;
+}
+
+void seedRandom(uint64_t seed) {
+    rngState = seed ? seed : 0x9E3779B97F4A7C15ull;
+}
+
+uint64_t psramUsed() {
+    return psramAllocated;
+}
+
+} // namespace sim
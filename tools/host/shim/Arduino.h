@@ -0,0 +1,227 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Arduino-ESP32 core API as the firmware uses it. Time is the scheduler's
+// virtual clock; pins, UARTs and the ADC are driven by the device models
+// in sim/ through the hooks at the end of this file.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+
+#include "FreeRTOS.h"
+#include "WString.h"
+
+using std::abs;
+using std::isinf;
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define IRAM_ATTR
+#define PROGMEM
+#define F(s) (s)
+
+#define LOW  0x0
+#define HIGH 0x1
+
+#define INPUT             0x01
+#define OUTPUT            0x03
+#define PULLUP            0x04
+#define INPUT_PULLUP      0x05
+#define PULLDOWN          0x08
+#define INPUT_PULLDOWN    0x09
+#define OPEN_DRAIN        0x10
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define DEC 10
+#define HEX 16
+
+#define SERIAL_8N1 0x800001c
+
+// Print / Stream
+
+class Print;
+
+class Printable {
+public:
+    virtual ~Printable() {}
+    virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+    size_t print(const Printable& x) { return x.printTo(*this); }
+
+    template <typename T> size_t println(const T& x) { return print(x) + println(); }
+    size_t println(double n, int digits) { return print(n, digits) + println(); }
+    size_t println() { return write("\r\n"); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+    unsigned long getTimeout() const { return timeoutMs; }
+
+protected:
+    unsigned long timeoutMs = 1000;
+};
+
+// UARTs. Serial (UART0) transmits at line rate through a 128-byte FIFO,
+// blocking the writer in virtual time as the ESP32 driver does without a
+// TX ring. Other ports receive what sim::uartReceive() hands them.
+
+typedef enum {
+    UART_NO_ERROR,
+    UART_BREAK_ERROR,
+    UART_BUFFER_FULL_ERROR,
+    UART_FIFO_OVF_ERROR,
+    UART_FRAME_ERROR,
+    UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+typedef std::function<void(void)> OnReceiveCb;
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uartNr);
+    ~HardwareSerial();
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end() { begun = false; }
+    size_t setRxBufferSize(size_t size);
+    size_t setTxBufferSize(size_t size) { return size; }
+    bool setRxFIFOFull(uint8_t bytes);
+    bool setRxTimeout(uint8_t symbols) { return true; }
+    void onReceive(OnReceiveCb cb, bool onlyOnTimeout = false);
+    void onReceiveError(OnReceiveErrorCb cb);
+    operator bool() const { return true; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+
+    // Host side: bytes arriving on RX (device models, via sim::uartReceive)
+    void hostReceive(const uint8_t* data, size_t len);
+    uint8_t rxFifoFull() const { return fifoFull; }
+    uint64_t txBytes() const { return txCount; }
+
+private:
+    int uartNr;
+    bool begun;
+    int64_t byteUs10;  // One 10-bit character, in 0.1 µs
+    int64_t txEndUs10; // When the FIFO runs empty, in 0.1 µs
+    uint64_t txCount;
+    uint8_t* rx;
+    size_t rxSize;
+    size_t rxHead, rxLen;
+    uint8_t fifoFull;
+    OnReceiveCb rxCb;
+    OnReceiveErrorCb errCb;
+};
+
+extern HardwareSerial Serial;
+
+// Time (virtual)
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*fn)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+// Random numbers: deterministic per run (sim::seedRandom)
+uint32_t esp_random();
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// System
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getHeapSize();
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount();
+    void restart();
+};
+extern EspClass ESP;
+
+bool psramFound();
+void* ps_malloc(size_t size);
+
+// SNTP (sim/SimNet.h starts syncing once the station is up)
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2 = nullptr,
+                const char* server3 = nullptr);
+
+namespace sim {
+
+// Device-model hooks
+void gpioDrive(int pin, int level);  // External driver (ALERT, stuck lines); -1 releases the pin
+int gpioLevel(int pin);              // What digitalRead() returns
+void uartReceive(int uartNr, const uint8_t* data, size_t len); // RX bytes, one driver event
+int uartRxFifoFull(int uartNr);      // RX event threshold the firmware set (0 = no such UART)
+void setAnalogSource(std::function<uint16_t(int pin)> fn);     // analogRead()
+void setConsole(FILE* out);          // Serial TX copy (nullptr = discard)
+void seedRandom(uint64_t seed);
+uint64_t psramUsed();
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,91 @@
+#include "FS.h"
+#include "SD_MMC.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+SDMMCFS SD_MMC;
+static std::string sdDir;
+static sim::SdCounters counters;
+
+namespace fs {
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    if (fp) counters.writes++;
+    return fp ? fwrite(buf, 1, size, fp.get()) : 0;
+}
+
+int File::available() {
+    if (!fp) return 0;
+    long pos = ftell(fp.get());
+    return (int)(size() - pos);
+}
+
+int File::read() {
+    return fp ? fgetc(fp.get()) : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+    if (fp) counters.reads++;
+    return fp ? fread(buf, 1, size, fp.get()) : 0;
+}
+
+int File::peek() {
+    if (!fp) return -1;
+    int c = fgetc(fp.get());
+    if (c != EOF) ungetc(c, fp.get());
+    return c;
+}
+
+void File::flush() {
+    if (fp) fflush(fp.get());
+}
+
+bool File::seek(uint32_t pos) {
+    return fp && fseek(fp.get(), pos, SEEK_SET) == 0;
+}
+
+size_t File::size() const {
+    struct stat st;
+    if (!fp || fstat(fileno(fp.get()), &st) != 0) return 0;
+    return (size_t)st.st_size;
+}
+
+File FS::open(const char* path, const char* mode, const bool create) {
+    if (root.empty()) return File();
+    std::string p = hostPath(path);
+    if (!strcmp(mode, FILE_READ) && access(p.c_str(), F_OK) != 0) return File();
+    counters.opens++;
+    return File(fopen(p.c_str(), !strcmp(mode, FILE_READ) ? "rb" : !strcmp(mode, FILE_WRITE) ? "wb" : "ab"));
+}
+
+bool FS::exists(const char* path) {
+    return !root.empty() && access(hostPath(path).c_str(), F_OK) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return !root.empty() && unlink(hostPath(path).c_str()) == 0;
+}
+
+bool FS::mkdir(const char* path) {
+    return !root.empty() && ::mkdir(hostPath(path).c_str(), 0755) == 0;
+}
+
+} // namespace fs
+
+bool SDMMCFS::begin(const char* mountpoint, bool mode1bit) {
+    if (sdDir.empty()) return false;
+    root = sdDir;
+    return true;
+}
+
+namespace sim {
+
+void mountSd(const char* hostDir) {
+    sdDir = hostDir ? hostDir : "";
+}
+
+SdCounters sdCounters() {
+    return counters;
+}
+
+} // namespace sim
@@ -0,0 +1,56 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+// Arduino FS over a host directory (sim::mountSd). Only what the firmware
+// uses; SD timing is not modelled.
+
+#include "Arduino.h"
+#include <memory>
+#include <string>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(FILE* f) : fp(f ? std::shared_ptr<FILE>(f, fclose) : nullptr) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    size_t read(uint8_t* buf, size_t size);
+    int peek() override;
+    void flush() override;
+    bool seek(uint32_t pos);
+    size_t size() const;
+    void close() { fp.reset(); }
+    operator bool() const { return fp != nullptr; }
+
+private:
+    std::shared_ptr<FILE> fp;
+};
+
+class FS {
+public:
+    File open(const char* path, const char* mode = FILE_READ, const bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool mkdir(const char* path);
+
+protected:
+    std::string hostPath(const char* path) const { return root + path; }
+    std::string root; // Empty: not mounted
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+#endif
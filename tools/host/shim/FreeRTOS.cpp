@@ -0,0 +1,277 @@
+#include "FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "../sim/SimKernel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <new>
+#include <vector>
+
+// Absolute deadline for a tick timeout: ticks count from the current tick
+// boundary, as the FreeRTOS tick interrupt does
+static int64_t deadline(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) return -1;
+    int64_t now = sim::nowUs();
+    return (now / 1000 + (int64_t)ticks) * 1000;
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    mux->count++;
+    sim::enterCritical();
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    mux->count--;
+    sim::exitCritical();
+}
+
+// Tasks
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stackBytes, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* handle, BaseType_t core) {
+    // The handle is stored before the new task can preempt the creator
+    sim::Task* t = sim::createTask(fn, name, stackBytes, arg, (int)prio, (int)core);
+    if (handle) *handle = t;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(void (*fn)(void*), const char* name, uint32_t stackBytes, void* arg,
+                       UBaseType_t prio, TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(fn, name, stackBytes, arg, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sim::yieldTask();
+        return;
+    }
+    sim::sleepUntil(deadline(ticks));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    TickType_t wake = *previousWake + increment;
+    TickType_t now = xTaskGetTickCount();
+    *previousWake = wake;
+    if ((int32_t)(wake - now) <= 0) {
+        sim::yieldTask();
+        return pdFALSE;
+    }
+    sim::sleepUntil((int64_t)(sim::nowUs() / 1000 + (int32_t)(wake - now)) * 1000);
+    return pdTRUE;
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    xTaskDelayUntil(previousWake, increment);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(sim::nowUs() / 1000);
+}
+
+TickType_t xTaskGetTickCountFromISR() {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return sim::currentTask();
+}
+
+// Reported against the size the firmware asked for. Host frames are wider
+// than Xtensa ones, so this is pessimistic; 0 means the host used more.
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    if (!task) task = sim::currentTask();
+    if (!task) return 0;
+    uint32_t used = sim::stackUsed(task);
+    return used < task->stackBytes ? task->stackBytes - used : 0;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    if (!task) task = sim::currentTask();
+    return task ? task->name.c_str() : "";
+}
+
+void taskYIELD() {
+    sim::yieldTask();
+}
+
+// Notifications
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    sim::Task* t = sim::currentTask();
+    if (t->notifyValue == 0) {
+        sim::wait(t->notifyWait, deadline(ticks));
+    }
+    uint32_t v = t->notifyValue;
+    if (v) t->notifyValue = clearOnExit ? 0 : v - 1;
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    if (!task) return pdFAIL;
+    task->notifyValue++;
+    sim::wakeOne(task->notifyWait);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    if (!task) return;
+    task->notifyValue++;
+    bool woke = sim::wakeOne(task->notifyWait);
+    if (higherPriorityTaskWoken && woke) *higherPriorityTaskWoken = pdTRUE;
+}
+
+// Semaphores: a count, an optional holder (mutex) and the tasks waiting
+
+struct QueueDefinition {
+    enum Kind { BINARY, COUNTING, MUTEX };
+    Kind kind;
+    UBaseType_t count;
+    UBaseType_t max;
+    bool isStatic;
+    sim::Task* holder;
+    sim::WaitList takers;
+};
+
+static_assert(sizeof(QueueDefinition) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+
+static SemaphoreHandle_t createSem(void* mem, QueueDefinition::Kind kind, UBaseType_t max, UBaseType_t initial) {
+    QueueDefinition* q = mem ? new (mem) QueueDefinition() : new QueueDefinition();
+    q->kind = kind;
+    q->count = initial;
+    q->max = max;
+    q->isStatic = mem != nullptr;
+    q->holder = nullptr;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return createSem(nullptr, QueueDefinition::BINARY, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer) {
+    return createSem(buffer, QueueDefinition::BINARY, 1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return createSem(nullptr, QueueDefinition::MUTEX, 1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial) {
+    return createSem(nullptr, QueueDefinition::COUNTING, max, initial);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    if (!sem) return;
+    if (!sem->takers.waiters.empty()) {
+        fprintf(stderr, "sim: semaphore deleted with tasks waiting on it\n");
+        abort();
+    }
+    if (sem->isStatic) {
+        sem->~QueueDefinition();
+    } else {
+        delete sem;
+    }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    int64_t until = deadline(ticks);
+    while (sem->count == 0) {
+        if (!sim::wait(sem->takers, until)) return pdFALSE;
+    }
+    sem->count--;
+    if (sem->kind == QueueDefinition::MUTEX) sem->holder = sim::currentTask();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (sem->kind == QueueDefinition::MUTEX && sem->holder != sim::currentTask()) return pdFALSE;
+    if (sem->count >= sem->max) return pdFALSE;
+    sem->count++;
+    sem->holder = nullptr;
+    sim::wakeOne(sem->takers);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t* higherPriorityTaskWoken) {
+    if (sem->count >= sem->max) return pdFALSE;
+    sem->count++;
+    bool woke = sim::wakeOne(sem->takers);
+    if (higherPriorityTaskWoken && woke) *higherPriorityTaskWoken = pdTRUE;
+    return pdTRUE;
+}
+
+// Ring buffers (no-split only, the one type the firmware uses). Space is
+// accounted as ESP-IDF does: an 8-byte header per item, data rounded up
+// to 4 bytes.
+
+#define RINGBUF_HEADER 8
+
+struct SimRingbuf {
+    size_t size;
+    size_t used;
+    std::deque<std::vector<uint8_t>> items;
+    std::vector<uint8_t> out; // Item handed out by Receive, until returned
+    bool outHeld;
+    sim::WaitList readers;
+    sim::WaitList writers;
+};
+
+static size_t itemCost(size_t len) {
+    return RINGBUF_HEADER + ((len + 3) & ~(size_t)3);
+}
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type) {
+    if (type != RINGBUF_TYPE_NOSPLIT) return nullptr;
+    SimRingbuf* r = new SimRingbuf();
+    r->size = size & ~(size_t)3;
+    r->used = 0;
+    r->outHeld = false;
+    return r;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t handle, const void* data, size_t len, TickType_t ticks) {
+    SimRingbuf* r = (SimRingbuf*)handle;
+    size_t cost = itemCost(len);
+    if (cost > r->size / 2) return pdFALSE; // Larger than xRingbufferGetMaxItemSize()
+    int64_t until = deadline(ticks);
+    while (r->size - r->used < cost) {
+        if (ticks == 0 || !sim::wait(r->writers, until)) return pdFALSE;
+    }
+    r->used += cost;
+    r->items.emplace_back((const uint8_t*)data, (const uint8_t*)data + len);
+    sim::wakeOne(r->readers);
+    return pdTRUE;
+}
+
+void* xRingbufferReceive(RingbufHandle_t handle, size_t* len, TickType_t ticks) {
+    SimRingbuf* r = (SimRingbuf*)handle;
+    int64_t until = deadline(ticks);
+    while (r->items.empty()) {
+        if (ticks == 0 || !sim::wait(r->readers, until)) return nullptr;
+    }
+    r->out.swap(r->items.front());
+    r->items.pop_front();
+    r->outHeld = true;
+    *len = r->out.size();
+    return r->out.data();
+}
+
+void vRingbufferReturnItem(RingbufHandle_t handle, void* item) {
+    SimRingbuf* r = (SimRingbuf*)handle;
+    if (!r->outHeld || item != r->out.data()) return;
+    r->outHeld = false;
+    r->used -= itemCost(r->out.size());
+    sim::wakeOne(r->writers);
+}
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t handle) {
+    SimRingbuf* r = (SimRingbuf*)handle;
+    size_t free = r->size - r->used;
+    return free > RINGBUF_HEADER ? free - RINGBUF_HEADER : 0;
+}
+
+size_t xRingbufferGetMaxItemSize(RingbufHandle_t handle) {
+    SimRingbuf* r = (SimRingbuf*)handle;
+    return r->size / 2 - RINGBUF_HEADER;
+}
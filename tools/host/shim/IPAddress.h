@@ -0,0 +1,20 @@
+#ifndef HOST_IPADDRESS_H
+#define HOST_IPADDRESS_H
+
+#include "Arduino.h"
+
+class IPAddress : public Printable {
+public:
+    IPAddress() : addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : addr((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24) {}
+    uint8_t operator[](int i) const { return (uint8_t)(addr >> (8 * i)); }
+    operator uint32_t() const { return addr; }
+    String toString() const;
+    size_t printTo(Print& p) const override;
+
+private:
+    uint32_t addr;
+};
+
+#endif
@@ -0,0 +1,552 @@
+#include "PubSubClient.h"
+#include "../sim/SimNet.h"
+#include <algorithm>
+#include <memory>
+
+static uint16_t bufferCap;
+
+PubSubClient::PubSubClient(WiFiClient& client)
+    : _client(&client), buffer(nullptr), bufferSize(0), keepAlive(MQTT_KEEPALIVE), socketTimeout(MQTT_SOCKET_TIMEOUT),
+      nextMsgId(0), lastOutActivity(0), lastInActivity(0), pingOutstanding(false), port(0), _state(MQTT_DISCONNECTED) {
+    setBufferSize(MQTT_MAX_PACKET_SIZE);
+}
+
+PubSubClient::~PubSubClient() {
+    free(buffer);
+}
+
+PubSubClient& PubSubClient::setServer(const char* d, uint16_t p) {
+    domain = d;
+    port = p;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE) {
+    this->callback = callback;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setKeepAlive(uint16_t k) {
+    keepAlive = k;
+    return *this;
+}
+
+PubSubClient& PubSubClient::setSocketTimeout(uint16_t t) {
+    socketTimeout = t;
+    return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size) {
+    if (size == 0) return false;
+    if (bufferCap && size > bufferCap) size = bufferCap;
+    uint8_t* newBuffer = (uint8_t*)realloc(buffer, size);
+    if (!newBuffer) return false;
+    buffer = newBuffer;
+    bufferSize = size;
+    return true;
+}
+
+// The library spins on available() here; the task blocks on the socket
+bool PubSubClient::waitPacket() {
+    sim::Conn* c = _client->conn();
+    int64_t deadline = ((int64_t)lastInActivity + socketTimeout * 1000LL) * 1000;
+    if (c && sim::connWait(c, deadline)) return true;
+    if (sim::nowUs() < deadline) sim::sleepUntil(deadline); // Reset: available() stays 0 until the timeout
+    return false;
+}
+
+bool PubSubClient::connect(const char* id) {
+    if (!connected()) {
+        int result = 0;
+        if (_client->connected()) {
+            result = 1;
+        } else {
+            result = _client->connect(domain.c_str(), port);
+        }
+        if (result == 1) {
+            nextMsgId = 1;
+            uint16_t length = MQTT_MAX_HEADER_SIZE;
+            const uint8_t d[7] = {0x00, 0x04, 'M', 'Q', 'T', 'T', MQTT_VERSION};
+            memcpy(buffer + length, d, sizeof(d));
+            length += sizeof(d);
+            buffer[length++] = 0x02; // Clean session
+            buffer[length++] = keepAlive >> 8;
+            buffer[length++] = keepAlive & 0xFF;
+            if (length + 2 + strnlen(id, bufferSize) > bufferSize) {
+                _client->stop();
+                return false;
+            }
+            length = writeString(id, buffer, length);
+            writeBuf(MQTTCONNECT, buffer, length - MQTT_MAX_HEADER_SIZE);
+            lastInActivity = lastOutActivity = millis();
+
+            if (!waitPacket()) {
+                _state = MQTT_CONNECTION_TIMEOUT;
+                _client->stop();
+                return false;
+            }
+            uint8_t llen;
+            uint32_t len = readPacket(&llen);
+            if (len == 4) {
+                if (buffer[3] == 0) {
+                    lastInActivity = millis();
+                    pingOutstanding = false;
+                    _state = MQTT_CONNECTED;
+                    return true;
+                }
+                _state = buffer[3];
+            }
+            _client->stop();
+        } else {
+            _state = MQTT_CONNECT_FAILED;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool PubSubClient::readByte(uint8_t* result) {
+    if (!_client->available()) {
+        sim::Conn* c = _client->conn();
+        int64_t deadline = sim::nowUs() + socketTimeout * 1000000LL;
+        if (!c || !sim::connWait(c, deadline)) return false;
+    }
+    *result = (uint8_t)_client->read();
+    return true;
+}
+
+bool PubSubClient::readByte(uint8_t* result, uint16_t* index) {
+    uint16_t current_index = *index;
+    uint8_t* write_address = &(result[current_index]);
+    if (readByte(write_address)) {
+        *index = current_index + 1;
+        return true;
+    }
+    return false;
+}
+
+uint32_t PubSubClient::readPacket(uint8_t* lengthLength) {
+    uint16_t len = 0;
+    if (!readByte(buffer, &len)) return 0;
+    bool isPublish = (buffer[0] & 0xF0) == MQTTPUBLISH;
+    uint32_t multiplier = 1;
+    uint32_t length = 0;
+    uint8_t digit = 0;
+    uint16_t skip = 0;
+    uint32_t start = 0;
+
+    do {
+        if (len == 5) {
+            // Invalid remaining length encoding - kill the connection
+            _state = MQTT_DISCONNECTED;
+            _client->stop();
+            return 0;
+        }
+        if (!readByte(&digit)) return 0;
+        buffer[len++] = digit;
+        length += (digit & 127) * multiplier;
+        multiplier <<= 7;
+    } while ((digit & 128) != 0);
+    *lengthLength = len - 1;
+
+    if (isPublish) {
+        // Read in topic length to calculate bytes to skip over for Stream writing
+        if (!readByte(buffer, &len)) return 0;
+        if (!readByte(buffer, &len)) return 0;
+        skip = (buffer[*lengthLength + 1] << 8) + buffer[*lengthLength + 2];
+        start = 2;
+        if (buffer[0] & MQTTQOS1) skip += 2; // Skip message id
+    }
+    (void)skip;
+    uint32_t idx = len;
+
+    for (uint32_t i = start; i < length; i++) {
+        if (!readByte(&digit)) return 0;
+        if (len < bufferSize) {
+            buffer[len] = digit;
+            len++;
+        }
+        idx++;
+    }
+    if (idx > bufferSize) len = 0; // This will cause the packet to be ignored.
+    return len;
+}
+
+bool PubSubClient::loop() {
+    if (connected()) {
+        unsigned long t = millis();
+        if ((t - lastInActivity > keepAlive * 1000UL) || (t - lastOutActivity > keepAlive * 1000UL)) {
+            if (pingOutstanding) {
+                _state = MQTT_CONNECTION_TIMEOUT;
+                _client->stop();
+                return false;
+            }
+            buffer[0] = MQTTPINGREQ;
+            buffer[1] = 0;
+            _client->write(buffer, 2);
+            lastOutActivity = t;
+            lastInActivity = t;
+            pingOutstanding = true;
+        }
+        if (_client->available()) {
+            uint8_t llen;
+            uint16_t len = readPacket(&llen);
+            uint8_t* payload;
+            if (len > 0) {
+                lastInActivity = t;
+                uint8_t type = buffer[0] & 0xF0;
+                if (type == MQTTPUBLISH) {
+                    if (callback) {
+                        uint16_t tl = (buffer[llen + 1] << 8) + buffer[llen + 2]; // Topic length in bytes
+                        memmove(buffer + llen + 2, buffer + llen + 3, tl); // Move topic inside buffer 1 byte to front
+                        buffer[llen + 2 + tl] = 0; // End the topic as a 'C' string with \x00
+                        char* topic = (char*)buffer + llen + 2;
+                        payload = buffer + llen + 3 + tl; // QoS 0 only
+                        callback(topic, payload, len - llen - 3 - tl);
+                    }
+                } else if (type == MQTTPINGREQ) {
+                    buffer[0] = MQTTPINGRESP;
+                    buffer[1] = 0;
+                    _client->write(buffer, 2);
+                } else if (type == MQTTPINGRESP) {
+                    pingOutstanding = false;
+                }
+            } else if (!connected()) {
+                // readPacket has closed the connection
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool PubSubClient::publish(const char* topic, const char* payload) {
+    return publish(topic, (const uint8_t*)payload, payload ? strnlen(payload, bufferSize) : 0, false);
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int plength, bool retained) {
+    if (connected()) {
+        if (bufferSize < MQTT_MAX_HEADER_SIZE + 2 + strnlen(topic, bufferSize) + plength) {
+            // Too long
+            return false;
+        }
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        length = writeString(topic, buffer, length);
+
+        // Add payload
+        for (uint16_t i = 0; i < plength; i++) buffer[length++] = payload[i];
+
+        uint8_t header = MQTTPUBLISH;
+        if (retained) header |= 1;
+        return writeBuf(header, buffer, length - MQTT_MAX_HEADER_SIZE);
+    }
+    return false;
+}
+
+bool PubSubClient::beginPublish(const char* topic, unsigned int plength, bool retained) {
+    if (connected()) {
+        // Send the header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        length = writeString(topic, buffer, length);
+        uint8_t header = MQTTPUBLISH;
+        if (retained) header |= 1;
+        size_t hlen = buildHeader(header, buffer, plength + length - MQTT_MAX_HEADER_SIZE);
+        uint16_t rc = _client->write(buffer + (MQTT_MAX_HEADER_SIZE - hlen), length - (MQTT_MAX_HEADER_SIZE - hlen));
+        lastOutActivity = millis();
+        return (rc == (length - (MQTT_MAX_HEADER_SIZE - hlen)));
+    }
+    return false;
+}
+
+int PubSubClient::endPublish() {
+    return 1;
+}
+
+size_t PubSubClient::write(uint8_t data) {
+    lastOutActivity = millis();
+    return _client->write(data);
+}
+
+size_t PubSubClient::write(const uint8_t* buf, size_t size) {
+    lastOutActivity = millis();
+    return _client->write(buf, size);
+}
+
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t* buf, uint16_t length) {
+    uint8_t lenBuf[4];
+    uint8_t llen = 0;
+    uint8_t digit;
+    uint8_t pos = 0;
+    uint16_t len = length;
+    do {
+        digit = len & 127; // digit = len %128
+        len >>= 7;         // len = len / 128
+        if (len > 0) digit |= 0x80;
+        lenBuf[pos++] = digit;
+        llen++;
+    } while (len > 0);
+
+    buf[4 - llen] = header;
+    for (int i = 0; i < llen; i++) buf[MQTT_MAX_HEADER_SIZE - llen + i] = lenBuf[i];
+    return llen + 1; // Full header size is variable length bit plus the 1-byte fixed header
+}
+
+bool PubSubClient::writeBuf(uint8_t header, uint8_t* buf, uint16_t length) {
+    uint16_t rc;
+    uint8_t hlen = buildHeader(header, buf, length);
+    rc = _client->write(buf + (MQTT_MAX_HEADER_SIZE - hlen), length + hlen);
+    lastOutActivity = millis();
+    return (rc == hlen + length);
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t qos) {
+    size_t topicLength = strnlen(topic, bufferSize);
+    if (topic == 0) return false;
+    if (qos > 1) return false;
+    if (bufferSize < 9 + topicLength) return false; // Too long
+    if (connected()) {
+        // Leave room in the buffer for header and variable length field
+        uint16_t length = MQTT_MAX_HEADER_SIZE;
+        nextMsgId++;
+        if (nextMsgId == 0) nextMsgId = 1;
+        buffer[length++] = (nextMsgId >> 8);
+        buffer[length++] = (nextMsgId & 0xFF);
+        length = writeString((char*)topic, buffer, length);
+        buffer[length++] = qos;
+        return writeBuf(MQTTSUBSCRIBE | MQTTQOS1, buffer, length - MQTT_MAX_HEADER_SIZE);
+    }
+    return false;
+}
+
+void PubSubClient::disconnect() {
+    buffer[0] = MQTTDISCONNECT;
+    buffer[1] = 0;
+    _client->write(buffer, 2);
+    _state = MQTT_DISCONNECTED;
+    _client->flush();
+    _client->stop();
+    lastInActivity = lastOutActivity = millis();
+}
+
+uint16_t PubSubClient::writeString(const char* string, uint8_t* buf, uint16_t pos) {
+    const char* idp = string;
+    uint16_t i = 0;
+    pos += 2;
+    while (*idp) {
+        buf[pos++] = *idp++;
+        i++;
+    }
+    buf[pos - i - 2] = (i >> 8);
+    buf[pos - i - 1] = (i & 0xFF);
+    return pos;
+}
+
+bool PubSubClient::connected() {
+    bool rc;
+    if (_client == NULL) {
+        rc = false;
+    } else {
+        rc = (int)_client->connected();
+        if (!rc) {
+            if (this->_state == MQTT_CONNECTED) {
+                this->_state = MQTT_CONNECTION_LOST;
+                _client->flush();
+                _client->stop();
+            }
+        } else {
+            return this->_state == MQTT_CONNECTED;
+        }
+    }
+    return rc;
+}
+
+// Broker stand-in
+
+namespace sim {
+
+namespace {
+
+struct Session {
+    ConnPtr conn;
+    std::vector<uint8_t> in;
+    std::vector<std::string> subs;
+    bool silent; // Gone quiet (blackholed or stalled): reads nothing, answers nothing
+};
+
+struct Broker {
+    Endpoint ep;
+    BrokerMode mode = BROKER_UP;
+    std::vector<std::shared_ptr<Session>> sessions;
+    std::function<void(const BrokerMessage&)> onPublish;
+    BrokerStats stats = {};
+};
+
+Broker& B() {
+    static Broker b;
+    return b;
+}
+
+void prune() {
+    std::vector<std::shared_ptr<Session>>& s = B().sessions;
+    s.erase(std::remove_if(s.begin(), s.end(),
+                           [](const std::shared_ptr<Session>& x) { return !x->conn->open || !x->conn->peerOpen; }),
+            s.end());
+}
+
+uint16_t be16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+void handlePacket(Session& s, const uint8_t* p, size_t len, size_t hdr, int64_t arrivalUs) {
+    Broker& b = B();
+    uint8_t type = p[0] & 0xF0;
+    const uint8_t* body = p + hdr;
+    size_t bodyLen = len - hdr;
+    if (type == MQTTCONNECT) {
+        if (b.mode != BROKER_UP) return;
+        const uint8_t connack[4] = {MQTTCONNACK, 2, 0, 0};
+        peerSend(s.conn.get(), connack, sizeof(connack), arrivalUs);
+        b.stats.connects++;
+    } else if (type == MQTTPUBLISH && bodyLen >= 2) {
+        uint16_t tl = be16(body);
+        if (2u + tl > bodyLen) return;
+        BrokerMessage m;
+        m.topic.assign((const char*)body + 2, tl);
+        size_t off = 2 + tl + ((p[0] & MQTTQOS1) ? 2 : 0);
+        m.payload.assign(body + off, body + bodyLen);
+        m.arrivalUs = arrivalUs;
+        b.stats.messages++;
+        b.stats.bytes += len;
+        if (b.onPublish) b.onPublish(m);
+    } else if (type == MQTTSUBSCRIBE && bodyLen >= 2) {
+        size_t off = 2;
+        while (off + 2 <= bodyLen) {
+            uint16_t tl = be16(body + off);
+            if (off + 2 + tl + 1 > bodyLen) break;
+            s.subs.emplace_back((const char*)body + off + 2, tl);
+            off += 2 + tl + 1;
+        }
+        const uint8_t suback[5] = {MQTTSUBACK, 3, body[0], body[1], 0};
+        peerSend(s.conn.get(), suback, sizeof(suback), arrivalUs);
+    } else if (type == MQTTPINGREQ) {
+        const uint8_t pingresp[2] = {MQTTPINGRESP, 0};
+        peerSend(s.conn.get(), pingresp, sizeof(pingresp), arrivalUs);
+        b.stats.pings++;
+    }
+}
+
+// Whole packets off the byte stream; the last byte of each is in this
+// chunk, so it arrived at arrivalUs
+void onBytes(Session& s, const uint8_t* data, size_t len, int64_t arrivalUs) {
+    if (s.silent) return;
+    s.in.insert(s.in.end(), data, data + len);
+    size_t pos = 0;
+    for (;;) {
+        if (s.in.size() - pos < 2) break;
+        uint32_t remaining = 0, mult = 1;
+        size_t i = pos + 1;
+        bool complete = false;
+        while (i < s.in.size() && i - pos <= 4) {
+            uint8_t d = s.in[i++];
+            remaining += (d & 127) * mult;
+            mult <<= 7;
+            if (!(d & 128)) {
+                complete = true;
+                break;
+            }
+        }
+        if (!complete) break;
+        size_t hdr = i - pos;
+        if (s.in.size() - pos < hdr + remaining) break;
+        handlePacket(s, &s.in[pos], hdr + remaining, hdr, arrivalUs);
+        pos += hdr + remaining;
+    }
+    s.in.erase(s.in.begin(), s.in.begin() + pos);
+}
+
+void accept(ConnPtr c) {
+    Broker& b = B();
+    prune();
+    std::shared_ptr<Session> s = std::make_shared<Session>();
+    s->conn = c;
+    s->silent = b.mode != BROKER_UP;
+    std::weak_ptr<Session> w = s;
+    c->onData = [w](const uint8_t* data, size_t len, int64_t arrivalUs) {
+        if (std::shared_ptr<Session> s = w.lock()) onBytes(*s, data, len, arrivalUs);
+    };
+    b.sessions.push_back(s);
+    b.stats.accepted++;
+}
+
+} // namespace
+
+void brokerListen(const char* host, uint16_t port, int64_t oneWayUs, double bps) {
+    Broker& b = B();
+    b.ep.state = ENDPOINT_UP;
+    b.ep.oneWayUs = oneWayUs;
+    b.ep.bps = bps;
+    b.ep.onAccept = accept;
+    listen(host, port, &b.ep);
+}
+
+void brokerSetMode(BrokerMode mode) {
+    Broker& b = B();
+    b.mode = mode;
+    prune();
+    switch (mode) {
+        case BROKER_UP:
+            b.ep.state = ENDPOINT_UP;
+            break;
+        case BROKER_REFUSED:
+            b.ep.state = ENDPOINT_REFUSED;
+            for (auto& s : b.sessions) peerClose(s->conn.get());
+            b.sessions.clear();
+            break;
+        case BROKER_BLACKHOLE:
+        case BROKER_STALLED:
+            b.ep.state = mode == BROKER_BLACKHOLE ? ENDPOINT_BLACKHOLE : ENDPOINT_UP;
+            for (auto& s : b.sessions) {
+                s->silent = true;
+                if (mode == BROKER_BLACKHOLE) setPeerRate(s->conn.get(), 0); // Nothing is acknowledged
+            }
+            break;
+    }
+}
+
+void brokerOnPublish(std::function<void(const BrokerMessage& m)> fn) {
+    B().onPublish = fn;
+}
+
+void brokerSend(const char* topic, const char* payload) {
+    prune();
+    size_t tl = strlen(topic), pl = strlen(payload);
+    std::vector<uint8_t> pkt;
+    pkt.push_back(MQTTPUBLISH);
+    size_t remaining = 2 + tl + pl;
+    do {
+        uint8_t d = remaining & 127;
+        remaining >>= 7;
+        pkt.push_back(remaining ? d | 0x80 : d);
+    } while (remaining);
+    pkt.push_back((uint8_t)(tl >> 8));
+    pkt.push_back((uint8_t)tl);
+    pkt.insert(pkt.end(), topic, topic + tl);
+    pkt.insert(pkt.end(), payload, payload + pl);
+    for (auto& s : B().sessions) {
+        if (s->silent) continue;
+        if (std::find(s->subs.begin(), s->subs.end(), topic) == s->subs.end()) continue;
+        peerSend(s->conn.get(), pkt.data(), pkt.size());
+    }
+}
+
+BrokerStats brokerStats() {
+    return B().stats;
+}
+
+void capMqttBuffer(uint16_t bytes) {
+    bufferCap = bytes;
+}
+
+} // namespace sim
@@ -0,0 +1,133 @@
+#ifndef HOST_PUBSUBCLIENT_H
+#define HOST_PUBSUBCLIENT_H
+
+// PubSubClient 2.8 on a WiFiClient, with the library's packet building,
+// keepalive and state codes. Waits that the library spins through (CONNACK,
+// SUBACK) block the task on the socket instead, so they take virtual time.
+// The broker at the other end is sim::Broker below.
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <string>
+#include <vector>
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_VERSION       MQTT_VERSION_3_1_1
+#define MQTT_MAX_PACKET_SIZE 256
+#define MQTT_KEEPALIVE       15
+#define MQTT_SOCKET_TIMEOUT  15
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTT_CONNECTION_TIMEOUT     -4
+#define MQTT_CONNECTION_LOST        -3
+#define MQTT_CONNECT_FAILED         -2
+#define MQTT_DISCONNECTED           -1
+#define MQTT_CONNECTED               0
+#define MQTT_CONNECT_BAD_PROTOCOL    1
+#define MQTT_CONNECT_BAD_CLIENT_ID   2
+#define MQTT_CONNECT_UNAVAILABLE     3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED    5
+
+#define MQTTCONNECT     1 << 4
+#define MQTTCONNACK     2 << 4
+#define MQTTPUBLISH     3 << 4
+#define MQTTSUBSCRIBE   8 << 4
+#define MQTTSUBACK      9 << 4
+#define MQTTPINGREQ     12 << 4
+#define MQTTPINGRESP    13 << 4
+#define MQTTDISCONNECT  14 << 4
+#define MQTTQOS1        (1 << 1)
+
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient : public Print {
+public:
+    explicit PubSubClient(WiFiClient& client);
+    ~PubSubClient();
+
+    PubSubClient& setServer(const char* domain, uint16_t port);
+    PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE);
+    PubSubClient& setKeepAlive(uint16_t keepAlive);
+    PubSubClient& setSocketTimeout(uint16_t timeout);
+    bool setBufferSize(uint16_t size);
+    uint16_t getBufferSize() { return bufferSize; }
+
+    bool connect(const char* id);
+    void disconnect();
+    bool publish(const char* topic, const char* payload);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int plength, bool retained = false);
+    bool beginPublish(const char* topic, unsigned int plength, bool retained);
+    int endPublish();
+    size_t write(uint8_t b) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    bool subscribe(const char* topic, uint8_t qos = 0);
+    bool loop();
+    bool connected();
+    int state() { return _state; }
+
+private:
+    uint32_t readPacket(uint8_t* lengthLength);
+    bool readByte(uint8_t* result);
+    bool readByte(uint8_t* result, uint16_t* index);
+    bool waitPacket(); // Until a byte arrives or the socket timeout
+    bool writeBuf(uint8_t header, uint8_t* buf, uint16_t length);
+    uint16_t writeString(const char* string, uint8_t* buf, uint16_t pos);
+    size_t buildHeader(uint8_t header, uint8_t* buf, uint16_t length);
+
+    WiFiClient* _client;
+    uint8_t* buffer;
+    uint16_t bufferSize;
+    uint16_t keepAlive;
+    uint16_t socketTimeout;
+    uint16_t nextMsgId;
+    unsigned long lastOutActivity;
+    unsigned long lastInActivity;
+    bool pingOutstanding;
+    MQTT_CALLBACK_SIGNATURE;
+    std::string domain;
+    uint16_t port;
+    int _state;
+};
+
+namespace sim {
+
+// Broker stand-in at the address the firmware connects to. Decodes the
+// client's packets off the connection, answers CONNECT/SUBSCRIBE/PINGREQ,
+// records every PUBLISH with the arrival time of its last byte, and sends
+// scripted messages to subscribers.
+enum BrokerMode {
+    BROKER_UP,
+    BROKER_REFUSED,   // Process stopped: connections refused, live ones reset
+    BROKER_BLACKHOLE, // Host unreachable: connects time out, live ones go silent
+    BROKER_STALLED,   // Accepts TCP but never answers MQTT
+};
+
+struct BrokerMessage {
+    std::string topic;
+    std::vector<uint8_t> payload;
+    int64_t arrivalUs;
+};
+
+struct BrokerStats {
+    uint64_t connects;  // CONNACKed sessions
+    uint64_t accepted;  // TCP connections accepted
+    uint64_t messages;
+    uint64_t bytes;     // Wire bytes of PUBLISH packets
+    uint64_t pings;
+};
+
+void brokerListen(const char* host, uint16_t port, int64_t oneWayUs, double bps);
+void brokerSetMode(BrokerMode mode);
+void brokerOnPublish(std::function<void(const BrokerMessage& m)> fn);
+void brokerSend(const char* topic, const char* payload); // To every session subscribed to the topic
+BrokerStats brokerStats();
+
+// setBufferSize() grants at most this many bytes (0 = no cap), so batch
+// sizes can be varied without rebuilding the firmware
+void capMqttBuffer(uint16_t bytes);
+
+} // namespace sim
+
+#endif
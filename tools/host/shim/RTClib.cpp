@@ -0,0 +1,145 @@
+#include "RTClib.h"
+
+#define DS3231_ADDRESS    0x68
+#define DS3231_TIME       0x00
+#define DS3231_STATUSREG  0x0F
+#define DS3231_STATUS_OSF 0x80
+
+static uint8_t bcd2bin(uint8_t v) {
+    return v - 6 * (v >> 4);
+}
+
+static uint8_t bin2bcd(uint8_t v) {
+    return v + 6 * (v / 10);
+}
+
+// Days since 2000-01-01 (valid 2000-2099), as the library computes them
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+    static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+    if (y >= 2000U) y -= 2000U;
+    uint16_t days = d;
+    for (uint8_t i = 1; i < m; ++i) days += daysInMonth[i - 1];
+    if (m > 2 && y % 4 == 0) ++days;
+    return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+static uint8_t conv2d(const char* p) {
+    uint8_t v = 0;
+    if ('0' <= *p && *p <= '9') v = *p - '0';
+    return 10 * v + *++p - '0';
+}
+
+DateTime::DateTime(uint32_t t) {
+    t -= SECONDS_FROM_1970_TO_2000;
+    ss = t % 60;
+    t /= 60;
+    mm = t % 60;
+    t /= 60;
+    hh = t % 24;
+    uint16_t days = t / 24;
+    uint8_t leap;
+    for (yOff = 0;; ++yOff) {
+        leap = yOff % 4 == 0;
+        if (days < 365U + leap) break;
+        days -= 365 + leap;
+    }
+    static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+    for (m = 1; m < 12; ++m) {
+        uint8_t daysPerMonth = daysInMonth[m - 1];
+        if (leap && m == 2) ++daysPerMonth;
+        if (days < daysPerMonth) break;
+        days -= daysPerMonth;
+    }
+    d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec) {
+    if (year >= 2000U) year -= 2000U;
+    yOff = year;
+    m = month;
+    d = day;
+    hh = hour;
+    mm = min;
+    ss = sec;
+}
+
+// "Mar  7 2026", "22:30:01"
+DateTime::DateTime(const char* date, const char* time) {
+    yOff = conv2d(date + 9);
+    switch (date[0]) {
+        case 'J': m = (date[1] == 'a') ? 1 : ((date[2] == 'n') ? 6 : 7); break;
+        case 'F': m = 2; break;
+        case 'A': m = date[2] == 'r' ? 4 : 8; break;
+        case 'M': m = date[2] == 'r' ? 3 : 5; break;
+        case 'S': m = 9; break;
+        case 'O': m = 10; break;
+        case 'N': m = 11; break;
+        case 'D': m = 12; break;
+        default:  m = 1; break;
+    }
+    d = conv2d(date + 4);
+    hh = conv2d(time);
+    mm = conv2d(time + 3);
+    ss = conv2d(time + 6);
+}
+
+uint8_t DateTime::dayOfTheWeek() const {
+    uint16_t day = date2days(yOff, m, d);
+    return (day + 6) % 7; // Jan 1, 2000 is a Saturday
+}
+
+uint32_t DateTime::unixtime() const {
+    uint16_t days = date2days(yOff, m, d);
+    return ((days * 24UL + hh) * 60 + mm) * 60 + ss + SECONDS_FROM_1970_TO_2000;
+}
+
+bool RTC_DS3231::readRegs(uint8_t reg, uint8_t* out, uint8_t len) {
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write(reg);
+    if (wire->endTransmission(false) != 0) return false;
+    if (wire->requestFrom((uint8_t)DS3231_ADDRESS, len) != len) return false;
+    for (uint8_t i = 0; i < len; i++) out[i] = (uint8_t)wire->read();
+    return true;
+}
+
+bool RTC_DS3231::writeRegs(const uint8_t* data, uint8_t len) {
+    wire->beginTransmission(DS3231_ADDRESS);
+    wire->write(data, len);
+    return wire->endTransmission() == 0;
+}
+
+bool RTC_DS3231::begin(TwoWire* w) {
+    wire = w;
+    wire->begin();
+    wire->beginTransmission(DS3231_ADDRESS);
+    return wire->endTransmission() == 0;
+}
+
+bool RTC_DS3231::lostPower() {
+    uint8_t status = 0;
+    readRegs(DS3231_STATUSREG, &status, 1);
+    return status & DS3231_STATUS_OSF;
+}
+
+void RTC_DS3231::adjust(const DateTime& dt) {
+    uint8_t buffer[8] = {DS3231_TIME,
+                         bin2bcd(dt.second()),
+                         bin2bcd(dt.minute()),
+                         bin2bcd(dt.hour()),
+                         bin2bcd(dt.dayOfTheWeek() ? dt.dayOfTheWeek() : 7),
+                         bin2bcd(dt.day()),
+                         bin2bcd(dt.month()),
+                         bin2bcd(dt.year() - 2000U)};
+    writeRegs(buffer, 8);
+    uint8_t status = 0;
+    readRegs(DS3231_STATUSREG, &status, 1);
+    uint8_t clear[2] = {DS3231_STATUSREG, (uint8_t)(status & ~DS3231_STATUS_OSF)};
+    writeRegs(clear, 2);
+}
+
+DateTime RTC_DS3231::now() {
+    uint8_t b[7] = {0};
+    readRegs(DS3231_TIME, b, 7);
+    return DateTime(bcd2bin(b[6]) + 2000U, bcd2bin(b[5] & 0x7F), bcd2bin(b[4]), bcd2bin(b[2]), bcd2bin(b[1]),
+                    bcd2bin(b[0] & 0x7F));
+}
@@ -0,0 +1,44 @@
+#ifndef HOST_RTCLIB_H
+#define HOST_RTCLIB_H
+
+// The part of Adafruit RTClib the firmware uses, talking to the DS3231
+// registers over Wire the way the library does
+
+#include "Wire.h"
+
+#define SECONDS_FROM_1970_TO_2000 946684800
+
+class DateTime {
+public:
+    DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+    DateTime(const char* date, const char* time); // __DATE__, __TIME__
+
+    uint16_t year() const { return 2000U + yOff; }
+    uint8_t month() const { return m; }
+    uint8_t day() const { return d; }
+    uint8_t hour() const { return hh; }
+    uint8_t minute() const { return mm; }
+    uint8_t second() const { return ss; }
+    uint8_t dayOfTheWeek() const;
+    uint32_t unixtime() const;
+
+private:
+    uint8_t yOff, m, d, hh, mm, ss;
+};
+
+class RTC_DS3231 {
+public:
+    bool begin(TwoWire* wire = &Wire);
+    bool lostPower();
+    void adjust(const DateTime& dt);
+    DateTime now();
+
+private:
+    bool readRegs(uint8_t reg, uint8_t* out, uint8_t len);
+    bool writeRegs(const uint8_t* data, uint8_t len);
+
+    TwoWire* wire = nullptr;
+};
+
+#endif
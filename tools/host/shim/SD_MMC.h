@@ -0,0 +1,29 @@
+#ifndef HOST_SD_MMC_H
+#define HOST_SD_MMC_H
+
+#include "FS.h"
+
+class SDMMCFS : public fs::FS {
+public:
+    bool setPins(int clk, int cmd, int d0) { return true; }
+    bool begin(const char* mountpoint = "/sdcard", bool mode1bit = false);
+    void end() { root.clear(); }
+};
+
+extern SDMMCFS SD_MMC;
+
+namespace sim {
+
+// Card contents live in this host directory; without it begin() fails as
+// with no card inserted
+void mountSd(const char* hostDir);
+
+// File opens and read/write calls since start, to check access patterns
+struct SdCounters {
+    uint64_t opens, reads, writes;
+};
+SdCounters sdCounters();
+
+} // namespace sim
+
+#endif
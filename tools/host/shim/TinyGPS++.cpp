@@ -0,0 +1,125 @@
+#include "TinyGPS++.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FIELDS 24
+
+TinyGPSCustom::TinyGPSCustom(TinyGPSPlus& gps, const char* name, int term) {
+    begin(gps, name, term);
+}
+
+void TinyGPSCustom::begin(TinyGPSPlus& gps, const char* name, int term) {
+    sentenceName = name;
+    termNumber = term;
+    next = gps.customs;
+    gps.customs = this;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// ddmm.mmmm / dddmm.mmmm to signed degrees
+static double parseDegrees(const char* term, const char* hemisphere) {
+    double v = atof(term);
+    int deg = (int)(v / 100);
+    double d = deg + (v - deg * 100) / 60.0;
+    if (hemisphere[0] == 'S' || hemisphere[0] == 'W') d = -d;
+    return d;
+}
+
+// hhmmss.ss to hhmmsscc
+static uint32_t parseTime(const char* term) {
+    double v = atof(term);
+    return (uint32_t)(v * 100 + 0.5);
+}
+
+static bool isSentence(const char* name, const char* type) {
+    return (name[0] == 'G' && (name[1] == 'P' || name[1] == 'N')) && !strcmp(name + 2, type);
+}
+
+bool TinyGPSPlus::encode(char c) {
+    encodedChars++;
+    if (c == '$') {
+        sentenceLen = 0;
+        inSentence = true;
+        return false;
+    }
+    if (!inSentence) return false;
+    if (c == '\r' || c == '\n') {
+        inSentence = false;
+        return endOfSentence();
+    }
+    if (sentenceLen >= _GPS_MAX_SENTENCE) {
+        inSentence = false; // Overlong: dropped like a bad checksum
+        failedChecksumCount++;
+        return false;
+    }
+    sentence[sentenceLen++] = c;
+    return false;
+}
+
+bool TinyGPSPlus::endOfSentence() {
+    sentence[sentenceLen] = '\0';
+    char* star = strchr(sentence, '*');
+    if (!star || sentenceLen - (star - sentence) < 3) return false; // No checksum term: ignored
+    uint8_t sum = 0;
+    for (char* p = sentence; p < star; p++) sum ^= (uint8_t)*p;
+    int hi = hexValue(star[1]), lo = hexValue(star[2]);
+    if (hi < 0 || lo < 0 || sum != (uint8_t)(hi << 4 | lo)) {
+        failedChecksumCount++;
+        return false;
+    }
+    passedChecksumCount++;
+    *star = '\0';
+
+    char* fields[MAX_FIELDS];
+    int count = 0;
+    char* p = sentence;
+    while (count < MAX_FIELDS) {
+        fields[count++] = p;
+        char* comma = strchr(p, ',');
+        if (!comma) break;
+        *comma = '\0';
+        p = comma + 1;
+    }
+    commit(fields, count);
+    return true;
+}
+
+void TinyGPSPlus::commit(char** f, int count) {
+    const char* name = f[0];
+    if (isSentence(name, "RMC") && count > 9) {
+        // The library commits time and date whether or not the fields are
+        // filled; callers check the date before trusting them
+        time.time = parseTime(f[1]);
+        time.valid = time.updated = true;
+        date.date = (uint32_t)atol(f[9]);
+        date.valid = date.updated = true;
+        if (f[2][0] == 'A') {
+            location.latDeg = parseDegrees(f[3], f[4]);
+            location.lngDeg = parseDegrees(f[5], f[6]);
+            location.valid = location.updated = true;
+        }
+    } else if (isSentence(name, "GGA") && count > 7) {
+        time.time = parseTime(f[1]);
+        time.valid = time.updated = true;
+        if (f[6][0] > '0') {
+            location.latDeg = parseDegrees(f[2], f[3]);
+            location.lngDeg = parseDegrees(f[4], f[5]);
+            location.valid = location.updated = true;
+        }
+        satellites.val = (uint32_t)atol(f[7]);
+        satellites.valid = satellites.updated = true;
+    }
+
+    for (TinyGPSCustom* c = customs; c; c = c->next) {
+        if (strcmp(name, c->sentenceName) || c->termNumber >= count) continue;
+        strncpy(c->buffer, f[c->termNumber], _GPS_MAX_FIELD_SIZE);
+        c->buffer[_GPS_MAX_FIELD_SIZE] = '\0';
+        c->valid = c->updated = true;
+    }
+}
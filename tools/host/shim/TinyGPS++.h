@@ -0,0 +1,117 @@
+#ifndef HOST_TINYGPS_PLUS_H
+#define HOST_TINYGPS_PLUS_H
+
+// The part of TinyGPS++ the firmware uses, with the library's commit
+// rules: nothing changes until a sentence's checksum passes; RMC commits
+// date and time (location only with status A), GGA commits time,
+// satellites and, with a fix, location. Reading a value clears its
+// updated flag.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define _GPS_MAX_FIELD_SIZE 15
+#define _GPS_MAX_SENTENCE   120
+
+class TinyGPSPlus;
+
+class TinyGPSLocation {
+public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    double lat() { updated = false; return latDeg; }
+    double lng() { updated = false; return lngDeg; }
+
+private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    double latDeg = 0.0, lngDeg = 0.0;
+};
+
+class TinyGPSDate {
+public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint16_t year() { updated = false; return 2000 + date % 100; }
+    uint8_t month() { updated = false; return (date / 100) % 100; }
+    uint8_t day() { updated = false; return date / 10000; }
+
+private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t date = 0; // ddmmyy
+};
+
+class TinyGPSTime {
+public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint8_t hour() { updated = false; return time / 1000000; }
+    uint8_t minute() { updated = false; return (time / 10000) % 100; }
+    uint8_t second() { updated = false; return (time / 100) % 100; }
+    uint8_t centisecond() { updated = false; return time % 100; }
+
+private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t time = 0; // hhmmsscc
+};
+
+class TinyGPSInteger {
+public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t value() { updated = false; return val; }
+
+private:
+    friend class TinyGPSPlus;
+    bool valid = false, updated = false;
+    uint32_t val = 0;
+};
+
+class TinyGPSCustom {
+public:
+    TinyGPSCustom() {}
+    TinyGPSCustom(TinyGPSPlus& gps, const char* sentenceName, int termNumber);
+    void begin(TinyGPSPlus& gps, const char* sentenceName, int termNumber);
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    const char* value() { updated = false; return buffer; }
+
+private:
+    friend class TinyGPSPlus;
+    const char* sentenceName = nullptr;
+    int termNumber = 0;
+    bool valid = false, updated = false;
+    char buffer[_GPS_MAX_FIELD_SIZE + 1] = {0};
+    TinyGPSCustom* next = nullptr;
+};
+
+class TinyGPSPlus {
+public:
+    bool encode(char c); // true when a sentence with a good checksum was committed
+
+    TinyGPSLocation location;
+    TinyGPSDate date;
+    TinyGPSTime time;
+    TinyGPSInteger satellites;
+
+    uint32_t charsProcessed() const { return encodedChars; }
+    uint32_t failedChecksum() const { return failedChecksumCount; }
+    uint32_t passedChecksum() const { return passedChecksumCount; }
+
+private:
+    friend class TinyGPSCustom;
+    bool endOfSentence();
+    void commit(char** fields, int count);
+
+    char sentence[_GPS_MAX_SENTENCE + 1];
+    size_t sentenceLen = 0;
+    bool inSentence = false;
+    uint32_t encodedChars = 0;
+    uint32_t failedChecksumCount = 0;
+    uint32_t passedChecksumCount = 0;
+    TinyGPSCustom* customs = nullptr;
+};
+
+#endif
@@ -0,0 +1,439 @@
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static sim::StringStats stats;
+
+namespace sim {
+
+StringStats stringStats() {
+    return stats;
+}
+
+void resetStringStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+} // namespace sim
+
+static void formatInt(char* out, size_t size, unsigned long long v, bool negative, unsigned char base) {
+    char tmp[72];
+    size_t n = 0;
+    if (base < 2 || base > 36) base = 10;
+    do {
+        unsigned d = (unsigned)(v % base);
+        tmp[n++] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+        v /= base;
+    } while (v);
+    size_t i = 0;
+    if (negative && i + 1 < size) out[i++] = '-';
+    while (n && i + 1 < size) out[i++] = tmp[--n];
+    out[i] = '\0';
+}
+
+// Signed values print with a sign in base 10 only, as in the core
+static void formatSigned(char* out, size_t size, long long v, unsigned char base) {
+    if (base == 10 && v < 0) {
+        formatInt(out, size, 0ULL - (unsigned long long)v, true, base);
+    } else {
+        formatInt(out, size, (unsigned long long)v, false, base);
+    }
+}
+
+void String::init() {
+    sso = true;
+    capacity = SSO_CAPACITY;
+    len = 0;
+    inlineBuf[0] = '\0';
+}
+
+void String::invalidate() {
+    if (!sso && heap) {
+        free(heap);
+        stats.frees++;
+    }
+    init();
+}
+
+// Grows to exactly maxStrLen characters; the core's reserve() policy
+bool String::changeBuffer(unsigned int maxStrLen) {
+    if (maxStrLen <= SSO_CAPACITY && sso) return true;
+    if (sso) {
+        char* p = (char*)malloc(maxStrLen + 1);
+        if (!p) return false;
+        stats.mallocs++;
+        stats.bytes += maxStrLen + 1;
+        memcpy(p, inlineBuf, len + 1);
+        heap = p;
+        sso = false;
+    } else {
+        char* p = (char*)realloc(heap, maxStrLen + 1);
+        if (!p) return false;
+        stats.reallocs++;
+        stats.bytes += maxStrLen + 1;
+        heap = p;
+    }
+    capacity = maxStrLen;
+    return true;
+}
+
+bool String::reserve(unsigned int size) {
+    if (size <= capacity) return true;
+    return changeBuffer(size);
+}
+
+String& String::copy(const char* cstr, unsigned int length) {
+    if (!reserve(length)) {
+        invalidate();
+        return *this;
+    }
+    len = length;
+    memmove(buffer(), cstr, length);
+    buffer()[len] = '\0';
+    return *this;
+}
+
+void String::move(String& rhs) {
+    invalidate();
+    if (rhs.sso) {
+        memcpy(inlineBuf, rhs.inlineBuf, rhs.len + 1);
+    } else {
+        heap = rhs.heap;
+        sso = false;
+    }
+    capacity = rhs.capacity;
+    len = rhs.len;
+    rhs.init();
+}
+
+String::String(const char* cstr) {
+    init();
+    if (cstr) copy(cstr, (unsigned int)strlen(cstr));
+}
+
+String::String(const char* cstr, unsigned int length) {
+    init();
+    if (cstr) copy(cstr, length);
+}
+
+String::String(const String& str) {
+    init();
+    copy(str.buffer(), str.len);
+}
+
+String::String(String&& rval) {
+    init();
+    move(rval);
+}
+
+String::String(char c) {
+    init();
+    char buf[2] = {c, '\0'};
+    copy(buf, 1);
+}
+
+String::String(unsigned char value, unsigned char base) {
+    init();
+    char buf[72];
+    formatInt(buf, sizeof(buf), value, false, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(int value, unsigned char base) {
+    init();
+    char buf[72];
+    formatSigned(buf, sizeof(buf), value, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(unsigned int value, unsigned char base) {
+    init();
+    char buf[72];
+    formatInt(buf, sizeof(buf), value, false, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(long value, unsigned char base) {
+    init();
+    char buf[72];
+    formatSigned(buf, sizeof(buf), value, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) {
+    init();
+    char buf[72];
+    formatInt(buf, sizeof(buf), value, false, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(long long value, unsigned char base) {
+    init();
+    char buf[72];
+    formatSigned(buf, sizeof(buf), value, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(unsigned long long value, unsigned char base) {
+    init();
+    char buf[72];
+    formatInt(buf, sizeof(buf), value, false, base);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+// dtostrf(): fixed point, no exponent
+String::String(float value, unsigned int decimalPlaces) {
+    init();
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, (double)value);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::String(double value, unsigned int decimalPlaces) {
+    init();
+    char buf[340];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimalPlaces, value);
+    copy(buf, (unsigned int)strlen(buf));
+}
+
+String::~String() {
+    invalidate();
+}
+
+String& String::operator=(const String& rhs) {
+    if (this == &rhs) return *this;
+    return copy(rhs.buffer(), rhs.len);
+}
+
+String& String::operator=(const char* cstr) {
+    if (!cstr) {
+        invalidate();
+        return *this;
+    }
+    return copy(cstr, (unsigned int)strlen(cstr));
+}
+
+String& String::operator=(String&& rval) {
+    if (this != &rval) move(rval);
+    return *this;
+}
+
+bool String::concat(const char* cstr, unsigned int length) {
+    if (!cstr) return false;
+    if (length == 0) return true;
+    unsigned int newlen = len + length;
+    // Appending a piece of ourselves: the buffer may move on reserve()
+    if (cstr >= buffer() && cstr < buffer() + len) {
+        size_t offset = cstr - buffer();
+        if (!reserve(newlen)) return false;
+        cstr = buffer() + offset;
+    } else if (!reserve(newlen)) {
+        return false;
+    }
+    memmove(buffer() + len, cstr, length);
+    len = newlen;
+    buffer()[len] = '\0';
+    return true;
+}
+
+bool String::concat(const String& s) {
+    return concat(s.buffer(), s.len);
+}
+
+bool String::concat(const char* cstr) {
+    return cstr && concat(cstr, (unsigned int)strlen(cstr));
+}
+
+bool String::concat(char c) {
+    return concat(&c, 1);
+}
+
+bool String::concat(unsigned char num) {
+    char buf[8];
+    formatInt(buf, sizeof(buf), num, false, 10);
+    return concat(buf);
+}
+
+bool String::concat(int num) {
+    char buf[16];
+    formatSigned(buf, sizeof(buf), num, 10);
+    return concat(buf);
+}
+
+bool String::concat(unsigned int num) {
+    char buf[16];
+    formatInt(buf, sizeof(buf), num, false, 10);
+    return concat(buf);
+}
+
+bool String::concat(long num) {
+    char buf[24];
+    formatSigned(buf, sizeof(buf), num, 10);
+    return concat(buf);
+}
+
+bool String::concat(unsigned long num) {
+    char buf[24];
+    formatInt(buf, sizeof(buf), num, false, 10);
+    return concat(buf);
+}
+
+bool String::concat(float num) {
+    return concat(String(num));
+}
+
+bool String::concat(double num) {
+    return concat(String(num));
+}
+
+// Chained + grows the left temporary in place
+StringSumHelper& operator+(const StringSumHelper& lhs, const String& rhs) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(rhs)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, const char* cstr) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!cstr || !a.concat(cstr)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, char c) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(c)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, int num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, unsigned int num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, long num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, unsigned long num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, float num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+StringSumHelper& operator+(const StringSumHelper& lhs, double num) {
+    StringSumHelper& a = const_cast<StringSumHelper&>(lhs);
+    if (!a.concat(num)) a.invalidate();
+    return a;
+}
+
+int String::compareTo(const String& s) const {
+    return strcmp(buffer(), s.buffer());
+}
+
+bool String::equals(const String& s) const {
+    return len == s.len && compareTo(s) == 0;
+}
+
+bool String::equals(const char* cstr) const {
+    if (!cstr) return len == 0;
+    return strcmp(buffer(), cstr) == 0;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    return len == s.len && strcasecmp(buffer(), s.buffer()) == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return prefix.len <= len && strncmp(buffer(), prefix.buffer(), prefix.len) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return suffix.len <= len && strcmp(buffer() + len - suffix.len, suffix.buffer()) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+    return index < len ? buffer()[index] : 0;
+}
+
+char String::operator[](unsigned int index) const {
+    return charAt(index);
+}
+
+char& String::operator[](unsigned int index) {
+    static char dummy;
+    if (index >= len) {
+        dummy = 0;
+        return dummy;
+    }
+    return buffer()[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    if (fromIndex >= len) return -1;
+    const char* p = strchr(buffer() + fromIndex, ch);
+    return p ? (int)(p - buffer()) : -1;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    if (fromIndex >= len) return -1;
+    const char* p = strstr(buffer() + fromIndex, str.buffer());
+    return p ? (int)(p - buffer()) : -1;
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int t = beginIndex;
+        beginIndex = endIndex;
+        endIndex = t;
+    }
+    if (beginIndex >= len) return String();
+    if (endIndex > len) endIndex = len;
+    return String(buffer() + beginIndex, endIndex - beginIndex);
+}
+
+void String::toLowerCase() {
+    for (char* p = buffer(); *p; p++) *p = (char)tolower((unsigned char)*p);
+}
+
+void String::toUpperCase() {
+    for (char* p = buffer(); *p; p++) *p = (char)toupper((unsigned char)*p);
+}
+
+void String::trim() {
+    char* b = buffer();
+    unsigned int begin = 0, end = len;
+    while (begin < end && isspace((unsigned char)b[begin])) begin++;
+    while (end > begin && isspace((unsigned char)b[end - 1])) end--;
+    len = end - begin;
+    if (begin) memmove(b, b + begin, len);
+    b[len] = '\0';
+}
+
+long String::toInt() const {
+    return atol(buffer());
+}
+
+float String::toFloat() const {
+    return (float)atof(buffer());
+}
+
+double String::toDouble() const {
+    return atof(buffer());
+}
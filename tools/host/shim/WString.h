@@ -0,0 +1,143 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+// Arduino String with the ESP32 core's storage behaviour: up to 11
+// characters live inline (SSO, as on the 32-bit target), longer strings
+// are heap buffers grown with realloc() to exactly the length needed, and
+// operator+ chains through StringSumHelper, growing the left operand in
+// place. Heap calls are counted (sim::stringStats()) so the JSON encoders
+// can be compared against the String code they replaced.
+
+#include <stdint.h>
+#include <stddef.h>
+
+class StringSumHelper;
+
+class String {
+public:
+    String(const char* cstr = "");
+    String(const char* cstr, unsigned int length);
+    String(const String& str);
+    String(String&& rval);
+    explicit String(char c);
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+    explicit String(double value, unsigned int decimalPlaces = 2);
+    ~String();
+
+    bool reserve(unsigned int size); // false on allocation failure
+    unsigned int length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+    const char* c_str() const { return buffer(); }
+
+    String& operator=(const String& rhs);
+    String& operator=(const char* cstr);
+    String& operator=(String&& rval);
+
+    bool concat(const String& str);
+    bool concat(const char* cstr);
+    bool concat(const char* cstr, unsigned int length);
+    bool concat(char c);
+    bool concat(unsigned char num);
+    bool concat(int num);
+    bool concat(unsigned int num);
+    bool concat(long num);
+    bool concat(unsigned long num);
+    bool concat(float num);
+    bool concat(double num);
+
+    template <typename T> String& operator+=(const T& rhs) {
+        concat(rhs);
+        return *this;
+    }
+
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, const String& rhs);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, const char* cstr);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, char c);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, int num);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, unsigned int num);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, long num);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, unsigned long num);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, float num);
+    friend StringSumHelper& operator+(const StringSumHelper& lhs, double num);
+
+    int compareTo(const String& s) const;
+    bool equals(const String& s) const;
+    bool equals(const char* cstr) const;
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const;
+    char& operator[](unsigned int index);
+    int indexOf(char ch, unsigned int fromIndex = 0) const;
+    int indexOf(const String& str, unsigned int fromIndex = 0) const;
+    String substring(unsigned int beginIndex) const { return substring(beginIndex, len); }
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+private:
+    enum { SSO_CAPACITY = 11 }; // Characters, as sizeof(ptr + cap + len) - 1 on the ESP32
+
+    char* buffer() { return sso ? inlineBuf : heap; }
+    const char* buffer() const { return sso ? inlineBuf : heap; }
+    void init();
+    void invalidate();
+    bool changeBuffer(unsigned int maxStrLen);
+    String& copy(const char* cstr, unsigned int length);
+    void move(String& rhs);
+
+    union {
+        char inlineBuf[SSO_CAPACITY + 1];
+        char* heap;
+    };
+    unsigned int capacity; // Characters, excluding the terminator
+    unsigned int len;
+    bool sso;
+};
+
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* p) : String(p) {}
+    StringSumHelper(char c) : String(c) {}
+    StringSumHelper(int num) : String(num) {}
+    StringSumHelper(unsigned int num) : String(num) {}
+    StringSumHelper(long num) : String(num) {}
+    StringSumHelper(unsigned long num) : String(num) {}
+    StringSumHelper(float num) : String(num) {}
+    StringSumHelper(double num) : String(num) {}
+};
+
+namespace sim {
+
+// Heap traffic of every String since start (or the last reset)
+struct StringStats {
+    uint64_t mallocs;  // New buffers
+    uint64_t reallocs; // Buffers grown
+    uint64_t frees;
+    uint64_t bytes;    // Requested by mallocs and reallocs
+};
+StringStats stringStats();
+void resetStringStats();
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,270 @@
+#include "WebServer.h"
+#include "../sim/SimNet.h"
+#include <deque>
+
+namespace {
+
+struct Pending {
+    std::shared_ptr<sim::HttpClientModel> client;
+    sim::ConnPtr conn;
+};
+
+std::deque<Pending> pending;
+sim::HttpStats stats;
+
+std::string urlDecode(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '+') {
+            out += ' ';
+        } else if (s[i] == '%' && i + 2 < s.size()) {
+            out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+// Client side of the response: status line and headers, then the body,
+// de-chunked if needed
+void clientReceive(sim::HttpClientModel& c, const uint8_t* data, size_t len, int64_t arrivalUs) {
+    size_t i = 0;
+    if (!c.inBody) {
+        while (i < len && !c.inBody) {
+            c.head += (char)data[i++];
+            if (c.head.size() >= 4 && !c.head.compare(c.head.size() - 4, 4, "\r\n\r\n")) {
+                c.inBody = true;
+                c.headUs = arrivalUs;
+                c.status = c.head.size() > 12 ? atoi(c.head.c_str() + 9) : 0;
+                c.isChunked = c.head.find("Transfer-Encoding: chunked") != std::string::npos;
+            }
+        }
+    }
+    while (i < len) {
+        if (!c.isChunked) {
+            c.bodyBytes += len - i;
+            if (c.onBody) c.onBody(c, (const char*)data + i, len - i, arrivalUs);
+            return;
+        }
+        if (c.chunkState == 0) { // Size line
+            char ch = (char)data[i++];
+            if (ch == '\n') {
+                c.chunkLeft = strtoul(c.chunkLine.c_str(), nullptr, 16);
+                c.chunkLine.clear();
+                c.chunkState = c.chunkLeft ? 1 : 3;
+            } else if (ch != '\r') {
+                c.chunkLine += ch;
+            }
+        } else if (c.chunkState == 1) { // Data
+            size_t n = len - i < c.chunkLeft ? len - i : c.chunkLeft;
+            c.bodyBytes += n;
+            if (c.onBody) c.onBody(c, (const char*)data + i, n, arrivalUs);
+            i += n;
+            c.chunkLeft -= n;
+            if (!c.chunkLeft) c.chunkState = 2;
+        } else if (c.chunkState == 2) { // CRLF after the data
+            if (data[i++] == '\n') c.chunkState = 0;
+        } else {
+            i = len; // Trailer
+        }
+    }
+}
+
+} // namespace
+
+WebServer::WebServer(int port) : started(false), contentLength_(CONTENT_LENGTH_NOT_SET), chunked(false) {
+}
+
+void WebServer::begin() {
+    started = true;
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+    routes.push_back(Route{uri.c_str(), method, fn});
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    collect.clear();
+    for (size_t i = 0; i < headerKeysCount; i++) collect.push_back(headerKeys[i]);
+}
+
+String WebServer::arg(const String& name) {
+    for (const Pair& p : args) {
+        if (p.key == name.c_str()) return String(p.value.c_str());
+    }
+    return String();
+}
+
+bool WebServer::hasArg(const String& name) {
+    for (const Pair& p : args) {
+        if (p.key == name.c_str()) return true;
+    }
+    return false;
+}
+
+String WebServer::header(const String& name) {
+    for (const Pair& p : headers) {
+        if (!strcasecmp(p.key.c_str(), name.c_str())) return String(p.value.c_str());
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) {
+    for (const Pair& p : headers) {
+        if (!strcasecmp(p.key.c_str(), name.c_str())) return true;
+    }
+    return false;
+}
+
+void WebServer::handleClient() {
+    if (!started || pending.empty()) return;
+    if (pending.size() > stats.pendingMax) stats.pendingMax = pending.size();
+    Pending p = pending.front();
+    pending.pop_front();
+    if (!p.conn->peerOpen) return; // Gave up before it was accepted
+
+    currentClient = WiFiClient(p.conn);
+    p.conn.reset();
+    std::string uri = p.client->uri;
+    size_t q = uri.find('?');
+    currentUri = String(uri.substr(0, q).c_str());
+    args.clear();
+    if (q != std::string::npos) {
+        std::string query = uri.substr(q + 1);
+        size_t pos = 0;
+        while (pos <= query.size()) {
+            size_t amp = query.find('&', pos);
+            std::string kv = query.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos);
+            size_t eq = kv.find('=');
+            if (!kv.empty()) {
+                args.push_back(Pair{urlDecode(kv.substr(0, eq)), eq == std::string::npos ? "" : urlDecode(kv.substr(eq + 1))});
+            }
+            if (amp == std::string::npos) break;
+            pos = amp + 1;
+        }
+    }
+    headers.clear();
+    for (auto& h : p.client->headers) {
+        for (const std::string& k : collect) {
+            if (!strcasecmp(k.c_str(), h.first.c_str())) headers.push_back(Pair{h.first, h.second});
+        }
+    }
+
+    bool handled = false;
+    for (Route& r : routes) {
+        if (r.uri == currentUri.c_str() && (r.method == HTTP_ANY || r.method == HTTP_GET)) {
+            r.fn();
+            handled = true;
+            break;
+        }
+    }
+    if (!handled) send(404, "text/plain", String("Not found: ") + currentUri);
+    if (chunked) sendContent("", 0);
+    stats.served++;
+
+    currentClient = WiFiClient(); // Connection: close
+    contentLength_ = CONTENT_LENGTH_NOT_SET;
+    pendingHeaders.clear();
+}
+
+const char* WebServer::responseCodeText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    if (first) {
+        pendingHeaders = line + pendingHeaders;
+    } else {
+        pendingHeaders += line;
+    }
+}
+
+void WebServer::sendResponseHead(int code, const char* contentType, size_t contentLength) {
+    std::string head = "HTTP/1.1 " + std::to_string(code) + " " + responseCodeText(code) + "\r\n";
+    head += std::string("Content-Type: ") + (contentType ? contentType : "text/html") + "\r\n";
+    if (contentLength_ == CONTENT_LENGTH_NOT_SET) {
+        head += "Content-Length: " + std::to_string(contentLength) + "\r\n";
+    } else if (contentLength_ != CONTENT_LENGTH_UNKNOWN) {
+        head += "Content-Length: " + std::to_string(contentLength_) + "\r\n";
+    } else {
+        chunked = true;
+        head += "Accept-Ranges: none\r\nTransfer-Encoding: chunked\r\n";
+    }
+    head += "Connection: close\r\n";
+    head += pendingHeaders;
+    head += "\r\n";
+    pendingHeaders.clear();
+    currentClient.write((const uint8_t*)head.data(), head.size());
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    sendResponseHead(code, contentType, content.length());
+    if (content.length()) sendContent(content);
+}
+
+void WebServer::send_P(int code, const char* contentType, const char* content, size_t contentLength) {
+    sendResponseHead(code, contentType, contentLength);
+    currentClient.write((const uint8_t*)content, contentLength);
+}
+
+void WebServer::sendContent(const char* content, size_t contentLength) {
+    if (chunked) {
+        char len[12];
+        int n = snprintf(len, sizeof(len), "%x\r\n", (unsigned)contentLength);
+        currentClient.write((const uint8_t*)len, n);
+    }
+    if (contentLength) currentClient.write((const uint8_t*)content, contentLength);
+    if (chunked) {
+        currentClient.write((const uint8_t*)"\r\n", 2);
+        if (contentLength == 0) chunked = false;
+    }
+}
+
+namespace sim {
+
+std::shared_ptr<HttpClientModel> httpGet(int64_t atUs, std::shared_ptr<HttpClientModel> c) {
+    stats.requests++;
+    c->sentUs = atUs;
+    at(atUs + c->oneWayUs, [c] {
+        ConnPtr conn = openConn(false, c->oneWayUs, c->bps);
+        c->conn = conn;
+        HttpClientModel* raw = c.get();
+        conn->onData = [raw](const uint8_t* data, size_t len, int64_t arrivalUs) {
+            clientReceive(*raw, data, len, arrivalUs);
+        };
+        conn->onClose = [c](int64_t lastUs) {
+            c->done = true;
+            c->doneUs = lastUs;
+            if (c->onDone) c->onDone(*c);
+        };
+        pending.push_back(Pending{c, conn});
+    });
+    return c;
+}
+
+void httpClose(HttpClientModel& c) {
+    if (ConnPtr conn = c.conn.lock()) peerClose(conn.get());
+    c.done = true;
+}
+
+void httpSetRate(HttpClientModel& c, double bps) {
+    if (ConnPtr conn = c.conn.lock()) setPeerRate(conn.get(), bps);
+}
+
+HttpStats httpStats() {
+    return stats;
+}
+
+} // namespace sim
@@ -0,0 +1,113 @@
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+// Arduino-ESP32 WebServer serving the scripted clients of sim::httpGet().
+// One request is taken per handleClient() call, the handler runs, and the
+// server drops its reference to the connection (Connection: close), so a
+// handler that kept a WiFiClient copy keeps the socket open.
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <string>
+#include <vector>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+typedef enum { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS } HTTPMethod;
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80);
+
+    void begin();
+    void handleClient();
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn);
+    void on(const String& uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+
+    String arg(const String& name);
+    bool hasArg(const String& name);
+    String header(const String& name);
+    bool hasHeader(const String& name);
+    String uri() { return currentUri; }
+    WiFiClient client() { return currentClient; }
+
+    void send(int code, const char* contentType = nullptr, const String& content = String(""));
+    void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+    void send_P(int code, const char* contentType, const char* content, size_t contentLength);
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t contentLength) { contentLength_ = contentLength; }
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t contentLength);
+
+private:
+    struct Route {
+        std::string uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+    };
+    struct Pair {
+        std::string key, value;
+    };
+
+    void sendResponseHead(int code, const char* contentType, size_t contentLength);
+    static const char* responseCodeText(int code);
+
+    bool started;
+    std::vector<Route> routes;
+    std::vector<std::string> collect;
+    WiFiClient currentClient;
+    String currentUri;
+    std::vector<Pair> args, headers;
+    std::string pendingHeaders;
+    size_t contentLength_;
+    bool chunked;
+};
+
+namespace sim {
+
+// A dashboard client on the SoftAP. The request reaches the server one way
+// after `at`; the response comes back at `bps`. onBody gets body bytes with
+// their arrival time (after the chunked framing is removed); onDone fires
+// when the server closes, with the arrival time of the last byte.
+struct HttpClientModel {
+    std::string uri;
+    std::vector<std::pair<std::string, std::string>> headers;
+    int64_t oneWayUs = 3000;
+    double bps = 500000;
+
+    int status = 0;
+    uint64_t bodyBytes = 0;
+    int64_t sentUs = 0, headUs = 0, doneUs = 0;
+    bool done = false;
+
+    std::function<void(HttpClientModel& c, const char* data, size_t len, int64_t arrivalUs)> onBody;
+    std::function<void(HttpClientModel& c)> onDone;
+
+    // Internal
+    std::string head;
+    bool inBody = false, isChunked = false;
+    size_t chunkLeft = 0;
+    int chunkState = 0;
+    std::string chunkLine;
+    std::weak_ptr<Conn> conn;
+};
+
+// Queues the request at `atUs` (>= now)
+std::shared_ptr<HttpClientModel> httpGet(int64_t atUs, std::shared_ptr<HttpClientModel> c);
+void httpClose(HttpClientModel& c);                // Client goes away (tab closed)
+void httpSetRate(HttpClientModel& c, double bps);  // 0 = stops reading (tab in background)
+
+struct HttpStats {
+    uint64_t requests;
+    uint64_t served;
+    uint64_t pendingMax; // Longest request queue seen by handleClient()
+};
+HttpStats httpStats();
+
+} // namespace sim
+
+#endif
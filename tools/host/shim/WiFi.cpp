@@ -0,0 +1,252 @@
+#include "WiFi.h"
+#include "esp_sntp.h"
+#include "esp_wifi.h"
+#include "esp_eap_client.h"
+#include "lwip/sockets.h"
+#include "../sim/SimNet.h"
+#include <vector>
+
+#define WIFI_CLIENT_WRITE_LIMIT_MS 10000 // WIFI_CLIENT_MAX_WRITE_RETRY × select timeout
+
+WiFiClass WiFi;
+
+// Closes the socket when the last WiFiClient copy lets go
+struct WiFiSocketHandle {
+    sim::ConnPtr conn;
+    explicit WiFiSocketHandle(const sim::ConnPtr& c) : conn(c) {}
+    ~WiFiSocketHandle() { sim::connClose(conn.get()); }
+};
+
+// IPAddress
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buf);
+}
+
+size_t IPAddress::printTo(Print& p) const {
+    return p.print(toString());
+}
+
+// WiFiClient
+
+WiFiClient::WiFiClient() {
+}
+
+WiFiClient::WiFiClient(const std::shared_ptr<sim::Conn>& conn) : handle(std::make_shared<WiFiSocketHandle>(conn)) {
+}
+
+WiFiClient::~WiFiClient() {
+}
+
+sim::Conn* WiFiClient::conn() const {
+    return handle ? handle->conn.get() : nullptr;
+}
+
+// One round trip for SYN/SYN-ACK; a silent host costs the whole timeout
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    sim::Endpoint* ep = sim::endpoint(host, port);
+    int64_t start = sim::nowUs();
+    if (!sim::stationUp() || !ep || ep->state == sim::ENDPOINT_BLACKHOLE) {
+        sim::sleepUntil(start + (int64_t)getTimeout() * 1000);
+        return 0;
+    }
+    sim::sleepUntil(start + 2 * ep->oneWayUs);
+    if (!sim::stationUp() || ep->state != sim::ENDPOINT_UP) return 0;
+    sim::ConnPtr c = sim::openConn(true, ep->oneWayUs, ep->bps);
+    handle = std::make_shared<WiFiSocketHandle>(c);
+    {
+        sim::ShimScope shim;
+        if (ep->onAccept) ep->onAccept(c);
+    }
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    sim::Conn* c = conn();
+    if (!c) return 0;
+    size_t done = 0;
+    int64_t limit = sim::nowUs() + WIFI_CLIENT_WRITE_LIMIT_MS * 1000LL;
+    while (done < size && c->open && c->peerOpen) {
+        size_t n;
+        {
+            sim::ShimScope shim;
+            n = sim::connPush(c, buf + done, size - done);
+        }
+        done += n;
+        if (done == size) break;
+        int64_t t = sim::connSpaceAt(c, 1436); // One MSS
+        if (t < 0 || t > limit) {
+            sim::sleepUntil(limit);
+            break;
+        }
+        sim::sleepUntil(t);
+    }
+    return done;
+}
+
+int WiFiClient::available() {
+    sim::Conn* c = conn();
+    return c ? (int)c->rx.size() : 0;
+}
+
+int WiFiClient::read() {
+    sim::Conn* c = conn();
+    if (!c || c->rx.empty()) return -1;
+    uint8_t b = c->rx.front();
+    c->rx.pop_front();
+    return b;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    sim::Conn* c = conn();
+    if (!c || c->rx.empty()) return -1;
+    size_t n = 0;
+    while (n < size && !c->rx.empty()) {
+        buf[n++] = c->rx.front();
+        c->rx.pop_front();
+    }
+    return (int)n;
+}
+
+int WiFiClient::peek() {
+    sim::Conn* c = conn();
+    return c && !c->rx.empty() ? c->rx.front() : -1;
+}
+
+void WiFiClient::stop() {
+    handle.reset();
+}
+
+// As the core: connected until the peer's close is seen and the data
+// before it has been read
+uint8_t WiFiClient::connected() {
+    sim::Conn* c = conn();
+    return c && c->open && (c->peerOpen || !c->rx.empty());
+}
+
+int WiFiClient::fd() const {
+    sim::Conn* c = conn();
+    return c && c->open ? c->fd : -1;
+}
+
+ssize_t lwip_send(int s, const void* data, size_t size, int flags) {
+    sim::Conn* c = sim::connByFd(s);
+    if (!c) {
+        errno = EBADF;
+        return -1;
+    }
+    if (!c->peerOpen) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    size_t done = 0;
+    for (;;) {
+        {
+            sim::ShimScope shim;
+            done += sim::connPush(c, (const uint8_t*)data + done, size - done);
+        }
+        if (done == size || (flags & MSG_DONTWAIT)) break;
+        int64_t t = sim::connSpaceAt(c, 1);
+        if (t < 0) break; // Blocking send on a dead peer: lwIP would wait for the RTO
+        sim::sleepUntil(t);
+        if (!c->peerOpen) break;
+    }
+    if (done == 0) {
+        errno = c->peerOpen ? EAGAIN : ECONNRESET;
+        return -1;
+    }
+    return (ssize_t)done;
+}
+
+// WiFiClass
+
+struct EventCb {
+    WiFiEventFuncCb fn;
+    arduino_event_id_t event; // ARDUINO_EVENT_MAX = all
+};
+
+static std::vector<EventCb> eventCbs;
+static bool staStarted;
+
+static void dispatch(bool gotIp) {
+    arduino_event_info_t info = {};
+    arduino_event_id_t id = gotIp ? ARDUINO_EVENT_WIFI_STA_GOT_IP : ARDUINO_EVENT_WIFI_STA_DISCONNECTED;
+    for (EventCb& cb : eventCbs) {
+        if (cb.event == ARDUINO_EVENT_MAX || cb.event == id) cb.fn(id, info);
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+    return true;
+}
+
+bool WiFiClass::softAP(const char* ssid, const char* passphrase) {
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char* ssid, const char* passphrase) {
+    sim::ShimScope shim;
+    staStarted = true;
+    sim::onStaEvent(dispatch);
+    sim::staBegin();
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifioff) {
+    sim::ShimScope shim;
+    sim::staDisconnect();
+    return true;
+}
+
+bool WiFiClass::setAutoReconnect(bool autoReconnect) {
+    return true; // The firmware paces reconnects itself; driver retries are not modelled
+}
+
+wl_status_t WiFiClass::status() {
+    if (sim::stationUp()) return WL_CONNECTED;
+    return staStarted ? WL_DISCONNECTED : WL_IDLE_STATUS;
+}
+
+IPAddress WiFiClass::localIP() {
+    return sim::stationUp() ? IPAddress(192, 168, 1, 57) : IPAddress();
+}
+
+int8_t WiFiClass::RSSI() {
+    return (int8_t)sim::rssiNow();
+}
+
+void WiFiClass::onEvent(WiFiEventFuncCb cb, arduino_event_id_t event) {
+    eventCbs.push_back(EventCb{cb, event});
+}
+
+// SNTP
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+    sim::setSntpCallback(callback);
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1, const char* server2,
+                const char* server3) {
+    sim::sntpStart();
+}
+
+// WPA2-Enterprise: accepted and ignored; the AP model has no security
+
+esp_err_t esp_wifi_sta_enterprise_enable() {
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_identity(const unsigned char* identity, int len) {
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_username(const unsigned char* username, int len) {
+    return ESP_OK;
+}
+
+esp_err_t esp_eap_client_set_password(const unsigned char* password, int len) {
+    return ESP_OK;
+}
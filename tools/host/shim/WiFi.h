@@ -0,0 +1,97 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+// Arduino-ESP32 WiFi and WiFiClient on the network model in sim/SimNet.h.
+// The station follows the scenario's access point; events are delivered
+// from the simulated WiFi event task (interrupt context here). A
+// WiFiClient shares its socket between copies, as the core's
+// WiFiClientSocketHandle does: the socket closes with the last copy.
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <memory>
+
+namespace sim {
+struct Conn;
+}
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6,
+    WL_NO_SHIELD = 255
+} wl_status_t;
+
+typedef enum { WIFI_MODE_NULL, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA } wifi_mode_t;
+#define WIFI_OFF    WIFI_MODE_NULL
+#define WIFI_STA    WIFI_MODE_STA
+#define WIFI_AP     WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_READY = 0,
+    ARDUINO_EVENT_WIFI_STA_START = 2,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP = 8,
+    ARDUINO_EVENT_MAX = 64
+} arduino_event_id_t;
+
+typedef struct {
+    uint8_t reason;
+} arduino_event_info_t;
+
+typedef std::function<void(arduino_event_id_t event, arduino_event_info_t info)> WiFiEventFuncCb;
+
+struct WiFiSocketHandle;
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient();
+    virtual ~WiFiClient();
+
+    int connect(const char* host, uint16_t port); // Blocks up to getTimeout() ms
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override; // Blocks for buffer space, ~10 s at most
+    using Print::write;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buf, size_t size);
+    int peek() override;
+    void flush() override {}
+    void stop();
+    uint8_t connected();
+    operator bool() { return connected(); }
+    int fd() const;
+    int setNoDelay(bool nodelay) { return 0; }
+
+    // Server side: wrap an accepted connection
+    explicit WiFiClient(const std::shared_ptr<sim::Conn>& conn);
+    sim::Conn* conn() const;
+
+private:
+    std::shared_ptr<WiFiSocketHandle> handle;
+};
+
+class WiFiClass {
+public:
+    bool mode(wifi_mode_t m);
+    bool softAP(const char* ssid, const char* passphrase = nullptr);
+    IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr);
+    bool disconnect(bool wifioff = false);
+    bool setAutoReconnect(bool autoReconnect);
+    wl_status_t status();
+    IPAddress localIP();
+    int8_t RSSI();
+    void onEvent(WiFiEventFuncCb cb, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+};
+
+extern WiFiClass WiFi;
+
+#endif
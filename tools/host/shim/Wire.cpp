@@ -0,0 +1,159 @@
+#include "Wire.h"
+#include "../sim/SimKernel.h"
+#include <map>
+#include <vector>
+
+#define I2C_DRIVER_OVERHEAD_US 20 // Command setup and completion interrupt per transaction
+
+TwoWire Wire(0);
+
+namespace {
+
+struct Fault {
+    uint8_t addr;
+    int64_t fromUs, toUs;
+    sim::I2cFaultKind kind;
+};
+
+std::map<uint8_t, sim::I2cDevice*>& devices() {
+    static std::map<uint8_t, sim::I2cDevice*> d;
+    return d;
+}
+
+std::vector<Fault> faults;
+sim::I2cBusStats busStats;
+
+const Fault* activeFault(uint8_t addr) {
+    int64_t now = sim::nowUs();
+    for (const Fault& f : faults) {
+        if (f.addr == addr && now >= f.fromUs && now < f.toUs) return &f;
+    }
+    return nullptr;
+}
+
+// The calling task waits while the controller works, as on the
+// interrupt-driven ESP32 driver
+void onWire(int64_t us) {
+    busStats.busyUs += us;
+    if (sim::currentTask() && !sim::inInterrupt()) sim::sleepUntil(sim::nowUs() + us);
+}
+
+int64_t bitsUs(uint64_t bits, uint32_t hz) {
+    return (int64_t)((bits * 1000000 + hz - 1) / hz);
+}
+
+} // namespace
+
+TwoWire::TwoWire(uint8_t busNum)
+    : started(false), clockHz(100000), timeoutMs(50), txAddress(0), txLen(0), txPending(false), rxLen(0), rxIndex(0) {
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+    if (started && sda < 0) return true; // Already running: the core keeps its pins
+    if (frequency) clockHz = frequency;
+    started = true;
+    return true;
+}
+
+bool TwoWire::end() {
+    started = false;
+    txPending = false;
+    return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+    if (frequency) clockHz = frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLen = 0;
+    txPending = false;
+}
+
+size_t TwoWire::write(uint8_t c) {
+    if (txLen >= sizeof(txBuf)) return 0;
+    txBuf[txLen++] = c;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    size_t n = 0;
+    while (n < quantity && write(data[n])) n++;
+    return n;
+}
+
+// One bus transaction: the pending write, then a read after a repeated
+// start if rxWanted. Returns an endTransmission() code.
+int TwoWire::transfer(uint8_t address, size_t rxWanted) {
+    rxLen = rxIndex = 0;
+    if (!started) return 4;
+    busStats.transfers++;
+
+    const Fault* fault = activeFault(address);
+    if (fault && fault->kind == sim::I2C_FAULT_HANG) {
+        busStats.timeouts++;
+        onWire((int64_t)timeoutMs * 1000);
+        return 5;
+    }
+    auto it = devices().find(address);
+    if (fault || it == devices().end()) {
+        busStats.nacks++;
+        onWire(I2C_DRIVER_OVERHEAD_US + bitsUs(9 + 2, clockHz)); // START, address, NACK, STOP
+        return 2;
+    }
+
+    sim::I2cDevice* dev = it->second;
+    uint64_t bits = 2; // START and STOP
+    bool ack = true;
+    if (txLen || !rxWanted) {
+        bits += 9 * (1 + txLen);
+        sim::ShimScope shim;
+        ack = dev->write(txBuf, txLen);
+    }
+    if (ack && rxWanted) {
+        bits += 1 + 9 * (1 + rxWanted); // Repeated START, address, data
+        sim::ShimScope shim;
+        dev->read(rxBuf, rxWanted);
+        rxLen = rxWanted;
+    }
+    if (!ack) busStats.nacks++;
+    onWire(I2C_DRIVER_OVERHEAD_US + bitsUs(bits, clockHz));
+    return ack ? 0 : 3;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    if (!sendStop) {
+        txPending = true; // Sent with the next requestFrom()
+        return 0;
+    }
+    int r = transfer(txAddress, 0);
+    txLen = 0;
+    return (uint8_t)r;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop) {
+    if (quantity > sizeof(rxBuf)) quantity = sizeof(rxBuf);
+    if (!txPending || txAddress != address) txLen = 0;
+    txPending = false;
+    int r = transfer(address, quantity);
+    txLen = 0;
+    return r == 0 ? (uint8_t)rxLen : 0;
+}
+
+namespace sim {
+
+void attachI2c(uint8_t addr, I2cDevice* dev) {
+    devices()[addr] = dev;
+}
+
+void addI2cFault(uint8_t addr, int64_t fromUs, int64_t toUs, I2cFaultKind kind) {
+    faults.push_back(Fault{addr, fromUs, toUs, kind});
+}
+
+I2cBusStats i2cBusStats() {
+    return busStats;
+}
+
+} // namespace sim
@@ -0,0 +1,83 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+// Arduino-ESP32 TwoWire on a simulated bus. Devices register by address
+// (sim::attachI2c); a transfer blocks the calling task for its time on the
+// wire at the programmed clock. endTransmission(false) defers the write so
+// requestFrom() runs both halves as one repeated-start transaction, as the
+// ESP32 core does; a NACK there shows up as a short read.
+
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire : public Stream {
+public:
+    explicit TwoWire(uint8_t busNum);
+
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    bool begin() { return begin(-1, -1, 0); }
+    bool end();
+    bool setClock(uint32_t frequency);
+    uint32_t getClock() const { return clockHz; }
+    void setTimeOut(uint16_t ms) { timeoutMs = ms; }
+    uint16_t getTimeOut() const { return timeoutMs; }
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true); // 0 ok, 2 address NACK, 3 data NACK, 4 other, 5 timeout
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* data, size_t quantity) override;
+    using Print::write;
+    int available() override { return (int)(rxLen - rxIndex); }
+    int read() override { return rxIndex < rxLen ? rxBuf[rxIndex++] : -1; }
+    int peek() override { return rxIndex < rxLen ? rxBuf[rxIndex] : -1; }
+
+private:
+    int transfer(uint8_t address, size_t rxWanted);
+
+    bool started;
+    uint32_t clockHz;
+    uint16_t timeoutMs;
+    uint8_t txAddress;
+    uint8_t txBuf[I2C_BUFFER_LENGTH];
+    size_t txLen;
+    bool txPending; // Held back by endTransmission(false)
+    uint8_t rxBuf[I2C_BUFFER_LENGTH];
+    size_t rxLen;
+    size_t rxIndex;
+};
+
+extern TwoWire Wire;
+
+namespace sim {
+
+// A register-level device model on the bus
+class I2cDevice {
+public:
+    virtual ~I2cDevice() {}
+    // Bytes after the address byte of a write; false NACKs the data
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+    // Bytes clocked out after a read address byte
+    virtual void read(uint8_t* out, size_t len) = 0;
+};
+
+void attachI2c(uint8_t addr, I2cDevice* dev);
+
+// Fault windows: the device NACKs its address, or holds SCL until the
+// controller times out
+enum I2cFaultKind { I2C_FAULT_NACK, I2C_FAULT_HANG };
+void addI2cFault(uint8_t addr, int64_t fromUs, int64_t toUs, I2cFaultKind kind);
+
+struct I2cBusStats {
+    uint64_t transfers;
+    uint64_t busyUs; // Time on the wire (includes timeouts)
+    uint64_t nacks;
+    uint64_t timeouts;
+};
+I2cBusStats i2cBusStats();
+
+} // namespace sim
+
+#endif
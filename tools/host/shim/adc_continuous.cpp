@@ -0,0 +1,148 @@
+#include "esp_adc/adc_continuous.h"
+#include "Arduino.h"
+#include "../sim/SimKernel.h"
+#include <deque>
+
+#define ADC_NOISE_TABLE 4096 // Conversion noise, ±6 LSB, repeats every 4096 conversions
+
+struct adc_continuous_ctx_t {
+    uint32_t poolFrames;
+    uint32_t frameBytes;
+    uint32_t patternNum;
+    adc_digi_pattern_config_t pattern[8];
+    uint32_t sampleHz;
+    adc_continuous_evt_cbs_t cbs;
+    void* user;
+
+    bool running;
+    int64_t startUs;
+    uint64_t accounted;       // Frames completed and either pooled or dropped
+    std::deque<int64_t> pool; // Completion times of pooled frames
+    uint64_t conversions;     // Position in the pattern and noise table
+};
+
+static sim::AdcStats stats;
+static int8_t noise[ADC_NOISE_TABLE];
+static bool noiseReady;
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t* cfg, adc_continuous_handle_t* ret) {
+    if (!cfg || !ret || !cfg->conv_frame_size || cfg->conv_frame_size % SOC_ADC_DIGI_RESULT_BYTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    adc_continuous_ctx_t* h = new adc_continuous_ctx_t();
+    h->frameBytes = cfg->conv_frame_size;
+    h->poolFrames = cfg->max_store_buf_size / cfg->conv_frame_size;
+    h->running = false;
+    if (!noiseReady) {
+        for (int i = 0; i < ADC_NOISE_TABLE; i++) noise[i] = (int8_t)((int)(esp_random() % 13) - 6);
+        noiseReady = true;
+    }
+    *ret = h;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t h, const adc_continuous_config_t* config) {
+    if (!h || h->running || !config || !config->pattern_num || config->pattern_num > 8) return ESP_ERR_INVALID_STATE;
+    if (config->format != ADC_DIGI_OUTPUT_FORMAT_TYPE2 || config->sample_freq_hz < 611 || config->sample_freq_hz > 83333) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    h->patternNum = config->pattern_num;
+    for (uint32_t i = 0; i < config->pattern_num; i++) h->pattern[i] = config->adc_pattern[i];
+    h->sampleHz = config->sample_freq_hz;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t h, const adc_continuous_evt_cbs_t* cbs,
+                                                  void* user_data) {
+    if (!h || h->running) return ESP_ERR_INVALID_STATE;
+    h->cbs = *cbs;
+    h->user = user_data;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t h) {
+    if (!h || h->running || !h->sampleHz) return ESP_ERR_INVALID_STATE;
+    h->running = true;
+    h->startUs = sim::nowUs();
+    h->accounted = 0;
+    h->pool.clear();
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t h) {
+    if (!h || !h->running) return ESP_ERR_INVALID_STATE;
+    h->running = false;
+    return ESP_OK;
+}
+
+// Brings the pool up to now: what the DMA interrupt would have done since
+// the last call
+static void catchUp(adc_continuous_handle_t h) {
+    uint64_t perFrame = h->frameBytes / SOC_ADC_DIGI_RESULT_BYTES;
+    uint64_t completed = (uint64_t)(sim::nowUs() - h->startUs) * h->sampleHz / (perFrame * 1000000);
+    while (h->accounted < completed) {
+        h->accounted++;
+        stats.frames++;
+        if (h->pool.size() < h->poolFrames) {
+            h->pool.push_back(h->startUs + (int64_t)(h->accounted * perFrame * 1000000 / h->sampleHz));
+            continue;
+        }
+        stats.dropped++;
+        h->conversions += perFrame;
+        if (h->cbs.on_pool_ovf) {
+            adc_continuous_evt_data_t e = {nullptr, 0};
+            h->cbs.on_pool_ovf(h, &e, h->user);
+        }
+    }
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t h, uint8_t* buf, uint32_t length_max, uint32_t* out_length,
+                              uint32_t timeout_ms) {
+    if (!h || !h->running) return ESP_ERR_INVALID_STATE;
+    sim::ShimScope shim;
+    catchUp(h);
+    if (h->pool.empty()) {
+        // Only the non-blocking form is modelled
+        *out_length = 0;
+        return ESP_ERR_TIMEOUT;
+    }
+    h->pool.pop_front();
+
+    uint16_t level[8];
+    for (uint32_t i = 0; i < h->patternNum; i++) level[i] = analogRead(h->pattern[i].channel + 1); // GPIO n is ADC1 ch n-1
+    uint32_t n = (length_max < h->frameBytes ? length_max : h->frameBytes) / SOC_ADC_DIGI_RESULT_BYTES;
+    adc_digi_output_data_t* out = (adc_digi_output_data_t*)buf;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t p = (uint32_t)(h->conversions % h->patternNum);
+        int v = level[p] + noise[h->conversions % ADC_NOISE_TABLE];
+        out[i].val = 0;
+        out[i].type2.data = v < 0 ? 0 : (v > 4095 ? 4095 : v);
+        out[i].type2.channel = h->pattern[p].channel;
+        out[i].type2.unit = 0;
+        h->conversions++;
+    }
+    *out_length = n * SOC_ADC_DIGI_RESULT_BYTES;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t h) {
+    if (!h) return ESP_ERR_INVALID_STATE;
+    delete h;
+    return ESP_OK;
+}
+
+// ESP32-S3: GPIO1..GPIO10 are ADC1 channels 0..9
+esp_err_t adc_continuous_io_to_channel(int io_num, adc_unit_t* unit_id, adc_channel_t* channel) {
+    if (io_num < 1 || io_num > 10) return ESP_ERR_INVALID_ARG;
+    *unit_id = ADC_UNIT_1;
+    *channel = (adc_channel_t)(io_num - 1);
+    return ESP_OK;
+}
+
+namespace sim {
+
+AdcStats adcStats() {
+    return stats;
+}
+
+} // namespace sim
@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_EAP_CLIENT_H
+#define HOST_ESP_EAP_CLIENT_H
+
+#include "esp_err.h"
+
+esp_err_t esp_eap_client_set_identity(const unsigned char* identity, int len);
+esp_err_t esp_eap_client_set_username(const unsigned char* username, int len);
+esp_err_t esp_eap_client_set_password(const unsigned char* password, int len);
+
+#endif
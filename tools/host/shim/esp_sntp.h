@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_SNTP_H
+#define HOST_ESP_SNTP_H
+
+// SNTP notification hook; syncs are scripted by sim/SimNet.h once
+// configTime() was called and the station has an IP
+
+#include <sys/time.h>
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval* tv);
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+#include "esp_err.h"
+
+esp_err_t esp_wifi_sta_enterprise_enable();
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HOST_RINGBUF_H
+#define HOST_RINGBUF_H
+
+// ESP-IDF ring buffer API (shim/FreeRTOS.cpp)
+
+#include "FreeRTOS.h"
+
+typedef void* RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF,
+} RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type);
+BaseType_t xRingbufferSend(RingbufHandle_t ring, const void* data, size_t len, TickType_t ticks);
+void* xRingbufferReceive(RingbufHandle_t ring, size_t* len, TickType_t ticks);
+void vRingbufferReturnItem(RingbufHandle_t ring, void* item);
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t ring);
+size_t xRingbufferGetMaxItemSize(RingbufHandle_t ring);
+
+#endif
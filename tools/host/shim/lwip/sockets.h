@@ -0,0 +1,20 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+// lwIP socket calls on the simulated TCP connections of sim/SimNet.h.
+// ESP-IDF declares these as inline wrappers around lwip_*; the host
+// <sys/socket.h> is deliberately not included so the names do not clash.
+
+#include <sys/types.h>
+#include <errno.h>
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0x08 // lwIP's value
+#endif
+
+ssize_t lwip_send(int s, const void* data, size_t size, int flags);
+static inline ssize_t send(int s, const void* data, size_t size, int flags) {
+    return lwip_send(s, data, size, flags);
+}
+
+#endif
@@ -0,0 +1,472 @@
+#include "Devices.h"
+#include "SimKernel.h"
+#include "SimNet.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include <math.h>
+#include <memory>
+#include <string>
+#include <time.h>
+
+// Wiring, as SensorService and GpsService use it
+#define INA_IN_ADDR   0x41
+#define INA_OUT_ADDR  0x51
+#define INA_ALERT_PIN 48
+#define RTC_ADDR      0x68
+#define GPS_UART      1
+#define GPS_BYTE_US   (10.0 * 1000000 / 9600) // 8N1 at 9600 baud
+#define GPS_RX_IDLE   2                       // Symbols of silence before the RX timeout event
+
+#define PACK_RINT_OHM   0.1
+#define PACK_MAH        3200.0
+#define CONVERTER_EFF   0.9
+#define RAIL_V          5.0
+#define RAIL_DROOP_OHM  0.05
+#define SOC_STEP_US     10000 // Coulomb integration step
+
+namespace sim {
+
+namespace {
+
+WorldConfig cfg;
+DeviceStats stats;
+
+// Device-side noise, separate from the firmware's esp_random() stream
+uint64_t noiseState = 0xD1B54A32D192ED03ull;
+
+double noise() {
+    noiseState ^= noiseState >> 12;
+    noiseState ^= noiseState << 25;
+    noiseState ^= noiseState >> 27;
+    uint64_t r = noiseState * 0x2545F4914F6CDD1Dull;
+    // Sum of two uniforms: triangular on [-1, 1]
+    return ((r >> 40) + ((r >> 16) & 0xFFFFFF)) / (double)(1 << 24) - 1.0;
+}
+
+// Pack: open-circuit voltage is the firmware's SoC table read backwards
+const double OCV_SOC[] = {0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100};
+const double OCV_V[] = {6.0, 6.4, 6.7, 6.9, 7.1, 7.3, 7.5, 7.7, 7.9, 8.1, 8.4};
+
+double ocv(double soc) {
+    if (soc <= 0) return OCV_V[0];
+    if (soc >= 100) return OCV_V[10];
+    int i = (int)(soc / 10);
+    return OCV_V[i] + (OCV_V[i + 1] - OCV_V[i]) * (soc - OCV_SOC[i]) / 10.0;
+}
+
+bool sunAt(int64_t us) {
+    return fmod(us / 60e6, cfg.orbitMin) < cfg.sunMin;
+}
+
+bool inrushAt(int64_t us) {
+    int64_t phase = (us + cfg.inrushEveryUs / 2) % cfg.inrushEveryUs;
+    return us >= cfg.inrushEveryUs / 2 && phase < cfg.inrushUs;
+}
+
+struct PackState {
+    double soc;
+    int64_t atUs;
+} pack;
+
+// Rails at `us` for a given state of charge; chargeA is what the charger
+// pushes into the pack
+PowerTruth evaluate(int64_t us, double soc, double* chargeA) {
+    PowerTruth p;
+    p.soc = soc;
+    p.sun = sunAt(us);
+    p.iout = cfg.loadA + (us % cfg.burstEveryUs < cfg.burstUs ? cfg.burstA : 0.0);
+    p.vout = RAIL_V - p.iout * RAIL_DROOP_OHM;
+    double v0 = ocv(soc);
+    p.iin = p.vout * p.iout / CONVERTER_EFF / v0 + (inrushAt(us) ? cfg.inrushA : 0.0);
+    double chg = 0.0;
+    if (p.sun) chg = soc < 95.0 ? cfg.chargeA : cfg.chargeA * (100.0 - soc) / 5.0;
+    p.vin = v0 + (chg - p.iin) * PACK_RINT_OHM;
+    if (chargeA) *chargeA = chg;
+    return p;
+}
+
+// Coulomb counting of the true pack, forward only. Queries a little in
+// the past (conversion windows) use the current charge.
+void advancePack(int64_t us) {
+    while (us - pack.atUs >= SOC_STEP_US) {
+        int64_t dt = us - pack.atUs;
+        if (dt > 1000000) dt = 1000000;
+        double chg;
+        PowerTruth p = evaluate(pack.atUs, pack.soc, &chg);
+        pack.soc += (chg - p.iin) * (dt / 3600e6) * 1000.0 / PACK_MAH * 100.0;
+        if (pack.soc > 100.0) pack.soc = 100.0;
+        if (pack.soc < 0.0) pack.soc = 0.0;
+        pack.atUs += dt;
+    }
+}
+
+// INA226: shunt and bus ADCs averaged over (bus CT + shunt CT) × AVG,
+// registers updated at the end of each conversion
+const uint16_t INA_AVG[] = {1, 4, 16, 64, 128, 256, 512, 1024};
+const uint16_t INA_CT_US[] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+
+class Ina226 : public I2cDevice {
+public:
+    Ina226(bool input, int alertPin) : input(input), alertPin(alertPin) { reset(); }
+
+    bool write(const uint8_t* data, size_t len) override {
+        if (!len) return true;
+        ptr = data[0];
+        if (len < 3) return true; // Pointer only: a read follows
+        uint16_t v = (uint16_t)(data[1] << 8 | data[2]);
+        switch (ptr) {
+            case 0x00:
+                if (v & 0x8000) reset();
+                else config = v;
+                restart();
+                break;
+            case 0x05: cal = v & 0x7FFF; break;
+            case 0x06:
+                mask = v & 0xFC03;
+                armAlert();
+                break;
+            case 0x07: limit = v; break;
+            default: break; // Read-only
+        }
+        return true;
+    }
+
+    void read(uint8_t* out, size_t len) override {
+        uint16_t v = reg(ptr);
+        for (size_t i = 0; i < len; i++) out[i] = (i & 1) ? (uint8_t)v : (uint8_t)(v >> 8);
+        stats.inaReads++;
+    }
+
+private:
+    void reset() {
+        config = 0x4127;
+        cal = 0;
+        mask = 0;
+        limit = 0;
+        ptr = 0;
+        shuntRaw = 0;
+        busRaw = 0;
+        restart();
+    }
+
+    // A config write aborts the running conversion and starts over
+    void restart() {
+        gen++;
+        startUs = nowUs();
+        periodUs = (int64_t)(INA_CT_US[(config >> 6) & 7] + INA_CT_US[(config >> 3) & 7]) * INA_AVG[(config >> 9) & 7];
+        readK = clearedK = -1;
+        armAlert();
+    }
+
+    bool continuous() const { return (config & 4) && (config & 3); }
+
+    // Latest completed conversion, -1 if none since the restart
+    int64_t completed(int64_t us) const {
+        if (!continuous()) return -1;
+        return (us - startUs) / periodUs - 1;
+    }
+
+    void latch(int64_t k) {
+        if (k < 0 || k == readK) return;
+        readK = k;
+        int64_t mid = startUs + k * periodUs + periodUs / 2;
+        advancePack(nowUs());
+        PowerTruth p = evaluate(mid, pack.soc, nullptr);
+        double v = input ? p.vin : p.vout;
+        double i = (input ? p.iin : p.iout) + cfg.inaNoiseA * noise();
+        double shunt = i * 0.1 / 2.5e-6; // 0.1 Ω shunt, 2.5 µV LSB
+        shuntRaw = (int16_t)fmax(-32768.0, fmin(32767.0, lround(shunt)));
+        busRaw = (uint16_t)fmax(0.0, fmin(32767.0, lround((v + 0.001 * noise()) / 0.00125)));
+    }
+
+    uint16_t reg(uint8_t r) {
+        int64_t k = completed(nowUs());
+        latch(k);
+        switch (r) {
+            case 0x00: return config;
+            case 0x01: return (uint16_t)shuntRaw;
+            case 0x02: return busRaw;
+            case 0x03: return (uint16_t)(abs(currentRaw()) * (int32_t)busRaw / 20000);
+            case 0x04: return (uint16_t)currentRaw();
+            case 0x05: return cal;
+            case 0x06: {
+                // Reading Mask/Enable clears the flag and releases ALERT
+                bool cvrf = k > clearedK;
+                clearedK = k;
+                if (alertLow) {
+                    alertLow = false;
+                    gpioDrive(alertPin, -1);
+                }
+                return (uint16_t)(mask | (cvrf ? 0x0008 : 0));
+            }
+            case 0x07: return limit;
+            case 0xFE: return 0x5449;
+            case 0xFF: return 0x2260;
+            default: return 0;
+        }
+    }
+
+    int32_t currentRaw() const {
+        return (int32_t)shuntRaw * cal / 2048;
+    }
+
+    // ALERT follows conversion ready only while CNVR is set; one event per
+    // conversion, none otherwise
+    void armAlert() {
+        if (alertPin < 0 || !(mask & 0x0400) || !continuous() || chained == gen) return;
+        chained = gen;
+        scheduleAlert(gen, completed(nowUs()) + 1);
+    }
+
+    void scheduleAlert(uint64_t g, int64_t k) {
+        at(startUs + (k + 1) * periodUs, [this, g, k]() {
+            if (g != gen || !(mask & 0x0400)) {
+                if (g == gen) chained = 0;
+                return;
+            }
+            stats.inaConversions++;
+            if (!alertLow) {
+                alertLow = true;
+                gpioDrive(alertPin, LOW);
+            }
+            scheduleAlert(g, k + 1);
+        });
+    }
+
+    bool input;
+    int alertPin;
+    uint8_t ptr;
+    uint16_t config, cal, mask, limit;
+    int64_t startUs = 0, periodUs = 1;
+    uint64_t gen = 0, chained = 0;
+    int64_t readK = -1, clearedK = -1;
+    int16_t shuntRaw;
+    uint16_t busRaw;
+    bool alertLow = false;
+};
+
+// DS3231: BCD time registers 0–6, control 0x0E, status 0x0F (OSF), and
+// the temperature. Writing the seconds register restarts the second.
+uint8_t bcd(int v) {
+    return (uint8_t)((v / 10) << 4 | (v % 10));
+}
+
+int unbcd(uint8_t v) {
+    return (v >> 4) * 10 + (v & 0x0F);
+}
+
+class Ds3231 : public I2cDevice {
+public:
+    Ds3231() : ptr(0), control(0x1C), status(cfg.rtcLostPower ? 0x88 : 0x08) {
+        baseTrueUs = trueLocalUs(nowUs());
+        baseRtcUs = baseTrueUs + cfg.rtcOffsetUs;
+    }
+
+    bool write(const uint8_t* data, size_t len) override {
+        if (!len) return true;
+        ptr = data[0];
+        if (len == 1) return true;
+        int64_t now = rtcUs();
+        uint8_t t[7];
+        timeRegs(now, t);
+        bool timeWritten = false, secondsWritten = false;
+        for (size_t i = 1; i < len; i++) {
+            if (ptr < 7) {
+                t[ptr] = data[i];
+                timeWritten = true;
+                secondsWritten |= ptr == 0;
+            } else if (ptr == 0x0E) {
+                control = data[i];
+            } else if (ptr == 0x0F) {
+                status = (uint8_t)((status & data[i] & 0x80) | (data[i] & 0x0B)); // OSF can only be cleared
+            }
+            ptr = (uint8_t)((ptr + 1) % 0x13);
+        }
+        if (timeWritten) {
+            struct tm tm = {};
+            tm.tm_sec = unbcd(t[0]);
+            tm.tm_min = unbcd(t[1]);
+            tm.tm_hour = unbcd(t[2] & 0x3F);
+            tm.tm_mday = unbcd(t[4]);
+            tm.tm_mon = unbcd(t[5] & 0x1F) - 1;
+            tm.tm_year = unbcd(t[6]) + 100;
+            int64_t sub = secondsWritten ? 0 : ((now % 1000000) + 1000000) % 1000000;
+            baseRtcUs = (int64_t)timegm(&tm) * 1000000 + sub;
+            baseTrueUs = trueLocalUs(nowUs());
+            stats.rtcWrites++;
+        }
+        return true;
+    }
+
+    void read(uint8_t* out, size_t len) override {
+        uint8_t t[7];
+        timeRegs(rtcUs(), t);
+        if (ptr < 7) stats.rtcReads++;
+        for (size_t i = 0; i < len; i++) {
+            if (ptr < 7) out[i] = t[ptr];
+            else if (ptr == 0x0E) out[i] = control;
+            else if (ptr == 0x0F) out[i] = status;
+            else if (ptr == 0x11) out[i] = 25; // °C
+            else out[i] = 0;
+            ptr = (uint8_t)((ptr + 1) % 0x13);
+        }
+    }
+
+private:
+    int64_t rtcUs() const {
+        int64_t elapsed = trueLocalUs(nowUs()) - baseTrueUs;
+        return baseRtcUs + elapsed + (int64_t)(elapsed * cfg.rtcPpm * 1e-6);
+    }
+
+    static void timeRegs(int64_t us, uint8_t t[7]) {
+        time_t s = (time_t)(us / 1000000);
+        struct tm tm;
+        gmtime_r(&s, &tm);
+        t[0] = bcd(tm.tm_sec);
+        t[1] = bcd(tm.tm_min);
+        t[2] = bcd(tm.tm_hour);
+        t[3] = (uint8_t)(tm.tm_wday + 1);
+        t[4] = bcd(tm.tm_mday);
+        t[5] = bcd(tm.tm_mon + 1);
+        t[6] = bcd(tm.tm_year % 100);
+    }
+
+    uint8_t ptr, control, status;
+    int64_t baseTrueUs, baseRtcUs;
+};
+
+// GPS module: one NMEA burst per UTC second, RMC first, at 9600 baud.
+// The UART raises an RX event per FIFO-full batch and on the idle line
+// after the burst, so bytes reach the driver in those chunks.
+void nmea(std::string& out, const char* body) {
+    uint8_t x = 0;
+    for (const char* p = body; *p; p++) x ^= (uint8_t)*p;
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", x);
+    out += '$';
+    out += body;
+    out += tail;
+    stats.gpsSentences++;
+}
+
+void gpsBurst(int64_t utcSec, std::string& out) {
+    int64_t up = nowUs();
+    char b[160];
+    if (up < cfg.gpsTimeUs) {
+        nmea(out, "GPRMC,,V,,,,,,,,,,N");
+        nmea(out, "GPGGA,,,,,,0,00,99.99,,,,,,");
+        nmea(out, "GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99");
+        nmea(out, "GPGSV,1,1,00");
+        nmea(out, "GPVTG,,,,,,,,,N");
+        return;
+    }
+    time_t s = (time_t)utcSec;
+    struct tm tm;
+    gmtime_r(&s, &tm);
+    char hms[32], dmy[32];
+    snprintf(hms, sizeof(hms), "%02d%02d%02d.00", tm.tm_hour, tm.tm_min, tm.tm_sec);
+    snprintf(dmy, sizeof(dmy), "%02d%02d%02d", tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+    if (up < cfg.gpsFixUs) {
+        snprintf(b, sizeof(b), "GPRMC,%s,V,,,,,,,%s,,,N", hms, dmy);
+        nmea(out, b);
+        snprintf(b, sizeof(b), "GPGGA,%s,,,,,0,03,25.5,,,,,,", hms);
+        nmea(out, b);
+        nmea(out, "GPGSA,A,1,,,,,,,,,,,,,25.5,25.5,25.5");
+        nmea(out, "GPGSV,1,1,03,02,45,120,22,05,30,045,18,12,62,300,25");
+        nmea(out, "GPVTG,,,,,,,,,N");
+        return;
+    }
+    double lat = cfg.lat + 5e-6 * noise();
+    double lng = cfg.lng + 5e-6 * noise();
+    int latDeg = (int)lat, lngDeg = (int)lng;
+    char pos[48];
+    snprintf(pos, sizeof(pos), "%02d%08.5f,N,%03d%08.5f,E", latDeg, (lat - latDeg) * 60, lngDeg, (lng - lngDeg) * 60);
+    snprintf(b, sizeof(b), "GPRMC,%s,A,%s,0.02,,%s,,,A", hms, pos, dmy);
+    nmea(out, b);
+    snprintf(b, sizeof(b), "GPGGA,%s,%s,1,08,0.92,12.5,M,-28.1,M,,", hms, pos);
+    nmea(out, b);
+    nmea(out, "GPGSA,A,3,02,05,12,13,15,18,20,25,,,,,1.60,0.92,1.31");
+    nmea(out, "GPGSV,3,1,11,02,45,120,38,05,30,045,35,12,62,300,40,13,15,200,28");
+    nmea(out, "GPGSV,3,2,11,15,52,080,41,18,21,250,30,20,70,010,44,25,12,330,26");
+    nmea(out, "GPGSV,3,3,11,26,05,160,,29,08,290,,31,02,020,");
+    nmea(out, "GLGSV,2,1,06,65,40,100,33,66,55,170,36,72,20,310,29,80,12,040,");
+    nmea(out, "GLGSV,2,2,06,81,33,220,31,82,08,280,");
+    nmea(out, "GAGSV,1,1,03,04,60,090,40,11,25,200,34,19,10,330,");
+    nmea(out, "GPVTG,,T,,M,0.02,N,0.04,K,A");
+}
+
+void gpsEpoch(int64_t utcSec) {
+    auto text = std::make_shared<std::string>();
+    gpsBurst(utcSec, *text);
+    stats.gpsBytes += text->size();
+
+    int64_t start = nowUs();
+    size_t batch = (size_t)uartRxFifoFull(GPS_UART);
+    if (!batch) batch = text->size(); // Driver not installed yet: the bytes are lost anyway
+    for (size_t off = 0; off < text->size(); off += batch) {
+        size_t end = std::min(off + batch, text->size());
+        double idle = end - off < batch ? GPS_RX_IDLE : 0;
+        at(start + (int64_t)((end + idle) * GPS_BYTE_US), [text, off, end]() {
+            uartReceive(GPS_UART, (const uint8_t*)text->data() + off, end - off);
+        });
+    }
+    at(virtualAtUtc((utcSec + 1) * 1000000 + cfg.gpsLatencyUs), [utcSec]() { gpsEpoch(utcSec + 1); });
+}
+
+// Comparator outputs on the ADC pins (active low), one per quarter of the
+// pack's charge
+const int ADC_PIN_ORDER[4] = {3, 2, 9, 1};
+const double COMPARATOR_SOC[4] = {12.5, 37.5, 62.5, 87.5};
+
+uint16_t comparator(int pin) {
+    for (int i = 0; i < 4; i++) {
+        if (ADC_PIN_ORDER[i] != pin) continue;
+        advancePack(nowUs());
+        return pack.soc > COMPARATOR_SOC[i] ? 150 : 3950;
+    }
+    return 4095;
+}
+
+void countInrush() {
+    stats.inrushes++;
+    after(cfg.inrushEveryUs, countInrush);
+}
+
+} // namespace
+
+PowerTruth powerAt(int64_t us) {
+    advancePack(us);
+    return evaluate(us, pack.soc, nullptr);
+}
+
+int64_t trueLocalUs(int64_t us) {
+    return trueUtcUs(us) + (int64_t)cfg.tzOffsetS * 1000000;
+}
+
+int64_t virtualAtUtc(int64_t utcUs) {
+    return (int64_t)llround((utcUs - cfg.utcAtBootUs) * (1.0 + cfg.crystalPpm * 1e-6));
+}
+
+void installWorld(const WorldConfig& c) {
+    cfg = c;
+    pack.soc = c.socStart;
+    pack.atUs = nowUs();
+    setTrueUtc([](int64_t us) { return cfg.utcAtBootUs + (int64_t)llround(us / (1.0 + cfg.crystalPpm * 1e-6)); });
+
+    if (c.inaInPresent) attachI2c(INA_IN_ADDR, new Ina226(true, INA_ALERT_PIN));
+    if (c.inaOutPresent) attachI2c(INA_OUT_ADDR, new Ina226(false, -1));
+    if (c.rtcPresent) attachI2c(RTC_ADDR, new Ds3231());
+    if (c.gpsPresent) {
+        int64_t first = (trueUtcUs(nowUs()) + 999999) / 1000000;
+        at(virtualAtUtc(first * 1000000 + c.gpsLatencyUs), [first]() { gpsEpoch(first); });
+    }
+    setAnalogSource(comparator);
+
+    at(c.inrushEveryUs / 2, countInrush);
+}
+
+DeviceStats deviceStats() {
+    return stats;
+}
+
+} // namespace sim
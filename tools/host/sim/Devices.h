@@ -0,0 +1,87 @@
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+// The hardware around the ESP32 for one scenario: the 2S pack and its
+// solar charger over an orbit, the two INA226 monitors, the DS3231, the
+// GPS module on UART1 and the four comparator outputs on the ADC pins.
+//
+// Everything derives from one notion of true time. The ESP32 crystal runs
+// crystalPpm fast, so virtual µs since boot (esp_timer) and true UTC part
+// slowly; SNTP, GPS and the RTC are all stamped from the truth, and the
+// firmware's SystemClock should recover the crystal error from them.
+//
+// Register contents are computed when the firmware reads them, from the
+// conversion window they belong to, so only the INA226 ALERT line and the
+// GPS bytes cost events.
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sim {
+
+struct WorldConfig {
+    int64_t utcAtBootUs = 1780272000000000; // 2026-06-01 00:00:00 UTC
+    double crystalPpm = 12.0;               // ESP32 clock error (+ = fast)
+    int tzOffsetS = 7 * 3600;               // Local time the RTC keeps
+
+    // Power: 2S 3200 mAh pack, charger in sunlight, 5 V rail for the payload
+    double socStart = 70.0;     // %
+    double orbitMin = 92.0;
+    double sunMin = 60.0;       // Sunlit part of each orbit, from its start
+    double chargeA = 0.5;       // Charger current in sunlight (tapers above 95 %)
+    double loadA = 0.24;        // 5 V rail, idle
+    double burstA = 0.25;       // Extra on the 5 V rail during a radio burst
+    int64_t burstEveryUs = 30100000; // Not locked to the 1 s records
+    int64_t burstUs = 300000;
+    double inrushA = 0.55;      // Extra converter input current when a payload powers up
+    int64_t inrushEveryUs = 7200000000LL;
+    int64_t inrushUs = 40000;
+    double inaNoiseA = 0.0004;  // Current noise per conversion (after averaging)
+
+    // DS3231: keeps local time, starts off by rtcOffsetUs, runs rtcPpm fast
+    bool rtcPresent = true;
+    bool rtcLostPower = false;  // OSF set: the firmware sets it from the build time
+    int64_t rtcOffsetUs = -2400000;
+    double rtcPpm = 2.0;
+
+    // GPS: time from a cold start at gpsTimeUs, fix at gpsFixUs
+    bool gpsPresent = true;
+    int64_t gpsTimeUs = 25000000;
+    int64_t gpsFixUs = 40000000;
+    int64_t gpsLatencyUs = 40000; // First byte of an epoch's burst after the UTC second
+    double lat = 13.7298;
+    double lng = 100.7782;
+
+    bool inaInPresent = true;
+    bool inaOutPresent = true;
+};
+
+// Creates the device models, attaches them to the bus, pins and UART, and
+// sets true UTC for the network (SNTP). Call once before sim::run().
+void installWorld(const WorldConfig& c);
+
+// Scenario truth, for checking the firmware against it
+struct PowerTruth {
+    double vin, iin;   // Converter input: pack voltage, current drawn (+)
+    double vout, iout; // 5 V rail
+    double soc;        // Pack state of charge, %
+    bool sun;
+};
+PowerTruth powerAt(int64_t us);
+int64_t trueLocalUs(int64_t us);      // Local wall clock at virtual time `us`
+int64_t virtualAtUtc(int64_t utcUs);  // Inverse of trueUtcUs()
+
+struct DeviceStats {
+    uint64_t inaConversions; // IN monitor, ALERT events
+    uint64_t inaReads;       // Register reads, both monitors
+    uint64_t rtcReads;
+    uint64_t rtcWrites;
+    uint64_t gpsBytes;
+    uint64_t gpsSentences;
+    uint64_t inrushes;
+};
+DeviceStats deviceStats();
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,445 @@
+// Fortified longjmp refuses to jump between stacks; switching stacks is
+// the point here
+#ifdef _FORTIFY_SOURCE
+#undef _FORTIFY_SOURCE
+#endif
+
+#include "SimKernel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#include <sys/mman.h>
+#include <algorithm>
+#include <queue>
+
+#define SIM_STACK_BYTES (256 * 1024) // Per task; glibc printf alone wants several KB
+#define SIM_STACK_PAINT 0xA5
+#define SIM_NEVER       INT64_MAX
+
+namespace sim {
+
+namespace {
+
+struct Event {
+    int64_t t;
+    uint64_t seq; // FIFO among events at the same time
+    std::function<void()> fn;
+};
+
+struct EventLater {
+    bool operator()(const Event& a, const Event& b) const {
+        return a.t != b.t ? a.t > b.t : a.seq > b.seq;
+    }
+};
+
+struct Kernel {
+    int64_t now = 0;
+    std::priority_queue<Event, std::vector<Event>, EventLater> events;
+    uint64_t eventSeq = 0;
+    std::vector<Task*> tasks;
+    Task* cur = nullptr;
+    bool isr = false;
+    int critical = 0;
+    bool stopped = false;
+    uint64_t runSeq = 0;
+
+    jmp_buf schedJb;
+    ucontext_t schedUc;
+
+    // Host time accounting for the task that is switched in
+    uint64_t inNs = 0;
+    uint64_t shimAtIn = 0;
+    uint64_t shimTotal = 0;
+    int shimDepth = 0;
+    uint64_t fwTotal = 0;
+
+    KernelStats stats = {};
+};
+
+Kernel& K() {
+    static Kernel k;
+    return k;
+}
+
+void fail(const char* what) {
+    Kernel& k = K();
+    fprintf(stderr, "sim: %s (task %s, t=%lld us)\n", what, k.cur ? k.cur->name.c_str() : "-", (long long)k.now);
+    abort();
+}
+
+void taskEntry() {
+    Task* t = K().cur;
+    t->fn(t->arg);
+    fail("task function returned"); // ESP-IDF aborts here too
+}
+
+// Task -> scheduler. Returns when the scheduler switches back.
+void switchOut() {
+    Kernel& k = K();
+    Task* t = k.cur;
+    if (!_setjmp(t->jb)) _longjmp(k.schedJb, 1);
+}
+
+// Scheduler -> task, until it switches out
+void switchTo(Task* t) {
+    Kernel& k = K();
+    k.cur = t;
+    if (!_setjmp(k.schedJb)) {
+        if (!t->started) {
+            t->started = true;
+            swapcontext(&k.schedUc, &t->uc);
+        } else {
+            _longjmp(t->jb, 1);
+        }
+    }
+    k.cur = nullptr;
+}
+
+void unlink(Task* t) {
+    if (!t->waitingOn) return;
+    std::vector<Task*>& w = t->waitingOn->waiters;
+    w.erase(std::remove(w.begin(), w.end(), t), w.end());
+    t->waitingOn = nullptr;
+}
+
+Task* earliestDeadline() {
+    Task* best = nullptr;
+    for (Task* t : K().tasks) {
+        if (t->state == Task::BLOCKED && t->deadlineUs >= 0 && (!best || t->deadlineUs < best->deadlineUs)) best = t;
+    }
+    return best;
+}
+
+void fire(Event& e) {
+    Kernel& k = K();
+    bool was = k.isr;
+    k.isr = true;
+    e.fn();
+    k.isr = was;
+    k.stats.events++;
+}
+
+// Moves the clock to `target`, running events and expiring timeouts in
+// time order on the way
+void advanceTo(int64_t target) {
+    Kernel& k = K();
+    for (;;) {
+        int64_t te = k.events.empty() ? SIM_NEVER : k.events.top().t;
+        Task* tt = earliestDeadline();
+        int64_t td = tt ? tt->deadlineUs : SIM_NEVER;
+        int64_t n = te < td ? te : td;
+        if (n > target) break;
+        if (n > k.now) k.now = n;
+        if (te <= td) {
+            Event e = std::move(const_cast<Event&>(k.events.top()));
+            k.events.pop();
+            fire(e);
+        } else {
+            unlink(tt);
+            tt->state = Task::READY;
+            tt->timedOut = true;
+            tt->deadlineUs = -1;
+        }
+    }
+    if (target > k.now) k.now = target;
+}
+
+Task* pickReady() {
+    Task* best = nullptr;
+    for (Task* t : K().tasks) {
+        if (t->state != Task::READY) continue;
+        if (!best || t->prio > best->prio || (t->prio == best->prio && t->lastRun < best->lastRun)) best = t;
+    }
+    return best;
+}
+
+bool higherReady(int prio) {
+    for (Task* t : K().tasks) {
+        if (t->state == Task::READY && t->prio > prio) return true;
+    }
+    return false;
+}
+
+void runTask(Task* t) {
+    Kernel& k = K();
+    t->lastRun = ++k.runSeq;
+    t->stats.switches++;
+    k.stats.switches++;
+    k.inNs = hostNs();
+    k.shimAtIn = k.shimTotal;
+    switchTo(t);
+    uint64_t dt = hostNs() - k.inNs;
+    uint64_t shim = k.shimTotal - k.shimAtIn;
+    uint64_t fw = dt > shim ? dt - shim : 0;
+    t->stats.firmwareNs += fw;
+    t->stats.shimNs += shim;
+    k.fwTotal += fw;
+}
+
+void preemptIfNeeded() {
+    Kernel& k = K();
+    if (k.cur && !k.isr && !k.critical && higherReady(k.cur->prio)) switchOut();
+}
+
+} // namespace
+
+int64_t nowUs() {
+    return K().now;
+}
+
+void at(int64_t us, std::function<void()> fn) {
+    Kernel& k = K();
+    if (us < k.now) us = k.now;
+    k.events.push(Event{us, k.eventSeq++, std::move(fn)});
+}
+
+bool inInterrupt() {
+    return K().isr;
+}
+
+Task* createTask(void (*fn)(void*), const char* name, uint32_t stackBytes, void* arg, int prio, int core) {
+    Kernel& k = K();
+    Task* t = new Task();
+    t->name = name ? name : "";
+    t->fn = fn;
+    t->arg = arg;
+    t->prio = prio;
+    t->core = core;
+    t->stackBytes = stackBytes;
+    t->state = Task::READY;
+    t->deadlineUs = -1;
+    t->waitingOn = nullptr;
+    t->timedOut = false;
+    t->lastRun = 0;
+    t->notifyValue = 0;
+    t->started = false;
+
+    // Guard page below the stack; the rest is painted for the high-water mark
+    long page = 4096;
+    t->stackSize = SIM_STACK_BYTES;
+    uint8_t* mem = (uint8_t*)mmap(nullptr, t->stackSize + page, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) fail("task stack allocation failed");
+    mprotect(mem, page, PROT_NONE);
+    t->stack = mem + page;
+    memset(t->stack, SIM_STACK_PAINT, t->stackSize);
+
+    getcontext(&t->uc);
+    t->uc.uc_stack.ss_sp = t->stack;
+    t->uc.uc_stack.ss_size = t->stackSize;
+    t->uc.uc_link = nullptr;
+    makecontext(&t->uc, taskEntry, 0);
+
+    t->stats.name = t->name;
+    t->stats.prio = prio;
+    t->stats.core = core;
+    t->stats.stackBytes = stackBytes;
+    k.tasks.push_back(t);
+
+    // A new task above the creator runs at once, as in FreeRTOS
+    preemptIfNeeded();
+    return t;
+}
+
+Task* currentTask() {
+    return K().cur;
+}
+
+bool wait(WaitList& w, int64_t deadlineUs) {
+    Kernel& k = K();
+    Task* t = k.cur;
+    if (!t || k.isr) fail("blocking call outside task context");
+    if (k.critical) fail("blocking call inside a critical section");
+    if (deadlineUs >= 0 && deadlineUs <= k.now) return false;
+    t->state = Task::BLOCKED;
+    t->deadlineUs = deadlineUs;
+    t->timedOut = false;
+    t->waitingOn = &w;
+    w.waiters.push_back(t);
+    switchOut();
+    return !t->timedOut;
+}
+
+bool wakeOne(WaitList& w) {
+    if (w.waiters.empty()) return false;
+    Task* best = nullptr;
+    for (Task* t : w.waiters) {
+        if (!best || t->prio > best->prio) best = t; // FIFO among equals
+    }
+    unlink(best);
+    best->state = Task::READY;
+    best->deadlineUs = -1;
+    best->timedOut = false;
+    preemptIfNeeded();
+    return true;
+}
+
+void sleepUntil(int64_t us) {
+    Kernel& k = K();
+    Task* t = k.cur;
+    if (!t || k.isr) fail("delay outside task context");
+    if (k.critical) fail("delay inside a critical section");
+    if (us <= k.now) {
+        yieldTask();
+        return;
+    }
+    t->state = Task::BLOCKED;
+    t->deadlineUs = us;
+    t->timedOut = false;
+    t->waitingOn = nullptr;
+    switchOut();
+}
+
+void busy(int64_t us) {
+    Kernel& k = K();
+    if (us <= 0) return;
+    {
+        ShimScope s;
+        advanceTo(k.now + us);
+    }
+    preemptIfNeeded();
+}
+
+void yieldTask() {
+    Kernel& k = K();
+    Task* t = k.cur;
+    if (!t || k.isr || k.critical) return;
+    for (Task* o : k.tasks) {
+        if (o != t && o->state == Task::READY && o->prio >= t->prio) {
+            switchOut();
+            return;
+        }
+    }
+}
+
+void enterCritical() {
+    K().critical++;
+}
+
+void exitCritical() {
+    Kernel& k = K();
+    if (k.critical <= 0) fail("unbalanced critical section");
+    if (--k.critical == 0) preemptIfNeeded(); // A wake-up deferred by the lock
+}
+
+void run(int64_t untilUs) {
+    Kernel& k = K();
+    if (k.cur) fail("run() from task context");
+    k.stopped = false;
+    uint64_t start = hostNs();
+    uint64_t inTasks = 0, inEvents = 0;
+    while (!k.stopped) {
+        // Interrupts posted for "now" by the last task go first
+        uint64_t e0 = hostNs();
+        advanceTo(k.now);
+        inEvents += hostNs() - e0;
+
+        Task* t = pickReady();
+        if (t) {
+            uint64_t t0 = hostNs();
+            runTask(t);
+            inTasks += hostNs() - t0;
+            continue;
+        }
+        int64_t te = k.events.empty() ? SIM_NEVER : k.events.top().t;
+        Task* tt = earliestDeadline();
+        int64_t next = std::min(te, tt ? tt->deadlineUs : SIM_NEVER);
+        e0 = hostNs();
+        if (next > untilUs) {
+            advanceTo(untilUs);
+            inEvents += hostNs() - e0;
+            break;
+        }
+        advanceTo(next);
+        inEvents += hostNs() - e0;
+    }
+    uint64_t total = hostNs() - start;
+    k.stats.eventNs += inEvents;
+    uint64_t accounted = inTasks + inEvents;
+    k.stats.schedulerNs += total > accounted ? total - accounted : 0;
+}
+
+void stop() {
+    K().stopped = true;
+}
+
+ShimScope::ShimScope() : start(0) {
+    if (K().shimDepth++ == 0) start = hostNs();
+}
+
+ShimScope::~ShimScope() {
+    Kernel& k = K();
+    if (--k.shimDepth == 0) k.shimTotal += hostNs() - start;
+}
+
+static uint64_t steadyNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#if defined(__x86_64__)
+// The clock is read several times per task switch and per shim call;
+// RDTSC costs a fraction of clock_gettime(). Scaled once against the
+// steady clock (invariant TSC assumed, as on any current x86-64).
+struct TscScale {
+    uint64_t tsc0, ns0;
+    double nsPerTick;
+    TscScale() {
+        tsc0 = __rdtsc();
+        ns0 = steadyNs();
+        uint64_t ns;
+        while ((ns = steadyNs()) - ns0 < 20000000) {
+        }
+        nsPerTick = (double)(ns - ns0) / (double)(__rdtsc() - tsc0);
+    }
+};
+
+uint64_t hostNs() {
+    static TscScale scale;
+    return scale.ns0 + (uint64_t)((double)(__rdtsc() - scale.tsc0) * scale.nsPerTick);
+}
+#else
+uint64_t hostNs() {
+    return steadyNs();
+}
+#endif
+
+uint64_t firmwareNs() {
+    Kernel& k = K();
+    uint64_t fw = k.fwTotal;
+    if (k.cur) {
+        uint64_t dt = hostNs() - k.inNs;
+        uint64_t shim = k.shimTotal - k.shimAtIn;
+        if (dt > shim) fw += dt - shim;
+    }
+    return fw;
+}
+
+uint32_t stackUsed(const Task* t) {
+    // Stacks grow down: the paint survives from the bottom up to the deepest frame
+    const uint64_t paint = 0x0101010101010101ull * SIM_STACK_PAINT;
+    size_t untouched = 0;
+    while (untouched + 8 <= t->stackSize && !memcmp(t->stack + untouched, &paint, 8)) untouched += 8;
+    return (uint32_t)(t->stackSize - untouched);
+}
+
+std::vector<TaskStats> taskStats() {
+    std::vector<TaskStats> out;
+    for (Task* t : K().tasks) {
+        TaskStats s = t->stats;
+        s.stackUsed = stackUsed(t);
+        out.push_back(s);
+    }
+    return out;
+}
+
+KernelStats kernelStats() {
+    return K().stats;
+}
+
+} // namespace sim
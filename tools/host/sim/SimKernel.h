@@ -0,0 +1,129 @@
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+// Virtual-time scheduler behind the FreeRTOS shim.
+//
+// Every firmware task runs as a coroutine on its own stack, all on one host
+// thread. The highest-priority ready task runs until it blocks (delay,
+// notification, semaphore, ring buffer, bus transfer); code between
+// blocking calls takes no virtual time. When every task is blocked the
+// clock jumps straight to the next deadline or device event, so idle time
+// costs nothing and a simulated day runs in seconds.
+//
+// Device models post events (conversion done, UART bytes, WiFi up) that
+// run in interrupt context at their virtual time. Host CPU time is charged
+// to the task that was running, minus time spent inside ShimScope, so the
+// per-task figures are the firmware's own cost on this machine.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include <setjmp.h>
+#include <ucontext.h>
+
+struct tskTaskControlBlock;
+
+namespace sim {
+
+typedef tskTaskControlBlock Task;
+
+// Tasks blocked on one object (semaphore, ring buffer, notification)
+struct WaitList {
+    std::vector<Task*> waiters;
+};
+
+// Virtual µs since boot: esp_timer_get_time(), micros(), millis(), ticks
+int64_t nowUs();
+
+// Device activity and interrupts at virtual time `us` (>= now)
+void at(int64_t us, std::function<void()> fn);
+inline void after(int64_t us, std::function<void()> fn) { at(nowUs() + us, fn); }
+bool inInterrupt();
+
+Task* createTask(void (*fn)(void*), const char* name, uint32_t stackBytes, void* arg, int prio, int core);
+Task* currentTask(); // nullptr outside task context
+
+// Task context only. wait() blocks on `w` until wakeOne() or the absolute
+// deadline (-1 = none); true if woken, false on timeout (or at once if the
+// deadline has passed).
+bool wait(WaitList& w, int64_t deadlineUs);
+bool wakeOne(WaitList& w);      // Highest-priority waiter; may preempt the caller
+void sleepUntil(int64_t us);    // Blocks; other tasks and events run meanwhile
+void busy(int64_t us);          // Spins without yielding (delayMicroseconds); interrupts still fire
+void yieldTask();               // Lets other ready tasks of the same priority run
+
+// Spinlock nesting (portENTER_CRITICAL): blocking inside one aborts
+void enterCritical();
+void exitCritical();
+
+// Runs until virtual time reaches `untilUs` or stop() is called
+void run(int64_t untilUs);
+void stop();
+
+// Host time spent inside a ShimScope (device models, fake network) is not
+// charged to the firmware
+struct ShimScope {
+    ShimScope();
+    ~ShimScope();
+    uint64_t start;
+};
+
+uint64_t hostNs();     // Host steady clock
+uint64_t firmwareNs(); // Host ns spent in task code outside ShimScope, up to now
+
+struct TaskStats {
+    std::string name;
+    int prio;
+    int core;
+    uint32_t stackBytes;  // As requested by the firmware
+    uint32_t stackUsed;   // Host stack actually touched (x86-64 frames are larger)
+    uint64_t firmwareNs;  // Host CPU time in firmware code
+    uint64_t shimNs;      // Host CPU time in shims called from this task
+    uint64_t switches;    // Times the task was switched in
+};
+std::vector<TaskStats> taskStats();
+uint32_t stackUsed(const Task* t);
+
+struct KernelStats {
+    uint64_t switches;
+    uint64_t events;
+    uint64_t eventNs;     // Host time in events run between tasks (device models, callbacks)
+    uint64_t schedulerNs; // Host time in the scheduler itself, switching included
+};
+KernelStats kernelStats();
+
+} // namespace sim
+
+// The FreeRTOS handle type is the scheduler's task record
+struct tskTaskControlBlock {
+    enum State { READY, BLOCKED, DONE };
+
+    std::string name;
+    void (*fn)(void*);
+    void* arg;
+    int prio;
+    int core;
+    uint32_t stackBytes;
+
+    State state;
+    int64_t deadlineUs;       // Blocked: timeout (-1 = none)
+    sim::WaitList* waitingOn; // Blocked: list this task is on, if any
+    bool timedOut;
+    uint64_t lastRun;         // Round robin among equal priorities
+
+    uint32_t notifyValue;     // Notification index 0
+    sim::WaitList notifyWait;
+
+    // Coroutine
+    uint8_t* stack;
+    size_t stackSize;
+    bool started;
+    ucontext_t uc;
+    jmp_buf jb;
+
+    sim::TaskStats stats;
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include "SimNet.h"
+#include <map>
+#include <sys/time.h>
+
+#define SIM_FIRST_FD        48       // lwIP numbers sockets from LWIP_SOCKET_OFFSET
+#define STA_ASSOC_US        1800000  // Scan, association, 4-way handshake, DHCP
+#define STA_NO_AP_US        3000000  // Scan finds nothing: DISCONNECTED (NO_AP_FOUND)
+#define SNTP_FIRST_US       1000000
+#define SNTP_INTERVAL_US    3600000000LL // CONFIG_LWIP_SNTP_UPDATE_DELAY
+#define SNTP_RETRY_US       15000000
+#define SNTP_RTT_US         40000
+#define DEFAULT_EPOCH_US    1767225600000000LL // 2026-01-01 00:00:00 UTC
+
+namespace sim {
+
+namespace {
+
+struct Outage {
+    int64_t fromUs, toUs;
+};
+
+struct Net {
+    std::map<int, std::weak_ptr<Conn>> fds;
+    int nextFd = SIM_FIRST_FD;
+    std::map<std::string, Endpoint*> endpoints;
+
+    std::vector<Outage> outages;
+    int64_t assocUs = STA_ASSOC_US;
+    std::function<int(int64_t)> rssi;
+    bool staUp = false;
+    uint64_t staGen = 0; // Invalidates scheduled outcomes of an abandoned attempt
+    std::function<void(bool)> staEvent;
+
+    bool sntpStarted = false;
+    bool sntpReachable = true;
+    void (*sntpCb)(struct timeval*) = nullptr;
+    std::function<int64_t(int64_t)> trueUtc;
+
+    NetStats stats = {};
+};
+
+Net& N() {
+    static Net n;
+    return n;
+}
+
+void drain(Conn* c) {
+    int64_t now = nowUs();
+    if (c->bps > 0 && now > c->drainedAt) {
+        c->queued -= (now - c->drainedAt) * c->bps / 1e6;
+        if (c->queued < 0) c->queued = 0;
+    }
+    c->drainedAt = now;
+}
+
+void wakeAll(WaitList& w) {
+    while (wakeOne(w)) {
+    }
+}
+
+void sntpPoll() {
+    Net& n = N();
+    if (!n.staUp || !n.sntpReachable) {
+        n.stats.sntpFailures++;
+        after(SNTP_RETRY_US, sntpPoll);
+        return;
+    }
+    after(SNTP_RTT_US, [] {
+        Net& n = N();
+        if (!n.staUp) {
+            n.stats.sntpFailures++;
+            after(SNTP_RETRY_US, sntpPoll);
+            return;
+        }
+        // lwIP compensates the round trip (SNTP_COMP_ROUNDTRIP); over a
+        // symmetric path the time handed over is right on arrival
+        int64_t utc = trueUtcUs(nowUs());
+        struct timeval tv;
+        tv.tv_sec = utc / 1000000;
+        tv.tv_usec = utc % 1000000;
+        n.stats.sntpSyncs++;
+        if (n.sntpCb) n.sntpCb(&tv);
+        after(SNTP_INTERVAL_US, sntpPoll);
+    });
+}
+
+void staLost() {
+    Net& n = N();
+    if (!n.staUp) return;
+    n.staUp = false;
+    n.stats.staDrops++;
+    resetStationConns();
+    if (n.staEvent) n.staEvent(false);
+}
+
+} // namespace
+
+ConnPtr openConn(bool station, int64_t oneWayUs, double bps) {
+    Net& n = N();
+    ConnPtr c = std::make_shared<Conn>();
+    c->fd = n.nextFd++;
+    c->station = station;
+    c->open = true;
+    c->peerOpen = true;
+    c->oneWayUs = oneWayUs;
+    c->bps = bps;
+    c->queued = 0;
+    c->drainedAt = nowUs();
+    c->lastArrival = 0;
+    c->bytesOut = c->bytesIn = 0;
+    n.fds[c->fd] = c;
+    n.stats.conns++;
+    return c;
+}
+
+Conn* connByFd(int fd) {
+    auto it = N().fds.find(fd);
+    if (it == N().fds.end()) return nullptr;
+    ConnPtr c = it->second.lock();
+    return c ? c.get() : nullptr;
+}
+
+size_t connFree(Conn* c) {
+    drain(c);
+    double free = SIM_TCP_SND_BUF - c->queued;
+    return free >= 1 ? (size_t)free : 0;
+}
+
+size_t connPush(Conn* c, const uint8_t* data, size_t len) {
+    if (!c->open || !c->peerOpen) return 0;
+    size_t free = connFree(c);
+    size_t n = len < free ? len : free;
+    if (!n) return 0;
+    c->queued += n;
+    c->bytesOut += n;
+    // A peer that is not reading never sees these bytes
+    if (c->bps > 0) {
+        int64_t arrival = nowUs() + c->oneWayUs + (int64_t)(c->queued * 1e6 / c->bps);
+        if (arrival < c->lastArrival) arrival = c->lastArrival;
+        c->lastArrival = arrival;
+        if (c->onData) c->onData(data, n, arrival);
+    }
+    return n;
+}
+
+int64_t connSpaceAt(Conn* c, size_t need) {
+    drain(c);
+    if (need > SIM_TCP_SND_BUF) need = SIM_TCP_SND_BUF;
+    double excess = c->queued - (SIM_TCP_SND_BUF - (double)need);
+    if (excess <= 0) return nowUs();
+    if (c->bps <= 0) return -1;
+    return nowUs() + (int64_t)(excess * 1e6 / c->bps) + 1;
+}
+
+bool connWait(Conn* c, int64_t deadlineUs) {
+    while (c->rx.empty() && c->peerOpen && c->open) {
+        if (!wait(c->rxWait, deadlineUs)) return false;
+    }
+    return !c->rx.empty();
+}
+
+void connClose(Conn* c) {
+    if (!c->open) return;
+    c->open = false;
+    N().fds.erase(c->fd);
+    wakeAll(c->rxWait);
+    if (c->peerOpen && c->onClose) {
+        int64_t now = nowUs();
+        c->onClose(c->lastArrival > now ? c->lastArrival : now + c->oneWayUs);
+    }
+}
+
+void peerSend(Conn* c, const uint8_t* data, size_t len, int64_t sendUs) {
+    ConnPtr keep = c->shared_from_this();
+    std::vector<uint8_t> bytes(data, data + len);
+    int64_t t = sendUs > nowUs() ? sendUs : nowUs();
+    at(t + c->oneWayUs, [keep, bytes] {
+        if (!keep->open || !keep->peerOpen) return;
+        keep->rx.insert(keep->rx.end(), bytes.begin(), bytes.end());
+        keep->bytesIn += bytes.size();
+        wakeOne(keep->rxWait);
+    });
+}
+
+void peerClose(Conn* c) {
+    if (!c->peerOpen) return;
+    c->peerOpen = false;
+    wakeAll(c->rxWait);
+}
+
+void setPeerRate(Conn* c, double bps) {
+    drain(c);
+    c->bps = bps;
+}
+
+void listen(const std::string& host, uint16_t port, Endpoint* ep) {
+    N().endpoints[host + ":" + std::to_string(port)] = ep;
+}
+
+Endpoint* endpoint(const std::string& host, uint16_t port) {
+    auto it = N().endpoints.find(host + ":" + std::to_string(port));
+    return it == N().endpoints.end() ? nullptr : it->second;
+}
+
+void resetStationConns() {
+    std::vector<ConnPtr> hit;
+    for (auto& e : N().fds) {
+        ConnPtr c = e.second.lock();
+        if (c && c->station) hit.push_back(c);
+    }
+    for (ConnPtr& c : hit) peerClose(c.get());
+}
+
+void addApOutage(int64_t fromUs, int64_t toUs) {
+    N().outages.push_back(Outage{fromUs, toUs});
+    at(fromUs, staLost);
+}
+
+void setAssociationUs(int64_t us) {
+    N().assocUs = us;
+}
+
+void setRssi(std::function<int(int64_t us)> fn) {
+    N().rssi = fn;
+}
+
+bool apPresent(int64_t us) {
+    for (const Outage& o : N().outages) {
+        if (us >= o.fromUs && us < o.toUs) return false;
+    }
+    return true;
+}
+
+bool stationUp() {
+    return N().staUp;
+}
+
+int rssiNow() {
+    Net& n = N();
+    if (!n.staUp) return 0;
+    return n.rssi ? n.rssi(nowUs()) : -60;
+}
+
+// Succeeds if the AP is there for the whole association
+void staBegin() {
+    Net& n = N();
+    n.staUp = false;
+    uint64_t gen = ++n.staGen;
+    int64_t start = nowUs();
+    bool ok = true;
+    for (int64_t t = start; t <= start + n.assocUs; t += 100000) ok = ok && apPresent(t);
+    after(ok ? n.assocUs : STA_NO_AP_US, [gen, ok] {
+        Net& n = N();
+        if (gen != n.staGen) return;
+        n.staUp = ok && apPresent(nowUs());
+        if (n.staEvent) n.staEvent(n.staUp);
+    });
+}
+
+void staDisconnect() {
+    Net& n = N();
+    n.staGen++;
+    if (n.staUp) {
+        n.staUp = false;
+        resetStationConns();
+    }
+}
+
+void onStaEvent(std::function<void(bool gotIp)> fn) {
+    N().staEvent = fn;
+}
+
+void sntpStart() {
+    Net& n = N();
+    if (n.sntpStarted) return;
+    n.sntpStarted = true;
+    after(SNTP_FIRST_US, sntpPoll);
+}
+
+void setSntpReachable(bool up) {
+    N().sntpReachable = up;
+}
+
+void setSntpCallback(void (*cb)(struct timeval* tv)) {
+    N().sntpCb = cb;
+}
+
+void setTrueUtc(std::function<int64_t(int64_t us)> fn) {
+    N().trueUtc = fn;
+}
+
+int64_t trueUtcUs(int64_t us) {
+    Net& n = N();
+    return n.trueUtc ? n.trueUtc(us) : DEFAULT_EPOCH_US + us;
+}
+
+NetStats netStats() {
+    return N().stats;
+}
+
+} // namespace sim
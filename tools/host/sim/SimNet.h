@@ -0,0 +1,115 @@
+#ifndef SIM_NET_H
+#define SIM_NET_H
+
+// The network around the ESP32: TCP connections, the STA link to the
+// access point, and SNTP.
+//
+// A connection is a send buffer drained at the peer's rate. Firmware
+// writes go in up to the free space (TCP_SND_BUF); the peer is handed each
+// write at once together with the virtual time its last byte arrives, so
+// latency is known without simulating packets. A peer that stops reading
+// (rate 0) leaves the buffer full, which is how a stalled dashboard or a
+// dead path looks to lwIP. Bytes from the peer arrive after one-way delay
+// and wake whoever waits in read.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SimKernel.h"
+
+#define SIM_TCP_SND_BUF 5744 // 4 × MSS, the ESP-IDF default
+
+namespace sim {
+
+struct Conn : std::enable_shared_from_this<Conn> {
+    int fd;
+    bool station;       // Through the STA link (reset when it drops); else a SoftAP client
+    bool open;          // Firmware side has not closed
+    bool peerOpen;      // Peer has not closed or reset
+    int64_t oneWayUs;
+    double bps;         // Rate the peer takes data at; 0 = not reading
+    double queued;      // Bytes in the send buffer
+    int64_t drainedAt;  // Virtual time `queued` was last updated
+    int64_t lastArrival;
+    uint64_t bytesOut, bytesIn;
+    std::deque<uint8_t> rx;
+    WaitList rxWait;    // Firmware tasks blocked in read/connect
+
+    // Peer side
+    std::function<void(const uint8_t* data, size_t len, int64_t arrivalUs)> onData;
+    std::function<void(int64_t lastArrivalUs)> onClose; // Firmware closed (FIN after the queued data)
+};
+
+typedef std::shared_ptr<Conn> ConnPtr;
+
+ConnPtr openConn(bool station, int64_t oneWayUs, double bps);
+Conn* connByFd(int fd);
+size_t connFree(Conn* c);                          // Send buffer space now
+size_t connPush(Conn* c, const uint8_t* data, size_t len); // Up to the free space; hands it to the peer
+int64_t connSpaceAt(Conn* c, size_t need);         // When `need` bytes will be free; -1 = never
+bool connWait(Conn* c, int64_t deadlineUs);         // Task: until peer data, close, or deadline
+void connClose(Conn* c);                            // Firmware side
+// Sent at sendUs (default now; e.g. when a request arrived), arrives one way later
+void peerSend(Conn* c, const uint8_t* data, size_t len, int64_t sendUs = -1);
+void peerClose(Conn* c);                            // Reset by the peer or the path
+void setPeerRate(Conn* c, double bps);
+
+// Servers the station can reach by name (DNS is not modelled)
+enum EndpointState {
+    ENDPOINT_UP,        // Accepts
+    ENDPOINT_REFUSED,   // Host up, nothing listening: RST after one round trip
+    ENDPOINT_BLACKHOLE, // No answer: connect() runs into its timeout
+};
+
+struct Endpoint {
+    EndpointState state;
+    int64_t oneWayUs;
+    double bps;
+    std::function<void(ConnPtr)> onAccept;
+};
+
+void listen(const std::string& host, uint16_t port, Endpoint* ep);
+Endpoint* endpoint(const std::string& host, uint16_t port);
+void resetStationConns(); // Link loss: every STA connection is reset
+
+// STA link. The AP is absent during outage windows; association plus DHCP
+// takes assocUs. RSSI is a function of time.
+void addApOutage(int64_t fromUs, int64_t toUs);
+void setAssociationUs(int64_t us);
+void setRssi(std::function<int(int64_t us)> fn);
+bool apPresent(int64_t us);
+bool stationUp();
+int rssiNow();
+
+// Station side of the WiFi shim
+void staBegin();
+void staDisconnect();
+void onStaEvent(std::function<void(bool gotIp)> fn); // GOT_IP / DISCONNECTED
+
+// SNTP: first request a second after configTime() with the link up, then
+// hourly; a failed request is retried after 15 s. Answers carry true UTC
+// (trueUtcUs), one way later.
+void sntpStart();
+void setSntpReachable(bool up);
+void setSntpCallback(void (*cb)(struct timeval* tv));
+
+// Simulated true time, set by the scenario: UTC µs at virtual time `us`.
+// The ESP32 crystal is not perfect, so this is not `us` plus a constant.
+void setTrueUtc(std::function<int64_t(int64_t us)> fn);
+int64_t trueUtcUs(int64_t us);
+
+struct NetStats {
+    uint64_t conns;
+    uint64_t staDrops;
+    uint64_t sntpSyncs;
+    uint64_t sntpFailures;
+};
+NetStats netStats();
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,17 @@
+// Live dashboard: one Server-Sent Events stream from /events
+const es = new EventSource('/events');
+es.onmessage = (ev) => {
+  try {
+    const d = JSON.parse(ev.data);
+    document.getElementById('data').innerText = JSON.stringify(d, null, 2);
+    document.getElementById('mode_str').innerText = d.mode_str;
+    document.getElementById('st_wifi').innerText = d.wifi_connected ? 'Connected' : 'Disconnected';
+    document.getElementById('st_mqtt').innerText = d.mqtt_connected ? 'Connected' : 'Disconnected';
+    document.getElementById('st_nr').innerText = d.mqtt_connected ? 'Connected (via MQTT)' : 'Disconnected';
+    document.getElementById('st_gps').innerText = d.satellites;
+    var batStr = d.vin ? (d.vin.toFixed(2) + 'V') : 'N/A';
+    if (d.batt_soc !== undefined) batStr += ' | ' + d.batt_soc.toFixed(1) + '%';
+    document.getElementById('st_bat').innerText = batStr;
+    document.getElementById('st_adcsoc').innerText = (d.adc_soc !== undefined) ? (d.adc_soc.toFixed(0) + '% (Comparator)') : 'N/A';
+  } catch (e) {}
+};